@@ -132,6 +132,8 @@ macro(config_compiler_and_linker)
   set(cxx_default "${cxx_exception}")
   set(cxx_no_rtti "${cxx_default} ${cxx_no_rtti_flags}")
   set(cxx_use_own_tuple "${cxx_default} -DGTEST_USE_OWN_TR1_TUPLE=1")
+  set(cxx_no_variadic_templates
+    "${cxx_default} -DGTEST_HAS_VARIADIC_TEMPLATES=0")
 
   # For building the gtest libraries.
   set(cxx_strict "${cxx_default} ${cxx_strict_flags}")
@@ -240,3 +242,37 @@ function(py_test name)
           --build_dir=${CMAKE_CURRENT_BINARY_DIR}/\${CTEST_CONFIGURATION_TYPE})
   endif()
 endfunction()
+
+# cxx_compile_benchmark(name args...)
+#
+# creates a custom target that runs scripts/compile_benchmark.py with
+# the given arguments, using the compiler and flags gtest's own tests
+# are built with.  It does nothing if Python is not installed.
+function(cxx_compile_benchmark name)
+  if (PYTHONINTERP_FOUND)
+    set(flags "${cxx_default} -I${gtest_SOURCE_DIR}/include")
+    set(flags "${flags} -I${gtest_SOURCE_DIR}")
+    add_custom_target(${name}
+      COMMAND ${PYTHON_EXECUTABLE}
+          ${gtest_SOURCE_DIR}/scripts/compile_benchmark.py
+          --cxx=${CMAKE_CXX_COMPILER} "--flags=${flags}" ${ARGN}
+      VERBATIM)
+  endif()
+endfunction()
+
+# cxx_runtime_benchmark(name binary args...)
+#
+# creates a custom target that runs scripts/framework_benchmark.py on
+# the given benchmark executable target with the given arguments.  It
+# does nothing if Python is not installed.
+function(cxx_runtime_benchmark name binary)
+  if (PYTHONINTERP_FOUND)
+    add_custom_target(${name}
+      COMMAND ${PYTHON_EXECUTABLE}
+          ${gtest_SOURCE_DIR}/scripts/framework_benchmark.py
+          --binary=${CMAKE_CURRENT_BINARY_DIR}/${CMAKE_CFG_INTDIR}/${binary}
+          ${ARGN}
+      DEPENDS ${binary}
+      VERBATIM)
+  endif()
+endfunction()
@@ -0,0 +1,543 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This header file defines assertions that compare arrays and containers
+// element by element, exactly or within a floating-point tolerance.  It
+// is #included by gtest.h so a user doesn't need to include this
+// directly, unless the user includes gtest-core.h instead of gtest.h.
+
+#ifndef GTEST_INCLUDE_GTEST_GTEST_ARRAY_H_
+#define GTEST_INCLUDE_GTEST_GTEST_ARRAY_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest-core.h"
+
+namespace testing {
+namespace internal {
+
+// IsTriviallyComparable<T>::value is true iff two T values are equal
+// exactly when their object representations are, so that arrays of T
+// can be compared with memcmp().  This holds for the built-in integer
+// types and for pointers, but not for floating-point types (0.0 == -0.0
+// and NaN != NaN) or for classes, which may have padding or their own
+// operator==.
+template <typename T>
+struct IsTriviallyComparable : public false_type {};
+
+template <typename T>
+struct IsTriviallyComparable<T*> : public true_type {};
+
+#define GTEST_IMPL_TRIVIALLY_COMPARABLE_(T) \
+  template <> \
+  struct IsTriviallyComparable<T> : public true_type {}
+
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(bool);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(char);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(signed char);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(unsigned char);
+#if !defined(_MSC_VER) || defined(_NATIVE_WCHAR_T_DEFINED)
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(wchar_t);
+#endif
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(short);  // NOLINT
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(unsigned short);  // NOLINT
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(int);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(unsigned int);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(long);  // NOLINT
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(unsigned long);  // NOLINT
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(TypeWithSize<8>::Int);
+GTEST_IMPL_TRIVIALLY_COMPARABLE_(TypeWithSize<8>::UInt);
+
+#undef GTEST_IMPL_TRIVIALLY_COMPARABLE_
+
+// Returns the smallest index i in [from, size) for which expected[i] !=
+// actual[i], or size if there is none.  Iter1 and Iter2 may be pointers,
+// random-access iterators, or anything else that can be indexed.
+template <typename Iter1, typename Iter2>
+size_t FindArrayMismatchImpl(Iter1 expected, Iter2 actual,
+                             size_t from, size_t size,
+                             false_type /* trivially comparable */) {
+GTEST_DISABLE_MSC_WARNINGS_PUSH_(4389 /* signed/unsigned mismatch */)
+  for (size_t i = from; i < size; ++i) {
+    if (!(expected[i] == actual[i]))
+      return i;
+  }
+  return size;
+GTEST_DISABLE_MSC_WARNINGS_POP_()
+}
+
+// Implements the above for arrays whose elements can be compared with
+// memcmp().  The C library vectorizes memcmp(), so we let it compare a
+// block at a time and only look at individual elements in the block in
+// which it finds a difference.
+template <typename T>
+size_t FindArrayMismatchImpl(const T* expected, const T* actual,
+                             size_t from, size_t size,
+                             true_type /* trivially comparable */) {
+  const size_t kBlockBytes = 4096;
+  const size_t block_size =
+      sizeof(T) < kBlockBytes ? kBlockBytes / sizeof(T) : 1;
+  for (size_t i = from; i < size; i += block_size) {
+    const size_t n = size - i < block_size ? size - i : block_size;
+    if (memcmp(expected + i, actual + i, n * sizeof(T)) != 0) {
+      while (expected[i] == actual[i])
+        ++i;
+      return i;
+    }
+  }
+  return size;
+}
+
+template <typename Iter1, typename Iter2>
+size_t FindArrayMismatch(Iter1 expected, Iter2 actual,
+                         size_t from, size_t size) {
+  return FindArrayMismatchImpl(expected, actual, from, size, false_type());
+}
+
+template <typename T>
+size_t FindArrayMismatch(const T* expected, const T* actual,
+                         size_t from, size_t size) {
+  return FindArrayMismatchImpl(expected, actual, from, size,
+                               IsTriviallyComparable<T>());
+}
+
+// Returns the smallest index i in [from, size) for which expected[i] ==
+// actual[i], or size if there is none.
+template <typename Iter1, typename Iter2>
+size_t FindArrayMatch(Iter1 expected, Iter2 actual, size_t from, size_t size) {
+GTEST_DISABLE_MSC_WARNINGS_PUSH_(4389 /* signed/unsigned mismatch */)
+  for (size_t i = from; i < size; ++i) {
+    if (expected[i] == actual[i])
+      return i;
+  }
+  return size;
+GTEST_DISABLE_MSC_WARNINGS_POP_()
+}
+
+// Describes where two arrays of the same size differ: how many elements
+// differ, in how many maximal ranges of consecutive indices, and which
+// the first few of those ranges are.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+struct ArrayMismatches {
+  enum { kMaxReportedRanges = 4 };
+
+  size_t count;
+  size_t num_ranges;
+  // The first min(num_ranges, kMaxReportedRanges) ranges, as [begin, end).
+  size_t range_begin[kMaxReportedRanges];
+  size_t range_end[kMaxReportedRanges];
+};
+
+// Prints the element at the given index of an array that the
+// printer was instantiated for.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+typedef void (*ArrayElementPrinter)(const void* array, size_t index,
+                                    ::std::ostream* os);
+
+// Implements ArrayElementPrinter for arrays indexed through an Iter.
+template <typename Iter>
+void PrintArrayElement(const void* array, size_t index, ::std::ostream* os)
+    GTEST_ATTRIBUTE_COLD_ GTEST_NO_INLINE_;
+
+template <typename Iter>
+void PrintArrayElement(const void* array, size_t index, ::std::ostream* os) {
+  UniversalPrint((*static_cast<const Iter*>(array))[index], os);
+}
+
+// Builds the failure message of {ASSERT|EXPECT}_ARRAY_EQ and
+// {ASSERT|EXPECT}_CONTAINER_EQ from type-erased arrays.  size_expression
+// is NULL when the size was not given by the user.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+GTEST_API_ AssertionResult ArrayEQFailure(const char* expected_expression,
+                                          const char* actual_expression,
+                                          const char* size_expression,
+                                          size_t size,
+                                          const ArrayMismatches& mismatches,
+                                          const void* expected,
+                                          ArrayElementPrinter print_expected,
+                                          const void* actual,
+                                          ArrayElementPrinter print_actual)
+    GTEST_ATTRIBUTE_COLD_;
+
+// Finds all ranges of differing elements, given that the first of them
+// starts at first_mismatch, and reports them.
+template <typename Iter1, typename Iter2>
+AssertionResult ArrayEQFailure(const char* expected_expression,
+                               const char* actual_expression,
+                               const char* size_expression,
+                               Iter1 expected, Iter2 actual, size_t size,
+                               size_t first_mismatch)
+    GTEST_ATTRIBUTE_COLD_ GTEST_NO_INLINE_;
+
+template <typename Iter1, typename Iter2>
+AssertionResult ArrayEQFailure(const char* expected_expression,
+                               const char* actual_expression,
+                               const char* size_expression,
+                               Iter1 expected, Iter2 actual, size_t size,
+                               size_t first_mismatch) {
+  ArrayMismatches mismatches;
+  mismatches.count = 0;
+  mismatches.num_ranges = 0;
+  for (size_t begin = first_mismatch; begin < size;) {
+    const size_t end = FindArrayMatch(expected, actual, begin + 1, size);
+    if (mismatches.num_ranges < ArrayMismatches::kMaxReportedRanges) {
+      mismatches.range_begin[mismatches.num_ranges] = begin;
+      mismatches.range_end[mismatches.num_ranges] = end;
+    }
+    mismatches.num_ranges++;
+    mismatches.count += end - begin;
+    // Element end is equal (unless end == size), so we skip it.
+    begin = end < size ?
+        FindArrayMismatch(expected, actual, end + 1, size) : size;
+  }
+  return ArrayEQFailure(expected_expression, actual_expression,
+                        size_expression, size, mismatches,
+                        &expected, &PrintArrayElement<Iter1>,
+                        &actual, &PrintArrayElement<Iter2>);
+}
+
+// Compares the first size elements of two arrays.
+template <typename Iter1, typename Iter2>
+AssertionResult CompareArrays(const char* expected_expression,
+                              const char* actual_expression,
+                              const char* size_expression,
+                              Iter1 expected, Iter2 actual, size_t size) {
+  const size_t first_mismatch = FindArrayMismatch(expected, actual, 0, size);
+  if (first_mismatch == size) {
+    return AssertionResult(true);
+  }
+  return ArrayEQFailure(expected_expression, actual_expression,
+                        size_expression, expected, actual, size,
+                        first_mismatch);
+}
+
+// The helper function for {ASSERT|EXPECT}_ARRAY_EQ.
+template <typename T1, typename T2>
+AssertionResult CmpHelperArrayEQ(const char* expected_expression,
+                                 const char* actual_expression,
+                                 const char* size_expression,
+                                 const T1* expected,
+                                 const T2* actual,
+                                 size_t size) {
+  return CompareArrays(expected_expression, actual_expression,
+                       size_expression, expected, actual, size);
+}
+
+// Indexes the elements of a container that has no random-access
+// iterators through an array of pointers to them.
+template <typename T>
+class IndirectArray {
+ public:
+  explicit IndirectArray(const T* const* elements) : elements_(elements) {}
+
+  const T& operator[](size_t i) const { return *elements_[i]; }
+
+ private:
+  const T* const* elements_;
+};
+
+// ContainerElements<Container>(container).array() returns something that
+// can be indexed like an array of the container's elements: a pointer to
+// them when they are known to be contiguous, so that
+// {ASSERT|EXPECT}_CONTAINER_EQ can compare them with memcmp(), or else
+// a random-access iterator, or else an IndirectArray.
+template <typename Container,
+          typename Category = typename ::std::iterator_traits<
+              typename Container::const_iterator>::iterator_category>
+class ContainerElements {
+ public:
+  typedef typename Container::value_type Element;
+  typedef IndirectArray<Element> Array;
+
+  explicit ContainerElements(const Container& container) {
+    for (typename Container::const_iterator it = container.begin();
+         it != container.end(); ++it) {
+      elements_.push_back(&*it);
+    }
+  }
+
+  Array array() const {
+    return Array(elements_.empty() ? NULL : &elements_[0]);
+  }
+
+ private:
+  ::std::vector<const Element*> elements_;
+};
+
+template <typename Container>
+class ContainerElements<Container, ::std::random_access_iterator_tag> {
+ public:
+  typedef typename Container::const_iterator Array;
+
+  explicit ContainerElements(const Container& container)
+      : begin_(container.begin()) {}
+
+  Array array() const { return begin_; }
+
+ private:
+  const Array begin_;
+};
+
+template <typename T, typename Allocator>
+class ContainerElements< ::std::vector<T, Allocator>,
+                         ::std::random_access_iterator_tag> {
+ public:
+  typedef const T* Array;
+
+  explicit ContainerElements(const ::std::vector<T, Allocator>& container)
+      : begin_(container.empty() ? NULL : &container[0]) {}
+
+  Array array() const { return begin_; }
+
+ private:
+  const Array begin_;
+};
+
+// std::vector<bool> packs its elements into bits, so we can only use its
+// iterators.
+template <typename Allocator>
+class ContainerElements< ::std::vector<bool, Allocator>,
+                         ::std::random_access_iterator_tag> {
+ public:
+  typedef typename ::std::vector<bool, Allocator>::const_iterator Array;
+
+  explicit ContainerElements(const ::std::vector<bool, Allocator>& container)
+      : begin_(container.begin()) {}
+
+  Array array() const { return begin_; }
+
+ private:
+  const Array begin_;
+};
+
+template <typename Char, typename Traits, typename Allocator>
+class ContainerElements< ::std::basic_string<Char, Traits, Allocator>,
+                         ::std::random_access_iterator_tag> {
+ public:
+  typedef const Char* Array;
+
+  explicit ContainerElements(
+      const ::std::basic_string<Char, Traits, Allocator>& container)
+      : begin_(container.data()) {}
+
+  Array array() const { return begin_; }
+
+ private:
+  const Array begin_;
+};
+
+// Reports that the containers compared by {ASSERT|EXPECT}_CONTAINER_EQ
+// have different sizes.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+GTEST_API_ AssertionResult ContainerSizeEQFailure(
+    const char* expected_expression, const char* actual_expression,
+    size_t expected_size, size_t actual_size) GTEST_ATTRIBUTE_COLD_;
+
+// Returns the number of elements of an STL-style container, which only
+// needs begin() and end(), e.g. std::forward_list.
+template <typename Container>
+size_t ContainerSize(const Container& container) {
+  return static_cast<size_t>(
+      ::std::distance(container.begin(), container.end()));
+}
+
+// The helper function for {ASSERT|EXPECT}_CONTAINER_EQ.
+template <typename Container1, typename Container2>
+AssertionResult CmpHelperContainerEQ(const char* expected_expression,
+                                     const char* actual_expression,
+                                     const Container1& expected,
+                                     const Container2& actual) {
+  const size_t size = ContainerSize(expected);
+  const size_t actual_size = ContainerSize(actual);
+  if (actual_size != size) {
+    return ContainerSizeEQFailure(expected_expression, actual_expression,
+                                  size, actual_size);
+  }
+  const ContainerElements<Container1> expected_elements(expected);
+  const ContainerElements<Container2> actual_elements(actual);
+  return CompareArrays(expected_expression, actual_expression, NULL,
+                       expected_elements.array(), actual_elements.array(),
+                       size);
+}
+
+// The result of comparing two arrays of floating-point numbers within a
+// tolerance t.  The differences are counted in a histogram with the
+// buckets 0, (0, t/4], (t/4, t/2], (t/2, t], (t, 4t], (4t, 64t], > 64t,
+// and NaN, where differences involving a NaN are counted in the last
+// bucket only.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+struct FloatingPointArrayErrors {
+  enum { kNumBuckets = 8 };
+
+  // The number of elements that differ by more than the tolerance.
+  size_t num_failures;
+  // The index of the first of the largest differences.  Differences
+  // involving a NaN are larger than any other.
+  size_t worst_index;
+  // The largest difference, or infinity if it involves a NaN.
+  double max_error;
+  // The upper bounds of the histogram buckets that have one, i.e. 0,
+  // t/4, t/2, t, 4t and 64t.
+  double bucket_limits[kNumBuckets - 2];
+  size_t histogram[kNumBuckets];
+};
+
+// Compares expected[i] and actual[i] for every i in [0, size) in a
+// single pass, measuring their differences in ULPs (units in the last
+// place, see FloatingPoint) or as absolute values.  These use SSE2 where
+// it's available.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+GTEST_API_ void MeasureUlpErrors(const float* expected, const float* actual,
+                                 size_t size, UInt64 max_ulps,
+                                 FloatingPointArrayErrors* errors);
+GTEST_API_ void MeasureUlpErrors(const double* expected, const double* actual,
+                                 size_t size, UInt64 max_ulps,
+                                 FloatingPointArrayErrors* errors);
+GTEST_API_ void MeasureAbsErrors(const float* expected, const float* actual,
+                                 size_t size, double abs_error,
+                                 FloatingPointArrayErrors* errors);
+GTEST_API_ void MeasureAbsErrors(const double* expected, const double* actual,
+                                 size_t size, double abs_error,
+                                 FloatingPointArrayErrors* errors);
+
+// Helper functions for implementing {ASSERT|EXPECT}_ARRAYS_NEAR_ULP.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+GTEST_API_ AssertionResult ArraysNearUlpPredFormat(
+    const char* expected_expression, const char* actual_expression,
+    const char* size_expression, const char* max_ulps_expression,
+    const float* expected, const float* actual, size_t size,
+    UInt64 max_ulps);
+GTEST_API_ AssertionResult ArraysNearUlpPredFormat(
+    const char* expected_expression, const char* actual_expression,
+    const char* size_expression, const char* max_ulps_expression,
+    const double* expected, const double* actual, size_t size,
+    UInt64 max_ulps);
+
+// Helper functions for implementing {ASSERT|EXPECT}_ARRAYS_NEAR.
+//
+// INTERNAL IMPLEMENTATION - DO NOT USE IN A USER PROGRAM.
+GTEST_API_ AssertionResult ArraysNearPredFormat(
+    const char* expected_expression, const char* actual_expression,
+    const char* size_expression, const char* abs_error_expression,
+    const float* expected, const float* actual, size_t size,
+    double abs_error);
+GTEST_API_ AssertionResult ArraysNearPredFormat(
+    const char* expected_expression, const char* actual_expression,
+    const char* size_expression, const char* abs_error_expression,
+    const double* expected, const double* actual, size_t size,
+    double abs_error);
+
+}  // namespace internal
+}  // namespace testing
+
+// Macros for comparing arrays and containers element by element.
+//
+//    * {ASSERT|EXPECT}_ARRAY_EQ(expected, actual, size):
+//         Tests that expected[i] == actual[i] for every i in [0, size),
+//         where expected and actual are pointers or C arrays.
+//    * {ASSERT|EXPECT}_CONTAINER_EQ(expected, actual):
+//         Tests that two STL-style containers have the same size and
+//         equal elements, in the same order.  The containers need
+//         begin(), end(), const_iterator and value_type, but not size().
+//
+// Arrays of integers and pointers are compared with memcmp(), so these
+// assertions are much faster than an EXPECT_EQ per element.  On failure,
+// they report how many elements differ, and print the first few ranges
+// of differing elements together with the elements around them.
+//
+// Examples:
+//
+//   EXPECT_ARRAY_EQ(kExpectedPixels, image.pixels(), kWidth * kHeight);
+//   ASSERT_CONTAINER_EQ(expected_ids, GetIds());
+
+#define EXPECT_ARRAY_EQ(expected, actual, size) \
+  EXPECT_PRED_FORMAT3(::testing::internal::CmpHelperArrayEQ, \
+                      expected, actual, size)
+#define ASSERT_ARRAY_EQ(expected, actual, size) \
+  ASSERT_PRED_FORMAT3(::testing::internal::CmpHelperArrayEQ, \
+                      expected, actual, size)
+
+#define EXPECT_CONTAINER_EQ(expected, actual) \
+  EXPECT_PRED_FORMAT2(::testing::internal::CmpHelperContainerEQ, \
+                      expected, actual)
+#define ASSERT_CONTAINER_EQ(expected, actual) \
+  ASSERT_PRED_FORMAT2(::testing::internal::CmpHelperContainerEQ, \
+                      expected, actual)
+
+// Macros for comparing arrays of floating-point numbers.
+//
+//    * {ASSERT|EXPECT}_ARRAYS_NEAR_ULP(expected, actual, size, max_ulps):
+//         Tests that expected[i] and actual[i] are at most max_ulps ULPs
+//         apart for every i in [0, size).
+//    * {ASSERT|EXPECT}_ARRAYS_NEAR(expected, actual, size, abs_error):
+//         Tests that the absolute difference between expected[i] and
+//         actual[i] doesn't exceed abs_error for every i in [0, size).
+//         A NaN abs_error always fails.
+//
+// expected and actual must both be arrays of float or both be arrays of
+// double.  NaN is never near anything, while equal infinities are near
+// each other.  On failure, these report the number of elements that
+// differ by too much, the largest difference and where it is, and a
+// histogram of all the differences.
+//
+// Examples:
+//
+//   EXPECT_ARRAYS_NEAR_ULP(kReferenceOutput, output, kSamples, 4);
+//   ASSERT_ARRAYS_NEAR(expected.data(), actual.data(), n, 1e-6);
+
+#define EXPECT_ARRAYS_NEAR_ULP(expected, actual, size, max_ulps) \
+  EXPECT_PRED_FORMAT4(::testing::internal::ArraysNearUlpPredFormat, \
+                      expected, actual, size, max_ulps)
+#define ASSERT_ARRAYS_NEAR_ULP(expected, actual, size, max_ulps) \
+  ASSERT_PRED_FORMAT4(::testing::internal::ArraysNearUlpPredFormat, \
+                      expected, actual, size, max_ulps)
+
+#define EXPECT_ARRAYS_NEAR(expected, actual, size, abs_error) \
+  EXPECT_PRED_FORMAT4(::testing::internal::ArraysNearPredFormat, \
+                      expected, actual, size, abs_error)
+#define ASSERT_ARRAYS_NEAR(expected, actual, size, abs_error) \
+  ASSERT_PRED_FORMAT4(::testing::internal::ArraysNearPredFormat, \
+                      expected, actual, size, abs_error)
+
+#endif  // GTEST_INCLUDE_GTEST_GTEST_ARRAY_H_
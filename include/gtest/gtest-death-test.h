@@ -33,11 +33,12 @@
 //
 // This header file defines the public API for death tests.  It is
 // #included by gtest.h so a user doesn't need to include this
-// directly.
+// directly, unless the user includes gtest-core.h instead of gtest.h.
 
 #ifndef GTEST_INCLUDE_GTEST_GTEST_DEATH_TEST_H_
 #define GTEST_INCLUDE_GTEST_GTEST_DEATH_TEST_H_
 
+#include "gtest/gtest-core.h"
 #include "gtest/internal/gtest-death-test-internal.h"
 
 namespace testing {
@@ -61,7 +61,9 @@ namespace testing {
 // Typical usage:
 //
 //   1. You stream a bunch of values to a Message object.
-//      It will remember the text in a stringstream.
+//      It will remember the text in a small buffer of its own, or
+//      in a stringstream once the text outgrows the buffer or a
+//      value needs an ostream to be printed.
 //   2. Then you stream the Message object to an ostream.
 //      This causes the text in the Message to be streamed
 //      to the ostream.
@@ -93,14 +95,10 @@ class GTEST_API_ Message {
   Message();
 
   // Copy constructor.
-  Message(const Message& msg) : ss_(new ::std::stringstream) {  // NOLINT
-    *ss_ << msg.GetString();
-  }
+  Message(const Message& msg);  // NOLINT
 
   // Constructs a Message from a C-string.
-  explicit Message(const char* str) : ss_(new ::std::stringstream) {
-    *ss_ << str;
-  }
+  explicit Message(const char* str);
 
 #if GTEST_OS_SYMBIAN
   // Streams a value (either a pointer or not) to this object.
@@ -128,7 +126,7 @@ class GTEST_API_ Message {
     // overloads of << defined in the global namespace and those
     // visible via Koenig lookup are both exposed in this function.
     using ::operator <<;
-    *ss_ << val;
+    GetStream() << val;
     return *this;
   }
 
@@ -148,9 +146,9 @@ class GTEST_API_ Message {
   template <typename T>
   inline Message& operator <<(T* const& pointer) {  // NOLINT
     if (pointer == NULL) {
-      *ss_ << "(null)";
+      Append("(null)", 6);
     } else {
-      *ss_ << pointer;
+      GetStream() << pointer;
     }
     return *this;
   }
@@ -162,16 +160,50 @@ class GTEST_API_ Message {
   // templatized version above.  Without this definition, streaming
   // endl or other basic IO manipulators to Message will confuse the
   // compiler.
-  Message& operator <<(BasicNarrowIoManip val) {
-    *ss_ << val;
-    return *this;
-  }
+  Message& operator <<(BasicNarrowIoManip val);
 
   // Instead of 1/0, we want to see true/false for bool values.
   Message& operator <<(bool b) {
     return *this << (b ? "true" : "false");
   }
 
+  // The following overloads print the most common values without the
+  // cost of setting up a stringstream.  They print exactly what
+  // streaming the value to an ostream would.
+  Message& operator <<(char c) {
+    Append(&c, 1);
+    return *this;
+  }
+
+  // A NULL C string is printed as "(null)".
+  Message& operator <<(const char* str) {
+    if (str == NULL) {
+      Append("(null)", 6);
+    } else {
+      Append(str, strlen(str));
+    }
+    return *this;
+  }
+  Message& operator <<(char* str) {
+    return *this << static_cast<const char*>(str);
+  }
+
+  Message& operator <<(const ::std::string& str) {
+    Append(str.data(), str.size());
+    return *this;
+  }
+
+  Message& operator <<(short n);  // NOLINT
+  Message& operator <<(unsigned short n);  // NOLINT
+  Message& operator <<(int n);
+  Message& operator <<(unsigned int n);
+  Message& operator <<(long n);  // NOLINT
+  Message& operator <<(unsigned long n);  // NOLINT
+  Message& operator <<(internal::BiggestInt n);
+  Message& operator <<(internal::UInt64 n);
+  Message& operator <<(float x);
+  Message& operator <<(double x);
+
   // These two overloads allow streaming a wide C string to a Message
   // using the UTF-8 encoding.
   Message& operator <<(const wchar_t* wide_c_str);
@@ -205,9 +237,9 @@ class GTEST_API_ Message {
   template <typename T>
   inline void StreamHelper(internal::true_type /*is_pointer*/, T* pointer) {
     if (pointer == NULL) {
-      *ss_ << "(null)";
+      Append("(null)", 6);
     } else {
-      *ss_ << pointer;
+      GetStream() << pointer;
     }
   }
   template <typename T>
@@ -216,12 +248,48 @@ class GTEST_API_ Message {
     // See the comments in Message& operator <<(const T&) above for why
     // we need this using statement.
     using ::operator <<;
-    *ss_ << value;
+    GetStream() << value;
   }
 #endif  // GTEST_OS_SYMBIAN
 
-  // We'll hold the text streamed to this object here.
-  const internal::scoped_ptr< ::std::stringstream> ss_;
+  // The number of characters a short message may have.  A Buffer takes
+  // up 128 bytes on 64-bit platforms.
+  enum { kBufferSize = 128 - sizeof(size_t) };
+
+  // Holds the text of a short message.
+  struct Buffer {
+    size_t size;
+    char chars[kBufferSize];
+  };
+
+  // Appends length characters starting at str to the text.
+  void Append(const char* str, size_t length) {
+    if (buffer_.get() != NULL && length <= kBufferSize - buffer_->size) {
+      memcpy(buffer_->chars + buffer_->size, str, length);
+      buffer_->size += length;
+    } else {
+      AppendToNewBufferOrStream(str, length);
+    }
+  }
+
+  // Appends to the text when it isn't in a buffer with room for it.
+  void AppendToNewBufferOrStream(const char* str, size_t length);
+
+  // Appends a number to the text.
+  template <typename Number>
+  Message& AppendNumber(Number n);
+
+  // Returns the stream that holds the text from now on, creating it
+  // and moving the buffered text into it the first time.
+  ::std::ostream& GetStream();
+
+  // The text streamed to this object is held in buffer_, which is
+  // allocated when the first characters arrive, until it outgrows the
+  // buffer or a value needs a stream to be printed.  After that it's
+  // held in ss_, and buffer_ is NULL.  Both start out NULL, so that a
+  // Message takes up little stack space (see Message::Message()).
+  internal::scoped_ptr<Buffer> buffer_;
+  internal::scoped_ptr< ::std::stringstream> ss_;
 
   // We declare (but don't implement) this to prevent the compiler
   // from implementing the assignment operator.
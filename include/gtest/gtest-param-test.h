@@ -188,6 +188,7 @@ TEST_P(DerivedTest, DoesBlah) {
 // scripts/fuse_gtest.py depends on gtest's own header being #included
 // *unconditionally*.  Therefore these #includes cannot be moved
 // inside #if GTEST_HAS_PARAM_TEST.
+#include "gtest/gtest-core.h"
 #include "gtest/internal/gtest-internal.h"
 #include "gtest/internal/gtest-param-util.h"
 #include "gtest/internal/gtest-param-util-generated.h"
@@ -196,6 +197,82 @@ TEST_P(DerivedTest, DoesBlah) {
 
 namespace testing {
 
+// The pure interface class that all value-parameterized tests inherit from.
+// A value-parameterized class must inherit from both ::testing::Test and
+// ::testing::WithParamInterface. In most cases that just means inheriting
+// from ::testing::TestWithParam, but more complicated test hierarchies
+// may need to inherit from Test and WithParamInterface at different levels.
+//
+// This interface has support for accessing the test parameter value via
+// the GetParam() method.
+//
+// Use it with one of the parameter generator defining functions, like Range(),
+// Values(), ValuesIn(), Bool(), and Combine().
+//
+// class FooTest : public ::testing::TestWithParam<int> {
+//  protected:
+//   FooTest() {
+//     // Can use GetParam() here.
+//   }
+//   virtual ~FooTest() {
+//     // Can use GetParam() here.
+//   }
+//   virtual void SetUp() {
+//     // Can use GetParam() here.
+//   }
+//   virtual void TearDown {
+//     // Can use GetParam() here.
+//   }
+// };
+// TEST_P(FooTest, DoesBar) {
+//   // Can use GetParam() method here.
+//   Foo foo;
+//   ASSERT_TRUE(foo.DoesBar(GetParam()));
+// }
+// INSTANTIATE_TEST_CASE_P(OneToTenRange, FooTest, ::testing::Range(1, 10));
+
+template <typename T>
+class WithParamInterface {
+ public:
+  typedef T ParamType;
+  virtual ~WithParamInterface() {}
+
+  // The current parameter value. Is also available in the test fixture's
+  // constructor. This member function is non-static, even though it only
+  // references static data, to reduce the opportunity for incorrect uses
+  // like writing 'WithParamInterface<bool>::GetParam()' for a test that
+  // uses a fixture whose parameter type is int.
+  const ParamType& GetParam() const {
+    GTEST_CHECK_(parameter_ != NULL)
+        << "GetParam() can only be called inside a value-parameterized test "
+        << "-- did you intend to write TEST_P instead of TEST_F?";
+    return *parameter_;
+  }
+
+ private:
+  // Sets parameter value. The caller is responsible for making sure the value
+  // remains alive and unchanged throughout the current test.
+  static void SetParam(const ParamType* parameter) {
+    parameter_ = parameter;
+  }
+
+  // Static value used for accessing parameter during a test lifetime.
+  static const ParamType* parameter_;
+
+  // TestClass must be a subclass of WithParamInterface<T> and Test.
+  template <class TestClass> friend class internal::ParameterizedTestFactory;
+};
+
+template <typename T>
+const T* WithParamInterface<T>::parameter_ = NULL;
+
+// Most value-parameterized classes can ignore the existence of
+// WithParamInterface, and can just inherit from ::testing::TestWithParam.
+
+template <typename T>
+class TestWithParam : public Test, public WithParamInterface<T> {
+};
+
 // Functions producing parameter generators.
 //
 // Google Test uses these generators to produce parameters for value-
@@ -342,8 +419,17 @@ internal::ParamGenerator<typename Container::value_type> ValuesIn(
 //
 // INSTANTIATE_TEST_CASE_P(FloatingNumbers, BazTest, Values(1, 2, 3.5));
 //
-// Currently, Values() supports from 1 to 50 parameters.
+// When GTEST_HAS_VARIADIC_TEMPLATES is 0, Values() supports from 1 to 50
+// parameters.
 //
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+template <typename... T>
+internal::ValueArray<T...> Values(T... v) {
+  return internal::ValueArray<T...>(v...);
+}
+
+# else  // GTEST_HAS_VARIADIC_TEMPLATES
 template <typename T1>
 internal::ValueArray1<T1> Values(T1 v1) {
   return internal::ValueArray1<T1>(v1);
@@ -1197,6 +1283,8 @@ internal::ValueArray50<T1, T2, T3, T4, T5, T6, T7, T8, T9, T10, T11, T12, T13,
       v48, v49, v50);
 }
 
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // Bool() allows generating tests with parameters in a set of (false, true).
 //
 // Synopsis:
@@ -1233,9 +1321,9 @@ inline internal::ParamGenerator<bool> Bool() {
 //     tuple<T1, T2, ..., TN> where T1, T2, ..., TN are the types
 //     of elements from sequences produces by gen1, gen2, ..., genN.
 //
-// Combine can have up to 10 arguments. This number is currently limited
-// by the maximum number of elements in the tuple implementation used by Google
-// Test.
+// When GTEST_HAS_VARIADIC_TEMPLATES is 0, Combine can have up to 10
+// arguments. This number is currently limited by the maximum number of
+// elements in the tuple implementation used by Google Test.
 //
 // Example:
 //
@@ -1270,6 +1358,14 @@ inline internal::ParamGenerator<bool> Bool() {
 // INSTANTIATE_TEST_CASE_P(TwoBoolSequence, FlagDependentTest,
 //                         Combine(Bool(), Bool()));
 //
+#  if GTEST_HAS_VARIADIC_TEMPLATES
+
+template <typename... Generator>
+internal::CartesianProductHolder<Generator...> Combine(const Generator&... g) {
+  return internal::CartesianProductHolder<Generator...>(g...);
+}
+
+#  else  // GTEST_HAS_VARIADIC_TEMPLATES
 template <typename Generator1, typename Generator2>
 internal::CartesianProductHolder2<Generator1, Generator2> Combine(
     const Generator1& g1, const Generator2& g2) {
@@ -1373,6 +1469,7 @@ internal::CartesianProductHolder10<Generator1, Generator2, Generator3,
       Generator10>(
       g1, g2, g3, g4, g5, g6, g7, g8, g9, g10);
 }
+#  endif  // GTEST_HAS_VARIADIC_TEMPLATES
 # endif  // GTEST_HAS_COMBINE
 
 
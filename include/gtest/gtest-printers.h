@@ -267,12 +267,112 @@ class UniversalPrinter;
 template <typename T>
 void UniversalPrint(const T& value, ::std::ostream* os);
 
-// Used to print an STL-style container when the user doesn't define
-// a PrintTo() for it.
+// Limits how much of a value the universal printer prints, so that a
+// failure involving a huge or deeply nested value stays cheap to
+// report.  The budget allows --gtest_print_budget characters and half
+// as many container or array elements (each of which takes at least
+// two characters), and is shared by everything printed to the stream
+// while the outermost UniversalPrinter<T>::Print() call for it runs,
+// including through user-defined PrintTo() functions.  Once the budget
+// is spent, each container being printed ends with "... (N more)".
+//
+// The character budget is only enforced on streams that can tell
+// their position (e.g. string streams, which is what Google Test
+// prints values to).
+class GTEST_API_ PrintBudget {
+ public:
+  // Starts a budget for printing a value to os, unless there's already
+  // one running for os.
+  explicit PrintBudget(::std::ostream* os);
+  ~PrintBudget();
+
+  // Charges one element of a container or array being printed to os.
+  // Returns false if the budget is spent and the element should be
+  // left out.
+  static bool ConsumeElement(::std::ostream* os);
+
+  // Charges count elements, which take at most max_chars characters in
+  // all, to the budget of os if it has room for all of them.  Returns
+  // false, and charges nothing, otherwise.
+  static bool ConsumeElements(::std::ostream* os, size_t count,
+                              size_t max_chars);
+
+  // Returns the number of characters that may still be printed to os.
+  static size_t CharactersLeft(::std::ostream* os);
+
+ private:
+  // Returns the running budget of os, or NULL if there is none.
+  static PrintBudget* Of(::std::ostream* os);
+
+  ::std::ostream* const os_;
+  // True iff this object is the budget installed on os_.
+  bool is_running_;
+  // The number of elements that may still be printed.
+  size_t elements_left_;
+  // The stream position at which the characters run out, or -1 if
+  // there's no limit on them.
+  ::std::streamoff end_;
+  // True iff the budget has run out.
+  bool spent_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(PrintBudget);
+};
+
+// Prints "... (N more)", which stands for count elements left out
+// because the print budget was spent.
+GTEST_API_ void PrintOmittedElementsTo(size_t count, ::std::ostream* os);
+
+// Prints the given number of elements in an array, without printing
+// the curly braces.  If the print budget runs out, prints "... (N
+// more)" in place of the remaining elements, where N also counts the
+// num_following elements the caller would print after them, and
+// returns false.
+template <typename T>
+bool PrintRawArrayTo(const T a[], size_t count, ::std::ostream* os,
+                     size_t num_following = 0) {
+  for (size_t i = 0; i != count; i++) {
+    if (i != 0) {
+      *os << ", ";
+    }
+    if (!PrintBudget::ConsumeElement(os)) {
+      PrintOmittedElementsTo(count - i + num_following, os);
+      return false;
+    }
+    UniversalPrint(a[i], os);
+  }
+  return true;
+}
+
+// These overloads print arrays of numbers.  They produce the same
+// output as the template above, but format the numbers into a buffer
+// themselves instead of sending each one through the stream's locale
+// machinery, unless the stream has a non-default number format.
+GTEST_API_ bool PrintRawArrayTo(const short a[], size_t count,  // NOLINT
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const unsigned short a[],  // NOLINT
+                                size_t count, ::std::ostream* os,
+                                size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const int a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const unsigned int a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const long a[], size_t count,  // NOLINT
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const unsigned long a[],  // NOLINT
+                                size_t count, ::std::ostream* os,
+                                size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const BiggestInt a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const UInt64 a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const float a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+GTEST_API_ bool PrintRawArrayTo(const double a[], size_t count,
+                                ::std::ostream* os, size_t num_following = 0);
+
+// Prints the elements of an STL-style container in curly braces.
 template <typename C>
-void DefaultPrintTo(IsContainer /* dummy */,
-                    false_type /* is not a pointer */,
-                    const C& container, ::std::ostream* os) {
+void DefaultPrintContainerTo(const C& container, ::std::ostream* os) {
   const size_t kMaxCount = 32;  // The maximum number of elements to print.
   *os << '{';
   size_t count = 0;
@@ -286,6 +386,13 @@ void DefaultPrintTo(IsContainer /* dummy */,
       }
     }
     *os << ' ';
+    if (!PrintBudget::ConsumeElement(os)) {
+      size_t omitted = 0;
+      for (; it != container.end(); ++it)
+        ++omitted;
+      PrintOmittedElementsTo(omitted, os);
+      break;
+    }
     // We cannot call PrintTo(*it, os) here as PrintTo() doesn't
     // handle *it being a native array.
     internal::UniversalPrint(*it, os);
@@ -297,6 +404,47 @@ void DefaultPrintTo(IsContainer /* dummy */,
   *os << '}';
 }
 
+// Used to print an STL-style container when the user doesn't define
+// a PrintTo() for it.
+template <typename C>
+void DefaultPrintTo(IsContainer /* dummy */,
+                    false_type /* is not a pointer */,
+                    const C& container, ::std::ostream* os) {
+  DefaultPrintContainerTo(container, os);
+}
+
+// Used to print a std::vector when the user doesn't define a PrintTo()
+// for it.  The elements are contiguous, so we print them as an array,
+// which is faster for numbers, but in the same format as above.
+template <typename T, typename Alloc>
+void DefaultPrintTo(IsContainer /* dummy */,
+                    false_type /* is not a pointer */,
+                    const ::std::vector<T, Alloc>& container,
+                    ::std::ostream* os) {
+  const size_t kMaxCount = 32;  // The maximum number of elements to print.
+  if (container.empty()) {
+    *os << "{}";
+    return;
+  }
+  *os << "{ ";
+  const size_t count = (std::min)(container.size(), kMaxCount);
+  if (PrintRawArrayTo(&container[0], count, os, container.size() - count) &&
+      count < container.size()) {
+    *os << ", ...";
+  }
+  *os << " }";
+}
+
+// std::vector<bool> doesn't keep its elements in an array, so it's
+// printed like any other container.
+template <typename Alloc>
+void DefaultPrintTo(IsContainer /* dummy */,
+                    false_type /* is not a pointer */,
+                    const ::std::vector<bool, Alloc>& container,
+                    ::std::ostream* os) {
+  DefaultPrintContainerTo(container, os);
+}
+
 // Used to print a pointer that is neither a char pointer nor a member
 // pointer, when the user doesn't define PrintTo() for it.  (A member
 // variable pointer or member function pointer doesn't really point to
@@ -442,20 +590,6 @@ inline void PrintTo(wchar_t* s, ::std::ostream* os) {
 }
 #endif
 
-// Overload for C arrays.  Multi-dimensional arrays are printed
-// properly.
-
-// Prints the given number of elements in an array, without printing
-// the curly braces.
-template <typename T>
-void PrintRawArrayTo(const T a[], size_t count, ::std::ostream* os) {
-  UniversalPrint(a[0], os);
-  for (size_t i = 1; i != count; i++) {
-    *os << ", ";
-    UniversalPrint(a[i], os);
-  }
-}
-
 // Overloads for ::string and ::std::string.
 #if GTEST_HAS_GLOBAL_STRING
 GTEST_API_ void PrintStringTo(const ::string&s, ::std::ostream* os);
@@ -607,6 +741,7 @@ class UniversalPrinter {
     // be visible here.  Since it is more specific than the generic ones
     // in ::testing::internal, it will be picked by the compiler in the
     // following statement - exactly what we want.
+    const PrintBudget budget(os);
     PrintTo(value, os);
   }
 
@@ -630,9 +765,10 @@ void UniversalPrintArray(const T* begin, size_t len, ::std::ostream* os) {
     if (len <= kThreshold) {
       PrintRawArrayTo(begin, len, os);
     } else {
-      PrintRawArrayTo(begin, kChunkSize, os);
-      *os << ", ..., ";
-      PrintRawArrayTo(begin + len - kChunkSize, kChunkSize, os);
+      if (PrintRawArrayTo(begin, kChunkSize, os, len - kChunkSize)) {
+        *os << ", ..., ";
+        PrintRawArrayTo(begin + len - kChunkSize, kChunkSize, os);
+      }
     }
     *os << " }";
   }
@@ -652,6 +788,7 @@ class UniversalPrinter<T[N]> {
   // Prints the given array, omitting some elements when there are too
   // many.
   static void Print(const T (&a)[N], ::std::ostream* os) {
+    const PrintBudget budget(os);
     UniversalPrintArray(a, N, os);
   }
 };
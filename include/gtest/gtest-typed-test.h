@@ -146,8 +146,10 @@ INSTANTIATE_TYPED_TEST_CASE_P(My, FooTest, MyTypes);
 
 #endif  // 0
 
+#include "gtest/gtest-core.h"
 #include "gtest/internal/gtest-port.h"
 #include "gtest/internal/gtest-type-util.h"
+#include "gtest/internal/gtest-typed-test-internal.h"
 
 // Implements typed tests.
 
@@ -35,10 +35,10 @@
 #ifndef GTEST_INCLUDE_GTEST_GTEST_PRED_IMPL_H_
 #define GTEST_INCLUDE_GTEST_GTEST_PRED_IMPL_H_
 
-// Makes sure this header is not included before gtest.h.
-#ifndef GTEST_INCLUDE_GTEST_GTEST_H_
+// Makes sure this header is not included before gtest-core.h.
+#ifndef GTEST_INCLUDE_GTEST_GTEST_CORE_H_
 # error Do not include gtest_pred_impl.h directly.  Include gtest.h instead.
-#endif  // GTEST_INCLUDE_GTEST_GTEST_H_
+#endif  // GTEST_INCLUDE_GTEST_GTEST_CORE_H_
 
 // This header implements a family of generic predicate assertion
 // macros:
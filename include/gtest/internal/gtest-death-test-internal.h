@@ -49,6 +49,7 @@ GTEST_DECLARE_string_(internal_run_death_test);
 // Names of the flags (needed for parsing Google Test flags).
 const char kDeathTestStyleFlag[] = "death_test_style";
 const char kDeathTestUseFork[] = "death_test_use_fork";
+const char kDeathTestUseZygote[] = "death_test_use_zygote";
 const char kInternalRunDeathTestFlag[] = "internal_run_death_test";
 
 #if GTEST_HAS_DEATH_TEST
@@ -36,12 +36,13 @@
 // Type and function utilities for implementing parameterized tests.
 // This file is generated by a SCRIPT.  DO NOT EDIT BY HAND!
 //
-// Currently Google Test supports at most 50 arguments in Values,
-// and at most 10 arguments in Combine. Please contact
-// googletestframework@googlegroups.com if you need more.
+// When GTEST_HAS_VARIADIC_TEMPLATES is 0, Google Test supports at most
+// 50 arguments in Values, and at most 10 arguments in Combine.
+// Please contact googletestframework@googlegroups.com if you need more.
 // Please note that the number of arguments to Combine is limited
 // by the maximum arity of the implementation of tuple which is
-// currently set at 10.
+// currently set at 10.  The C++11 variadic implementation has
+// no such limits.
 
 #ifndef GTEST_INCLUDE_GTEST_INTERNAL_GTEST_PARAM_UTIL_GENERATED_H_
 #define GTEST_INCLUDE_GTEST_INTERNAL_GTEST_PARAM_UTIL_GENERATED_H_
@@ -51,6 +52,7 @@
 // inside #if GTEST_HAS_PARAM_TEST.
 #include "gtest/internal/gtest-param-util.h"
 #include "gtest/internal/gtest-port.h"
+#include "gtest/internal/gtest-type-util.h"
 
 #if GTEST_HAS_PARAM_TEST
 
@@ -72,6 +74,35 @@ internal::ParamGenerator<typename Container::value_type> ValuesIn(
 
 namespace internal {
 
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Used in the Values() function to provide polymorphic capabilities.
+template <typename... Ts>
+class ValueArray {
+ public:
+  explicit ValueArray(Ts... v) : v_(v...) {}
+
+  template <typename T>
+  operator ParamGenerator<T>() const {
+    return ValuesIn(MakeVector<T>(
+        typename MakeIndexSequence<sizeof...(Ts)>::type()));
+  }
+
+ private:
+  template <typename T, size_t... Is>
+  ::std::vector<T> MakeVector(IndexSequence<Is...>) const {
+    const T array[] = {static_cast<T>(::std::get<Is>(v_))...};
+    return ::std::vector<T>(array, array + sizeof...(Ts));
+  }
+
+  // No implementation - assignment is unsupported.
+  void operator=(const ValueArray& other);
+
+  const ::std::tuple<Ts...> v_;
+};
+
+# else  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // Used in the Values() function to provide polymorphic capabilities.
 template <typename T1>
 class ValueArray1 {
@@ -3149,7 +3180,164 @@ class ValueArray50 {
   const T50 v50_;
 };
 
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 # if GTEST_HAS_COMBINE
+#  if GTEST_HAS_VARIADIC_TEMPLATES
+// INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
+//
+// Generates values from the Cartesian product of values produced
+// by the argument generators.
+template <typename... Ts>
+class CartesianProductGenerator
+    : public ParamGeneratorInterface< ::testing::tuple<Ts...> > {
+ public:
+  typedef ::testing::tuple<Ts...> ParamType;
+
+  explicit CartesianProductGenerator(
+      const ::std::tuple<ParamGenerator<Ts>...>& generators)
+      : generators_(generators) {}
+  virtual ~CartesianProductGenerator() {}
+
+  virtual ParamIteratorInterface<ParamType>* Begin() const {
+    return new Iterator(this, generators_, false);
+  }
+  virtual ParamIteratorInterface<ParamType>* End() const {
+    return new Iterator(this, generators_, true);
+  }
+
+ private:
+  template <typename Indices>
+  class IteratorImpl;
+
+  template <size_t... Is>
+  class IteratorImpl<IndexSequence<Is...> >
+      : public ParamIteratorInterface<ParamType> {
+   public:
+    IteratorImpl(const ParamGeneratorInterface<ParamType>* base,
+                 const ::std::tuple<ParamGenerator<Ts>...>& generators,
+                 bool is_end)
+        : base_(base),
+          begin_(::std::get<Is>(generators).begin()...),
+          end_(::std::get<Is>(generators).end()...),
+          current_(is_end ? end_ : begin_) {
+      ComputeCurrentValue();
+    }
+    virtual ~IteratorImpl() {}
+
+    virtual const ParamGeneratorInterface<ParamType>* BaseGenerator() const {
+      return base_;
+    }
+    // Advance should not be called on beyond-of-range iterators
+    // so no component iterators must be beyond end of range, either.
+    virtual void Advance() {
+      assert(!AtEnd());
+      ++::std::get<sizeof...(Ts) - 1>(current_);
+      AdvanceIfEnd(SizeT<sizeof...(Ts) - 1>());
+      ComputeCurrentValue();
+    }
+    virtual ParamIteratorInterface<ParamType>* Clone() const {
+      return new IteratorImpl(*this);
+    }
+    virtual const ParamType* Current() const { return &current_value_; }
+    virtual bool Equals(const ParamIteratorInterface<ParamType>& other) const {
+      // Having the same base generator guarantees that the other
+      // iterator is of the same type and we can downcast.
+      GTEST_CHECK_(BaseGenerator() == other.BaseGenerator())
+          << "The program attempted to compare iterators "
+          << "from different generators." << std::endl;
+      const IteratorImpl* typed_other =
+          CheckedDowncastToActualType<const IteratorImpl>(&other);
+      // We must report iterators equal if they both point beyond their
+      // respective ranges. That can happen in a variety of fashions,
+      // so we have to consult AtEnd().
+      if (AtEnd() && typed_other->AtEnd())
+        return true;
+      bool same = true;
+      const bool dummy[] = {(same = same && ::std::get<Is>(current_) ==
+                                                ::std::get<Is>(
+                                                    typed_other->current_))...};
+      (void)dummy;
+      return same;
+    }
+
+   private:
+    template <size_t I>
+    struct SizeT {};
+
+    // When the I-th component iterator reaches the end of its range,
+    // rewinds it and carries over to the (I-1)-th one.
+    template <size_t I>
+    void AdvanceIfEnd(SizeT<I>) {
+      if (::std::get<I>(current_) == ::std::get<I>(end_)) {
+        ::std::get<I>(current_) = ::std::get<I>(begin_);
+        ++::std::get<I - 1>(current_);
+        AdvanceIfEnd(SizeT<I - 1>());
+      }
+    }
+    // The first component iterator has nothing to carry over to.
+    void AdvanceIfEnd(SizeT<0>) {}
+
+    void ComputeCurrentValue() {
+      if (!AtEnd())
+        current_value_ = ParamType(*::std::get<Is>(current_)...);
+    }
+    bool AtEnd() const {
+      // We must report iterator past the end of the range when either of the
+      // component iterators has reached the end of its range.
+      bool at_end = false;
+      const bool dummy[] = {(at_end = at_end || ::std::get<Is>(current_) ==
+                                                    ::std::get<Is>(end_))...};
+      (void)dummy;
+      return at_end;
+    }
+
+    // No implementation - assignment is unsupported.
+    void operator=(const IteratorImpl& other);
+
+    const ParamGeneratorInterface<ParamType>* const base_;
+    // begin_[i] and end_[i] define the i-th range that Iterator traverses.
+    // current_[i] is the actual traversing iterator.
+    const ::std::tuple<typename ParamGenerator<Ts>::iterator...> begin_;
+    const ::std::tuple<typename ParamGenerator<Ts>::iterator...> end_;
+    ::std::tuple<typename ParamGenerator<Ts>::iterator...> current_;
+
+    ParamType current_value_;
+  };  // class CartesianProductGenerator::IteratorImpl
+
+  typedef IteratorImpl<typename MakeIndexSequence<sizeof...(Ts)>::type>
+      Iterator;
+
+  // No implementation - assignment is unsupported.
+  void operator=(const CartesianProductGenerator& other);
+
+  const ::std::tuple<ParamGenerator<Ts>...> generators_;
+};  // class CartesianProductGenerator
+
+// INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
+//
+// Helper class providing Combine() with polymorphic features. It allows
+// casting CartesianProductGenerator<T...> to ParamGenerator<U...> if T is
+// convertible to U.
+template <class... Generators>
+class CartesianProductHolder {
+ public:
+  explicit CartesianProductHolder(const Generators&... g) : generators_(g...) {}
+  template <typename... Ts>
+  operator ParamGenerator< ::testing::tuple<Ts...> >() const {
+    return ParamGenerator< ::testing::tuple<Ts...> >(
+        new CartesianProductGenerator<Ts...>(
+            ::std::tuple<ParamGenerator<Ts>...>(generators_)));
+  }
+
+ private:
+  // No implementation - assignment is unsupported.
+  void operator=(const CartesianProductHolder& other);
+
+  const ::std::tuple<Generators...> generators_;
+};
+
+#  else  // GTEST_HAS_VARIADIC_TEMPLATES
 // INTERNAL IMPLEMENTATION - DO NOT USE IN USER CODE.
 //
 // Generates values from the Cartesian product of values produced
@@ -5133,6 +5321,7 @@ CartesianProductHolder10(const Generator1& g1, const Generator2& g2,
   const Generator10 g10_;
 };  // class CartesianProductHolder10
 
+#  endif  // GTEST_HAS_VARIADIC_TEMPLATES
 # endif  // GTEST_HAS_COMBINE
 
 }  // namespace internal
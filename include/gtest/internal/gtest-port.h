@@ -92,6 +92,9 @@
 //   GTEST_HAS_SEH            - Define it to 1/0 to indicate whether the
 //                              compiler supports Microsoft's "Structured
 //                              Exception Handling".
+//   GTEST_HAS_SSE2           - Define it to 1/0 to indicate whether Google
+//                              Test may use SSE2 intrinsics to speed up
+//                              comparing arrays and printing strings.
 //   GTEST_HAS_STREAM_REDIRECTION
 //                            - Define it to 1/0 to indicate whether the
 //                              platform supports I/O stream redirection using
@@ -100,6 +103,11 @@
 //                              Test's own tr1 tuple implementation should be
 //                              used.  Unused when the user sets
 //                              GTEST_HAS_TR1_TUPLE to 0.
+//   GTEST_HAS_VARIADIC_TEMPLATES
+//                            - Define it to 1/0 to indicate whether type
+//                              lists, Values(), and Combine() are implemented
+//                              with C++11 variadic templates instead of the
+//                              pump-generated fixed-arity versions.
 //   GTEST_LANG_CXX11         - Define it to 1/0 to indicate that Google Test
 //                              is building in C++11/C++98 mode.
 //   GTEST_LINKED_AS_SHARED_LIBRARY
@@ -196,6 +204,9 @@
 //   GTEST_AMBIGUOUS_ELSE_BLOCKER_ - for disabling a gcc warning.
 //   GTEST_ATTRIBUTE_UNUSED_  - declares that a class' instances or a
 //                              variable don't have to be used.
+//   GTEST_ATTRIBUTE_COLD_    - declares that a function is unlikely to be
+//                              called, e.g. because it only runs when an
+//                              assertion fails.
 //   GTEST_DISALLOW_ASSIGN_   - disables operator=.
 //   GTEST_DISALLOW_COPY_AND_ASSIGN_ - disables copy ctor and operator=.
 //   GTEST_MUST_USE_RESULT_   - declares that a function's result must be used.
@@ -430,6 +441,20 @@
 # endif
 #endif
 
+// Determines whether Google Test uses C++11 variadic templates to
+// implement Types<...>, Templates<...>, Values(...), and Combine(...).
+// The variadic versions have no arity limit and are much cheaper to
+// parse than the pump-generated TypesN/ValueArrayN/CartesianProductGeneratorN
+// families, which are still used in C++98 mode.  They rely on std::tuple,
+// so they are only enabled when it is available.
+#ifndef GTEST_HAS_VARIADIC_TEMPLATES
+# if GTEST_LANG_CXX11 && GTEST_HAS_STD_TUPLE_
+#  define GTEST_HAS_VARIADIC_TEMPLATES 1
+# else
+#  define GTEST_HAS_VARIADIC_TEMPLATES 0
+# endif
+#endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // Brings in definitions for functions used in the testing::internal::posix
 // namespace (read, write, close, chdir, isatty, stat). We do not currently
 // use them on Windows Mobile.
@@ -813,6 +838,17 @@ using ::std::tuple_size;
 # endif  // !GTEST_OS_WINDOWS_MOBILE && !GTEST_OS_SYMBIAN
 #endif  // GTEST_HAS_STREAM_REDIRECTION
 
+// Determines whether SSE2 intrinsics are available.  Every x86-64 CPU
+// has them.
+#ifndef GTEST_HAS_SSE2
+# if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define GTEST_HAS_SSE2 1
+# else
+#  define GTEST_HAS_SSE2 0
+# endif
+#endif  // GTEST_HAS_SSE2
+
 // Determines whether to support death tests.
 // Google Test does not support death tests for VC 7.1 and earlier as
 // abort() in a VC 7.1 application compiled as GUI in debug config
@@ -858,6 +894,12 @@ using ::std::tuple_size;
 # define GTEST_CAN_STREAM_RESULTS_ 1
 #endif
 
+// Determines whether the tests of a test case can run in child processes
+// forked after SetUpTestCase() (see Test::ForkEachTest()).
+#if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
+# define GTEST_CAN_FORK_TESTS_ 1
+#endif
+
 // Defines some utility macros.
 
 // The GNU compiler emits a warning if nested "if" statements are followed by
@@ -952,6 +994,12 @@ using ::std::tuple_size;
 
 #endif  // GTEST_HAS_SEH
 
+// Determines whether test events can be delivered to the listeners on a
+// background thread.
+#if GTEST_HAS_PTHREAD
+# define GTEST_CAN_DELIVER_EVENTS_ASYNC_ 1
+#endif
+
 #ifdef _MSC_VER
 
 # if GTEST_LINKED_AS_SHARED_LIBRARY
@@ -973,6 +1021,17 @@ using ::std::tuple_size;
 # define GTEST_NO_INLINE_
 #endif
 
+// Tells the compiler that a given function is rarely called.  gcc and
+// clang optimize such a function for size, move it away from the hot
+// code, and treat the branches leading to its calls as unlikely.  We
+// use it for the code that formats assertion failures, so that a
+// passing assertion only costs its comparison and a branch.
+#if defined(__clang__) || (defined(__GNUC__) && GTEST_GCC_VER_ >= 40300)
+# define GTEST_ATTRIBUTE_COLD_ __attribute__((cold))
+#else
+# define GTEST_ATTRIBUTE_COLD_
+#endif
+
 // _LIBCPP_VERSION is defined by the libc++ library from the LLVM project.
 #if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)
 # define GTEST_HAS_CXXABI_H_ 1
@@ -161,6 +161,10 @@ class GTEST_API_ String {
 // character in the buffer is replaced with "\\0".
 GTEST_API_ std::string StringStreamToString(::std::stringstream* stream);
 
+// Converts length characters starting at str to an std::string, replacing
+// each '\0' character with "\\0".
+GTEST_API_ std::string StringWithEscapedNuls(const char* str, size_t length);
+
 }  // namespace internal
 }  // namespace testing
 
@@ -36,10 +36,11 @@
 // Type utilities needed for implementing typed and type-parameterized
 // tests.  This file is generated by a SCRIPT.  DO NOT EDIT BY HAND!
 //
-// Currently we support at most 50 types in a list, and at most 50
-// type-parameterized tests in one type-parameterized test case.
-// Please contact googletestframework@googlegroups.com if you need
-// more.
+// When GTEST_HAS_VARIADIC_TEMPLATES is 0, we support at most 50 types
+// in a list, and at most 50 type-parameterized tests in one
+// type-parameterized test case.  Please contact
+// googletestframework@googlegroups.com if you need more.  The C++11
+// variadic implementation has no such limit.
 
 #ifndef GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPE_UTIL_H_
 #define GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPE_UTIL_H_
@@ -87,6 +88,43 @@ std::string GetTypeName() {
 # endif  // GTEST_HAS_RTTI
 }
 
+#if GTEST_HAS_VARIADIC_TEMPLATES
+
+// IndexSequence<I0, I1, ...> is a compile-time sequence of indices,
+// and MakeIndexSequence<N>::type is IndexSequence<0, 1, ..., N - 1>.
+// They stand in for C++14's std::index_sequence and are used to expand
+// tuples and type lists without recursion.
+template <size_t... Is>
+struct IndexSequence {
+  typedef IndexSequence type;
+};
+
+// Doubles the sequence IndexSequence<0, ..., sizeofT - 1> (and appends
+// one more index if plus_one is true).  Building the sequence this way
+// keeps the instantiation depth of MakeIndexSequence<N> at O(log N).
+template <bool plus_one, typename T, size_t sizeofT>
+struct DoubleSequence;
+
+template <size_t... Is, size_t sizeofT>
+struct DoubleSequence<true, IndexSequence<Is...>, sizeofT> {
+  typedef IndexSequence<Is..., (sizeofT + Is)..., 2 * sizeofT> type;
+};
+
+template <size_t... Is, size_t sizeofT>
+struct DoubleSequence<false, IndexSequence<Is...>, sizeofT> {
+  typedef IndexSequence<Is..., (sizeofT + Is)...> type;
+};
+
+template <size_t N>
+struct MakeIndexSequence
+    : DoubleSequence<N % 2 == 1, typename MakeIndexSequence<N / 2>::type,
+                     N / 2>::type {};
+
+template <>
+struct MakeIndexSequence<0> : IndexSequence<> {};
+
+#endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 #if GTEST_HAS_TYPED_TEST || GTEST_HAS_TYPED_TEST_P
 
 // AssertyTypeEq<T1, T2>::type is defined iff T1 and T2 are the same
@@ -101,6 +139,46 @@ struct AssertTypeEq<T, T> {
   typedef bool type;
 };
 
+// A type list is either the empty list Types0, or a struct with two
+// member types: Head for the first type in the list, and Tail for the
+// rest of the list.
+
+// The empty type list.
+struct Types0 {};
+
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// TypeSequence<T1, T2, ..., TN> represents a non-empty type list.
+// Besides Head and Tail, its types can be expanded directly as a
+// parameter pack, which lets TypeParameterizedTest register all of
+// them without recursing once per type.
+template <typename... Ts>
+struct TypeSequence;
+
+}  // namespace internal
+
+// Types<T1, ..., TN> translates to internal::TypeSequence<T1, ..., TN>,
+// and Types<> to internal::Types0.
+template <typename... Ts>
+struct Types {
+  typedef internal::TypeSequence<Ts...> type;
+};
+
+template <>
+struct Types<> {
+  typedef internal::Types0 type;
+};
+
+namespace internal {
+
+template <typename T1, typename... Ts>
+struct TypeSequence<T1, Ts...> {
+  typedef T1 Head;
+  typedef typename Types<Ts...>::type Tail;
+};
+
+# else  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // A unique type used as the default value for the arguments of class
 // template Types.  This allows us to simulate variadic templates
 // (e.g. Types<int>, Type<int, double>, and etc), which C++ doesn't
@@ -110,12 +188,6 @@ struct None {};
 // The following family of struct and struct templates are used to
 // represent type lists.  In particular, TypesN<T1, T2, ..., TN>
 // represents a type list with N types (T1, T2, ..., and TN) in it.
-// Except for Types0, every struct in the family has two member types:
-// Head for the first type in the list, and Tail for the rest of the
-// list.
-
-// The empty type list.
-struct Types0 {};
 
 // Type lists of length 1, 2, 3, and so on.
 
@@ -1619,6 +1691,8 @@ struct Types<T1, T2, T3, T4, T5, T6, T7, T8, T9, T10, T11, T12, T13, T14, T15,
 
 namespace internal {
 
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 # define GTEST_TEMPLATE_ template <typename T> class
 
 // The template "selector" struct TemplateSel<Tmpl> is used to
@@ -1640,6 +1714,55 @@ struct TemplateSel {
 # define GTEST_BIND_(TmplSel, T) \
   TmplSel::template Bind<T>::type
 
+// A template list is either the empty list Templates0, or a struct
+// with two member types: Head for the selector of the first template
+// in the list, and Tail for the rest of the list.
+
+// The empty template list.
+struct Templates0 {};
+
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// TemplateSequence<T1, T2, ..., TN> represents a non-empty template
+// list.  Like TypeSequence, its templates can also be expanded
+// directly as a parameter pack.
+template <GTEST_TEMPLATE_... Ts>
+struct TemplateSequence;
+
+// Templates<T1, ..., TN> translates to TemplateSequence<T1, ..., TN>,
+// and Templates<> to Templates0.
+template <GTEST_TEMPLATE_... Ts>
+struct Templates {
+  typedef TemplateSequence<Ts...> type;
+};
+
+template <>
+struct Templates<> {
+  typedef Templates0 type;
+};
+
+template <GTEST_TEMPLATE_ T1, GTEST_TEMPLATE_... Ts>
+struct TemplateSequence<T1, Ts...> {
+  typedef TemplateSel<T1> Head;
+  typedef typename Templates<Ts...>::type Tail;
+};
+
+// The TypeList template makes it possible to use either a single type
+// or a Types<...> list in TYPED_TEST_CASE() and
+// INSTANTIATE_TYPED_TEST_CASE_P().
+
+template <typename T>
+struct TypeList {
+  typedef TypeSequence<T> type;
+};
+
+template <typename... Ts>
+struct TypeList<Types<Ts...> > {
+  typedef typename Types<Ts...>::type type;
+};
+
+# else  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // A unique struct template used as the default value for the
 // arguments of class template Templates.  This allows us to simulate
 // variadic templates (e.g. Templates<int>, Templates<int, double>,
@@ -1649,13 +1772,7 @@ struct NoneT {};
 
 // The following family of struct and struct templates are used to
 // represent template lists.  In particular, TemplatesN<T1, T2, ...,
-// TN> represents a list of N templates (T1, T2, ..., and TN).  Except
-// for Templates0, every struct in the family has two member types:
-// Head for the selector of the first template in the list, and Tail
-// for the rest of the list.
-
-// The empty template list.
-struct Templates0 {};
+// TN> represents a list of N templates (T1, T2, ..., and TN).
 
 // Template lists of length 1, 2, 3, and so on.
 
@@ -3323,6 +3440,8 @@ struct TypeList<Types<T1, T2, T3, T4, T5, T6, T7, T8, T9, T10, T11, T12, T13,
       T41, T42, T43, T44, T45, T46, T47, T48, T49, T50>::type type;
 };
 
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 #endif  // GTEST_HAS_TYPED_TEST || GTEST_HAS_TYPED_TEST_P
 
 }  // namespace internal
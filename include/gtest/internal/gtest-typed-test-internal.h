@@ -0,0 +1,265 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This header file defines internal utilities needed for implementing
+// typed tests and type-parameterized tests.  They are subject to change
+// without notice.
+
+#ifndef GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPED_TEST_INTERNAL_H_
+#define GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPED_TEST_INTERNAL_H_
+
+#include <set>
+#include <string>
+
+#include "gtest/internal/gtest-internal.h"
+#include "gtest/internal/gtest-port.h"
+#include "gtest/internal/gtest-type-util.h"
+
+namespace testing {
+namespace internal {
+
+#if GTEST_HAS_TYPED_TEST || GTEST_HAS_TYPED_TEST_P
+
+// State of the definition of a type-parameterized test case.
+class GTEST_API_ TypedTestCasePState {
+ public:
+  TypedTestCasePState() : registered_(false) {}
+
+  // Adds the given test name to defined_test_names_ and return true
+  // if the test case hasn't been registered; otherwise aborts the
+  // program.
+  bool AddTestName(const char* file, int line, const char* case_name,
+                   const char* test_name) {
+    if (registered_) {
+      fprintf(stderr, "%s Test %s must be defined before "
+              "REGISTER_TYPED_TEST_CASE_P(%s, ...).\n",
+              FormatFileLocation(file, line).c_str(), test_name, case_name);
+      fflush(stderr);
+      posix::Abort();
+    }
+    defined_test_names_.insert(test_name);
+    return true;
+  }
+
+  // Verifies that registered_tests match the test names in
+  // defined_test_names_; returns registered_tests if successful, or
+  // aborts the program otherwise.
+  const char* VerifyRegisteredTestNames(
+      const char* file, int line, const char* registered_tests);
+
+ private:
+  bool registered_;
+  ::std::set<const char*> defined_test_names_;
+};
+
+// Skips to the first non-space char after the first comma in 'str';
+// returns NULL if no comma is found in 'str'.
+inline const char* SkipComma(const char* str) {
+  const char* comma = strchr(str, ',');
+  if (comma == NULL) {
+    return NULL;
+  }
+  while (IsSpace(*(++comma))) {}
+  return comma;
+}
+
+// Returns the prefix of 'str' before the first comma in it; returns
+// the entire string if it contains no comma.
+inline std::string GetPrefixUntilComma(const char* str) {
+  const char* comma = strchr(str, ',');
+  return comma == NULL ? str : std::string(str, comma);
+}
+
+// TypeParameterizedTest<Fixture, TestSel, Types>::Register()
+// registers a list of type-parameterized tests with Google Test.  The
+// return value is insignificant - we just need to return something
+// such that we can call this function in a namespace scope.
+//
+// Implementation note: The GTEST_TEMPLATE_ macro declares a template
+// template parameter.  It's defined in gtest-type-util.h.
+template <GTEST_TEMPLATE_ Fixture, class TestSel, typename Types>
+class TypeParameterizedTest {
+ public:
+  // 'index' is the index of the test in the type list 'Types'
+  // specified in INSTANTIATE_TYPED_TEST_CASE_P(Prefix, TestCase,
+  // Types).  Valid values for 'index' are [0, N - 1] where N is the
+  // length of Types.
+  static bool Register(const char* prefix, const char* case_name,
+                       const char* test_names, int index) {
+    typedef typename Types::Head Type;
+    typedef Fixture<Type> FixtureClass;
+    typedef typename GTEST_BIND_(TestSel, Type) TestClass;
+
+    // First, registers the first type-parameterized test in the type
+    // list.
+    MakeAndRegisterTestInfo(
+        (std::string(prefix) + (prefix[0] == '\0' ? "" : "/") + case_name + "/"
+         + StreamableToString(index)).c_str(),
+        StripTrailingSpaces(GetPrefixUntilComma(test_names)).c_str(),
+        GetTypeName<Type>().c_str(),
+        NULL,  // No value parameter.
+        GetTypeId<FixtureClass>(),
+        TestClass::SetUpTestCase,
+        TestClass::TearDownTestCase,
+        new TestFactoryImpl<TestClass>);
+
+    // Next, recurses (at compile time) with the tail of the type list.
+    return TypeParameterizedTest<Fixture, TestSel, typename Types::Tail>
+        ::Register(prefix, case_name, test_names, index + 1);
+  }
+};
+
+// The base case for the compile time recursion.
+template <GTEST_TEMPLATE_ Fixture, class TestSel>
+class TypeParameterizedTest<Fixture, TestSel, Types0> {
+ public:
+  static bool Register(const char* /*prefix*/, const char* /*case_name*/,
+                       const char* /*test_names*/, int /*index*/) {
+    return true;
+  }
+};
+
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// RegisterTypeParameterizedTest<Fixture, TestSel, Type>() registers
+// the type-parameterized test selected by TestSel for a single type.
+// It's the body of TypeParameterizedTest<...>::Register() without the
+// recursion, shared by all types in a TypeSequence.
+template <GTEST_TEMPLATE_ Fixture, class TestSel, typename Type>
+bool RegisterTypeParameterizedTest(const char* prefix, const char* case_name,
+                                   const char* test_names, int index) {
+  typedef Fixture<Type> FixtureClass;
+  typedef typename GTEST_BIND_(TestSel, Type) TestClass;
+
+  MakeAndRegisterTestInfo(
+      (std::string(prefix) + (prefix[0] == '\0' ? "" : "/") + case_name + "/"
+       + StreamableToString(index)).c_str(),
+      StripTrailingSpaces(GetPrefixUntilComma(test_names)).c_str(),
+      GetTypeName<Type>().c_str(),
+      NULL,  // No value parameter.
+      GetTypeId<FixtureClass>(),
+      TestClass::SetUpTestCase,
+      TestClass::TearDownTestCase,
+      new TestFactoryImpl<TestClass>);
+  return true;
+}
+
+template <GTEST_TEMPLATE_ Fixture, class TestSel, typename Types,
+          typename Indices>
+class TypeParameterizedTestImpl;
+
+template <GTEST_TEMPLATE_ Fixture, class TestSel, typename... Ts,
+          size_t... Is>
+class TypeParameterizedTestImpl<Fixture, TestSel, TypeSequence<Ts...>,
+                                IndexSequence<Is...> > {
+ public:
+  static bool Register(const char* prefix, const char* case_name,
+                       const char* test_names, int index) {
+    // The elements of a braced initializer list are evaluated in
+    // order, so the tests are registered in the order of the types.
+    const bool registered[] = {
+      RegisterTypeParameterizedTest<Fixture, TestSel, Ts>(
+          prefix, case_name, test_names, index + static_cast<int>(Is))...
+    };
+    return registered[0];
+  }
+};
+
+// With variadic type lists, all types are registered by a single pack
+// expansion instead of one nested instantiation per type, so the
+// length of the type list isn't bounded by the compiler's template
+// instantiation depth.
+template <GTEST_TEMPLATE_ Fixture, class TestSel, typename... Ts>
+class TypeParameterizedTest<Fixture, TestSel, TypeSequence<Ts...> >
+    : public TypeParameterizedTestImpl<
+          Fixture, TestSel, TypeSequence<Ts...>,
+          typename MakeIndexSequence<sizeof...(Ts)>::type> {};
+
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
+// TypeParameterizedTestCase<Fixture, Tests, Types>::Register()
+// registers *all combinations* of 'Tests' and 'Types' with Google
+// Test.  The return value is insignificant - we just need to return
+// something such that we can call this function in a namespace scope.
+template <GTEST_TEMPLATE_ Fixture, typename Tests, typename Types>
+class TypeParameterizedTestCase {
+ public:
+  static bool Register(const char* prefix, const char* case_name,
+                       const char* test_names) {
+    typedef typename Tests::Head Head;
+
+    // First, register the first test in 'Test' for each type in 'Types'.
+    TypeParameterizedTest<Fixture, Head, Types>::Register(
+        prefix, case_name, test_names, 0);
+
+    // Next, recurses (at compile time) with the tail of the test list.
+    return TypeParameterizedTestCase<Fixture, typename Tests::Tail, Types>
+        ::Register(prefix, case_name, SkipComma(test_names));
+  }
+};
+
+// The base case for the compile time recursion.
+template <GTEST_TEMPLATE_ Fixture, typename Types>
+class TypeParameterizedTestCase<Fixture, Templates0, Types> {
+ public:
+  static bool Register(const char* /*prefix*/, const char* /*case_name*/,
+                       const char* /*test_names*/) {
+    return true;
+  }
+};
+
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Registers all tests in a TemplateSequence with a single pack
+// expansion.  Each test consumes its own name from the front of
+// 'test_names' in turn.
+template <GTEST_TEMPLATE_ Fixture, GTEST_TEMPLATE_... Tests, typename Types>
+class TypeParameterizedTestCase<Fixture, TemplateSequence<Tests...>, Types> {
+ public:
+  static bool Register(const char* prefix, const char* case_name,
+                       const char* test_names) {
+    const bool registered[] = {
+      (TypeParameterizedTest<Fixture, TemplateSel<Tests>, Types>::Register(
+           prefix, case_name, test_names, 0),
+       test_names = SkipComma(test_names), true)...
+    };
+    return registered[0];
+  }
+};
+
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
+#endif  // GTEST_HAS_TYPED_TEST || GTEST_HAS_TYPED_TEST_P
+
+}  // namespace internal
+}  // namespace testing
+
+#endif  // GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPED_TEST_INTERNAL_H_
@@ -0,0 +1,421 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""compile_benchmark.py v0.2.0
+Measures how expensive Google Test's headers are to compile.
+
+SYNOPSIS
+       compile_benchmark.py [OPTIONS] SOURCE...
+
+       Compiles each SOURCE once per variant and prints, for every
+       (source, variant) pair, the number of lines after preprocessing,
+       the wall time of a syntax-only pass (parsing and template
+       instantiation), the wall time of a full compilation, and the size
+       of the resulting object file.  Times are the minimum over
+       --repeat runs.
+
+       A SOURCE of the form header:NAME stands for a translation unit
+       that does nothing but #include "NAME", which measures the cost
+       of parsing a header by itself.
+
+       A SOURCE of the form synthetic:KEY=VALUE,... stands for a
+       generated translation unit that includes gtest/gtest.h and
+       contains:
+
+         tests=N     N TESTs, each with the EXPECT_EQs below.
+         expects=M   M EXPECT_EQs per TEST, cycling through int, long,
+                     unsigned, double, bool, char, std::string,
+                     std::vector<int>, and a user-defined class.
+         types=K     a typed test case instantiated with K types.
+         combine=C   a value-parameterized test case instantiated with
+                     Combine() over C generators.
+
+       Omitted keys default to 0.  For example,
+       synthetic:tests=100,expects=10 measures 1000 assertions.
+
+OPTIONS
+       --cxx=COMPILER        the compiler to use (default: $CXX or c++).
+       --flags=FLAGS         flags passed to every compilation.
+       --variant=NAME:FLAGS  adds a variant compiled with the extra
+                             FLAGS.  May be repeated.  Without any
+                             --variant, a single variant named 'default'
+                             with no extra flags is measured.
+       --repeat=N            compiles each pair N times (default: 3).
+       --output=FILE         also writes the results to FILE as JSON.
+       --compare=FILE        compares the results with those in FILE, a
+                             JSON report written by --output, typically
+                             for another revision of Google Test.
+
+EXAMPLES
+       ./compile_benchmark.py --flags="-I../include" \\
+           --variant=fixed:-DGTEST_HAS_VARIADIC_TEMPLATES=0 \\
+           --variant=variadic:-DGTEST_HAS_VARIADIC_TEMPLATES=1 \\
+           header:gtest/gtest.h ../test/gtest_variadic_templates_benchmark.cc
+
+       ./compile_benchmark.py --flags="-I../include" --output=new.json \\
+           --compare=old.json synthetic:tests=100,expects=10,types=20
+"""
+
+import getopt
+import json
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+# Prefix of a SOURCE argument that names a header to be measured alone.
+HEADER_PREFIX = 'header:'
+
+# Prefix of a SOURCE argument that describes a generated translation unit.
+SYNTHETIC_PREFIX = 'synthetic:'
+
+# The keys of a synthetic:... SOURCE, in the order they are generated.
+SYNTHETIC_KEYS = ('tests', 'expects', 'types', 'combine')
+
+# The assertions a synthetic TEST cycles through; %(i)d is replaced by
+# the index of the assertion.
+SYNTHETIC_EXPECTS = (
+    'EXPECT_EQ(%(i)d, %(i)d);',
+    'EXPECT_EQ(%(i)dL, static_cast<long>(%(i)d));',
+    'EXPECT_EQ(%(i)du, static_cast<unsigned>(%(i)d));',
+    'EXPECT_EQ(%(i)d.5, %(i)d + 0.5);',
+    'EXPECT_EQ(true, %(i)d >= 0);',
+    'EXPECT_EQ(\'a\', static_cast<char>(\'a\' + %(i)d %% 1));',
+    'EXPECT_EQ(::std::string("s%(i)d"), "s%(i)d");',
+    'EXPECT_EQ(::std::vector<int>(%(i)d, 1), ::std::vector<int>(%(i)d, 1));',
+    'EXPECT_EQ(Point(%(i)d, 1), Point(%(i)d, 1));',
+)
+
+# The generators a synthetic Combine() cycles through, with the types of
+# the values they generate.
+SYNTHETIC_GENERATORS = (
+    ('int', '::testing::Values(1, 2)'),
+    ('bool', '::testing::Bool()'),
+    ('::std::string',
+     '::testing::Values(::std::string("a"), ::std::string("b"))'),
+    ('int', '::testing::Range(0, 3)'),
+)
+
+
+class Variant(object):
+  """A named set of extra compiler flags."""
+
+  def __init__(self, name, flags):
+    self.name = name
+    self.flags = flags
+
+
+def ParseVariant(spec):
+  """Parses a --variant=NAME:FLAGS argument."""
+
+  name, _, flags = spec.partition(':')
+  return Variant(name, shlex.split(flags))
+
+
+def ParseSyntheticSpec(spec):
+  """Parses the KEY=VALUE,... part of a synthetic:... SOURCE."""
+
+  params = dict((key, 0) for key in SYNTHETIC_KEYS)
+  for item in spec.split(','):
+    if not item:
+      continue
+    key, _, value = item.partition('=')
+    if key not in params:
+      raise ValueError('Unknown key %s in synthetic:%s' % (key, spec))
+    params[key] = int(value)
+  return params
+
+
+def GenerateSyntheticSource(params):
+  """Returns the text of a synthetic translation unit."""
+
+  lines = ['#include <string>',
+           '#include <vector>',
+           '',
+           '#include "gtest/gtest.h"',
+           '',
+           'namespace {',
+           '',
+           'struct Point {',
+           '  Point(int a_x, int a_y) : x(a_x), y(a_y) {}',
+           '  int x;',
+           '  int y;',
+           '};',
+           '',
+           'inline bool operator==(const Point& lhs, const Point& rhs) {',
+           '  return lhs.x == rhs.x && lhs.y == rhs.y;',
+           '}',
+           '',
+           'inline void PrintTo(const Point& p, ::std::ostream* os) {',
+           '  *os << "(" << p.x << ", " << p.y << ")";',
+           '}',
+           '']
+
+  for test in range(params['tests']):
+    lines.append('TEST(SyntheticTest, Test%d) {' % test)
+    for i in range(params['expects']):
+      expect = SYNTHETIC_EXPECTS[i % len(SYNTHETIC_EXPECTS)]
+      lines.append('  ' + expect % {'i': i})
+    lines.extend(['}', ''])
+
+  if params['types']:
+    types = ', '.join('Int<%d>' % i for i in range(params['types']))
+    lines.extend([
+        'template <int N>',
+        'struct Int {',
+        '  static int value() { return N; }',
+        '};',
+        '',
+        'template <typename T>',
+        'class SyntheticTypedTest : public ::testing::Test {};',
+        '',
+        'typedef ::testing::Types<%s> SyntheticTypes;' % types,
+        'TYPED_TEST_CASE(SyntheticTypedTest, SyntheticTypes);',
+        '',
+        'TYPED_TEST(SyntheticTypedTest, Works) {',
+        '  EXPECT_EQ(TypeParam::value(), TypeParam::value());',
+        '}',
+        ''])
+
+  if params['combine']:
+    generators = [SYNTHETIC_GENERATORS[i % len(SYNTHETIC_GENERATORS)]
+                  for i in range(params['combine'])]
+    lines.extend([
+        'typedef ::testing::tuple<%s> SyntheticParam;' %
+        ', '.join(t for t, _ in generators),
+        '',
+        'class SyntheticParamTest',
+        '    : public ::testing::TestWithParam<SyntheticParam> {};',
+        '',
+        'TEST_P(SyntheticParamTest, Works) {',
+        '  EXPECT_EQ(GetParam(), GetParam());',
+        '}',
+        '',
+        'INSTANTIATE_TEST_CASE_P(Synthetic, SyntheticParamTest,',
+        '                        ::testing::Combine(%s));' %
+        ',\n                                           '.join(
+            g for _, g in generators),
+        ''])
+
+  lines.extend(['}  // namespace', ''])
+  return '\n'.join(lines)
+
+
+def MaterializeSource(source, work_dir):
+  """Returns the path of a file to compile for the given SOURCE."""
+
+  if source.startswith(HEADER_PREFIX):
+    header = source[len(HEADER_PREFIX):]
+    text = '#include "%s"\n' % header
+    name = header
+  elif source.startswith(SYNTHETIC_PREFIX):
+    text = GenerateSyntheticSource(
+        ParseSyntheticSpec(source[len(SYNTHETIC_PREFIX):]))
+    name = source
+  else:
+    return os.path.abspath(source)
+  path = os.path.join(work_dir, ''.join(
+      c if c.isalnum() else '_' for c in name) + '.cc')
+  f = open(path, 'w')
+  f.write(text)
+  f.close()
+  return path
+
+
+def TimeCommand(command, repeat):
+  """Runs command repeat times; returns the fastest wall time in seconds."""
+
+  best = None
+  for _ in range(repeat):
+    start = time.time()
+    process = subprocess.Popen(command, stdout=subprocess.PIPE,
+                               stderr=subprocess.PIPE)
+    _, err = process.communicate()
+    elapsed = time.time() - start
+    if process.returncode != 0:
+      sys.stderr.write(err.decode('utf-8', 'replace'))
+      raise RuntimeError('Command failed: %s' % ' '.join(command))
+    if best is None or elapsed < best:
+      best = elapsed
+  return best
+
+
+def CountPreprocessedLines(command):
+  """Returns the number of non-blank lines the preprocessor outputs."""
+
+  output = subprocess.Popen(command, stdout=subprocess.PIPE).communicate()[0]
+  return len([line for line in output.splitlines()
+              if line.strip() and not line.startswith(b'#')])
+
+
+def Measure(cxx, flags, source_path, variant, work_dir, repeat):
+  """Measures one (source, variant) pair; returns a dict of results."""
+
+  base = [cxx] + flags + variant.flags
+  obj = os.path.join(work_dir, 'out.o')
+  result = {}
+  result['preprocessed_lines'] = CountPreprocessedLines(
+      base + ['-E', source_path])
+  result['parse_seconds'] = TimeCommand(
+      base + ['-fsyntax-only', source_path], repeat)
+  result['compile_seconds'] = TimeCommand(
+      base + ['-c', source_path, '-o', obj], repeat)
+  result['object_bytes'] = os.path.getsize(obj)
+  return result
+
+
+def PrintLines(lines):
+  """Prints a list of tuples of strings as an aligned text table."""
+
+  widths = [max(len(line[i]) for line in lines) for i in range(len(lines[0]))]
+  for line in lines:
+    print('  '.join(cell.ljust(width) for cell, width in zip(line, widths)))
+
+
+def PrintTable(rows):
+  """Prints the results as an aligned text table."""
+
+  lines = [('source', 'variant', 'pp lines', 'parse s', 'compile s',
+            'object KB')]
+  for row in rows:
+    lines.append((row['source'], row['variant'],
+                  str(row['preprocessed_lines']),
+                  '%.3f' % row['parse_seconds'],
+                  '%.3f' % row['compile_seconds'],
+                  '%.1f' % (row['object_bytes'] / 1024.0)))
+  PrintLines(lines)
+
+
+def FormatChange(old, new):
+  """Formats the relative change from old to new as a percentage."""
+
+  if not old:
+    return 'n/a'
+  return '%+.1f%%' % (100.0 * (new - old) / old)
+
+
+def PrintComparison(old_rows, new_rows):
+  """Prints how each (source, variant) pair changed between two runs."""
+
+  old_by_key = dict(((row['source'], row['variant']), row)
+                    for row in old_rows)
+  lines = [('source', 'variant', 'pp lines', 'parse s', 'compile s',
+            'object KB')]
+  for row in new_rows:
+    old = old_by_key.get((row['source'], row['variant']))
+    if old is None:
+      continue
+    lines.append((row['source'], row['variant']) + tuple(
+        FormatChange(old[key], row[key])
+        for key in ('preprocessed_lines', 'parse_seconds',
+                    'compile_seconds', 'object_bytes')))
+  print('')
+  print('Changes relative to the baseline:')
+  PrintLines(lines)
+
+
+def WriteReport(path, cxx, flags, repeat, rows):
+  """Writes the results to path as a JSON report."""
+
+  report = {'cxx': cxx, 'flags': flags, 'repeat': repeat, 'results': rows}
+  f = open(path, 'w')
+  json.dump(report, f, indent=2, separators=(',', ': '), sort_keys=True)
+  f.write('\n')
+  f.close()
+
+
+def ReadReport(path):
+  """Returns the results in a JSON report written by WriteReport()."""
+
+  f = open(path)
+  report = json.load(f)
+  f.close()
+  return report['results']
+
+
+def main():
+  try:
+    opts, sources = getopt.getopt(sys.argv[1:], '',
+                                  ['cxx=', 'flags=', 'variant=', 'repeat=',
+                                   'output=', 'compare='])
+  except getopt.GetoptError:
+    print(__doc__)
+    sys.exit(1)
+  if not sources:
+    print(__doc__)
+    sys.exit(1)
+
+  cxx = os.environ.get('CXX', 'c++')
+  flags = []
+  variants = []
+  repeat = 3
+  output = None
+  baseline = None
+  for opt, value in opts:
+    if opt == '--cxx':
+      cxx = value
+    elif opt == '--flags':
+      flags = shlex.split(value)
+    elif opt == '--variant':
+      variants.append(ParseVariant(value))
+    elif opt == '--repeat':
+      repeat = int(value)
+    elif opt == '--output':
+      output = value
+    elif opt == '--compare':
+      baseline = value
+  if not variants:
+    variants = [Variant('default', [])]
+
+  work_dir = tempfile.mkdtemp(prefix='gtest_compile_benchmark')
+  try:
+    rows = []
+    for source in sources:
+      source_path = MaterializeSource(source, work_dir)
+      for variant in variants:
+        row = Measure(cxx, flags, source_path, variant, work_dir, repeat)
+        row['source'] = source
+        row['variant'] = variant.name
+        rows.append(row)
+    PrintTable(rows)
+    if output:
+      WriteReport(output, cxx, flags, repeat, rows)
+    if baseline:
+      PrintComparison(ReadReport(baseline), rows)
+  finally:
+    shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+  main()
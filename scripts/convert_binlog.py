@@ -0,0 +1,611 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""convert_binlog.py v0.1.0
+Converts the binary logs of Google Test programs to other formats.
+
+SYNOPSIS
+       convert_binlog.py [--format=xml|console] [--output=FILE] BINLOG...
+
+       Reads the binary logs written by --gtest_output=binlog:BINLOG and
+       writes the XML report that --gtest_output=xml would have written,
+       or the text the default result printer would have printed.  The
+       logs are read in a single pass each, so that converting is fast
+       even for very large programs.
+
+       When several logs are given, typically one per test shard, they
+       are merged into one report: a test that ran in any shard is
+       reported with the result of that shard, the elapsed times of the
+       test cases add up, and the program is as long as the longest
+       shard.  For logs covering several iterations (--gtest_repeat),
+       only the last iteration is reported.
+
+       The format of the logs is described next to the class
+       BinlogUnitTestResultPrinter in src/gtest.cc.  A log that doesn't
+       follow it is rejected, except for a last record cut short by a
+       crash of the test program.
+
+OPTIONS
+       --format=FORMAT       xml (the default) or console.
+       --output=FILE         writes to FILE instead of stdout.
+
+EXAMPLES
+       ./convert_binlog.py --output=report.xml shard0.binlog shard1.binlog
+"""
+
+import getopt
+import sys
+import time
+
+# The record types.
+STRING_RECORD = 1
+ITERATION_START_RECORD = 2
+TEST_RECORD = 3
+TEST_CASE_START_RECORD = 4
+TEST_START_RECORD = 5
+TEST_PART_RESULT_RECORD = 6
+PROPERTY_RECORD = 7
+TEST_END_RECORD = 8
+TEST_CASE_END_RECORD = 9
+ITERATION_END_RECORD = 10
+
+# The flags of a test record.
+SHOULD_RUN_FLAG = 1
+DISABLED_FLAG = 2
+
+# The scopes of a property record.
+TEST_SCOPE = 0
+TEST_CASE_SCOPE = 1
+PROGRAM_SCOPE = 2
+
+# TestPartResult::kSuccess.
+SUCCESS = 0
+
+MAGIC = bytearray(b'GTBINLOG')
+FORMAT_VERSION = 1
+STACK_TRACE_MARKER = '\nStack trace:\n'
+
+
+class Properties(object):
+  """The key/value pairs recorded for a test, test case, or program."""
+
+  def __init__(self):
+    self.keys = []
+    self.values = {}
+
+  def Set(self, key, value):
+    if key not in self.values:
+      self.keys.append(key)
+    self.values[key] = value
+
+  def Update(self, other):
+    for key in other.keys:
+      self.Set(key, other.values[key])
+
+  def Items(self):
+    return [(key, self.values[key]) for key in self.keys]
+
+
+class Test(object):
+  """A test and its result."""
+
+  def __init__(self, test_case_name, name, value_param, type_param, flags):
+    self.test_case_name = test_case_name
+    self.name = name
+    self.value_param = value_param
+    self.type_param = type_param
+    self.should_run = bool(flags & SHOULD_RUN_FLAG)
+    self.is_disabled = bool(flags & DISABLED_FLAG)
+    self.elapsed = 0
+    self.parts = []  # (type, file, line, message) tuples.
+    self.properties = Properties()
+
+  def Failed(self):
+    for part in self.parts:
+      if part[0] != SUCCESS:
+        return True
+    return False
+
+
+class TestCase(object):
+  """A test case and the results of its tests."""
+
+  def __init__(self, name, type_param):
+    self.name = name
+    self.type_param = type_param
+    self.elapsed = 0
+    self.tests = []
+    self.test_indices = {}  # Maps the name of each test to its index.
+    self.properties = Properties()
+
+  def AddTest(self, test):
+    self.test_indices[test.name] = len(self.tests)
+    self.tests.append(test)
+
+  def TestsToRun(self):
+    return [test for test in self.tests if test.should_run]
+
+  def FailedTests(self):
+    return [test for test in self.tests if test.should_run and test.Failed()]
+
+  def DisabledTestCount(self):
+    return len([test for test in self.tests if test.is_disabled])
+
+
+class Report(object):
+  """The results of one iteration of a test program."""
+
+  def __init__(self, timestamp, random_seed):
+    self.timestamp = timestamp
+    self.random_seed = random_seed
+    self.elapsed = 0
+    self.test_cases = []
+    self.test_cases_by_name = {}
+    self.properties = Properties()
+
+  def GetTestCase(self, name, type_param):
+    test_case = self.test_cases_by_name.get(name)
+    if test_case is None:
+      test_case = TestCase(name, type_param)
+      self.test_cases_by_name[name] = test_case
+      self.test_cases.append(test_case)
+    return test_case
+
+  def Merge(self, other):
+    """Merges the report of another shard of the same program."""
+
+    self.timestamp = min(self.timestamp, other.timestamp)
+    self.elapsed = max(self.elapsed, other.elapsed)
+    self.properties.Update(other.properties)
+    for other_case in other.test_cases:
+      test_case = self.GetTestCase(other_case.name, other_case.type_param)
+      test_case.elapsed += other_case.elapsed
+      test_case.properties.Update(other_case.properties)
+      for other_test in other_case.tests:
+        index = test_case.test_indices.get(other_test.name)
+        if index is None:
+          test_case.AddTest(other_test)
+        elif other_test.should_run and not test_case.tests[index].should_run:
+          test_case.tests[index] = other_test
+
+  def TestCasesToRun(self):
+    return [test_case for test_case in self.test_cases
+            if test_case.TestsToRun()]
+
+  def TestsToRun(self):
+    return [test for test_case in self.test_cases
+            for test in test_case.TestsToRun()]
+
+  def FailedTests(self):
+    return [test for test_case in self.test_cases
+            for test in test_case.FailedTests()]
+
+  def DisabledTestCount(self):
+    return sum([test_case.DisabledTestCount()
+                for test_case in self.test_cases])
+
+
+def ReadVarint(data, pos):
+  """Reads the varint at data[pos]; returns it and the position after it."""
+
+  value = 0
+  shift = 0
+  while True:
+    byte = data[pos]
+    pos += 1
+    value |= (byte & 0x7F) << shift
+    shift += 7
+    if byte < 0x80:
+      return value, pos
+
+
+def ReadRecords(path):
+  """Yields (offset, type, fields) for the records of the log at path.
+
+  The offset is where the record starts in the log, and the fields are a
+  bytearray holding the record without its type.
+  """
+
+  f = open(path, 'rb')
+  try:
+    data = bytearray(f.read())
+  finally:
+    f.close()
+  if data[:len(MAGIC)] != MAGIC:
+    raise ValueError('%s is not a Google Test binary log' % path)
+  version, pos = ReadVarint(data, len(MAGIC))
+  if version != FORMAT_VERSION:
+    raise ValueError('%s has unsupported format version %d' % (path, version))
+
+  while pos < len(data):
+    # A process forked by a death test may have written the start of the
+    # log once more, which no record can start with.
+    if data[pos:pos + len(MAGIC)] == MAGIC:
+      raise ValueError('%s has a second header at offset %d' % (path, pos))
+    offset = pos
+    try:
+      length, pos = ReadVarint(data, pos)
+    except IndexError:
+      break  # The program crashed while writing the record.
+    if pos + length > len(data):
+      break  # Ditto.
+    if length == 0:
+      raise ValueError('%s has an empty record at offset %d' % (path, offset))
+    yield offset, data[pos], data[pos + 1:pos + length]
+    pos += length
+
+
+class FieldReader(object):
+  """Reads the fields of a record one after the other."""
+
+  def __init__(self, fields, strings):
+    self.fields = fields
+    self.strings = strings
+    self.pos = 0
+
+  def Number(self):
+    value, self.pos = ReadVarint(self.fields, self.pos)
+    return value
+
+  def String(self):
+    return self.strings[self.Number()]
+
+  def Text(self):
+    length = self.Number()
+    self.pos += length
+    if self.pos > len(self.fields):
+      raise IndexError('text past the end of the record')
+    return self.fields[self.pos - length:self.pos].decode('latin-1')
+
+  def AtEnd(self):
+    return self.pos == len(self.fields)
+
+
+def ReadReport(path):
+  """Returns the Report of the last iteration logged at path."""
+
+  # Strings are decoded as Latin-1, which maps each byte to the character
+  # of the same code, so that the output has the very bytes of the input.
+  strings = [None]
+  report = None
+  tests = []  # In the order of their test records.
+  test_case = None
+  test = None
+  for offset, record_type, fields in ReadRecords(path):
+    if record_type == STRING_RECORD:
+      strings.append(fields.decode('latin-1'))
+      continue
+
+    # A record of an unknown type, that refers to something the log
+    # hasn't introduced, or whose fields don't add up to its length, is
+    # malformed.  New record types come with a new format version.
+    reader = FieldReader(fields, strings)
+    well_formed = False
+    try:
+      if record_type == ITERATION_START_RECORD:
+        reader.Number()  # The iteration.
+        report = Report(reader.Number(), reader.Number())
+        tests = []
+      elif record_type == TEST_RECORD:
+        test_case_name = reader.String()
+        name = reader.Text()
+        value_param = reader.String()
+        type_param = reader.String()
+        tests.append(Test(test_case_name, name, value_param, type_param,
+                          reader.Number()))
+        report.GetTestCase(test_case_name, type_param).AddTest(tests[-1])
+      elif record_type == TEST_CASE_START_RECORD:
+        test_case = report.test_cases_by_name[reader.String()]
+      elif record_type == TEST_START_RECORD:
+        test = tests[reader.Number()]
+      elif record_type == TEST_PART_RESULT_RECORD:
+        part = (reader.Number(), reader.String(), reader.Number() - 1,
+                reader.Text())
+        # Failures outside of tests, e.g. in SetUpTestCase(), are not in
+        # the report.
+        if test is not None:
+          test.parts.append(part)
+      elif record_type == PROPERTY_RECORD:
+        scope = reader.Number()
+        key = reader.String()
+        value = reader.Text()
+        if scope == TEST_SCOPE:
+          test.properties.Set(key, value)
+        elif scope == TEST_CASE_SCOPE:
+          test_case.properties.Set(key, value)
+        else:
+          report.properties.Set(key, value)
+      elif record_type == TEST_END_RECORD:
+        test.elapsed = reader.Number()
+        test = None
+      elif record_type == TEST_CASE_END_RECORD:
+        test_case.elapsed = reader.Number()
+        test_case = None
+      elif record_type == ITERATION_END_RECORD:
+        report.elapsed = reader.Number()
+      else:
+        raise KeyError(record_type)
+      well_formed = reader.AtEnd()
+    except (AttributeError, IndexError, KeyError):
+      pass
+    if not well_formed:
+      raise ValueError('%s has a malformed record at offset %d' %
+                       (path, offset))
+  if report is None:
+    raise ValueError('%s holds no test iteration' % path)
+  return report
+
+
+def FormatCountableNoun(count, singular_form, plural_form):
+  return '%d %s' % (count, count == 1 and singular_form or plural_form)
+
+
+def FormatTestCount(count):
+  return FormatCountableNoun(count, 'test', 'tests')
+
+
+def FormatTestCaseCount(count):
+  return FormatCountableNoun(count, 'test case', 'test cases')
+
+
+def FormatSeconds(millis):
+  """Formats a time like FormatTimeInMillisAsSeconds() does."""
+
+  return '%g' % (millis * 1e-3)
+
+
+def FormatTimestamp(millis):
+  """Formats a timestamp like FormatEpochTimeInMillisAsIso8601() does."""
+
+  return time.strftime('%Y-%m-%dT%H:%M:%S', time.localtime(millis // 1000))
+
+
+def FormatLocation(file_name, line):
+  """Formats a location like FormatCompilerIndependentFileLocation()."""
+
+  if file_name is None:
+    file_name = 'unknown file'
+  if line < 0:
+    return file_name
+  return '%s:%d' % (file_name, line)
+
+
+def IsValidXmlCharacter(ch):
+  # Like in Google Test on platforms where char is signed, the bytes
+  # above 0x7F are invalid.
+  return ch in '\t\n\r' or ' ' <= ch <= '\x7f'
+
+
+XML_TEXT_ESCAPES = {'<': '&lt;', '>': '&gt;', '&': '&amp;'}
+XML_ATTRIBUTE_ESCAPES = {'<': '&lt;', '>': '&gt;', '&': '&amp;',
+                         "'": '&apos;', '"': '&quot;', '\t': '&#x09;',
+                         '\n': '&#x0A;', '\r': '&#x0D;'}
+
+
+def EscapeXmlAttribute(text):
+  return ''.join([XML_ATTRIBUTE_ESCAPES.get(ch, ch) for ch in text
+                  if IsValidXmlCharacter(ch)])
+
+
+def XmlCDataSection(text):
+  text = ''.join([ch for ch in text if IsValidXmlCharacter(ch)])
+  return '<![CDATA[%s]]>' % text.replace(']]>', ']]>]]&gt;<![CDATA[')
+
+
+def XmlAttributes(pairs):
+  return ''.join([' %s="%s"' % (name, EscapeXmlAttribute(value))
+                  for name, value in pairs])
+
+
+def WriteXml(report, out):
+  """Writes report as --gtest_output=xml does."""
+
+  failed_tests = report.FailedTests()
+  attributes = [('tests', str(sum([len(test_case.tests)
+                                   for test_case in report.test_cases]))),
+                ('failures', str(len(failed_tests))),
+                ('disabled', str(report.DisabledTestCount())),
+                ('errors', '0'),
+                ('timestamp', FormatTimestamp(report.timestamp)),
+                ('time', FormatSeconds(report.elapsed))]
+  if report.random_seed:
+    attributes.append(('random_seed', str(report.random_seed)))
+  attributes += report.properties.Items()
+  attributes.append(('name', 'AllTests'))
+  out.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+  out.write('<testsuites%s>\n' % XmlAttributes(attributes))
+
+  for test_case in report.test_cases:
+    attributes = [('name', test_case.name),
+                  ('tests', str(len(test_case.tests))),
+                  ('failures', str(len(test_case.FailedTests()))),
+                  ('disabled', str(test_case.DisabledTestCount())),
+                  ('errors', '0'),
+                  ('time', FormatSeconds(test_case.elapsed))]
+    attributes += test_case.properties.Items()
+    out.write('  <testsuite%s>\n' % XmlAttributes(attributes))
+
+    for test in test_case.tests:
+      attributes = [('name', test.name)]
+      if test.value_param is not None:
+        attributes.append(('value_param', test.value_param))
+      if test.type_param is not None:
+        attributes.append(('type_param', test.type_param))
+      attributes += [('status', test.should_run and 'run' or 'notrun'),
+                     ('time', FormatSeconds(test.elapsed)),
+                     ('classname', test_case.name)]
+      attributes += test.properties.Items()
+      out.write('    <testcase%s' % XmlAttributes(attributes))
+
+      failures = [part for part in test.parts if part[0] != SUCCESS]
+      if not failures:
+        out.write(' />\n')
+        continue
+      out.write('>\n')
+      for _, file_name, line, message in failures:
+        location = FormatLocation(file_name, line)
+        summary = message.split(STACK_TRACE_MARKER)[0]
+        out.write('      <failure message="%s" type="">%s</failure>\n' %
+                  (EscapeXmlAttribute(location + '\n' + summary),
+                   XmlCDataSection(location + '\n' + message)))
+      out.write('    </testcase>\n')
+    out.write('  </testsuite>\n')
+  out.write('</testsuites>\n')
+
+
+def FormatTestComment(test):
+  """Formats the parameters of a test like PrintFullTestCommentIfPresent()."""
+
+  comments = []
+  if test.type_param is not None:
+    comments.append('TypeParam = %s' % test.type_param)
+  if test.value_param is not None:
+    comments.append('GetParam() = %s' % test.value_param)
+  if not comments:
+    return ''
+  return ', where ' + ' and '.join(comments)
+
+
+def WriteConsole(report, out):
+  """Writes report as the default result printer prints it, uncolored."""
+
+  test_cases = report.TestCasesToRun()
+  test_count = len(report.TestsToRun())
+  out.write('[==========] Running %s from %s.\n' %
+            (FormatTestCount(test_count), FormatTestCaseCount(len(test_cases))))
+  out.write('[----------] Global test environment set-up.\n')
+
+  for test_case in test_cases:
+    counts = FormatCountableNoun(len(test_case.TestsToRun()), 'test', 'tests')
+    out.write('[----------] %s from %s' % (counts, test_case.name))
+    if test_case.type_param is None:
+      out.write('\n')
+    else:
+      out.write(', where TypeParam = %s\n' % test_case.type_param)
+
+    for test in test_case.TestsToRun():
+      out.write('[ RUN      ] %s.%s\n' % (test_case.name, test.name))
+      for part_type, file_name, line, message in test.parts:
+        if part_type == SUCCESS:
+          continue
+        if file_name is None:
+          file_name = 'unknown file'
+        if line < 0:
+          location = file_name + ':'
+        else:
+          location = '%s:%d:' % (file_name, line)
+        out.write('%s Failure\n%s\n' % (location, message))
+      if test.Failed():
+        out.write('[  FAILED  ] %s.%s%s' %
+                  (test_case.name, test.name, FormatTestComment(test)))
+      else:
+        out.write('[       OK ] %s.%s' % (test_case.name, test.name))
+      out.write(' (%d ms)\n' % test.elapsed)
+    out.write('[----------] %s from %s (%d ms total)\n\n' %
+              (counts, test_case.name, test_case.elapsed))
+
+  out.write('[----------] Global test environment tear-down\n')
+  out.write('[==========] %s from %s ran. (%d ms total)\n' %
+            (FormatTestCount(test_count), FormatTestCaseCount(len(test_cases)),
+             report.elapsed))
+  failed_tests = report.FailedTests()
+  out.write('[  PASSED  ] %s.\n' %
+            FormatTestCount(test_count - len(failed_tests)))
+  if failed_tests:
+    out.write('[  FAILED  ] %s, listed below:\n' %
+              FormatTestCount(len(failed_tests)))
+    for test in failed_tests:
+      out.write('[  FAILED  ] %s.%s%s\n' %
+                (test.test_case_name, test.name, FormatTestComment(test)))
+    out.write('\n%2d FAILED %s\n' %
+              (len(failed_tests), len(failed_tests) == 1 and 'TEST' or 'TESTS'))
+
+  # Disabled tests that ran mean --gtest_also_run_disabled_tests was
+  # given, which hides the reminder.
+  disabled_count = report.DisabledTestCount()
+  ran_disabled = [test for test in report.TestsToRun() if test.is_disabled]
+  if disabled_count and not ran_disabled:
+    if not failed_tests:
+      out.write('\n')
+    out.write('  YOU HAVE %d DISABLED %s\n\n' %
+              (disabled_count, disabled_count == 1 and 'TEST' or 'TESTS'))
+
+
+class Latin1Writer(object):
+  """Writes text to a binary file, one byte per character."""
+
+  def __init__(self, binary_file):
+    self.binary_file = binary_file
+
+  def write(self, text):
+    self.binary_file.write(text.encode('latin-1'))
+
+
+def main():
+  try:
+    opts, paths = getopt.getopt(sys.argv[1:], '', ['format=', 'output='])
+  except getopt.GetoptError:
+    print(__doc__)
+    sys.exit(1)
+
+  output_format = 'xml'
+  output = None
+  for opt, value in opts:
+    if opt == '--format':
+      output_format = value
+    elif opt == '--output':
+      output = value
+  if output_format not in ('xml', 'console') or not paths:
+    print(__doc__)
+    sys.exit(1)
+
+  try:
+    report = ReadReport(paths[0])
+    for path in paths[1:]:
+      report.Merge(ReadReport(path))
+  except ValueError:
+    sys.stderr.write('%s\n' % sys.exc_info()[1])
+    sys.exit(1)
+
+  if output:
+    binary_file = open(output, 'wb')
+  else:
+    binary_file = getattr(sys.stdout, 'buffer', sys.stdout)
+  if output_format == 'xml':
+    WriteXml(report, Latin1Writer(binary_file))
+  else:
+    WriteConsole(report, Latin1Writer(binary_file))
+  if output:
+    binary_file.close()
+
+
+if __name__ == '__main__':
+  main()
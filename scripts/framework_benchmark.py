@@ -0,0 +1,174 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""framework_benchmark.py v0.1.0
+Measures the overhead of Google Test itself.
+
+SYNOPSIS
+       framework_benchmark.py --binary=PATH [OPTIONS] BENCHMARK:N...
+
+       Runs PATH, which must be test/gtest_framework_benchmark_.cc built
+       against the Google Test to measure, once per BENCHMARK:N pair and
+       repetition, and prints the average cost of one unit of work
+       (a test or an assertion) in nanoseconds.  The number reported for
+       a pair is the minimum over --repeat runs, which is much more stable
+       than the mean on a busy machine.
+
+       See test/gtest_framework_benchmark_.cc for the list of benchmarks.
+
+OPTIONS
+       --binary=PATH         the benchmark program to run.
+       --threads=T           the number of threads used by the contention
+                             benchmark (default: 4).
+       --repeat=N            runs each pair N times (default: 3).
+       --output=FILE         also writes the results to FILE as JSON.
+       --compare=FILE        compares the results with those in FILE, a
+                             JSON report written by --output, typically
+                             for another revision of Google Test.
+
+EXAMPLES
+       ./framework_benchmark.py --binary=gtest_framework_benchmark_ \\
+           --output=new.json --compare=old.json \\
+           register:100000 run:100000 expect_pass:10000000
+"""
+
+import getopt
+import json
+import subprocess
+import sys
+
+from compile_benchmark import FormatChange
+from compile_benchmark import PrintLines
+
+
+def RunOnce(binary, benchmark, n, threads):
+  """Runs one benchmark; returns (nanoseconds per unit, unit)."""
+
+  command = [binary, '--benchmark=%s' % benchmark, '--n=%d' % n,
+             '--threads=%d' % threads]
+  process = subprocess.Popen(command, stdout=subprocess.PIPE,
+                             stderr=subprocess.PIPE)
+  out, err = process.communicate()
+  if process.returncode != 0:
+    sys.stderr.write(err.decode('utf-8', 'replace'))
+    raise RuntimeError('Command failed: %s' % ' '.join(command))
+  # The output is a single line: NAME N VALUE ns/UNIT.
+  fields = out.decode('utf-8').split()
+  return float(fields[2]), fields[3].split('/')[1]
+
+
+def Measure(binary, benchmark, n, threads, repeat):
+  """Measures one BENCHMARK:N pair; returns a dict of results."""
+
+  best = None
+  for _ in range(repeat):
+    nanos, unit = RunOnce(binary, benchmark, n, threads)
+    if best is None or nanos < best:
+      best = nanos
+  return {'benchmark': benchmark, 'n': n, 'nanos': best, 'unit': unit}
+
+
+def PrintTable(rows):
+  """Prints the results as an aligned text table."""
+
+  lines = [('benchmark', 'n', 'ns', 'per')]
+  for row in rows:
+    lines.append((row['benchmark'], str(row['n']), '%.1f' % row['nanos'],
+                  row['unit']))
+  PrintLines(lines)
+
+
+def PrintComparison(old_rows, new_rows):
+  """Prints how each BENCHMARK:N pair changed between two runs."""
+
+  old_by_key = dict(((row['benchmark'], row['n']), row) for row in old_rows)
+  lines = [('benchmark', 'n', 'ns')]
+  for row in new_rows:
+    old = old_by_key.get((row['benchmark'], row['n']))
+    if old is not None:
+      lines.append((row['benchmark'], str(row['n']),
+                    FormatChange(old['nanos'], row['nanos'])))
+  print('')
+  print('Changes relative to the baseline:')
+  PrintLines(lines)
+
+
+def main():
+  try:
+    opts, benchmarks = getopt.getopt(sys.argv[1:], '',
+                                     ['binary=', 'threads=', 'repeat=',
+                                      'output=', 'compare='])
+  except getopt.GetoptError:
+    print(__doc__)
+    sys.exit(1)
+
+  binary = None
+  threads = 4
+  repeat = 3
+  output = None
+  baseline = None
+  for opt, value in opts:
+    if opt == '--binary':
+      binary = value
+    elif opt == '--threads':
+      threads = int(value)
+    elif opt == '--repeat':
+      repeat = int(value)
+    elif opt == '--output':
+      output = value
+    elif opt == '--compare':
+      baseline = value
+  if not binary or not benchmarks:
+    print(__doc__)
+    sys.exit(1)
+
+  rows = []
+  for spec in benchmarks:
+    benchmark, _, n = spec.partition(':')
+    rows.append(Measure(binary, benchmark, int(n), threads, repeat))
+  PrintTable(rows)
+
+  if output:
+    f = open(output, 'w')
+    json.dump({'binary': binary, 'threads': threads, 'repeat': repeat,
+               'results': rows},
+              f, indent=2, separators=(',', ': '), sort_keys=True)
+    f.write('\n')
+    f.close()
+  if baseline:
+    f = open(baseline)
+    old_rows = json.load(f)['results']
+    f.close()
+    PrintComparison(old_rows, rows)
+
+
+if __name__ == '__main__':
+  main()
@@ -40,6 +40,7 @@
 
 // The following lines pull in the real gtest *.cc files.
 #include "src/gtest.cc"
+#include "src/gtest-array.cc"
 #include "src/gtest-death-test.cc"
 #include "src/gtest-filepath.cc"
 #include "src/gtest-port.cc"
@@ -0,0 +1,775 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This file implements the assertions on arrays and containers that
+// don't need to be templates: the floating-point comparisons and the
+// failure messages.
+
+#include "gtest/gtest-array.h"
+
+#include <math.h>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+// The floating-point comparisons are vectorized with SSE2 where it's
+// available.
+#if GTEST_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
+namespace testing {
+namespace internal {
+
+// The number of equal elements printed on each side of a range of
+// differing elements.
+static const size_t kArrayContextElements = 2;
+
+// The maximum number of differing elements printed for one range.
+static const size_t kMaxPrintedRangeElements = 8;
+
+// Returns "expression (which is value)", or just value if the expression
+// is a literal that reads the same.
+static std::string DescribeValue(const char* expression,
+                                 const std::string& value) {
+  if (expression == NULL || value == expression)
+    return value;
+  return std::string(expression) + " (which is " + value + ")";
+}
+
+// Prints { a[begin], ..., a[end - 1] }.
+static void PrintArraySlice(const void* array, ArrayElementPrinter print,
+                            size_t begin, size_t end, ::std::ostream* os) {
+  *os << "{ ";
+  for (size_t i = begin; i != end; ++i) {
+    if (i != begin) *os << ", ";
+    print(array, i, os);
+  }
+  *os << " }";
+}
+
+// Builds the failure message of {ASSERT|EXPECT}_ARRAY_EQ and
+// {ASSERT|EXPECT}_CONTAINER_EQ.  For example:
+//
+//   Value of: actual
+//   Expected: expected
+//   3 of n (which is 1000) elements differ, in 2 ranges.
+//   Elements [10, 12) differ; showing [8, 14):
+//     Expected: { 8, 9, 10, 11, 12, 13 }
+//       Actual: { 8, 9, 5, 6, 12, 13 }
+//   Element 500 differs; showing [498, 503):
+//     Expected: { 498, 499, 500, 501, 502 }
+//       Actual: { 498, 499, 0, 501, 502 }
+AssertionResult ArrayEQFailure(const char* expected_expression,
+                               const char* actual_expression,
+                               const char* size_expression,
+                               size_t size,
+                               const ArrayMismatches& mismatches,
+                               const void* expected,
+                               ArrayElementPrinter print_expected,
+                               const void* actual,
+                               ArrayElementPrinter print_actual) {
+  ::std::stringstream ss;
+  ss << "Value of: " << actual_expression
+     << "\nExpected: " << expected_expression << "\n"
+     << mismatches.count << " of "
+     << DescribeValue(size_expression, StreamableToString(size))
+     << " elements " << (mismatches.count == 1 ? "differs" : "differ")
+     << ", in " << mismatches.num_ranges
+     << (mismatches.num_ranges == 1 ? " range." : " ranges.");
+
+  const size_t max_reported_ranges = ArrayMismatches::kMaxReportedRanges;
+  const size_t reported_ranges = mismatches.num_ranges < max_reported_ranges ?
+      mismatches.num_ranges : max_reported_ranges;
+  for (size_t r = 0; r != reported_ranges; ++r) {
+    const size_t begin = mismatches.range_begin[r];
+    const size_t end = mismatches.range_end[r];
+    const size_t printed_end = end - begin > kMaxPrintedRangeElements ?
+        begin + kMaxPrintedRangeElements : end;
+    const size_t window_begin = begin > kArrayContextElements ?
+        begin - kArrayContextElements : 0;
+    const size_t window_end = size - printed_end > kArrayContextElements ?
+        printed_end + kArrayContextElements : size;
+
+    if (end - begin == 1) {
+      ss << "\nElement " << begin << " differs";
+    } else {
+      ss << "\nElements [" << begin << ", " << end << ") differ";
+    }
+    ss << "; showing [" << window_begin << ", " << window_end << "):"
+       << "\n  Expected: ";
+    PrintArraySlice(expected, print_expected, window_begin, window_end, &ss);
+    ss << "\n    Actual: ";
+    PrintArraySlice(actual, print_actual, window_begin, window_end, &ss);
+  }
+  if (mismatches.num_ranges > reported_ranges) {
+    ss << "\n(" << mismatches.num_ranges - reported_ranges
+       << " more ranges of differing elements not shown)";
+  }
+  return AssertionFailure() << ss.str();
+}
+
+// Reports that the containers compared by {ASSERT|EXPECT}_CONTAINER_EQ
+// have different sizes.
+AssertionResult ContainerSizeEQFailure(const char* expected_expression,
+                                       const char* actual_expression,
+                                       size_t expected_size,
+                                       size_t actual_size) {
+  return AssertionFailure()
+      << "Value of: " << actual_expression
+      << "\nExpected: " << expected_expression
+      << "\nThey have different sizes: " << expected_size
+      << " elements are expected, but there are " << actual_size << ".";
+}
+
+namespace {
+
+// The number of histogram buckets that have an upper bound.  The
+// vectorized loops below assume there are 6.
+const int kNumBucketLimits = FloatingPointArrayErrors::kNumBuckets - 2;
+
+// The index of the bucket limit that is the tolerance itself.
+const int kToleranceBucketLimit = 3;
+
+// Accumulates the differences between the elements of two arrays, where
+// Error is the type in which a difference is measured.
+template <typename Error>
+struct ErrorTally {
+  ErrorTally() : nans(0), worst_index(0), max_error(0) {
+    for (int k = 0; k != kNumBucketLimits; ++k)
+      above[k] = 0;
+  }
+
+  // Adds the difference at the given index.  Differences involving a NaN
+  // must be passed as the largest Error there is.
+  void Add(size_t index, Error error, bool is_nan, const Error* limits) {
+    if (error > max_error) {
+      max_error = error;
+      worst_index = index;
+    }
+    for (int k = 0; k != kNumBucketLimits; ++k)
+      above[k] += is_nan || error > limits[k];
+    nans += is_nan;
+  }
+
+  // above[k] is the number of differences that are greater than
+  // limits[k], or involve a NaN.
+  size_t above[kNumBucketLimits];
+  size_t nans;
+  size_t worst_index;
+  Error max_error;
+};
+
+// Fills *errors from a tally of size differences.
+template <typename Error>
+void SummarizeErrors(const ErrorTally<Error>& tally, size_t size,
+                     const Error* limits, double max_error,
+                     FloatingPointArrayErrors* errors) {
+  errors->num_failures = tally.above[kToleranceBucketLimit];
+  errors->worst_index = tally.worst_index;
+  errors->max_error = max_error;
+  errors->histogram[0] = size - tally.above[0];
+  for (int k = 0; k != kNumBucketLimits; ++k) {
+    errors->bucket_limits[k] = static_cast<double>(limits[k]);
+    if (k + 1 != kNumBucketLimits)
+      errors->histogram[k + 1] = tally.above[k] - tally.above[k + 1];
+  }
+  errors->histogram[kNumBucketLimits] =
+      tally.above[kNumBucketLimits - 1] - tally.nans;
+  errors->histogram[kNumBucketLimits + 1] = tally.nans;
+}
+
+// Returns tolerance * factor, or max if that's greater.
+UInt64 ScaleUlps(UInt64 tolerance, UInt64 factor, UInt64 max) {
+  return tolerance <= max / factor ? tolerance * factor : max;
+}
+
+// Computes the bucket limits for a tolerance of max_ulps, keeping them
+// below nan_distance, the distance that stands for a NaN.
+void GetUlpBucketLimits(UInt64 max_ulps, UInt64 nan_distance,
+                        UInt64* limits) {
+  const UInt64 max_limit = nan_distance - 1;
+  const UInt64 tolerance = max_ulps < max_limit ? max_ulps : max_limit;
+  limits[0] = 0;
+  limits[1] = tolerance / 4;
+  limits[2] = tolerance / 2;
+  limits[3] = tolerance;
+  limits[4] = ScaleUlps(tolerance, 4, max_limit);
+  limits[5] = ScaleUlps(tolerance, 64, max_limit);
+}
+
+void GetAbsBucketLimits(double abs_error, double* limits) {
+  limits[0] = 0;
+  limits[1] = abs_error / 4;
+  limits[2] = abs_error / 2;
+  limits[3] = abs_error;
+  limits[4] = abs_error * 4;
+  limits[5] = abs_error * 64;
+}
+
+// Converts a floating-point number in sign-and-magnitude representation
+// to the biased representation, in which the order of the numbers is
+// the order of their bits as unsigned integers.  See FloatingPoint.
+template <typename Bits>
+Bits SignAndMagnitudeToBiased(Bits sam, Bits sign_bit) {
+  return (sam & sign_bit) ? ~sam + 1 : sam | sign_bit;
+}
+
+// Returns the distance that stands for a NaN in UlpDistance<RawType>().
+template <typename RawType>
+UInt64 NanUlpDistance() {
+  return static_cast<typename FloatingPoint<RawType>::Bits>(~0);
+}
+
+// Returns the number of ULPs between two numbers, or NanUlpDistance()
+// if either is a NaN.  No two other numbers are that far apart.
+template <typename RawType>
+UInt64 UlpDistance(RawType expected, RawType actual) {
+  typedef FloatingPoint<RawType> FP;
+  typedef typename FP::Bits Bits;
+  const FP lhs(expected);
+  const FP rhs(actual);
+  if (lhs.is_nan() || rhs.is_nan())
+    return NanUlpDistance<RawType>();
+  const Bits biased1 = SignAndMagnitudeToBiased(lhs.bits(), FP::kSignBitMask);
+  const Bits biased2 = SignAndMagnitudeToBiased(rhs.bits(), FP::kSignBitMask);
+  return biased1 >= biased2 ? biased1 - biased2 : biased2 - biased1;
+}
+
+// Returns the absolute difference between two numbers, or 0 if they
+// are equal, so that equal infinities don't differ.  The difference is
+// a NaN iff either number is a NaN.
+inline double AbsError(double expected, double actual) {
+  return expected == actual ? 0 : fabs(actual - expected);
+}
+
+// FindUlpError() and FindAbsError() return the index of the first
+// element from begin on whose difference is the given one, where a
+// difference involving a NaN is NanUlpDistance() or infinity.  There
+// must be such an element.
+template <typename RawType>
+size_t FindUlpError(const RawType* expected, const RawType* actual,
+                    size_t begin, UInt64 distance) {
+  while (UlpDistance(expected[begin], actual[begin]) != distance)
+    ++begin;
+  return begin;
+}
+
+template <typename RawType>
+size_t FindAbsError(const RawType* expected, const RawType* actual,
+                    size_t begin, double error) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (;; ++begin) {
+    const double e = AbsError(expected[begin], actual[begin]);
+    if ((e != e ? infinity : e) == error)
+      return begin;
+  }
+}
+
+// Returns the index of the first element whose difference involves a
+// NaN.  There must be such an element.
+template <typename RawType>
+size_t FindAbsNan(const RawType* expected, const RawType* actual) {
+  size_t i = 0;
+  while (!(expected[i] != expected[i] || actual[i] != actual[i]))
+    ++i;
+  return i;
+}
+
+template <typename RawType>
+void TallyUlpErrors(const RawType* expected, const RawType* actual,
+                    size_t begin, size_t end, const UInt64* limits,
+                    ErrorTally<UInt64>* tally) {
+  const UInt64 nan_distance = NanUlpDistance<RawType>();
+  for (size_t i = begin; i != end; ++i) {
+    const UInt64 distance = UlpDistance(expected[i], actual[i]);
+    tally->Add(i, distance, distance == nan_distance, limits);
+  }
+}
+
+template <typename RawType>
+void TallyAbsErrors(const RawType* expected, const RawType* actual,
+                    size_t begin, size_t end, const double* limits,
+                    ErrorTally<double>* tally) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (size_t i = begin; i != end; ++i) {
+    const double error = AbsError(expected[i], actual[i]);
+    const bool is_nan = error != error;
+    tally->Add(i, is_nan ? infinity : error, is_nan, limits);
+  }
+}
+
+// VectorizedTallyUlpErrors() and VectorizedTallyAbsErrors() tally the
+// differences between the elements in a prefix of the arrays as above,
+// and return the size of that prefix.  When they can't be vectorized,
+// the prefix is empty.
+template <typename RawType>
+size_t VectorizedTallyUlpErrors(const RawType* /* expected */,
+                                const RawType* /* actual */,
+                                size_t /* size */,
+                                const UInt64* /* limits */,
+                                ErrorTally<UInt64>* /* tally */) {
+  return 0;
+}
+
+#if GTEST_HAS_SSE2
+
+// Returns the bits of a where mask is set, and those of b elsewhere.
+inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128d Select(__m128d mask, __m128d a, __m128d b) {
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+// Four floats at a time.  The counts are kept in 32-bit lanes, which
+// we add to the tally before they can overflow.  Only the largest
+// distance is tracked in the loop; we look for where it is afterwards,
+// and only when it's the largest so far.
+size_t VectorizedTallyUlpErrors(const float* expected, const float* actual,
+                                size_t size, const UInt64* limits,
+                                ErrorTally<UInt64>* tally) {
+  // SSE2 has no unsigned 32-bit comparisons, so unsigned numbers are
+  // compared with signed comparisons after flipping their sign bits.
+  const __m128i kSignBit = _mm_set1_epi32(-0x7FFFFFFF - 1);
+  const __m128i kMagnitudeMask = _mm_set1_epi32(0x7FFFFFFF);
+  const __m128i kInfinityBits = _mm_set1_epi32(0x7F800000);
+  __m128i flipped_limits[kNumBucketLimits];
+  for (int k = 0; k != kNumBucketLimits; ++k) {
+    flipped_limits[k] = _mm_xor_si128(
+        _mm_set1_epi32(static_cast<int>(static_cast<UInt32>(limits[k]))),
+        kSignBit);
+  }
+
+  const size_t kBlockSize = 4 << 16;
+  const size_t vectorized_size = size - size % 4;
+  for (size_t block = 0; block != vectorized_size;) {
+    const size_t block_end = vectorized_size - block > kBlockSize ?
+        block + kBlockSize : vectorized_size;
+    __m128i above[kNumBucketLimits];
+    for (int k = 0; k != kNumBucketLimits; ++k)
+      above[k] = _mm_setzero_si128();
+    __m128i nans = _mm_setzero_si128();
+    __m128i flipped_max = kSignBit;
+    for (size_t i = block; i != block_end; i += 4) {
+      const __m128i e = _mm_castps_si128(_mm_loadu_ps(expected + i));
+      const __m128i a = _mm_castps_si128(_mm_loadu_ps(actual + i));
+      const __m128i magnitude_e = _mm_and_si128(e, kMagnitudeMask);
+      const __m128i magnitude_a = _mm_and_si128(a, kMagnitudeMask);
+      const __m128i nan = _mm_or_si128(
+          _mm_cmpgt_epi32(magnitude_e, kInfinityBits),
+          _mm_cmpgt_epi32(magnitude_a, kInfinityBits));
+      // Maps the numbers to signed integers in the same order, by
+      // negating the magnitudes of the negative ones.  Those are the
+      // biased representations minus 2^31.
+      const __m128i negative_e = _mm_srai_epi32(e, 31);
+      const __m128i negative_a = _mm_srai_epi32(a, 31);
+      const __m128i ordered_e =
+          _mm_sub_epi32(_mm_xor_si128(magnitude_e, negative_e), negative_e);
+      const __m128i ordered_a =
+          _mm_sub_epi32(_mm_xor_si128(magnitude_a, negative_a), negative_a);
+      // |ordered_e - ordered_a| as an unsigned number, found by negating
+      // the difference where ordered_a is the greater.
+      const __m128i negate = _mm_cmpgt_epi32(ordered_a, ordered_e);
+      const __m128i difference = _mm_sub_epi32(ordered_e, ordered_a);
+      const __m128i distance = _mm_or_si128(
+          _mm_sub_epi32(_mm_xor_si128(difference, negate), negate), nan);
+      const __m128i flipped = _mm_xor_si128(distance, kSignBit);
+
+      // Unrolled by hand, so that the counts stay in registers.
+#define GTEST_COUNT_ABOVE_(k) \
+      above[k] = _mm_sub_epi32(above[k], \
+                               _mm_cmpgt_epi32(flipped, flipped_limits[k]))
+      GTEST_COUNT_ABOVE_(0);
+      GTEST_COUNT_ABOVE_(1);
+      GTEST_COUNT_ABOVE_(2);
+      GTEST_COUNT_ABOVE_(3);
+      GTEST_COUNT_ABOVE_(4);
+      GTEST_COUNT_ABOVE_(5);
+#undef GTEST_COUNT_ABOVE_
+      nans = _mm_sub_epi32(nans, nan);
+      flipped_max = Select(_mm_cmpgt_epi32(flipped, flipped_max),
+                           flipped, flipped_max);
+    }
+
+    UInt32 lanes[4];
+    for (int k = 0; k != kNumBucketLimits; ++k) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), above[k]);
+      tally->above[k] += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), nans);
+    tally->nans += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes),
+                     _mm_xor_si128(flipped_max, kSignBit));
+    UInt32 block_max = lanes[0];
+    for (int lane = 1; lane != 4; ++lane)
+      block_max = lanes[lane] > block_max ? lanes[lane] : block_max;
+    if (block_max > tally->max_error) {
+      tally->max_error = block_max;
+      tally->worst_index =
+          FindUlpError(expected, actual, block, block_max);
+    }
+    block = block_end;
+  }
+  return vectorized_size;
+}
+
+inline __m128d LoadAsDoubles(const double* p) { return _mm_loadu_pd(p); }
+
+inline __m128d LoadAsDoubles(const float* p) {
+  return _mm_cvtps_pd(_mm_castsi128_ps(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+
+// Two elements at a time, converted to double.  As above, we look for
+// the largest difference in a block only if it's the largest so far.
+template <typename RawType>
+size_t VectorizedTallyAbsErrors(const RawType* expected,
+                                const RawType* actual,
+                                size_t size, const double* limits,
+                                ErrorTally<double>* tally) {
+  const __m128d kSignBit = _mm_set1_pd(-0.0);
+  const __m128d kInfinity =
+      _mm_set1_pd(std::numeric_limits<double>::infinity());
+  __m128d vector_limits[kNumBucketLimits];
+  __m128i above[kNumBucketLimits];
+  for (int k = 0; k != kNumBucketLimits; ++k) {
+    vector_limits[k] = _mm_set1_pd(limits[k]);
+    above[k] = _mm_setzero_si128();
+  }
+  __m128i nans = _mm_setzero_si128();
+
+  const size_t kBlockSize = 2 << 16;
+  const size_t vectorized_size = size - size % 2;
+  for (size_t block = 0; block != vectorized_size;) {
+    const size_t block_end = vectorized_size - block > kBlockSize ?
+        block + kBlockSize : vectorized_size;
+    __m128d max_error = _mm_setzero_pd();
+    for (size_t i = block; i != block_end; i += 2) {
+      const __m128d e = LoadAsDoubles(expected + i);
+      const __m128d a = LoadAsDoubles(actual + i);
+      // See AbsError().
+      const __m128d error = _mm_andnot_pd(
+          _mm_cmpeq_pd(e, a), _mm_andnot_pd(kSignBit, _mm_sub_pd(a, e)));
+      const __m128d nan = _mm_cmpunord_pd(error, error);
+      const __m128d error_or_infinity = Select(nan, kInfinity, error);
+
+      // Unrolled by hand, so that the counts stay in registers.
+#define GTEST_COUNT_ABOVE_(k) \
+      above[k] = _mm_sub_epi64(above[k], _mm_castpd_si128(_mm_or_pd( \
+          _mm_cmpgt_pd(error_or_infinity, vector_limits[k]), nan)))
+      GTEST_COUNT_ABOVE_(0);
+      GTEST_COUNT_ABOVE_(1);
+      GTEST_COUNT_ABOVE_(2);
+      GTEST_COUNT_ABOVE_(3);
+      GTEST_COUNT_ABOVE_(4);
+      GTEST_COUNT_ABOVE_(5);
+#undef GTEST_COUNT_ABOVE_
+      nans = _mm_sub_epi64(nans, _mm_castpd_si128(nan));
+      max_error = _mm_max_pd(max_error, error_or_infinity);
+    }
+
+    double maxima[2];
+    _mm_storeu_pd(maxima, max_error);
+    const double block_max = maxima[0] > maxima[1] ? maxima[0] : maxima[1];
+    if (block_max > tally->max_error) {
+      tally->max_error = block_max;
+      tally->worst_index =
+          FindAbsError(expected, actual, block, block_max);
+    }
+    block = block_end;
+  }
+
+  UInt64 lanes[2];
+  for (int k = 0; k != kNumBucketLimits; ++k) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), above[k]);
+    tally->above[k] += static_cast<size_t>(lanes[0] + lanes[1]);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), nans);
+  tally->nans += static_cast<size_t>(lanes[0] + lanes[1]);
+  return vectorized_size;
+}
+
+#else  // GTEST_HAS_SSE2
+
+template <typename RawType>
+size_t VectorizedTallyAbsErrors(const RawType* /* expected */,
+                                const RawType* /* actual */,
+                                size_t /* size */,
+                                const double* /* limits */,
+                                ErrorTally<double>* /* tally */) {
+  return 0;
+}
+
+#endif  // GTEST_HAS_SSE2
+
+template <typename RawType>
+void MeasureUlpErrorsImpl(const RawType* expected, const RawType* actual,
+                          size_t size, UInt64 max_ulps,
+                          FloatingPointArrayErrors* errors) {
+  const UInt64 nan_distance = NanUlpDistance<RawType>();
+  UInt64 limits[kNumBucketLimits];
+  GetUlpBucketLimits(max_ulps, nan_distance, limits);
+  ErrorTally<UInt64> tally;
+  const size_t vectorized_size =
+      VectorizedTallyUlpErrors(expected, actual, size, limits, &tally);
+  TallyUlpErrors(expected, actual, vectorized_size, size, limits, &tally);
+  SummarizeErrors(tally, size, limits,
+                  tally.max_error == nan_distance ?
+                  std::numeric_limits<double>::infinity() :
+                  static_cast<double>(tally.max_error),
+                  errors);
+}
+
+template <typename RawType>
+void MeasureAbsErrorsImpl(const RawType* expected, const RawType* actual,
+                          size_t size, double abs_error,
+                          FloatingPointArrayErrors* errors) {
+  double limits[kNumBucketLimits];
+  GetAbsBucketLimits(abs_error, limits);
+  ErrorTally<double> tally;
+  const size_t vectorized_size =
+      VectorizedTallyAbsErrors(expected, actual, size, limits, &tally);
+  TallyAbsErrors(expected, actual, vectorized_size, size, limits, &tally);
+  SummarizeErrors(tally, size, limits, tally.max_error, errors);
+  // An infinite difference ties with a NaN in the tally, so the first
+  // NaN is looked for here, and only when there is one.
+  if (tally.nans != 0)
+    errors->worst_index = FindAbsNan(expected, actual);
+}
+
+// Formats a floating-point number with enough digits to tell it apart
+// from its neighbors.
+template <typename RawType>
+std::string FormatFloatingPoint(RawType value) {
+  ::std::stringstream ss;
+  ss << std::setprecision(std::numeric_limits<RawType>::digits10 + 2)
+     << value;
+  return ss.str();
+}
+
+// Builds the failure message of {ASSERT|EXPECT}_ARRAYS_NEAR{,_ULP}.  For
+// example:
+//
+//   Value of: actual
+//   Expected: expected, within max_ulps (which is 4) ULPs
+//   2 of n (which is 1000) elements differ by more than that.
+//   The largest difference is 1234 ULPs, at index 17:
+//     expected[17] = 1.00000012
+//       actual[17] = 1.00012345
+//   Histogram of the differences:
+//     0: 997
+//     (2, 4]: 1
+//     > 256: 2
+template <typename RawType>
+AssertionResult ArraysNearFailure(const char* expected_expression,
+                                  const char* actual_expression,
+                                  const char* size_expression,
+                                  const std::string& tolerance,
+                                  const char* unit,
+                                  const RawType* expected,
+                                  const RawType* actual,
+                                  size_t size,
+                                  const FloatingPointArrayErrors& errors) {
+  const size_t worst = errors.worst_index;
+  ::std::stringstream ss;
+  ss << "Value of: " << actual_expression
+     << "\nExpected: " << expected_expression << ", within " << tolerance
+     << unit << "\n" << errors.num_failures << " of "
+     << DescribeValue(size_expression, StreamableToString(size))
+     << " elements " << (errors.num_failures == 1 ? "differs" : "differ")
+     << " by more than that.\nThe largest difference is ";
+  if (FloatingPoint<RawType>(expected[worst]).is_nan() ||
+      FloatingPoint<RawType>(actual[worst]).is_nan()) {
+    ss << "NaN";
+  } else {
+    ss << errors.max_error << unit;
+  }
+  ss << ", at index " << worst << ":"
+     << "\n  " << expected_expression << "[" << worst << "] = "
+     << FormatFloatingPoint(expected[worst])
+     << "\n    " << actual_expression << "[" << worst << "] = "
+     << FormatFloatingPoint(actual[worst])
+     << "\nHistogram of the differences:";
+
+  const int kNumBuckets = FloatingPointArrayErrors::kNumBuckets;
+  for (int k = 0; k != kNumBuckets; ++k) {
+    if (errors.histogram[k] == 0)
+      continue;
+    ss << "\n  ";
+    if (k == 0) {
+      ss << "0";
+    } else if (k <= kNumBucketLimits - 1) {
+      ss << "(" << errors.bucket_limits[k - 1] << ", "
+         << errors.bucket_limits[k] << "]";
+    } else if (k == kNumBucketLimits) {
+      ss << "> " << errors.bucket_limits[kNumBucketLimits - 1];
+    } else {
+      ss << "NaN";
+    }
+    ss << ": " << errors.histogram[k];
+  }
+  return AssertionFailure() << ss.str();
+}
+
+template <typename RawType>
+AssertionResult ArraysNearUlpPredFormatImpl(const char* expected_expression,
+                                            const char* actual_expression,
+                                            const char* size_expression,
+                                            const char* max_ulps_expression,
+                                            const RawType* expected,
+                                            const RawType* actual,
+                                            size_t size,
+                                            UInt64 max_ulps) {
+  FloatingPointArrayErrors errors;
+  MeasureUlpErrors(expected, actual, size, max_ulps, &errors);
+  if (errors.num_failures == 0)
+    return AssertionSuccess();
+
+  return ArraysNearFailure(
+      expected_expression, actual_expression, size_expression,
+      DescribeValue(max_ulps_expression, StreamableToString(max_ulps)),
+      " ULPs", expected, actual, size, errors);
+}
+
+template <typename RawType>
+AssertionResult ArraysNearPredFormatImpl(const char* expected_expression,
+                                         const char* actual_expression,
+                                         const char* size_expression,
+                                         const char* abs_error_expression,
+                                         const RawType* expected,
+                                         const RawType* actual,
+                                         size_t size,
+                                         double abs_error) {
+  // Every element would compare as within a NaN tolerance, as no
+  // comparison with NaN holds.  EXPECT_NEAR() fails then, and so do we.
+  if (FloatingPoint<double>(abs_error).is_nan()) {
+    return AssertionFailure()
+        << "Value of: " << actual_expression
+        << "\nExpected: " << expected_expression << ", within "
+        << DescribeValue(abs_error_expression, StreamableToString(abs_error))
+        << "\nThe tolerance is NaN, so no element can be near.";
+  }
+
+  FloatingPointArrayErrors errors;
+  MeasureAbsErrors(expected, actual, size, abs_error, &errors);
+  if (errors.num_failures == 0)
+    return AssertionSuccess();
+
+  return ArraysNearFailure(
+      expected_expression, actual_expression, size_expression,
+      DescribeValue(abs_error_expression, StreamableToString(abs_error)),
+      "", expected, actual, size, errors);
+}
+
+}  // namespace
+
+void MeasureUlpErrors(const float* expected, const float* actual,
+                      size_t size, UInt64 max_ulps,
+                      FloatingPointArrayErrors* errors) {
+  MeasureUlpErrorsImpl(expected, actual, size, max_ulps, errors);
+}
+
+void MeasureUlpErrors(const double* expected, const double* actual,
+                      size_t size, UInt64 max_ulps,
+                      FloatingPointArrayErrors* errors) {
+  MeasureUlpErrorsImpl(expected, actual, size, max_ulps, errors);
+}
+
+void MeasureAbsErrors(const float* expected, const float* actual,
+                      size_t size, double abs_error,
+                      FloatingPointArrayErrors* errors) {
+  MeasureAbsErrorsImpl(expected, actual, size, abs_error, errors);
+}
+
+void MeasureAbsErrors(const double* expected, const double* actual,
+                      size_t size, double abs_error,
+                      FloatingPointArrayErrors* errors) {
+  MeasureAbsErrorsImpl(expected, actual, size, abs_error, errors);
+}
+
+AssertionResult ArraysNearUlpPredFormat(const char* expected_expression,
+                                        const char* actual_expression,
+                                        const char* size_expression,
+                                        const char* max_ulps_expression,
+                                        const float* expected,
+                                        const float* actual,
+                                        size_t size,
+                                        UInt64 max_ulps) {
+  return ArraysNearUlpPredFormatImpl(expected_expression, actual_expression,
+                                     size_expression, max_ulps_expression,
+                                     expected, actual, size, max_ulps);
+}
+
+AssertionResult ArraysNearUlpPredFormat(const char* expected_expression,
+                                        const char* actual_expression,
+                                        const char* size_expression,
+                                        const char* max_ulps_expression,
+                                        const double* expected,
+                                        const double* actual,
+                                        size_t size,
+                                        UInt64 max_ulps) {
+  return ArraysNearUlpPredFormatImpl(expected_expression, actual_expression,
+                                     size_expression, max_ulps_expression,
+                                     expected, actual, size, max_ulps);
+}
+
+AssertionResult ArraysNearPredFormat(const char* expected_expression,
+                                     const char* actual_expression,
+                                     const char* size_expression,
+                                     const char* abs_error_expression,
+                                     const float* expected,
+                                     const float* actual,
+                                     size_t size,
+                                     double abs_error) {
+  return ArraysNearPredFormatImpl(expected_expression, actual_expression,
+                                  size_expression, abs_error_expression,
+                                  expected, actual, size, abs_error);
+}
+
+AssertionResult ArraysNearPredFormat(const char* expected_expression,
+                                     const char* actual_expression,
+                                     const char* size_expression,
+                                     const char* abs_error_expression,
+                                     const double* expected,
+                                     const double* actual,
+                                     size_t size,
+                                     double abs_error) {
+  return ArraysNearPredFormatImpl(expected_expression, actual_expression,
+                                  size_expression, abs_error_expression,
+                                  expected, actual, size, abs_error);
+}
+
+}  // namespace internal
+}  // namespace testing
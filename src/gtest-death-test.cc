@@ -43,17 +43,15 @@
 # include <errno.h>
 # include <fcntl.h>
 # include <limits.h>
-
-# if GTEST_OS_LINUX
-#  include <signal.h>
-# endif  // GTEST_OS_LINUX
-
 # include <stdarg.h>
 
 # if GTEST_OS_WINDOWS
 #  include <windows.h>
 # else
+#  include <signal.h>
 #  include <sys/mman.h>
+#  include <sys/socket.h>
+#  include <sys/uio.h>
 #  include <sys/wait.h>
 # endif  // GTEST_OS_WINDOWS
 
@@ -103,6 +101,13 @@ GTEST_DEFINE_bool_(
     "work in 99% of the cases. Once valgrind is fixed, this flag will "
     "most likely be removed.");
 
+GTEST_DEFINE_bool_(
+    death_test_use_zygote,
+    internal::BoolFromGTestEnv("death_test_use_zygote", false),
+    "Instructs InitGoogleTest() to fork a helper process, which then forks "
+    "the child processes of threadsafe-style death tests instead of "
+    "re-executing the test program for each of them.");
+
 namespace internal {
 GTEST_DEFINE_string_(
     internal_run_death_test, "",
@@ -820,7 +825,15 @@ class NoExecDeathTest : public ForkingDeathTest {
 // The AssumeRole process for a fork-and-run death test.  It implements a
 // straightforward fork, with a simple pipe to transmit the status byte.
 DeathTest::TestRole NoExecDeathTest::AssumeRole() {
-  const size_t thread_count = GetThreadCount();
+  // With --gtest_async_listeners, waits until the reporting thread is idle,
+  // so that it holds no locks when the process forks.  The child never uses
+  // it, so it isn't worth a warning.  Also writes out the streamed results,
+  // so that the receiver has them while the death test runs.
+  const bool has_reporting_thread =
+      GetUnitTestImpl()->FlushEventsBeforeFork();
+  size_t thread_count = GetThreadCount();
+  if (has_reporting_thread && thread_count > 1)
+    thread_count--;
   if (thread_count != 1) {
     GTEST_LOG_(WARNING) << DeathTestThreadWarning(thread_count);
   }
@@ -862,6 +875,279 @@ DeathTest::TestRole NoExecDeathTest::AssumeRole() {
   }
 }
 
+// Appends a field to a message passed between processes: a decimal
+// length, ':', and that many bytes.
+static void AppendField(std::string* message, const std::string& field) {
+  *message += StreamableToString(field.length());
+  *message += ':';
+  *message += field;
+}
+
+// Reads the field at *pos of the message into *field, and moves *pos
+// past it.  Returns false if the message ends before the field does.
+static bool ReadField(const std::string& message, size_t* pos,
+                      std::string* field) {
+  const size_t colon = message.find(':', *pos);
+  if (colon == std::string::npos || colon == *pos)
+    return false;
+
+  size_t length = 0;
+  for (size_t i = *pos; i != colon; i++) {
+    if (!IsDigit(message[i]))
+      return false;
+    length = length * 10 + static_cast<size_t>(message[i] - '0');
+  }
+  if (message.length() - (colon + 1) < length)
+    return false;
+
+  field->assign(message, colon + 1, length);
+  *pos = colon + 1 + length;
+  return true;
+}
+
+// The death test zygote.
+//
+// With --gtest_death_test_use_zygote, InitGoogleTest() forks a helper
+// process before the test program has a chance to start threads of its
+// own.  Threadsafe-style death tests then ask this single-threaded
+// process to fork their child processes, instead of re-executing the
+// test program, which spares each child loading the program, running
+// its static initializers, and parsing the flags again.  A child
+// process the zygote forks returns from InitGoogleTest() as if it had
+// been re-executed with the flags that select its death test.
+//
+// The test program sends the zygote a request for each death test: the
+// --gtest_filter and --gtest_internal_run_death_test flags without the
+// file descriptor, as two fields (see AppendField()) preceded by their
+// total length, along with the write end of the status pipe and the
+// test program's stdout and stderr.  The zygote answers with the process
+// ID of the child, then with its exit status once it has exited.
+
+// The number of file descriptors in a request to the zygote.
+static const int kZygoteRequestFdCount = 3;
+
+// The test program's end of the socket to the zygote; -1 if the zygote
+// isn't running.
+static int g_zygote_fd = -1;
+
+// Writes the given bytes to a file descriptor.
+static void WriteFully(int fd, const void* data, size_t length) {
+  const char* p = static_cast<const char*>(data);
+  while (length > 0) {
+    int bytes_written;
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_written = posix::Write(
+        fd, p, static_cast<unsigned int>(length)));
+    p += bytes_written;
+    length -= static_cast<size_t>(bytes_written);
+  }
+}
+
+// Reads the given number of bytes from a file descriptor.  Returns
+// false if the other end is closed first.
+static bool ReadFully(int fd, void* data, size_t length) {
+  char* p = static_cast<char*>(data);
+  while (length > 0) {
+    int bytes_read;
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_read = posix::Read(
+        fd, p, static_cast<unsigned int>(length)));
+    if (bytes_read == 0)
+      return false;
+    p += bytes_read;
+    length -= static_cast<size_t>(bytes_read);
+  }
+  return true;
+}
+
+// Sends a request with the given file descriptors to the zygote.
+static void SendZygoteRequest(const std::string& request, const int* fds) {
+  GTEST_DEATH_TEST_CHECK_(request.length() <= UINT_MAX);
+  unsigned int length = static_cast<unsigned int>(request.length());
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  union {
+    struct cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int) * kZygoteRequestFdCount)];
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+  struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * kZygoteRequestFdCount);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * kZygoteRequestFdCount);
+
+  ssize_t bytes_sent;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_sent = sendmsg(g_zygote_fd, &msg, 0));
+  GTEST_DEATH_TEST_CHECK_(bytes_sent == static_cast<ssize_t>(sizeof(length)));
+  WriteFully(g_zygote_fd, request.data(), request.length());
+}
+
+// Receives a request and its file descriptors from the test program.
+// Returns false if the test program has closed its end of the socket.
+static bool ReceiveZygoteRequest(int fd, std::string* request, int* fds) {
+  unsigned int length = 0;
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  union {
+    struct cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int) * kZygoteRequestFdCount)];
+  } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  ssize_t bytes_received;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_received = recvmsg(fd, &msg, 0));
+  if (bytes_received == 0)
+    return false;
+  // The descriptors arrive with the first byte of the request.
+  const struct cmsghdr* const cmsg = CMSG_FIRSTHDR(&msg);
+  GTEST_DEATH_TEST_CHECK_(
+      cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS &&
+      cmsg->cmsg_len == CMSG_LEN(sizeof(int) * kZygoteRequestFdCount));
+  memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * kZygoteRequestFdCount);
+  GTEST_DEATH_TEST_CHECK_(ReadFully(
+      fd, reinterpret_cast<char*>(&length) + bytes_received,
+      sizeof(length) - static_cast<size_t>(bytes_received)));
+
+  std::vector<char> buffer(length + 1);
+  GTEST_DEATH_TEST_CHECK_(ReadFully(fd, &buffer[0], length));
+  request->assign(&buffer[0], length);
+  return true;
+}
+
+// Serves the requests of the test program until it exits, when the
+// zygote exits too.  Returns only in the death test child processes it
+// forks, after setting the flags that select their death tests.
+static void RunZygote(int fd) {
+  for (;;) {
+    std::string request;
+    int fds[kZygoteRequestFdCount];
+    if (!ReceiveZygoteRequest(fd, &request, fds))
+      _exit(0);
+
+    const pid_t child_pid = fork();
+    GTEST_DEATH_TEST_CHECK_(child_pid != -1);
+    if (child_pid == 0) {
+      GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fd));
+      // Takes over the test program's stdout and stderr, which capture
+      // the output of the death test.
+      GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(fds[1], 1));
+      GTEST_DEATH_TEST_CHECK_SYSCALL_(dup2(fds[2], 2));
+      for (int i = 1; i < kZygoteRequestFdCount; i++) {
+        if (fds[i] > 2)
+          GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fds[i]));
+      }
+
+      size_t pos = 0;
+      std::string filter, internal_flag;
+      if (!ReadField(request, &pos, &filter) ||
+          !ReadField(request, &pos, &internal_flag)) {
+        DeathTestAbort("Bad request to the death test zygote: " + request);
+      }
+      GTEST_FLAG(filter) = filter;
+      GTEST_FLAG(internal_run_death_test) =
+          internal_flag + "|" + StreamableToString(fds[0]);
+
+      // Runs the death test in the directory the test program was
+      // invoked from, as a re-executed test program would.
+      const char* const original_dir =
+          UnitTest::GetInstance()->original_working_dir();
+      if (chdir(original_dir) != 0) {
+        DeathTestAbort(std::string("chdir(\"") + original_dir +
+                       "\") failed: " + GetLastErrnoDescription());
+      }
+      return;
+    }
+
+    // Only the child may hold the write end of the status pipe, so that
+    // the test program sees it close when the child dies.
+    for (int i = 0; i < kZygoteRequestFdCount; i++)
+      GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fds[i]));
+
+    WriteFully(fd, &child_pid, sizeof(child_pid));
+    int status;
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(waitpid(child_pid, &status, 0));
+    WriteFully(fd, &status, sizeof(status));
+  }
+}
+
+// Forks the death test zygote if --gtest_death_test_use_zygote is set.
+// Returns in the test program, and in each death test child process the
+// zygote forks.
+void StartDeathTestZygote() {
+  if (!GTEST_FLAG(death_test_use_zygote) ||
+      !GTEST_FLAG(internal_run_death_test).empty() || g_zygote_fd != -1)
+    return;
+
+  // The zygote can only fork safely while it has a single thread, which
+  // it only has if the test program did when it forked the zygote.
+  const size_t thread_count = GetThreadCount();
+  if (thread_count > 1) {
+    GTEST_LOG_(WARNING)
+        << "Not starting the death test zygote, as InitGoogleTest() was "
+        << "called when " << thread_count << " threads were running.  "
+        << "Threadsafe death tests will re-execute the test program.";
+    return;
+  }
+
+  int socket_fd[2];
+  GTEST_DEATH_TEST_CHECK_(socketpair(AF_UNIX, SOCK_STREAM, 0, socket_fd) != -1);
+  // Keeps the output buffered so far from being written twice.
+  FlushInfoLog();
+
+  const pid_t zygote_pid = fork();
+  GTEST_DEATH_TEST_CHECK_(zygote_pid != -1);
+  if (zygote_pid == 0) {
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(close(socket_fd[0]));
+    RunZygote(socket_fd[1]);
+    return;
+  }
+
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(socket_fd[1]));
+  // Keeps processes the tests execute from holding the socket open.
+  GTEST_DEATH_TEST_CHECK_(fcntl(socket_fd[0], F_SETFD, FD_CLOEXEC) != -1);
+  g_zygote_fd = socket_fd[0];
+}
+
+// Asks the zygote to fork a child process that runs the given death
+// test, and returns its process ID.
+static pid_t SpawnChildFromZygote(const std::string& filter,
+                                  const std::string& internal_flag,
+                                  int status_fd) {
+  std::string request;
+  AppendField(&request, filter);
+  AppendField(&request, internal_flag);
+  const int fds[kZygoteRequestFdCount] = { status_fd, 1, 2 };
+  SendZygoteRequest(request, fds);
+
+  pid_t child_pid;
+  GTEST_DEATH_TEST_CHECK_(ReadFully(g_zygote_fd, &child_pid,
+                                    sizeof(child_pid)));
+  return child_pid;
+}
+
+// Waits for the child process the zygote forked last to exit, and
+// returns its exit status.
+static int WaitForZygoteChild() {
+  int status;
+  GTEST_DEATH_TEST_CHECK_(ReadFully(g_zygote_fd, &status, sizeof(status)));
+  return status;
+}
+
 // A concrete death test class that forks and re-executes the main
 // program from the beginning, with command-line flags set that cause
 // only this specific death test to be run.
@@ -869,8 +1155,10 @@ class ExecDeathTest : public ForkingDeathTest {
  public:
   ExecDeathTest(const char* a_statement, const RE* a_regex,
                 const char* file, int line) :
-      ForkingDeathTest(a_statement, a_regex), file_(file), line_(line) { }
+      ForkingDeathTest(a_statement, a_regex), file_(file), line_(line),
+      spawned_by_zygote_(false) { }
   virtual TestRole AssumeRole();
+  virtual int Wait();
  private:
   static ::std::vector<testing::internal::string>
   GetArgvsForDeathTestChildProcess() {
@@ -881,6 +1169,8 @@ class ExecDeathTest : public ForkingDeathTest {
   const char* const file_;
   // The line number on which the death test is located.
   const int line_;
+  // True if the death test zygote forked the child process.
+  bool spawned_by_zygote_;
 };
 
 // Utility class for accumulating command-line arguments.
@@ -919,8 +1209,9 @@ class Arguments {
 // A struct that encompasses the arguments to the child process of a
 // threadsafe-style death test process.
 struct ExecDeathTestArgs {
-  char* const* argv;  // Command-line arguments for the child's call to exec
-  int close_fd;       // File descriptor to close; the read end of a pipe
+  char* const* argv;     // Command-line arguments for the child's call to exec
+  int close_fd;          // File descriptor to close; the read end of a pipe
+  sigset_t signal_mask;  // Signal mask for the child to exec with
 };
 
 #  if GTEST_OS_MAC
@@ -938,6 +1229,24 @@ inline char** GetEnviron() { return environ; }
 #  endif  // GTEST_OS_MAC
 
 #  if !GTEST_OS_QNX
+// Restores the default action of the signals the test program handles,
+// then unblocks the signals the test program didn't block.  Until then,
+// no signal handler can run in the child process, which may still share
+// the memory of the test program.
+static void RestoreSignalsInChild(const sigset_t& signal_mask) {
+  for (int signum = 1; signum < NSIG; signum++) {
+    struct sigaction action;
+    // Fails for the signals the C library reserves, which is fine.
+    if (sigaction(signum, NULL, &action) != 0 ||
+        action.sa_handler == SIG_IGN || action.sa_handler == SIG_DFL)
+      continue;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SIG_DFL;
+    sigaction(signum, &action, NULL);
+  }
+  pthread_sigmask(SIG_SETMASK, &signal_mask, NULL);
+}
+
 // The main function for a threadsafe-style death test child process.
 // This function is called in a clone()-ed process and thus must avoid
 // any potentially unsafe operations like malloc or libc functions.
@@ -962,6 +1271,7 @@ static int ExecDeathTestChildMain(void* child_arg) {
   // unsafe.  Since execve() doesn't search the PATH, the user must
   // invoke the test program via a valid path that contains at least
   // one path separator.
+  RestoreSignalsInChild(args->signal_mask);
   execve(args->argv[0], args->argv, GetEnviron());
   DeathTestAbort(std::string("execve(") + args->argv[0] + ", ...) in " +
                  original_dir + " failed: " +
@@ -997,12 +1307,16 @@ bool StackGrowsDown() {
 // Spawns a child process with the same executable as the current process in
 // a thread-safe manner and instructs it to run the death test.  The
 // implementation uses fork(2) + exec.  On systems where clone(2) is
-// available, it is used instead, being slightly more thread-safe.  On QNX,
-// fork supports only single-threaded environments, so this function uses
-// spawn(2) there instead.  The function dies with an error message if
-// anything goes wrong.
+// available, it is used instead, being slightly more thread-safe, and
+// sharing this process' memory until the exec like vfork(2) and
+// posix_spawn(3) do, so that it costs the same however much memory the
+// test program has mapped.  On QNX, fork supports only single-threaded
+// environments, so this function uses spawn(2) there instead.  The
+// function dies with an error message if anything goes wrong.
 static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
-  ExecDeathTestArgs args = { argv, close_fd };
+  ExecDeathTestArgs args;
+  args.argv = argv;
+  args.close_fd = close_fd;
   pid_t child_pid = -1;
 
 #  if GTEST_OS_QNX
@@ -1036,25 +1350,25 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
   GTEST_DEATH_TEST_CHECK_SYSCALL_(close(cwd_fd));
 
 #  else   // GTEST_OS_QNX
-#   if GTEST_OS_LINUX
-  // When a SIGPROF signal is received while fork() or clone() are executing,
-  // the process may hang. To avoid this, we ignore SIGPROF here and re-enable
-  // it after the call to fork()/clone() is complete.
-  struct sigaction saved_sigprof_action;
-  struct sigaction ignore_sigprof_action;
-  memset(&ignore_sigprof_action, 0, sizeof(ignore_sigprof_action));
-  sigemptyset(&ignore_sigprof_action.sa_mask);
-  ignore_sigprof_action.sa_handler = SIG_IGN;
-  GTEST_DEATH_TEST_CHECK_SYSCALL_(sigaction(
-      SIGPROF, &ignore_sigprof_action, &saved_sigprof_action));
-#   endif  // GTEST_OS_LINUX
+  // Blocks all signals in this thread, whose mask the child process
+  // inherits, until the child is about to exec, so that no signal handler
+  // runs in the child on the memory it shares with this process.  This
+  // also keeps a SIGPROF received while fork() or clone() are executing
+  // from hanging the process.  sigprocmask() is unspecified in a
+  // multithreaded process, hence pthread_sigmask().
+  sigset_t all_signals;
+  sigfillset(&all_signals);
+  GTEST_DEATH_TEST_CHECK_(
+      pthread_sigmask(SIG_SETMASK, &all_signals, &args.signal_mask) == 0);
 
 #   if GTEST_HAS_CLONE
   const bool use_fork = GTEST_FLAG(death_test_use_fork);
 
   if (!use_fork) {
     static const bool stack_grows_down = StackGrowsDown();
-    const size_t stack_size = getpagesize();
+    // The child may be the first to call some C library functions, and
+    // the dynamic linker needs a few kilobytes of stack to resolve them.
+    const size_t stack_size = 16 * getpagesize();
     // MMAP_ANONYMOUS is not defined on Mac, so we use MAP_ANON instead.
     void* const stack = mmap(NULL, stack_size, PROT_READ | PROT_WRITE,
                              MAP_ANON | MAP_PRIVATE, -1, 0);
@@ -1073,7 +1387,11 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
     GTEST_DEATH_TEST_CHECK_(stack_size > kMaxStackAlignment &&
         reinterpret_cast<intptr_t>(stack_top) % kMaxStackAlignment == 0);
 
-    child_pid = clone(&ExecDeathTestChildMain, stack_top, SIGCHLD, &args);
+    // CLONE_VM spares copying the page tables of this process, and
+    // CLONE_VFORK keeps this thread, whose stack holds args, from
+    // returning before the child process has exec'ed or exited.
+    child_pid = clone(&ExecDeathTestChildMain, stack_top,
+                      CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
 
     GTEST_DEATH_TEST_CHECK_(munmap(stack, stack_size) != -1);
   }
@@ -1085,11 +1403,9 @@ static pid_t ExecDeathTestSpawnChild(char* const* argv, int close_fd) {
       ExecDeathTestChildMain(&args);
       _exit(0);
   }
+  GTEST_DEATH_TEST_CHECK_(
+      pthread_sigmask(SIG_SETMASK, &args.signal_mask, NULL) == 0);
 #  endif  // GTEST_OS_QNX
-#  if GTEST_OS_LINUX
-  GTEST_DEATH_TEST_CHECK_SYSCALL_(
-      sigaction(SIGPROF, &saved_sigprof_action, NULL));
-#  endif  // GTEST_OS_LINUX
 
   GTEST_DEATH_TEST_CHECK_(child_pid != -1);
   return child_pid;
@@ -1117,18 +1433,11 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
   // it be closed when the child process does an exec:
   GTEST_DEATH_TEST_CHECK_(fcntl(pipe_fd[1], F_SETFD, 0) != -1);
 
-  const std::string filter_flag =
-      std::string("--") + GTEST_FLAG_PREFIX_ + kFilterFlag + "="
-      + info->test_case_name() + "." + info->name();
-  const std::string internal_flag =
-      std::string("--") + GTEST_FLAG_PREFIX_ + kInternalRunDeathTestFlag + "="
-      + file_ + "|" + StreamableToString(line_) + "|"
-      + StreamableToString(death_test_index) + "|"
-      + StreamableToString(pipe_fd[1]);
-  Arguments args;
-  args.AddArguments(GetArgvsForDeathTestChildProcess());
-  args.AddArgument(filter_flag.c_str());
-  args.AddArgument(internal_flag.c_str());
+  const std::string filter =
+      std::string(info->test_case_name()) + "." + info->name();
+  const std::string death_test_flag =
+      file_ + ("|" + StreamableToString(line_)) + "|"
+      + StreamableToString(death_test_index);
 
   DeathTest::set_last_death_test_message("");
 
@@ -1137,7 +1446,22 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
   // is necessary.
   FlushInfoLog();
 
-  const pid_t child_pid = ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0]);
+  pid_t child_pid;
+  if (g_zygote_fd != -1) {
+    child_pid = SpawnChildFromZygote(filter, death_test_flag, pipe_fd[1]);
+    spawned_by_zygote_ = true;
+  } else {
+    const std::string filter_flag =
+        std::string("--") + GTEST_FLAG_PREFIX_ + kFilterFlag + "=" + filter;
+    const std::string internal_flag =
+        std::string("--") + GTEST_FLAG_PREFIX_ + kInternalRunDeathTestFlag
+        + "=" + death_test_flag + "|" + StreamableToString(pipe_fd[1]);
+    Arguments args;
+    args.AddArguments(GetArgvsForDeathTestChildProcess());
+    args.AddArgument(filter_flag.c_str());
+    args.AddArgument(internal_flag.c_str());
+    child_pid = ExecDeathTestSpawnChild(args.Argv(), pipe_fd[0]);
+  }
   GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[1]));
   set_child_pid(child_pid);
   set_read_fd(pipe_fd[0]);
@@ -1145,6 +1469,21 @@ DeathTest::TestRole ExecDeathTest::AssumeRole() {
   return OVERSEE_TEST;
 }
 
+// Waits for the child in a death test to exit, returning its exit
+// status, or 0 if no child process exists.  As a side effect, sets the
+// outcome data member.
+int ExecDeathTest::Wait() {
+  if (!spawned_by_zygote_)
+    return ForkingDeathTest::Wait();
+
+  ReadAndInterpretStatusByte();
+
+  // The child process is the zygote's to wait for.
+  const int status_value = WaitForZygoteChild();
+  set_status(status_value);
+  return status_value;
+}
+
 # endif  // !GTEST_OS_WINDOWS
 
 // Creates a concrete DeathTest-derived class that depends on the
@@ -1339,8 +1678,186 @@ InternalRunDeathTestFlag* ParseInternalRunDeathTestFlag() {
   return new InternalRunDeathTestFlag(fields[0], line, index, write_fd);
 }
 
+# if GTEST_CAN_FORK_TESTS_
+
+// Utilities needed for running tests in forked child processes.
+
+// A child process reports the result of its test as a sequence of
+// fields (see AppendField()).  Each test part result is "part" followed
+// by its type, file name (empty if unknown), line number, and message;
+// each property is "property" followed by its key and value; the report
+// ends with "end".
+
+// Writes the report of the given test result to the pipe.
+static void WriteTestReport(int fd, const TestResult& result) {
+  std::string report;
+  for (int i = 0; i < result.total_part_count(); i++) {
+    const TestPartResult& part = result.GetTestPartResult(i);
+    AppendField(&report, "part");
+    AppendField(&report, StreamableToString(static_cast<int>(
+        part.type())));
+    AppendField(&report,
+                part.file_name() == NULL ? "" : part.file_name());
+    AppendField(&report, StreamableToString(part.line_number()));
+    AppendField(&report, part.message());
+  }
+  for (int i = 0; i < result.test_property_count(); i++) {
+    const TestProperty& property = result.GetTestProperty(i);
+    AppendField(&report, "property");
+    AppendField(&report, property.key());
+    AppendField(&report, property.value());
+  }
+  AppendField(&report, "end");
+
+  const char* data = report.data();
+  size_t remaining = report.length();
+  while (remaining > 0) {
+    int bytes_written;
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_written = posix::Write(
+        fd, data, static_cast<unsigned int>(remaining)));
+    data += bytes_written;
+    remaining -= static_cast<size_t>(bytes_written);
+  }
+}
+
+// Reads everything the child process writes to the pipe until it exits.
+static std::string ReadTestReport(int fd) {
+  std::string report;
+  char buffer[4096];
+  int bytes_read;
+  do {
+    GTEST_DEATH_TEST_CHECK_SYSCALL_(bytes_read = posix::Read(
+        fd, buffer, sizeof(buffer)));
+    report.append(buffer, static_cast<size_t>(bytes_read));
+  } while (bytes_read > 0);
+  return report;
+}
+
+// Reports the test part results and properties in a child process'
+// report for the current test, as if they had happened in this
+// process.  Returns true iff the report is complete.
+static bool ReplayTestReport(const std::string& report) {
+  UnitTestImpl* const impl = GetUnitTestImpl();
+  size_t pos = 0;
+  std::string kind;
+  while (ReadField(report, &pos, &kind)) {
+    if (kind == "end") {
+      return pos == report.length();
+    } else if (kind == "part") {
+      std::string type, file, line, message;
+      if (!ReadField(report, &pos, &type) ||
+          !ReadField(report, &pos, &file) ||
+          !ReadField(report, &pos, &line) ||
+          !ReadField(report, &pos, &message)) {
+        return false;
+      }
+      impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+          TestPartResult(static_cast<TestPartResult::Type>(atoi(type.c_str())),
+                         file.empty() ? NULL : file.c_str(),
+                         atoi(line.c_str()), message.c_str()));
+    } else if (kind == "property") {
+      std::string key, value;
+      if (!ReadField(report, &pos, &key) ||
+          !ReadField(report, &pos, &value)) {
+        return false;
+      }
+      impl->RecordProperty(TestProperty(key, value));
+    } else {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Creates a pipe and forks a child process to run a test in.  Returns
+// the child's process ID and the read end of the pipe in the parent
+// process, and 0 and the write end of the pipe in the child process.
+static pid_t ForkTestProcess(int* fd) {
+  int pipe_fd[2];
+  GTEST_DEATH_TEST_CHECK_(pipe(pipe_fd) != -1);
+  // Keeps processes the test executes from holding the pipe open.
+  GTEST_DEATH_TEST_CHECK_(fcntl(pipe_fd[1], F_SETFD, FD_CLOEXEC) != -1);
+
+  const pid_t child_pid = fork();
+  GTEST_DEATH_TEST_CHECK_(child_pid != -1);
+  const int unused_end = child_pid == 0 ? 0 : 1;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(pipe_fd[unused_end]));
+  *fd = pipe_fd[1 - unused_end];
+  return child_pid;
+}
+
+// Reads the report of the child process from the pipe and waits for
+// the child process to exit.  Returns its exit status.
+static int WaitForTestProcess(pid_t child_pid, int fd, std::string* report) {
+  *report = ReadTestReport(fd);
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(close(fd));
+  int status;
+  GTEST_DEATH_TEST_CHECK_SYSCALL_(waitpid(child_pid, &status, 0));
+  return status;
+}
+
+# endif  // GTEST_CAN_FORK_TESTS_
+
 }  // namespace internal
 
+# if GTEST_CAN_FORK_TESTS_
+
+// Runs the test in a child process forked from this one, and records
+// the result the child process reports.
+void TestInfo::RunInChildProcess() {
+  if (!should_run_) return;
+
+  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
+  impl->set_current_test_info(this);
+
+  TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
+  repeater->OnTestStart(*this);
+
+  const TimeInMillis start = internal::GetTimeInMillis();
+
+  // Waits until the reporting thread of --gtest_async_listeners, if any,
+  // is idle, so that it holds no locks when the process forks.  Flushes
+  // the output, so that the child process doesn't print or stream it
+  // again.
+  impl->FlushEventsBeforeFork();
+  internal::FlushInfoLog();
+
+  int fd;
+  const pid_t child_pid = internal::ForkTestProcess(&fd);
+  if (child_pid == 0) {
+    // The listeners hear about the test from the parent process.
+    impl->listeners()->SuppressEventForwarding();
+    Run();
+    internal::WriteTestReport(fd, result_);
+    internal::FlushInfoLog();
+    // Skips the exit handlers and static destructors, which belong to the
+    // parent process.
+    _exit(0);
+  }
+
+  std::string report;
+  const int status = internal::WaitForTestProcess(child_pid, fd, &report);
+
+  if (!internal::ReplayTestReport(report)) {
+    const std::string message = "The child process running the test ended "
+        "before the test did: " + internal::ExitSummary(status) + ".";
+    impl->GetTestPartResultReporterForCurrentThread()->ReportTestPartResult(
+        TestPartResult(TestPartResult::kFatalFailure, NULL, -1,
+                       message.c_str()));
+  }
+
+  result_.set_elapsed_time(internal::GetTimeInMillis() - start);
+
+  // Notifies the unit test event listener that a test has just finished.
+  repeater->OnTestEnd(*this);
+
+  // Tells UnitTest to stop associating assertion results to this
+  // test.
+  impl->set_current_test_info(NULL);
+}
+
+# endif  // GTEST_CAN_FORK_TESTS_
+
 #endif  // GTEST_HAS_DEATH_TEST
 
 }  // namespace testing
@@ -53,6 +53,7 @@
 #include <string.h>  // For memmove.
 
 #include <algorithm>
+#include <locale>
 #include <string>
 #include <vector>
 
@@ -78,6 +79,7 @@ namespace testing {
 // Google Test's own unit tests to be able to access it. Therefore we
 // declare it here as opposed to in gtest.h.
 GTEST_DECLARE_bool_(death_test_use_fork);
+GTEST_DECLARE_bool_(death_test_use_zygote);
 
 namespace internal {
 
@@ -87,17 +89,22 @@ GTEST_API_ extern const TypeId kTestTypeIdInGoogleTest;
 
 // Names of the flags (needed for parsing Google Test flags).
 const char kAlsoRunDisabledTestsFlag[] = "also_run_disabled_tests";
+const char kAsyncListenersFlag[] = "async_listeners";
 const char kBreakOnFailureFlag[] = "break_on_failure";
+const char kBriefFlag[] = "brief";
 const char kCatchExceptionsFlag[] = "catch_exceptions";
 const char kColorFlag[] = "color";
 const char kFilterFlag[] = "filter";
+const char kIncrementalOutputFlag[] = "incremental_output";
 const char kListTestsFlag[] = "list_tests";
 const char kOutputFlag[] = "output";
+const char kPrintBudgetFlag[] = "print_budget";
 const char kPrintTimeFlag[] = "print_time";
 const char kRandomSeedFlag[] = "random_seed";
 const char kRepeatFlag[] = "repeat";
 const char kShuffleFlag[] = "shuffle";
 const char kStackTraceDepthFlag[] = "stack_trace_depth";
+const char kStreamResultFormatFlag[] = "stream_result_format";
 const char kStreamResultToFlag[] = "stream_result_to";
 const char kThrowOnFailureFlag[] = "throw_on_failure";
 
@@ -163,20 +170,26 @@ class GTestFlagSaver {
   // The c'tor.
   GTestFlagSaver() {
     also_run_disabled_tests_ = GTEST_FLAG(also_run_disabled_tests);
+    async_listeners_ = GTEST_FLAG(async_listeners);
     break_on_failure_ = GTEST_FLAG(break_on_failure);
+    brief_ = GTEST_FLAG(brief);
     catch_exceptions_ = GTEST_FLAG(catch_exceptions);
     color_ = GTEST_FLAG(color);
     death_test_style_ = GTEST_FLAG(death_test_style);
     death_test_use_fork_ = GTEST_FLAG(death_test_use_fork);
+    death_test_use_zygote_ = GTEST_FLAG(death_test_use_zygote);
     filter_ = GTEST_FLAG(filter);
     internal_run_death_test_ = GTEST_FLAG(internal_run_death_test);
+    incremental_output_ = GTEST_FLAG(incremental_output);
     list_tests_ = GTEST_FLAG(list_tests);
     output_ = GTEST_FLAG(output);
+    print_budget_ = GTEST_FLAG(print_budget);
     print_time_ = GTEST_FLAG(print_time);
     random_seed_ = GTEST_FLAG(random_seed);
     repeat_ = GTEST_FLAG(repeat);
     shuffle_ = GTEST_FLAG(shuffle);
     stack_trace_depth_ = GTEST_FLAG(stack_trace_depth);
+    stream_result_format_ = GTEST_FLAG(stream_result_format);
     stream_result_to_ = GTEST_FLAG(stream_result_to);
     throw_on_failure_ = GTEST_FLAG(throw_on_failure);
   }
@@ -184,20 +197,26 @@ class GTestFlagSaver {
   // The d'tor is not virtual.  DO NOT INHERIT FROM THIS CLASS.
   ~GTestFlagSaver() {
     GTEST_FLAG(also_run_disabled_tests) = also_run_disabled_tests_;
+    GTEST_FLAG(async_listeners) = async_listeners_;
     GTEST_FLAG(break_on_failure) = break_on_failure_;
+    GTEST_FLAG(brief) = brief_;
     GTEST_FLAG(catch_exceptions) = catch_exceptions_;
     GTEST_FLAG(color) = color_;
     GTEST_FLAG(death_test_style) = death_test_style_;
     GTEST_FLAG(death_test_use_fork) = death_test_use_fork_;
+    GTEST_FLAG(death_test_use_zygote) = death_test_use_zygote_;
     GTEST_FLAG(filter) = filter_;
     GTEST_FLAG(internal_run_death_test) = internal_run_death_test_;
+    GTEST_FLAG(incremental_output) = incremental_output_;
     GTEST_FLAG(list_tests) = list_tests_;
     GTEST_FLAG(output) = output_;
+    GTEST_FLAG(print_budget) = print_budget_;
     GTEST_FLAG(print_time) = print_time_;
     GTEST_FLAG(random_seed) = random_seed_;
     GTEST_FLAG(repeat) = repeat_;
     GTEST_FLAG(shuffle) = shuffle_;
     GTEST_FLAG(stack_trace_depth) = stack_trace_depth_;
+    GTEST_FLAG(stream_result_format) = stream_result_format_;
     GTEST_FLAG(stream_result_to) = stream_result_to_;
     GTEST_FLAG(throw_on_failure) = throw_on_failure_;
   }
@@ -205,20 +224,26 @@ class GTestFlagSaver {
  private:
   // Fields for saving the original values of flags.
   bool also_run_disabled_tests_;
+  bool async_listeners_;
   bool break_on_failure_;
+  bool brief_;
   bool catch_exceptions_;
   std::string color_;
   std::string death_test_style_;
   bool death_test_use_fork_;
+  bool death_test_use_zygote_;
   std::string filter_;
   std::string internal_run_death_test_;
+  bool incremental_output_;
   bool list_tests_;
   std::string output_;
+  internal::Int32 print_budget_;
   bool print_time_;
   internal::Int32 random_seed_;
   internal::Int32 repeat_;
   bool shuffle_;
   internal::Int32 stack_trace_depth_;
+  std::string stream_result_format_;
   std::string stream_result_to_;
   bool throw_on_failure_;
 } GTEST_ATTRIBUTE_UNUSED_;
@@ -246,6 +271,43 @@ GTEST_API_ std::string CodePointToUtf8(UInt32 code_point);
 // will be encoded as individual Unicode characters from Basic Normal Plane.
 GTEST_API_ std::string WideStringToUtf8(const wchar_t* str, int num_chars);
 
+// The largest precision for which FormatNumber() formats floating-point
+// numbers.
+const std::streamsize kMaxFastPrecision = 20;
+
+// The maximum number of characters FormatNumber() writes.  A number
+// formatted with "%.*g" takes at most precision digits, a sign, a
+// decimal point, and an exponent like "e+308".
+const size_t kMaxFormattedNumberLength = 30;
+
+// Returns true iff a stream imbued with loc formats numbers with the
+// same digits and punctuation as FormatNumber() does.
+GTEST_API_ bool HasClassicNumberFormat(const ::std::locale& loc,
+                                       bool is_floating_point);
+
+// Formats a number into out the way ostream's << would with the
+// classic locale, the default flags, and the given precision (which
+// must be in [0, kMaxFastPrecision]), and returns its length.  out must
+// have room for kMaxFormattedNumberLength characters.
+GTEST_API_ size_t FormatNumber(short n, std::streamsize precision,  // NOLINT
+                               char* out);
+GTEST_API_ size_t FormatNumber(unsigned short n,  // NOLINT
+                               std::streamsize precision, char* out);
+GTEST_API_ size_t FormatNumber(int n, std::streamsize precision, char* out);
+GTEST_API_ size_t FormatNumber(unsigned int n, std::streamsize precision,
+                               char* out);
+GTEST_API_ size_t FormatNumber(long n, std::streamsize precision,  // NOLINT
+                               char* out);
+GTEST_API_ size_t FormatNumber(unsigned long n,  // NOLINT
+                               std::streamsize precision, char* out);
+GTEST_API_ size_t FormatNumber(BiggestInt n, std::streamsize precision,
+                               char* out);
+GTEST_API_ size_t FormatNumber(UInt64 n, std::streamsize precision,
+                               char* out);
+GTEST_API_ size_t FormatNumber(float x, std::streamsize precision, char* out);
+GTEST_API_ size_t FormatNumber(double x, std::streamsize precision,
+                               char* out);
+
 // Reads the GTEST_SHARD_STATUS_FILE environment variable, and creates the file
 // if the variable is present. If a file already exists at this location, this
 // function will write over it. If the variable is present, but the file cannot
@@ -501,6 +563,11 @@ class DefaultPerThreadTestPartResultReporter
   GTEST_DISALLOW_COPY_AND_ASSIGN_(DefaultPerThreadTestPartResultReporter);
 };
 
+class BinlogUnitTestResultPrinter;
+#if GTEST_CAN_STREAM_RESULTS_
+class StreamingListener;
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
 // The private implementation of the UnitTest class.  We don't protect
 // the methods under a mutex, as this class is not accessible by a
 // user and the UnitTest class that delegates work to this class does
@@ -598,6 +665,12 @@ class GTEST_API_ UnitTestImpl {
   // Provides access to the event listener list.
   TestEventListeners* listeners() { return &listeners_; }
 
+  // Waits until the reporting thread of --gtest_async_listeners, if any,
+  // is idle, and writes out the results buffered for the binary log and
+  // the --gtest_stream_result_to socket, so that a process forked next
+  // inherits none of them.  Returns true iff there is a reporting thread.
+  bool FlushEventsBeforeFork();
+
   // Returns the TestResult for the test that's currently running, or
   // the TestResult for the ad hoc test if no test is running.
   TestResult* current_test_result();
@@ -740,6 +813,7 @@ class GTEST_API_ UnitTestImpl {
   void ListTestsMatchingFilter();
 
   const TestCase* current_test_case() const { return current_test_case_; }
+  TestCase* current_test_case() { return current_test_case_; }
   TestInfo* current_test_info() { return current_test_info_; }
   const TestInfo* current_test_info() const { return current_test_info_; }
 
@@ -892,6 +966,16 @@ class GTEST_API_ UnitTestImpl {
   // Google Test.
   TestEventListeners listeners_;
 
+  // The printer writing the --gtest_output=binlog report, or NULL.  It
+  // is valid only while it is listeners_.default_xml_generator().
+  BinlogUnitTestResultPrinter* binlog_printer_;
+
+#if GTEST_CAN_STREAM_RESULTS_
+  // The listener streaming the results to --gtest_stream_result_to, or
+  // NULL.  listeners_ owns it.
+  StreamingListener* streaming_listener_;
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
   // The OS stack trace getter.  Will be deleted when the UnitTest
   // object is destructed.  By default, an OsStackTraceGetter is used,
   // but the user can set this field to use a custom getter if that is
@@ -1014,6 +1098,13 @@ bool ParseNaturalNumber(const ::std::string& str, Integer* number) {
 }
 #endif  // GTEST_HAS_DEATH_TEST
 
+#if GTEST_CAN_FORK_TESTS_
+// Forks the process that threadsafe-style death tests fork their child
+// processes from, if --gtest_death_test_use_zygote is set.  Returns in
+// this process, and in each of those child processes.
+void StartDeathTestZygote();
+#endif  // GTEST_CAN_FORK_TESTS_
+
 // TestResult contains some private methods that should be hidden from
 // Google Test user but are required for testing. This class allow our tests
 // to access them.
@@ -1040,17 +1131,36 @@ class TestResultAccessor {
 
 #if GTEST_CAN_STREAM_RESULTS_
 
-// Streams test results to the given port on the given host machine.
+// Streams test results to the given port on the given host machine, or
+// to a Unix domain socket.
 class StreamingListener : public EmptyTestEventListener {
  public:
+  // How the messages are delimited on the wire.
+  enum Framing {
+    // Each message is a line of '&'-separated key=value fields, with
+    // '=', '&', '%', and '\n' in the values escaped as "%xx".
+    kTextFraming,
+    // Each message is a 4-byte big-endian length followed by that many
+    // bytes of fields, each a key and a value terminated by '\0'.
+    kBinaryFraming
+  };
+
   // Abstract base class for writing strings to a socket.
   class AbstractSocketWriter {
    public:
     virtual ~AbstractSocketWriter() {}
 
-    // Sends a string to the socket.
+    // Sends a string to the socket.  The string may be buffered until
+    // the next Flush().
     virtual void Send(const string& message) = 0;
 
+    // Writes the buffered strings to the socket.
+    virtual void Flush() {}
+
+    // Writes as much of the buffered strings to the socket as it takes
+    // without waiting for the reader.
+    virtual void FlushPending() {}
+
     // Closes the socket.
     virtual void CloseConnection() {}
 
@@ -1060,11 +1170,24 @@ class StreamingListener : public EmptyTestEventListener {
     }
   };
 
-  // Concrete class for actually writing strings to a socket.
+  // Concrete class for actually writing strings to a socket.  It buffers
+  // the strings and writes them out when kFlushBytes have accumulated or
+  // kFlushMillis have passed since the last write, and whenever the
+  // listener calls FlushPending().  Writes don't block until more than
+  // kMaxPendingBytes are waiting for a slow reader.
   class SocketWriter : public AbstractSocketWriter {
    public:
+    // Connects to the given TCP port on the given host.
     SocketWriter(const string& host, const string& port)
-        : sockfd_(-1), host_name_(host), port_num_(port) {
+        : sockfd_(-1), host_name_(host), port_num_(port),
+          last_flush_time_(0) {
+      MakeConnection();
+    }
+
+    // Connects to the Unix domain socket with the given path.
+    explicit SocketWriter(const string& unix_socket_path)
+        : sockfd_(-1), unix_socket_path_(unix_socket_path),
+          last_flush_time_(0) {
       MakeConnection();
     }
 
@@ -1074,34 +1197,51 @@ class StreamingListener : public EmptyTestEventListener {
     }
 
     // Sends a string to the socket.
-    virtual void Send(const string& message) {
-      GTEST_CHECK_(sockfd_ != -1)
-          << "Send() can be called only when there is a connection.";
-
-      const int len = static_cast<int>(message.length());
-      if (write(sockfd_, message.c_str(), len) != len) {
-        GTEST_LOG_(WARNING)
-            << "stream_result_to: failed to stream to "
-            << host_name_ << ":" << port_num_;
-      }
-    }
+    virtual void Send(const string& message);
+
+    // Writes the buffered strings to the socket, waiting for the reader
+    // if necessary.
+    virtual void Flush() { WriteBuffer(0); }
+
+    // Writes the buffered strings to the socket, unless the reader is
+    // too slow to take them.
+    virtual void FlushPending();
 
    private:
     // Creates a client socket and connects to the server.
     void MakeConnection();
 
-    // Closes the socket.
+    // Returns the server, as given to --gtest_stream_result_to.
+    string Endpoint() const {
+      return unix_socket_path_.empty() ? host_name_ + ":" + port_num_
+                                       : "unix:" + unix_socket_path_;
+    }
+
+    // Writes the buffer to the socket until at most max_pending_bytes
+    // are left, waiting for the socket to become writable if necessary.
+    void WriteBuffer(size_t max_pending_bytes);
+
+    // Flushes the buffer and closes the socket.
     void CloseConnection() {
       GTEST_CHECK_(sockfd_ != -1)
           << "CloseConnection() can be called only when there is a connection.";
 
+      Flush();
       close(sockfd_);
       sockfd_ = -1;
     }
 
+    static const size_t kFlushBytes = 16 * 1024;
+    static const TimeInMillis kFlushMillis = 100;
+    static const size_t kMaxPendingBytes = 1024 * 1024;
+
     int sockfd_;  // socket file descriptor
     const string host_name_;
     const string port_num_;
+    const string unix_socket_path_;
+    // The bytes waiting to be written to the socket.
+    string buffer_;
+    TimeInMillis last_flush_time_;
 
     GTEST_DISALLOW_COPY_AND_ASSIGN_(SocketWriter);
   };  // class SocketWriter
@@ -1110,76 +1250,136 @@ class StreamingListener : public EmptyTestEventListener {
   static string UrlEncode(const char* str);
 
   StreamingListener(const string& host, const string& port)
-      : socket_writer_(new SocketWriter(host, port)) { Start(); }
+      : socket_writer_(new SocketWriter(host, port)),
+        framing_(kTextFraming) { Start(); }
 
   explicit StreamingListener(AbstractSocketWriter* socket_writer)
-      : socket_writer_(socket_writer) { Start(); }
+      : socket_writer_(socket_writer), framing_(kTextFraming) { Start(); }
+
+  StreamingListener(AbstractSocketWriter* socket_writer, Framing framing)
+      : socket_writer_(socket_writer), framing_(framing) { Start(); }
+
+  int SubscribedEvents() const {
+    return kAllEvents & ~(kEnvironmentsSetUpStart |
+                          kEnvironmentsSetUpEnd |
+                          kEnvironmentsTearDownStart |
+                          kEnvironmentsTearDownEnd);
+  }
+
+  // Writes the messages buffered so far to the socket.
+  void Flush() { socket_writer_->Flush(); }
 
   void OnTestProgramStart(const UnitTest& /* unit_test */) {
-    SendLn("event=TestProgramStart");
+    StartEvent("TestProgramStart");
+    SendMessage();
   }
 
   void OnTestProgramEnd(const UnitTest& unit_test) {
     // Note that Google Test current only report elapsed time for each
     // test iteration, not for the entire test program.
-    SendLn("event=TestProgramEnd&passed=" + FormatBool(unit_test.Passed()));
+    StartEvent("TestProgramEnd");
+    AddBoolField("passed", unit_test.Passed());
+    SendMessage();
 
     // Notify the streaming server to stop.
     socket_writer_->CloseConnection();
   }
 
   void OnTestIterationStart(const UnitTest& /* unit_test */, int iteration) {
-    SendLn("event=TestIterationStart&iteration=" +
-           StreamableToString(iteration));
+    StartEvent("TestIterationStart");
+    AddIntField("iteration", iteration, "");
+    SendMessage();
   }
 
   void OnTestIterationEnd(const UnitTest& unit_test, int /* iteration */) {
-    SendLn("event=TestIterationEnd&passed=" +
-           FormatBool(unit_test.Passed()) + "&elapsed_time=" +
-           StreamableToString(unit_test.elapsed_time()) + "ms");
+    StartEvent("TestIterationEnd");
+    AddBoolField("passed", unit_test.Passed());
+    AddIntField("elapsed_time", unit_test.elapsed_time(), "ms");
+    SendMessage();
+
+    // The receiver shouldn't have to wait for the next event to learn
+    // that the iteration is over.
+    socket_writer_->Flush();
   }
 
   void OnTestCaseStart(const TestCase& test_case) {
-    SendLn(std::string("event=TestCaseStart&name=") + test_case.name());
+    StartEvent("TestCaseStart");
+    AddField("name", test_case.name());
+    SendMessage();
   }
 
   void OnTestCaseEnd(const TestCase& test_case) {
-    SendLn("event=TestCaseEnd&passed=" + FormatBool(test_case.Passed())
-           + "&elapsed_time=" + StreamableToString(test_case.elapsed_time())
-           + "ms");
+    StartEvent("TestCaseEnd");
+    AddBoolField("passed", test_case.Passed());
+    AddIntField("elapsed_time", test_case.elapsed_time(), "ms");
+    SendMessage();
   }
 
   void OnTestStart(const TestInfo& test_info) {
-    SendLn(std::string("event=TestStart&name=") + test_info.name());
+    StartEvent("TestStart");
+    AddField("name", test_info.name());
+    SendMessage();
+
+    // Lets the receiver tell which test hangs or crashes the program
+    // without waiting for the next event.
+    socket_writer_->FlushPending();
   }
 
   void OnTestEnd(const TestInfo& test_info) {
-    SendLn("event=TestEnd&passed=" +
-           FormatBool((test_info.result())->Passed()) +
-           "&elapsed_time=" +
-           StreamableToString((test_info.result())->elapsed_time()) + "ms");
+    StartEvent("TestEnd");
+    AddBoolField("passed", test_info.result()->Passed());
+    AddIntField("elapsed_time", test_info.result()->elapsed_time(), "ms");
+    SendMessage();
   }
 
   void OnTestPartResult(const TestPartResult& test_part_result) {
     const char* file_name = test_part_result.file_name();
     if (file_name == NULL)
       file_name = "";
-    SendLn("event=TestPartResult&file=" + UrlEncode(file_name) +
-           "&line=" + StreamableToString(test_part_result.line_number()) +
-           "&message=" + UrlEncode(test_part_result.message()));
+    StartEvent("TestPartResult");
+    AddField("file", file_name);
+    AddIntField("line", test_part_result.line_number(), "");
+    AddField("message", test_part_result.message());
+    SendMessage();
+    socket_writer_->FlushPending();
   }
 
  private:
-  // Sends the given message and a newline to the socket.
-  void SendLn(const string& message) { socket_writer_->SendLn(message); }
+  // Starts composing a message in message_.
+  void StartMessage();
+
+  // Starts composing the message for the given event.
+  void StartEvent(const char* event) {
+    StartMessage();
+    AddField("event", event);
+  }
+
+  // Appends a field to the message, escaping the value as the framing
+  // requires.
+  void AddField(const char* key, const char* value);
+
+  // Appends a field whose value is a number followed by the given unit.
+  void AddIntField(const char* key, TimeInMillis value, const char* unit);
+
+  void AddBoolField(const char* key, bool value) {
+    AddField(key, value ? "1" : "0");
+  }
+
+  // Finishes the message and sends it to the socket.
+  void SendMessage();
 
   // Called at the start of streaming to notify the receiver what
   // protocol we are using.
-  void Start() { SendLn("gtest_streaming_protocol_version=1.0"); }
-
-  string FormatBool(bool value) { return value ? "1" : "0"; }
+  void Start() {
+    StartMessage();
+    AddField("gtest_streaming_protocol_version", "1.0");
+    SendMessage();
+  }
 
   const scoped_ptr<AbstractSocketWriter> socket_writer_;
+  const Framing framing_;
+  // The message being composed; reused to avoid an allocation per event.
+  string message_;
 
   GTEST_DISALLOW_COPY_AND_ASSIGN_(StreamingListener);
 };  // class StreamingListener
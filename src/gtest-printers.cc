@@ -44,12 +44,29 @@
 
 #include "gtest/gtest-printers.h"
 #include <ctype.h>
+#include <locale.h>
 #include <stdio.h>
+#include <string.h>
 #include <cwchar>
+#include <limits>
+#include <locale>
 #include <ostream>  // NOLINT
 #include <string>
 #include "gtest/internal/gtest-port.h"
 
+// Indicates that this translation unit is part of Google Test's
+// implementation.  It must come before gtest-internal-inl.h is
+// included, or there will be a compiler error.  This trick exists to
+// prevent the accidental inclusion of gtest-internal-inl.h in the
+// user's code.
+#define GTEST_IMPLEMENTATION_ 1
+#include "src/gtest-internal-inl.h"
+#undef GTEST_IMPLEMENTATION_
+
+#if GTEST_HAS_SSE2
+# include <emmintrin.h>
+#endif
+
 namespace testing {
 
 namespace {
@@ -62,20 +79,26 @@ GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
 GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_
 void PrintByteSegmentInObjectTo(const unsigned char* obj_bytes, size_t start,
                                 size_t count, ostream* os) {
-  char text[5] = "";
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  // The bytes are formatted into a buffer, which is written to the
+  // stream whenever it can't take another byte.
+  char buffer[256];
+  size_t size = 0;
   for (size_t i = 0; i != count; i++) {
     const size_t j = start + i;
+    if (size > sizeof(buffer) - 3) {
+      os->write(buffer, static_cast<std::streamsize>(size));
+      size = 0;
+    }
     if (i != 0) {
       // Organizes the bytes into groups of 2 for easy parsing by
       // human.
-      if ((j % 2) == 0)
-        *os << ' ';
-      else
-        *os << '-';
+      buffer[size++] = (j % 2) == 0 ? ' ' : '-';
     }
-    GTEST_SNPRINTF_(text, sizeof(text), "%02X", obj_bytes[j]);
-    *os << text;
+    buffer[size++] = kHexDigits[obj_bytes[j] >> 4];
+    buffer[size++] = kHexDigits[obj_bytes[j] & 0xF];
   }
+  os->write(buffer, static_cast<std::streamsize>(size));
 }
 
 // Prints the bytes in the given value to the given ostream.
@@ -120,6 +143,297 @@ void PrintBytesInObjectTo(const unsigned char* obj_bytes, size_t count,
 
 namespace internal {
 
+// Returns the index of the ostream word that points to the running
+// print budget of the stream.
+static int PrintBudgetIndex() {
+  static const int index = ::std::ios_base::xalloc();
+  return index;
+}
+
+PrintBudget* PrintBudget::Of(ostream* os) {
+  return static_cast<PrintBudget*>(os->pword(PrintBudgetIndex()));
+}
+
+PrintBudget::PrintBudget(ostream* os)
+    : os_(os),
+      is_running_(false),
+      elements_left_(0),
+      end_(-1),
+      spent_(false) {
+  const Int32 budget = GTEST_FLAG(print_budget);
+  if (budget <= 0 || Of(os) != NULL)
+    return;
+
+  elements_left_ = static_cast<size_t>(budget) / 2;
+  const ::std::streamoff start = os->tellp();
+  if (start != -1)
+    end_ = start + budget;
+  os->pword(PrintBudgetIndex()) = this;
+  is_running_ = true;
+}
+
+PrintBudget::~PrintBudget() {
+  if (is_running_)
+    os_->pword(PrintBudgetIndex()) = NULL;
+}
+
+bool PrintBudget::ConsumeElement(ostream* os) {
+  PrintBudget* const budget = Of(os);
+  if (budget == NULL)
+    return true;
+
+  if (!budget->spent_) {
+    if (budget->elements_left_ == 0 ||
+        (budget->end_ != -1 &&
+         static_cast< ::std::streamoff>(os->tellp()) >= budget->end_)) {
+      budget->spent_ = true;
+    } else {
+      budget->elements_left_--;
+    }
+  }
+  return !budget->spent_;
+}
+
+bool PrintBudget::ConsumeElements(ostream* os, size_t count,
+                                  size_t max_chars) {
+  PrintBudget* const budget = Of(os);
+  if (budget == NULL)
+    return true;
+  if (budget->spent_ || budget->elements_left_ < count)
+    return false;
+
+  if (budget->end_ != -1) {
+    const ::std::streamoff pos = os->tellp();
+    if (pos != -1 &&
+        (pos >= budget->end_ ||
+         static_cast<size_t>(budget->end_ - pos) < max_chars)) {
+      return false;
+    }
+  }
+  budget->elements_left_ -= count;
+  return true;
+}
+
+size_t PrintBudget::CharactersLeft(ostream* os) {
+  const PrintBudget* const budget = Of(os);
+  if (budget == NULL || budget->end_ == -1)
+    return (::std::numeric_limits<size_t>::max)();
+  if (budget->spent_)
+    return 0;
+
+  const ::std::streamoff pos = os->tellp();
+  if (pos == -1)
+    return (::std::numeric_limits<size_t>::max)();
+  return pos < budget->end_ ? static_cast<size_t>(budget->end_ - pos) : 0;
+}
+
+void PrintOmittedElementsTo(size_t count, ostream* os) {
+  *os << "... (" << count << " more)";
+}
+
+// The maximum length of a formatted number and the separator before it.
+const size_t kMaxFormattedElementLength = kMaxFormattedNumberLength + 2;
+
+// "00" through "99", for formatting two decimal digits at a time.
+static const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+bool HasClassicNumberFormat(const ::std::locale& loc,
+                            bool is_floating_point) {
+  // snprintf() uses the C locale's decimal point.
+  if (is_floating_point && strcmp(localeconv()->decimal_point, ".") != 0)
+    return false;
+  return loc == ::std::locale::classic();
+}
+
+// Returns true iff os prints a number the way FormatNumber() does: in
+// decimal, without padding or a '+' sign, with the classic locale's
+// digits and punctuation, and, for a floating-point number, as "%.*g"
+// with a precision of at most kMaxFastPrecision would.
+static bool HasDefaultNumberFormat(ostream* os, bool is_floating_point) {
+  const ::std::ios_base::fmtflags flags = os->flags();
+  if (os->width() != 0 || (flags & ::std::ios_base::showpos) != 0)
+    return false;
+
+  if (is_floating_point) {
+    const ::std::ios_base::fmtflags kNonDefaultFlags =
+        ::std::ios_base::floatfield | ::std::ios_base::showpoint |
+        ::std::ios_base::uppercase;
+    const std::streamsize precision = os->precision();
+    if ((flags & kNonDefaultFlags) != 0 || precision < 0 ||
+        precision > kMaxFastPrecision) {
+      return false;
+    }
+  } else {
+    const ::std::ios_base::fmtflags base = flags & ::std::ios_base::basefield;
+    if (base == ::std::ios_base::oct || base == ::std::ios_base::hex)
+      return false;
+  }
+  return HasClassicNumberFormat(os->getloc(), is_floating_point);
+}
+
+// Formats n in decimal so that it ends right before end, and returns
+// where it starts.
+template <typename UInt>
+static char* FormatDecimalBackwards(UInt n, char* end) {
+  while (n >= 100) {
+    const size_t i = static_cast<size_t>(n % 100) * 2;
+    n /= 100;
+    *--end = kDigitPairs[i + 1];
+    *--end = kDigitPairs[i];
+  }
+  if (n >= 10) {
+    const size_t i = static_cast<size_t>(n) * 2;
+    *--end = kDigitPairs[i + 1];
+    *--end = kDigitPairs[i];
+  } else {
+    *--end = static_cast<char>('0' + n);
+  }
+  return end;
+}
+
+// Formats an unsigned integer into out, and returns its length.
+template <typename UInt>
+static size_t FormatUnsigned(UInt n, char* out) {
+  char digits[24];
+  char* const end = digits + sizeof(digits);
+  const char* const begin = FormatDecimalBackwards(n, end);
+  memcpy(out, begin, static_cast<size_t>(end - begin));
+  return static_cast<size_t>(end - begin);
+}
+
+// Formats a signed integer into out, and returns its length.  UInt is
+// the unsigned version of Int.
+template <typename UInt, typename Int>
+static size_t FormatSigned(Int n, char* out) {
+  if (n >= 0)
+    return FormatUnsigned(static_cast<UInt>(n), out);
+
+  // Negating in the unsigned type is well-defined for the minimum value.
+  out[0] = '-';
+  return 1 + FormatUnsigned(static_cast<UInt>(0 - static_cast<UInt>(n)),
+                            out + 1);
+}
+
+size_t FormatNumber(short n, std::streamsize, char* out) {  // NOLINT
+  return FormatSigned<unsigned short>(n, out);  // NOLINT
+}
+size_t FormatNumber(unsigned short n,  // NOLINT
+                    std::streamsize, char* out) {
+  return FormatUnsigned(n, out);
+}
+size_t FormatNumber(int n, std::streamsize, char* out) {
+  return FormatSigned<unsigned int>(n, out);
+}
+size_t FormatNumber(unsigned int n, std::streamsize, char* out) {
+  return FormatUnsigned(n, out);
+}
+size_t FormatNumber(long n, std::streamsize, char* out) {  // NOLINT
+  return FormatSigned<unsigned long>(n, out);  // NOLINT
+}
+size_t FormatNumber(unsigned long n,  // NOLINT
+                    std::streamsize, char* out) {
+  return FormatUnsigned(n, out);
+}
+size_t FormatNumber(BiggestInt n, std::streamsize, char* out) {
+  return FormatSigned<UInt64>(n, out);
+}
+size_t FormatNumber(UInt64 n, std::streamsize, char* out) {
+  return FormatUnsigned(n, out);
+}
+size_t FormatNumber(double x, std::streamsize precision, char* out) {
+  const int length = GTEST_SNPRINTF_(out, kMaxFormattedNumberLength,
+                                     "%.*g", static_cast<int>(precision), x);
+  return static_cast<size_t>(length);
+}
+size_t FormatNumber(float x, std::streamsize precision, char* out) {
+  return FormatNumber(static_cast<double>(x), precision, out);
+}
+
+// Implements the PrintRawArrayTo() overloads for arrays of numbers.
+// Falls back to the generic version when the stream doesn't use the
+// default number format, or when the numbers might not fit in the
+// print budget, so that the budget is applied element by element.
+template <typename Number>
+static bool PrintNumbersTo(const Number* a, size_t count, ostream* os,
+                           size_t num_following) {
+  const bool is_floating_point = !std::numeric_limits<Number>::is_integer;
+  if (!HasDefaultNumberFormat(os, is_floating_point) ||
+      !PrintBudget::ConsumeElements(os, count,
+                                    count * kMaxFormattedElementLength)) {
+    return PrintRawArrayTo<Number>(a, count, os, num_following);
+  }
+
+  const std::streamsize precision = os->precision();
+  // The numbers are formatted into a buffer, which is written to the
+  // stream whenever it can't take another number.
+  char buffer[1024];
+  size_t size = 0;
+  for (size_t i = 0; i != count; i++) {
+    if (size > sizeof(buffer) - kMaxFormattedElementLength) {
+      os->write(buffer, static_cast<std::streamsize>(size));
+      size = 0;
+    }
+    if (i != 0) {
+      buffer[size++] = ',';
+      buffer[size++] = ' ';
+    }
+    size += FormatNumber(a[i], precision, buffer + size);
+  }
+  os->write(buffer, static_cast<std::streamsize>(size));
+  return true;
+}
+
+bool PrintRawArrayTo(const short a[], size_t count,  // NOLINT
+                     ostream* os, size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const unsigned short a[], size_t count,  // NOLINT
+                     ostream* os, size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const int a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const unsigned int a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const long a[], size_t count,  // NOLINT
+                     ostream* os, size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const unsigned long a[], size_t count,  // NOLINT
+                     ostream* os, size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const BiggestInt a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const UInt64 a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const float a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+bool PrintRawArrayTo(const double a[], size_t count, ostream* os,
+                     size_t num_following) {
+  return PrintNumbersTo(a, count, os, num_following);
+}
+
 // Depending on the value of a char (or wchar_t), we print it in one
 // of three formats:
 //   - as is if it's a printable ASCII (e.g. 'a', '2', ' '),
@@ -138,6 +452,23 @@ inline bool IsPrintableAscii(wchar_t c) {
   return 0x20 <= c && c <= 0x7E;
 }
 
+// Prints "\\x" followed by the given character code in upper-case
+// hexadecimal, without leading zeros.
+template <typename UnsignedChar>
+static void PrintHexEscapeTo(UnsignedChar code, ostream* os) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+  char buffer[2 + 2 * sizeof(code)];
+  char* const end = buffer + sizeof(buffer);
+  char* begin = end;
+  do {
+    *--begin = kHexDigits[code & 0xF];
+    code = static_cast<UnsignedChar>(code >> 4);
+  } while (code != 0);
+  *--begin = 'x';
+  *--begin = '\\';
+  os->write(begin, end - begin);
+}
+
 // Prints a wide or narrow char c as a character literal without the
 // quotes, escaping it when necessary; returns how c was formatted.
 // The template argument UnsignedChar is the unsigned version of Char,
@@ -180,7 +511,7 @@ static CharFormat PrintAsCharLiteralTo(Char c, ostream* os) {
         *os << static_cast<char>(c);
         return kAsIs;
       } else {
-        *os << "\\x" + String::FormatHexInt(static_cast<UnsignedChar>(c));
+        PrintHexEscapeTo(static_cast<UnsignedChar>(c), os);
         return kHexEscape;
       }
   }
@@ -251,10 +582,87 @@ void PrintTo(wchar_t wc, ostream* os) {
   PrintCharAndCodeTo<wchar_t>(wc, os);
 }
 
+// Returns true iff c is printed as is in a string literal.
+inline bool IsPlainStringChar(wchar_t c) {
+  return IsPrintableAscii(c) && c != L'"' && c != L'\\';
+}
+
+// Returns the length of the run of characters at the start of [begin,
+// end) that are printed as is in a string literal.
+GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_
+GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
+GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_
+static size_t PlainStringCharRunLength(const char* begin, const char* end) {
+  const char* p = begin;
+#if GTEST_HAS_SSE2
+  // Checks 16 characters at a time.  Bytes are signed here, so the
+  // ones above 0x7F fail the range check too.
+  const __m128i kBeforeSpace = _mm_set1_epi8(0x1F);
+  const __m128i kDelete = _mm_set1_epi8(0x7F);
+  const __m128i kQuote = _mm_set1_epi8('"');
+  const __m128i kBackslash = _mm_set1_epi8('\\');
+  while (end - p >= 16) {
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(chars, kBeforeSpace),
+                                            _mm_cmplt_epi8(chars, kDelete));
+    const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chars, kQuote),
+                                         _mm_cmpeq_epi8(chars, kBackslash));
+    if (_mm_movemask_epi8(_mm_andnot_si128(special, printable)) != 0xFFFF)
+      break;  // The loop below finds where the run ends.
+    p += 16;
+  }
+#endif  // GTEST_HAS_SSE2
+  while (p != end && IsPlainStringChar(static_cast<unsigned char>(*p)))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_
+GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
+GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_
+static size_t PlainStringCharRunLength(const wchar_t* begin,
+                                       const wchar_t* end) {
+  const wchar_t* p = begin;
+  while (p != end && IsPlainStringChar(*p))
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+// Writes a run of characters that are printed as is.
+GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_
+GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
+GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_
+static void WritePlainStringChars(const char* begin, size_t len,
+                                  ostream* os) {
+  os->write(begin, static_cast<std::streamsize>(len));
+}
+
+GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_
+GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
+GTEST_ATTRIBUTE_NO_SANITIZE_THREAD_
+static void WritePlainStringChars(const wchar_t* begin, size_t len,
+                                  ostream* os) {
+  // The characters are ASCII, so narrowing them loses nothing.
+  char buffer[256];
+  while (len > 0) {
+    const size_t chunk = (std::min)(len, sizeof(buffer));
+    for (size_t i = 0; i != chunk; i++)
+      buffer[i] = static_cast<char>(begin[i]);
+    os->write(buffer, static_cast<std::streamsize>(chunk));
+    begin += chunk;
+    len -= chunk;
+  }
+}
+
 // Prints the given array of characters to the ostream.  CharType must be either
 // char or wchar_t.
 // The array starts at begin, the length is len, it may include '\0' characters
-// and may not be NUL-terminated.
+// and may not be NUL-terminated.  Only as many characters as the print
+// budget allows are printed.
+//
+// Runs of characters that need no escaping, which make up most
+// strings, are written with one call each; only the other characters
+// are printed one by one.
 template <typename CharType>
 GTEST_ATTRIBUTE_NO_SANITIZE_MEMORY_
 GTEST_ATTRIBUTE_NO_SANITIZE_ADDRESS_
@@ -263,18 +671,30 @@ static void PrintCharsAsStringTo(
     const CharType* begin, size_t len, ostream* os) {
   const char* const kQuoteBegin = sizeof(CharType) == 1 ? "\"" : "L\"";
   *os << kQuoteBegin;
+  const size_t print_len = (std::min)(len, PrintBudget::CharactersLeft(os));
+  const CharType* const end = begin + print_len;
   bool is_previous_hex = false;
-  for (size_t index = 0; index < len; ++index) {
-    const CharType cur = begin[index];
-    if (is_previous_hex && IsXDigit(cur)) {
+  for (const CharType* cur = begin; cur != end; ++cur) {
+    if (is_previous_hex && IsXDigit(*cur)) {
       // Previous character is of '\x..' form and this character can be
       // interpreted as another hexadecimal digit in its number. Break string to
       // disambiguate.
       *os << "\" " << kQuoteBegin;
     }
-    is_previous_hex = PrintAsStringLiteralTo(cur, os) == kHexEscape;
+    const size_t run = PlainStringCharRunLength(cur, end);
+    if (run > 0) {
+      WritePlainStringChars(cur, run, os);
+      cur += run - 1;
+      is_previous_hex = false;
+    } else {
+      is_previous_hex = PrintAsStringLiteralTo(*cur, os) == kHexEscape;
+    }
   }
   *os << "\"";
+  if (print_len < len) {
+    *os << ' ';
+    PrintOmittedElementsTo(len - print_len, os);
+  }
 }
 
 // Prints a (const) char/wchar_t array of 'len' elements, starting at address
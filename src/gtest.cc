@@ -128,8 +128,19 @@
 #if GTEST_CAN_STREAM_RESULTS_
 # include <arpa/inet.h>  // NOLINT
 # include <netdb.h>  // NOLINT
+# include <poll.h>  // NOLINT
 # include <sys/socket.h>  // NOLINT
 # include <sys/types.h>  // NOLINT
+# include <sys/un.h>  // NOLINT
+#endif
+
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+# include <errno.h>  // NOLINT
+# include <sys/time.h>  // NOLINT
+#endif
+
+#if GTEST_HAS_SSE2
+# include <emmintrin.h>
 #endif
 
 // Indicates that this translation unit is part of Google Test's
@@ -166,8 +177,11 @@ static const char kDeathTestCaseFilter[] = "*DeathTest:*DeathTest/*";
 // A test filter that matches everything.
 static const char kUniversalFilter[] = "*";
 
-// The default output file for XML output.
-static const char kDefaultOutputFile[] = "test_detail.xml";
+// The default output format.
+static const char kDefaultOutputFormat[] = "xml";
+
+// The default output file, without the extension of its format.
+static const char kDefaultOutputFile[] = "test_detail";
 
 // The environment variable name for the test shard index.
 static const char kTestShardIndex[] = "GTEST_SHARD_INDEX";
@@ -197,11 +211,23 @@ GTEST_DEFINE_bool_(
     internal::BoolFromGTestEnv("also_run_disabled_tests", false),
     "Run disabled tests too, in addition to the tests normally being run.");
 
+GTEST_DEFINE_bool_(
+    async_listeners,
+    internal::BoolFromGTestEnv("async_listeners", false),
+    "True iff test events should be delivered to the listeners on a "
+    "background reporting thread instead of the thread running the tests.");
+
 GTEST_DEFINE_bool_(
     break_on_failure,
     internal::BoolFromGTestEnv("break_on_failure", false),
     "True iff a failed assertion should be a debugger break-point.");
 
+GTEST_DEFINE_bool_(
+    brief,
+    internal::BoolFromGTestEnv("brief", false),
+    "True iff only failures, a progress line, and the summary should be "
+    "printed to the console, instead of a line for every test.");
+
 GTEST_DEFINE_bool_(
     catch_exceptions,
     internal::BoolFromGTestEnv("catch_exceptions", true),
@@ -225,21 +251,35 @@ GTEST_DEFINE_string_(
     "exclude).  A test is run if it matches one of the positive "
     "patterns and does not match any of the negative patterns.");
 
+GTEST_DEFINE_bool_(
+    incremental_output,
+    internal::BoolFromGTestEnv("incremental_output", false),
+    "True iff the XML or JSON report is written as tests finish, and "
+    "completed when they are done, so that a crash leaves a "
+    "partial report behind.");
+
 GTEST_DEFINE_bool_(list_tests, false,
                    "List all tests without running them.");
 
 GTEST_DEFINE_string_(
     output,
     internal::StringFromGTestEnv("output", ""),
-    "A format (currently must be \"xml\"), optionally followed "
+    "A format (\"xml\", \"json\", or \"binlog\"), optionally followed "
     "by a colon and an output file name or directory. A directory "
     "is indicated by a trailing pathname separator. "
-    "Examples: \"xml:filename.xml\", \"xml::directoryname/\". "
+    "Examples: \"xml:filename.xml\", \"json:directoryname/\". "
     "If a directory is specified, output files will be created "
     "within that directory, with file-names based on the test "
     "executable's name and, if necessary, made unique by adding "
     "digits.");
 
+GTEST_DEFINE_int32_(
+    print_budget,
+    internal::Int32FromGTestEnv("print_budget", kDefaultPrintBudget),
+    "The maximum number of characters to print for a value in a failure "
+    "message, or 0 for no limit.  Containers, arrays, and strings that "
+    "don't fit are cut short with \"... (N more)\".");
+
 GTEST_DEFINE_bool_(
     print_time,
     internal::BoolFromGTestEnv("print_time", true),
@@ -279,8 +319,15 @@ GTEST_DEFINE_string_(
     stream_result_to,
     internal::StringFromGTestEnv("stream_result_to", ""),
     "This flag specifies the host name and the port number on which to stream "
-    "test results. Example: \"localhost:555\". The flag is effective only on "
-    "Linux.");
+    "test results. Example: \"localhost:555\". It can also specify a Unix "
+    "domain socket. Example: \"unix:/tmp/gtest.sock\". The flag is effective "
+    "only on Linux.");
+
+GTEST_DEFINE_string_(
+    stream_result_format,
+    internal::StringFromGTestEnv("stream_result_format", "text"),
+    "How the streamed test results are framed: \"text\" for a line per event, "
+    "or \"binary\" for a length-prefixed message per event.");
 
 GTEST_DEFINE_bool_(
     throw_on_failure,
@@ -412,12 +459,17 @@ std::string UnitTestOptions::GetAbsolutePathToOutputFile() {
   if (gtest_output_flag == NULL)
     return "";
 
+  std::string format = GetOutputFormat();
+  if (format.empty())
+    format = kDefaultOutputFormat;
+
   const char* const colon = strchr(gtest_output_flag, ':');
   if (colon == NULL)
     return internal::FilePath::ConcatPaths(
         internal::FilePath(
             UnitTest::GetInstance()->original_working_dir()),
-        internal::FilePath(kDefaultOutputFile)).string();
+        internal::FilePath(std::string(kDefaultOutputFile) + "." +
+                           format)).string();
 
   internal::FilePath output_name(colon + 1);
   if (!output_name.IsAbsolutePath())
@@ -433,8 +485,7 @@ std::string UnitTestOptions::GetAbsolutePathToOutputFile() {
     return output_name.string();
 
   internal::FilePath result(internal::FilePath::GenerateUniqueFileName(
-      output_name, internal::GetCurrentExecutableName(),
-      GetOutputFormat().c_str()));
+      output_name, internal::GetCurrentExecutableName(), format.c_str()));
   return result.string();
 }
 
@@ -901,15 +952,112 @@ static void StreamWideCharsToMessage(const wchar_t* wstr, size_t length,
 
 }  // namespace internal
 
+// By default, we want there to be enough precision when printing a
+// double to a Message.
+static const std::streamsize kMessagePrecision =
+    std::numeric_limits<double>::digits10 + 2;
+
 // Constructs an empty Message.
-// We allocate the stringstream separately because otherwise each use of
-// ASSERT/EXPECT in a procedure adds over 200 bytes to the procedure's
-// stack frame leading to huge stack frames in some cases; gcc does not reuse
-// the stack space.
-Message::Message() : ss_(new ::std::stringstream) {
-  // By default, we want there to be enough precision when printing
-  // a double to a Message.
-  *ss_ << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+// We allocate the buffer and the stringstream separately, and only when
+// they are needed, because otherwise each use of ASSERT/EXPECT in a
+// procedure adds over 100 bytes to the procedure's stack frame leading
+// to huge stack frames in some cases; gcc does not reuse the stack
+// space.
+Message::Message() {}
+
+// Copy constructor.
+Message::Message(const Message& msg) {
+  *this << msg.GetString();
+}
+
+// Constructs a Message from a C-string.
+Message::Message(const char* str) {
+  *this << str;
+}
+
+void Message::AppendToNewBufferOrStream(const char* str, size_t length) {
+  if (length == 0) {
+    return;
+  } else if (ss_.get() == NULL && buffer_.get() == NULL &&
+             length <= kBufferSize) {
+    buffer_.reset(new Buffer);
+    memcpy(buffer_->chars, str, length);
+    buffer_->size = length;
+  } else {
+    GetStream().write(str, static_cast<std::streamsize>(length));
+  }
+}
+
+std::ostream& Message::GetStream() {
+  if (ss_.get() == NULL) {
+    ss_.reset(new ::std::stringstream);
+    *ss_ << std::setprecision(kMessagePrecision);
+    if (buffer_.get() != NULL) {
+      ss_->write(buffer_->chars, static_cast<std::streamsize>(buffer_->size));
+      buffer_.reset();
+    }
+  }
+  return *ss_;
+}
+
+// Streams the basic IO manipulators.  endl and ends are common enough
+// in failure messages to be worth handling without a stringstream.
+Message& Message::operator <<(BasicNarrowIoManip val) {
+  if (val == static_cast<BasicNarrowIoManip>(::std::endl)) {
+    return *this << '\n';
+  } else if (val == static_cast<BasicNarrowIoManip>(::std::ends)) {
+    return *this << '\0';
+  }
+  GetStream() << val;
+  return *this;
+}
+
+// Formats numbers with FormatNumber() until the text moves to the
+// stream, as the stream may have been given a different format since.
+// The stream would be imbued with the global locale, so that's the
+// locale that has to format numbers the classic way.
+template <typename Number>
+Message& Message::AppendNumber(Number n) {
+  if (ss_.get() == NULL &&
+      internal::HasClassicNumberFormat(
+          ::std::locale(), !std::numeric_limits<Number>::is_integer)) {
+    char buffer[internal::kMaxFormattedNumberLength];
+    Append(buffer, internal::FormatNumber(n, kMessagePrecision, buffer));
+  } else {
+    GetStream() << n;
+  }
+  return *this;
+}
+
+Message& Message::operator <<(short n) {  // NOLINT
+  return AppendNumber(n);
+}
+Message& Message::operator <<(unsigned short n) {  // NOLINT
+  return AppendNumber(n);
+}
+Message& Message::operator <<(int n) {
+  return AppendNumber(n);
+}
+Message& Message::operator <<(unsigned int n) {
+  return AppendNumber(n);
+}
+Message& Message::operator <<(long n) {  // NOLINT
+  return AppendNumber(n);
+}
+Message& Message::operator <<(unsigned long n) {  // NOLINT
+  return AppendNumber(n);
+}
+Message& Message::operator <<(internal::BiggestInt n) {
+  return AppendNumber(n);
+}
+Message& Message::operator <<(internal::UInt64 n) {
+  return AppendNumber(n);
+}
+Message& Message::operator <<(float x) {
+  return AppendNumber(x);
+}
+Message& Message::operator <<(double x) {
+  return AppendNumber(x);
 }
 
 // These two overloads allow streaming a wide C string to a Message
@@ -942,7 +1090,11 @@ Message& Message::operator <<(const ::wstring& wstr) {
 // Gets the text streamed to this object so far as an std::string.
 // Each '\0' character in the buffer is replaced with "\\0".
 std::string Message::GetString() const {
-  return internal::StringStreamToString(ss_.get());
+  if (ss_.get() != NULL)
+    return internal::StringStreamToString(ss_.get());
+  if (buffer_.get() == NULL)
+    return "";
+  return internal::StringWithEscapedNuls(buffer_->chars, buffer_->size);
 }
 
 // AssertionResult constructors.
@@ -951,7 +1103,10 @@ AssertionResult::AssertionResult(const AssertionResult& other)
     : success_(other.success_),
       message_(other.message_.get() != NULL ?
                new ::std::string(*other.message_) :
-               static_cast< ::std::string*>(NULL)) {
+               static_cast< ::std::string*>(NULL)),
+      formatter_(other.formatter_.get() != NULL ?
+                 other.formatter_->Clone() :
+                 static_cast<internal::AssertionFormatterInterface*>(NULL)) {
 }
 
 // Swaps two AssertionResults.
@@ -959,6 +1114,7 @@ void AssertionResult::swap(AssertionResult& other) {
   using std::swap;
   swap(success_, other.success_);
   swap(message_, other.message_);
+  swap(formatter_, other.formatter_);
 }
 
 // Returns the assertion's negation. Used with EXPECT/ASSERT_FALSE.
@@ -966,9 +1122,34 @@ AssertionResult AssertionResult::operator!() const {
   AssertionResult negation(!success_);
   if (message_.get() != NULL)
     negation << *message_;
+  if (formatter_.get() != NULL)
+    negation.formatter_.reset(formatter_->Clone());
   return negation;
 }
 
+// Formats the deferred message and appends it to message_.
+void AssertionResult::FormatDeferredMessage() const {
+  Message msg;
+  formatter_->FormatTo(&msg);
+  formatter_.reset();
+  if (message_.get() == NULL) {
+    message_.reset(new ::std::string(msg.GetString()));
+  } else {
+    message_->append(msg.GetString());
+  }
+}
+
+namespace internal {
+
+AssertionResult MakeDeferredAssertionResult(
+    bool success, AssertionFormatterInterface* formatter) {
+  AssertionResult result(success);
+  result.formatter_.reset(formatter);
+  return result;
+}
+
+}  // namespace internal
+
 // Makes a successful assertion result.
 AssertionResult AssertionSuccess() {
   return AssertionResult(true);
@@ -1047,36 +1228,258 @@ std::vector<EditType> CalculateOptimalEdits(const std::vector<size_t>& left,
 
 namespace {
 
-// Helper class to convert string into ids with deduplication.
+// Computes a shortest edit script with Myers' O(ND) algorithm, using
+// the linear space refinement described in section 4b of the paper: a
+// search from both ends finds a point on an optimal path, and the two
+// halves of the problem are solved recursively.  See
+// http://www.xmailserver.org/diff2.pdf
+class LinearSpaceDiff {
+ public:
+  LinearSpaceDiff(const std::vector<size_t>& left,
+                  const std::vector<size_t>& right,
+                  std::vector<EditType>* edits)
+      : left_(left), right_(right), edits_(edits) {}
+
+  // Appends the edits to *edits and returns true if at most max_edits
+  // adds and removes are needed; otherwise returns false.
+  bool Run(size_t max_edits) {
+    return Diff(0, left_.size(), 0, right_.size(), max_edits);
+  }
+
+ private:
+  void Append(EditType edit, size_t count) {
+    edits_->insert(edits_->end(), count, edit);
+  }
+
+  // Diffs left_[l_begin, l_end) against right_[r_begin, r_end).
+  bool Diff(size_t l_begin, size_t l_end, size_t r_begin, size_t r_end,
+            size_t max_edits) {
+    // Common prefixes and suffixes are always part of an optimal path.
+    size_t prefix = 0;
+    while (l_begin + prefix < l_end && r_begin + prefix < r_end &&
+           left_[l_begin + prefix] == right_[r_begin + prefix]) {
+      ++prefix;
+    }
+    Append(kMatch, prefix);
+    l_begin += prefix;
+    r_begin += prefix;
+    size_t suffix = 0;
+    while (l_begin < l_end - suffix && r_begin < r_end - suffix &&
+           left_[l_end - suffix - 1] == right_[r_end - suffix - 1]) {
+      ++suffix;
+    }
+    l_end -= suffix;
+    r_end -= suffix;
+
+    if (l_begin == l_end || r_begin == r_end) {
+      if ((l_end - l_begin) + (r_end - r_begin) > max_edits) return false;
+      Append(kRemove, l_end - l_begin);
+      Append(kAdd, r_end - r_begin);
+    } else {
+      size_t l_split, r_split;
+      if (!FindSplit(l_begin, l_end, r_begin, r_end, max_edits,
+                     &l_split, &r_split)) {
+        return false;
+      }
+      // The limit only needs to be checked once: FindSplit() has
+      // already bounded the cost of both halves.
+      const size_t kNoLimit = std::numeric_limits<size_t>::max();
+      Diff(l_begin, l_split, r_begin, r_split, kNoLimit);
+      Diff(l_split, l_end, r_split, r_end, kNoLimit);
+    }
+    Append(kMatch, suffix);
+    return true;
+  }
+
+  // Finds a point (l_split, r_split) on an optimal path through a
+  // problem that has no common prefix or suffix, by running the greedy
+  // algorithm forward from the start and backward from the end until
+  // the two searches meet.  Returns false if the edit distance exceeds
+  // max_edits.
+  bool FindSplit(size_t l_begin, size_t l_end, size_t r_begin, size_t r_end,
+                 size_t max_edits, size_t* l_split, size_t* r_split) const {
+    const ptrdiff_t n = static_cast<ptrdiff_t>(l_end - l_begin);
+    const ptrdiff_t m = static_cast<ptrdiff_t>(r_end - r_begin);
+    // The searches always meet by d == (n + m + 1) / 2, and can't meet
+    // within max_edits after d == max_edits / 2 + 1; the smaller of the
+    // two bounds the search, and the memory it uses.
+    ptrdiff_t max_d = (n + m + 1) / 2;
+    if (max_edits / 2 + 1 < static_cast<size_t>(max_d))
+      max_d = static_cast<ptrdiff_t>(max_edits / 2 + 1);
+    const ptrdiff_t offset = max_d + 1;
+    const ptrdiff_t delta = n - m;
+    const bool delta_is_odd = (delta & 1) != 0;
+
+    // forward[offset + k] is the furthest x reached on diagonal k = x - y
+    // by the forward search; backward[offset + k] is the same for the
+    // backward search, which measures x and y from the ends.
+    std::vector<ptrdiff_t> forward(2 * offset + 1, -1);
+    std::vector<ptrdiff_t> backward(2 * offset + 1, -1);
+    forward[offset + 1] = 0;
+    backward[offset + 1] = 0;
+
+    for (ptrdiff_t d = 0; d <= max_d; ++d) {
+      // Paths that meet in the forward search at d have 2 * d - 1 edits,
+      // and those that meet in the backward search have 2 * d.
+      if (d > 0 && static_cast<size_t>(2 * d - 1) > max_edits) return false;
+
+      for (ptrdiff_t k = -d; k <= d; k += 2) {
+        ptrdiff_t x;
+        if (k == -d || (k != d && forward[offset + k - 1] <
+                                  forward[offset + k + 1])) {
+          x = forward[offset + k + 1];
+        } else {
+          x = forward[offset + k - 1] + 1;
+        }
+        ptrdiff_t y = x - k;
+        if (x < 0 || y < 0 || x > n || y > m) continue;
+        while (x < n && y < m &&
+               left_[l_begin + x] == right_[r_begin + y]) {
+          ++x;
+          ++y;
+        }
+        forward[offset + k] = x;
+        // The backward search has covered diagonals delta - (d - 1) to
+        // delta + (d - 1); the paths overlap if they meet on one.
+        const ptrdiff_t backward_k = delta - k;
+        if (delta_is_odd && backward_k >= -(d - 1) && backward_k <= d - 1 &&
+            backward[offset + backward_k] >= 0 &&
+            x + backward[offset + backward_k] >= n) {
+          *l_split = l_begin + static_cast<size_t>(x);
+          *r_split = r_begin + static_cast<size_t>(y);
+          return true;
+        }
+      }
+
+      if (static_cast<size_t>(2 * d) > max_edits) return false;
+
+      for (ptrdiff_t k = -d; k <= d; k += 2) {
+        ptrdiff_t x;
+        if (k == -d || (k != d && backward[offset + k - 1] <
+                                  backward[offset + k + 1])) {
+          x = backward[offset + k + 1];
+        } else {
+          x = backward[offset + k - 1] + 1;
+        }
+        ptrdiff_t y = x - k;
+        if (x < 0 || y < 0 || x > n || y > m) continue;
+        while (x < n && y < m &&
+               left_[l_end - x - 1] == right_[r_end - y - 1]) {
+          ++x;
+          ++y;
+        }
+        backward[offset + k] = x;
+        const ptrdiff_t forward_k = delta - k;
+        if (!delta_is_odd && forward_k >= -d && forward_k <= d &&
+            forward[offset + forward_k] >= 0 &&
+            x + forward[offset + forward_k] >= n) {
+          *l_split = l_end - static_cast<size_t>(x);
+          *r_split = r_end - static_cast<size_t>(y);
+          return true;
+        }
+      }
+    }
+    // Not reached: the searches meet by d == (n + m + 1) / 2, and return
+    // false above if max_edits stops them first.
+    *l_split = l_end;
+    *r_split = r_begin;
+    return true;
+  }
+
+  const std::vector<size_t>& left_;
+  const std::vector<size_t>& right_;
+  std::vector<EditType>* const edits_;
+};
+
+}  // namespace
+
+bool CalculateMinimalEdits(const std::vector<size_t>& left,
+                           const std::vector<size_t>& right,
+                           size_t max_edits,
+                           std::vector<EditType>* edits) {
+  edits->clear();
+  return LinearSpaceDiff(left, right, edits).Run(max_edits);
+}
+
+namespace {
+
+// Helper class to convert strings into ids with deduplication.  It's an
+// open-addressing hash table of the strings seen so far, which makes
+// interning n lines O(n) instead of O(n log n) string comparisons.  The
+// strings are not copied, so they must outlive the table.
 class InternalStrings {
  public:
+  InternalStrings() : buckets_(16, NoId()) {}
+
   size_t GetId(const std::string& str) {
-    IdMap::iterator it = ids_.find(str);
-    if (it != ids_.end()) return it->second;
-    size_t id = ids_.size();
-    return ids_[str] = id;
+    const size_t hash = Hash(str);
+    size_t bucket = hash & (buckets_.size() - 1);
+    for (; buckets_[bucket] != NoId();
+         bucket = (bucket + 1) & (buckets_.size() - 1)) {
+      const size_t id = buckets_[bucket];
+      if (hashes_[id] == hash && *strings_[id] == str) return id;
+    }
+
+    const size_t id = strings_.size();
+    strings_.push_back(&str);
+    hashes_.push_back(hash);
+    buckets_[bucket] = id;
+    // Keeps the load factor at or below 1/2.
+    if (2 * strings_.size() > buckets_.size()) Rehash();
+    return id;
   }
 
  private:
-  typedef std::map<std::string, size_t> IdMap;
-  IdMap ids_;
+  // Marks an empty bucket.
+  static size_t NoId() { return ~static_cast<size_t>(0); }
+
+  // The 32-bit FNV-1a hash of str.
+  static size_t Hash(const std::string& str) {
+    UInt32 hash = 2166136261U;
+    for (size_t i = 0; i < str.size(); ++i) {
+      hash = (hash ^ static_cast<unsigned char>(str[i])) * 16777619U;
+    }
+    return hash;
+  }
+
+  void Rehash() {
+    buckets_.assign(2 * buckets_.size(), NoId());
+    for (size_t id = 0; id < strings_.size(); ++id) {
+      size_t bucket = hashes_[id] & (buckets_.size() - 1);
+      while (buckets_[bucket] != NoId()) {
+        bucket = (bucket + 1) & (buckets_.size() - 1);
+      }
+      buckets_[bucket] = id;
+    }
+  }
+
+  std::vector<const std::string*> strings_;  // Indexed by id.
+  std::vector<size_t> hashes_;  // Indexed by id.
+  std::vector<size_t> buckets_;  // The size is a power of 2.
 };
 
+void InternStrings(const std::vector<std::string>& left,
+                   const std::vector<std::string>& right,
+                   std::vector<size_t>* left_ids,
+                   std::vector<size_t>* right_ids) {
+  InternalStrings intern_table;
+  left_ids->reserve(left.size());
+  for (size_t i = 0; i < left.size(); ++i) {
+    left_ids->push_back(intern_table.GetId(left[i]));
+  }
+  right_ids->reserve(right.size());
+  for (size_t i = 0; i < right.size(); ++i) {
+    right_ids->push_back(intern_table.GetId(right[i]));
+  }
+}
+
 }  // namespace
 
 std::vector<EditType> CalculateOptimalEdits(
     const std::vector<std::string>& left,
     const std::vector<std::string>& right) {
   std::vector<size_t> left_ids, right_ids;
-  {
-    InternalStrings intern_table;
-    for (size_t i = 0; i < left.size(); ++i) {
-      left_ids.push_back(intern_table.GetId(left[i]));
-    }
-    for (size_t i = 0; i < right.size(); ++i) {
-      right_ids.push_back(intern_table.GetId(right[i]));
-    }
-  }
+  InternStrings(left, right, &left_ids, &right_ids);
   return CalculateOptimalEdits(left_ids, right_ids);
 }
 
@@ -1156,6 +1559,47 @@ class Hunk {
 
 }  // namespace
 
+namespace {
+
+// The maximum number of adds and removes CreateUnifiedDiff() prints a
+// full diff for.  A longer diff would be too long to read and could take
+// a long time to compute.
+const size_t kMaxDiffEdits = 1000;
+
+// The number of lines from each side CreateUnifiedDiff() prints when it
+// gives up on a full diff.
+const size_t kMaxDivergenceLines = 10;
+
+// Prints the first region where left and right differ as a hunk.
+void PrintFirstDivergence(const std::vector<std::string>& left,
+                          const std::vector<std::string>& right,
+                          size_t context, std::ostream* os) {
+  size_t prefix = 0;
+  while (prefix < left.size() && prefix < right.size() &&
+         left[prefix] == right[prefix]) {
+    ++prefix;
+  }
+
+  const size_t prefix_context = std::min(prefix, context);
+  Hunk hunk(prefix - prefix_context + 1, prefix - prefix_context + 1);
+  for (size_t i = prefix - prefix_context; i < prefix; ++i) {
+    hunk.PushLine(' ', left[i].c_str());
+  }
+  for (size_t i = prefix;
+       i < left.size() && i < prefix + kMaxDivergenceLines; ++i) {
+    hunk.PushLine('-', left[i].c_str());
+  }
+  for (size_t i = prefix;
+       i < right.size() && i < prefix + kMaxDivergenceLines; ++i) {
+    hunk.PushLine('+', right[i].c_str());
+  }
+  hunk.PrintTo(os);
+  *os << "(More than " << kMaxDiffEdits << " lines differ; only the first "
+      << "difference is shown.)\n";
+}
+
+}  // namespace
+
 // Create a list of diff hunks in Unified diff format.
 // Each hunk has a header generated by PrintHeader above plus a body with
 // lines prefixed with ' ' for no change, '-' for deletion and '+' for
@@ -1163,13 +1607,22 @@ class Hunk {
 // 'context' represents the desired unchanged prefix/suffix around the diff.
 // If two hunks are close enough that their contexts overlap, then they are
 // joined into one hunk.
+// If more than kMaxDiffEdits lines need to be added or removed, only the
+// first region where the inputs differ is printed.
 std::string CreateUnifiedDiff(const std::vector<std::string>& left,
                               const std::vector<std::string>& right,
                               size_t context) {
-  const std::vector<EditType> edits = CalculateOptimalEdits(left, right);
+  std::vector<size_t> left_ids, right_ids;
+  InternStrings(left, right, &left_ids, &right_ids);
 
-  size_t l_i = 0, r_i = 0, edit_i = 0;
+  std::vector<EditType> edits;
   std::stringstream ss;
+  if (!CalculateMinimalEdits(left_ids, right_ids, kMaxDiffEdits, &edits)) {
+    PrintFirstDivergence(left, right, context, &ss);
+    return ss.str();
+  }
+
+  size_t l_i = 0, r_i = 0, edit_i = 0;
   while (edit_i < edits.size()) {
     // Find first edit.
     while (edit_i < edits.size() && edits[edit_i] == kMatch) {
@@ -1395,6 +1848,93 @@ AssertionResult DoubleLE(const char* expr1, const char* expr2,
 
 namespace internal {
 
+// Builds the failure message of {ASSERT|EXPECT}_EQ from type-erased
+// operands.
+AssertionResult CmpHelperEQFailure(const char* expected_expression,
+                                   const char* actual_expression,
+                                   const void* expected,
+                                   OperandFormatter format_expected,
+                                   const void* actual,
+                                   OperandFormatter format_actual) {
+  return EqFailure(expected_expression,
+                   actual_expression,
+                   format_expected(expected),
+                   format_actual(actual),
+                   false);
+}
+
+namespace {
+
+// When two strings compared with {ASSERT|EXPECT}_EQ don't fit in the
+// print budget, this many characters before their first difference
+// are shown, out of kStringWindowLength in all.
+const size_t kStringWindowContext = 64;
+const size_t kStringWindowLength = 256;
+
+// Implements CmpHelperEQFailure() for strings.
+template <typename StringType>
+AssertionResult StringsEqFailure(const char* expected_expression,
+                                 const char* actual_expression,
+                                 const StringType& expected,
+                                 const StringType& actual) {
+  const size_t longest = (std::max)(expected.size(), actual.size());
+  const Int32 budget = GTEST_FLAG(print_budget);
+  if (budget <= 0 || longest <= static_cast<size_t>(budget)) {
+    return EqFailure(expected_expression, actual_expression,
+                     PrintToString(expected), PrintToString(actual), false);
+  }
+
+  const size_t shortest = (std::min)(expected.size(), actual.size());
+  const size_t first_difference = static_cast<size_t>(
+      ::std::mismatch(expected.begin(), expected.begin() + shortest,
+                      actual.begin()).first - expected.begin());
+  const size_t begin =
+      first_difference - (std::min)(first_difference, kStringWindowContext);
+  const size_t end = (std::min)(begin + kStringWindowLength, longest);
+  return EqFailure(expected_expression, actual_expression,
+                   PrintToString(expected.substr(begin, end - begin)),
+                   PrintToString(actual.substr(begin, end - begin)), false)
+      << "\nThe strings are too long to print in full, so only their "
+      << "characters [" << begin << ", " << end << ") are shown.  They first "
+      << "differ at index " << first_difference << ", and have "
+      << expected.size() << " and " << actual.size()
+      << " characters respectively.";
+}
+
+}  // namespace
+
+AssertionResult CmpHelperEQFailure(const char* expected_expression,
+                                   const char* actual_expression,
+                                   const ::std::string& expected,
+                                   const ::std::string& actual) {
+  return StringsEqFailure(expected_expression, actual_expression, expected,
+                          actual);
+}
+
+#if GTEST_HAS_STD_WSTRING
+AssertionResult CmpHelperEQFailure(const char* expected_expression,
+                                   const char* actual_expression,
+                                   const ::std::wstring& expected,
+                                   const ::std::wstring& actual) {
+  return StringsEqFailure(expected_expression, actual_expression, expected,
+                          actual);
+}
+#endif  // GTEST_HAS_STD_WSTRING
+
+// Builds the failure message of {ASSERT|EXPECT}_OP from type-erased
+// operands.
+AssertionResult CmpHelperOpFailure(const char* expr1,
+                                   const char* expr2,
+                                   const void* val1,
+                                   OperandFormatter format_val1,
+                                   const void* val2,
+                                   OperandFormatter format_val2,
+                                   const char* op) {
+  return AssertionFailure()
+         << "Expected: (" << expr1 << ") " << op << " (" << expr2
+         << "), actual: " << format_val1(val1) << " vs " << format_val2(val2);
+}
+
 // The helper function for {ASSERT|EXPECT}_EQ with int or enum
 // arguments.
 AssertionResult CmpHelperEQ(const char* expected_expression,
@@ -1713,6 +2253,48 @@ inline UInt32 ChopLowBits(UInt32* bits, int n) {
   return low_bits;
 }
 
+// The maximum number of characters WriteCodePointAsUtf8() writes, for
+// "(Invalid Unicode 0xXXXXXXXX)".
+const size_t kMaxCodePointUtf8Length = 28;
+
+// Writes a Unicode code point to out in UTF-8 encoding, and returns the
+// number of characters written.  If the code_point is not a valid
+// Unicode code point, writes "(Invalid Unicode 0xXXXXXXXX)" instead.
+static size_t WriteCodePointAsUtf8(UInt32 code_point, char* out) {
+  if (code_point <= kMaxCodePoint1) {
+    out[0] = static_cast<char>(code_point);                          // 0xxxxxxx
+    return 1;
+  } else if (code_point <= kMaxCodePoint2) {
+    out[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[0] = static_cast<char>(0xC0 | code_point);                   // 110xxxxx
+    return 2;
+  } else if (code_point <= kMaxCodePoint3) {
+    out[2] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[0] = static_cast<char>(0xE0 | code_point);                   // 1110xxxx
+    return 3;
+  } else if (code_point <= kMaxCodePoint4) {
+    out[3] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[2] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
+    out[0] = static_cast<char>(0xF0 | code_point);                   // 11110xxx
+    return 4;
+  }
+
+  static const char kPrefix[] = "(Invalid Unicode 0x";
+  const size_t prefix_length = sizeof(kPrefix) - 1;
+  memcpy(out, kPrefix, prefix_length);
+  int num_digits = 1;
+  while (num_digits < 8 && (code_point >> (4 * num_digits)) != 0)
+    num_digits++;
+  for (int i = num_digits - 1; i >= 0; i--) {
+    out[prefix_length + i] = "0123456789ABCDEF"[code_point & 0xF];
+    code_point >>= 4;
+  }
+  out[prefix_length + num_digits] = ')';
+  return prefix_length + num_digits + 1;
+}
+
 // Converts a Unicode code point to a narrow string in UTF-8 encoding.
 // code_point parameter is of type UInt32 because wchar_t may not be
 // wide enough to contain a code point.
@@ -1720,30 +2302,8 @@ inline UInt32 ChopLowBits(UInt32* bits, int n) {
 // (i.e. outside of Unicode range U+0 to U+10FFFF) it will be converted
 // to "(Invalid Unicode 0xXXXXXXXX)".
 std::string CodePointToUtf8(UInt32 code_point) {
-  if (code_point > kMaxCodePoint4) {
-    return "(Invalid Unicode 0x" + String::FormatHexInt(code_point) + ")";
-  }
-
-  char str[5];  // Big enough for the largest valid code point.
-  if (code_point <= kMaxCodePoint1) {
-    str[1] = '\0';
-    str[0] = static_cast<char>(code_point);                          // 0xxxxxxx
-  } else if (code_point <= kMaxCodePoint2) {
-    str[2] = '\0';
-    str[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[0] = static_cast<char>(0xC0 | code_point);                   // 110xxxxx
-  } else if (code_point <= kMaxCodePoint3) {
-    str[3] = '\0';
-    str[2] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[0] = static_cast<char>(0xE0 | code_point);                   // 1110xxxx
-  } else {  // code_point <= kMaxCodePoint4
-    str[4] = '\0';
-    str[3] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[2] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[1] = static_cast<char>(0x80 | ChopLowBits(&code_point, 6));  // 10xxxxxx
-    str[0] = static_cast<char>(0xF0 | code_point);                   // 11110xxx
-  }
+  char str[kMaxCodePointUtf8Length + 1];
+  str[WriteCodePointAsUtf8(code_point, str)] = '\0';
   return str;
 }
 
@@ -1787,23 +2347,44 @@ std::string WideStringToUtf8(const wchar_t* str, int num_chars) {
   if (num_chars == -1)
     num_chars = static_cast<int>(wcslen(str));
 
-  ::std::stringstream stream;
-  for (int i = 0; i < num_chars; ++i) {
-    UInt32 unicode_code_point;
+  // The text is encoded into buffer, which is appended to the result
+  // whenever it may not have room for another code point.
+  std::string result;
+  result.reserve(static_cast<size_t>(num_chars));
+  char buffer[1024];
+  const size_t capacity = sizeof(buffer) - kMaxCodePointUtf8Length;
+  size_t size = 0;
+  for (int i = 0; i < num_chars; ) {
+    if (size >= capacity) {
+      result.append(buffer, size);
+      size = 0;
+    }
 
+    // Copies a run of ASCII characters other than NUL, leaving room for
+    // the code point that may end the run.
+    const int run_end = i + static_cast<int>(
+        std::min(capacity - size, static_cast<size_t>(num_chars - i)));
+    while (i != run_end && static_cast<UInt32>(str[i]) - 1 < kMaxCodePoint1)
+      buffer[size++] = static_cast<char>(str[i++]);
+    if (i == run_end)
+      continue;
+
+    UInt32 unicode_code_point;
     if (str[i] == L'\0') {
       break;
     } else if (i + 1 < num_chars && IsUtf16SurrogatePair(str[i], str[i + 1])) {
       unicode_code_point = CreateCodePointFromUtf16SurrogatePair(str[i],
                                                                  str[i + 1]);
-      i++;
+      i += 2;
     } else {
       unicode_code_point = static_cast<UInt32>(str[i]);
+      i++;
     }
 
-    stream << CodePointToUtf8(unicode_code_point);
+    size += WriteCodePointAsUtf8(unicode_code_point, buffer + size);
   }
-  return StringStreamToString(&stream);
+  result.append(buffer, size);
+  return result;
 }
 
 // Converts a wide C string to an std::string using the UTF-8 encoding.
@@ -1944,19 +2525,24 @@ std::string String::FormatByte(unsigned char value) {
 // bytes to "\\0" along the way.
 std::string StringStreamToString(::std::stringstream* ss) {
   const ::std::string& str = ss->str();
-  const char* const start = str.c_str();
-  const char* const end = start + str.length();
+  return StringWithEscapedNuls(str.data(), str.length());
+}
+
+// Converts the given characters to an std::string, converting NUL
+// bytes to "\\0" along the way.
+std::string StringWithEscapedNuls(const char* str, size_t length) {
+  if (memchr(str, '\0', length) == NULL)
+    return std::string(str, length);
 
   std::string result;
-  result.reserve(2 * (end - start));
-  for (const char* ch = start; ch != end; ++ch) {
+  result.reserve(2 * length);
+  for (const char* ch = str; ch != str + length; ++ch) {
     if (*ch == '\0') {
       result += "\\0";  // Replaces NUL with "\\0";
     } else {
       result += *ch;
     }
   }
-
   return result;
 }
 
@@ -2034,7 +2620,8 @@ void TestResult::RecordProperty(const std::string& xml_element,
 }
 
 // The list of reserved attributes used in the <testsuites> element of XML
-// output.
+// output.  The JSON report uses the same names as keys, and also has a
+// "testsuites" array.
 static const char* const kReservedTestSuitesAttributes[] = {
   "disabled",
   "errors",
@@ -2042,24 +2629,28 @@ static const char* const kReservedTestSuitesAttributes[] = {
   "name",
   "random_seed",
   "tests",
+  "testsuites",
   "time",
   "timestamp"
 };
 
 // The list of reserved attributes used in the <testsuite> element of XML
-// output.
+// output.  The JSON report also has a "testsuite" array.
 static const char* const kReservedTestSuiteAttributes[] = {
   "disabled",
   "errors",
   "failures",
   "name",
   "tests",
+  "testsuite",
   "time"
 };
 
 // The list of reserved attributes used in the <testcase> element of XML output.
+// The JSON report also has a "failures" array.
 static const char* const kReservedTestCaseAttributes[] = {
   "classname",
+  "failures",
   "name",
   "status",
   "time",
@@ -2207,6 +2798,22 @@ void Test::RecordProperty(const std::string& key, int value) {
   RecordProperty(key, value_message.GetString().c_str());
 }
 
+// Makes the tests of the current test case run in forked child processes.
+void Test::ForkEachTest() {
+  internal::UnitTestImpl* const impl = internal::GetUnitTestImpl();
+  TestCase* const test_case = impl->current_test_case();
+  if (test_case == NULL || impl->current_test_info() != NULL) {
+    ADD_FAILURE() << "ForkEachTest() must be called from SetUpTestCase().";
+    return;
+  }
+
+#if GTEST_CAN_FORK_TESTS_
+  // A death test subprocess only runs the test with the death test.
+  if (impl->internal_run_death_test_flag() == NULL)
+    test_case->forks_each_test_ = true;
+#endif  // GTEST_CAN_FORK_TESTS_
+}
+
 namespace internal {
 
 void ReportFailureInUnknownLocation(TestPartResult::Type result_type,
@@ -2681,6 +3288,7 @@ TestCase::TestCase(const char* a_name, const char* a_type_param,
       set_up_tc_(set_up_tc),
       tear_down_tc_(tear_down_tc),
       should_run_(false),
+      forks_each_test_(false),
       elapsed_time_(0) {
 }
 
@@ -2721,12 +3329,19 @@ void TestCase::Run() {
   TestEventListener* repeater = UnitTest::GetInstance()->listeners().repeater();
 
   repeater->OnTestCaseStart(*this);
+  forks_each_test_ = false;
   impl->os_stack_trace_getter()->UponLeavingGTest();
   internal::HandleExceptionsInMethodIfSupported(
       this, &TestCase::RunSetUpTestCase, "SetUpTestCase()");
 
   const internal::TimeInMillis start = internal::GetTimeInMillis();
   for (int i = 0; i < total_test_count(); i++) {
+#if GTEST_CAN_FORK_TESTS_
+    if (forks_each_test_) {
+      GetMutableTestInfo(i)->RunInChildProcess();
+      continue;
+    }
+#endif  // GTEST_CAN_FORK_TESTS_
     GetMutableTestInfo(i)->Run();
   }
   elapsed_time_ = internal::GetTimeInMillis() - start;
@@ -2977,6 +3592,41 @@ void PrintFullTestCommentIfPresent(const TestInfo& test_info) {
   }
 }
 
+// The state of the tests that listeners may look at, as of when an
+// event happened.  The repeater copies it into each event it queues for
+// the reporting thread (--gtest_async_listeners): by the time the thread
+// forwards the event, the tests may have changed the flags or started
+// another test.
+struct TestEventState {
+  const TestCase* current_test_case;
+  const TestInfo* current_test_info;
+  bool print_time;
+};
+
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+
+// The state of the queued event that the reporting thread is forwarding.
+// NULL on the other threads, which see the current state.
+static ThreadLocal<const TestEventState*> g_queued_event_state;
+
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+
+// Returns the state as of the queued event that the calling thread is
+// forwarding to the listeners, or NULL if it isn't forwarding one.
+static const TestEventState* QueuedEventState() {
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  return g_queued_event_state.get();
+#else
+  return NULL;
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+}
+
+// Returns the value of --gtest_print_time as of the event being handled.
+static bool PrintTimeForEvent() {
+  const TestEventState* const state = QueuedEventState();
+  return state != NULL ? state->print_time : GTEST_FLAG(print_time);
+}
+
 // This class implements the TestEventListener interface.
 //
 // Class PrettyUnitTestResultPrinter is copyable.
@@ -2988,6 +3638,11 @@ class PrettyUnitTestResultPrinter : public TestEventListener {
   }
 
   // The following methods override what's in the TestEventListener class.
+  virtual int SubscribedEvents() const {
+    return kTestIterationStart | kEnvironmentsSetUpStart | kTestCaseStart |
+        kTestStart | kTestPartResult | kTestEnd | kTestCaseEnd |
+        kEnvironmentsTearDownStart | kTestIterationEnd;
+  }
   virtual void OnTestProgramStart(const UnitTest& /*unit_test*/) {}
   virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
   virtual void OnEnvironmentsSetUpStart(const UnitTest& unit_test);
@@ -3091,7 +3746,7 @@ void PrettyUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
   if (test_info.result()->Failed())
     PrintFullTestCommentIfPresent(test_info);
 
-  if (GTEST_FLAG(print_time)) {
+  if (PrintTimeForEvent()) {
     printf(" (%s ms)\n", internal::StreamableToString(
            test_info.result()->elapsed_time()).c_str());
   } else {
@@ -3101,7 +3756,7 @@ void PrettyUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
 }
 
 void PrettyUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
-  if (!GTEST_FLAG(print_time)) return;
+  if (!PrintTimeForEvent()) return;
 
   const std::string counts =
       FormatCountableNoun(test_case.test_to_run_count(), "test", "tests");
@@ -3150,7 +3805,7 @@ void PrettyUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
   printf("%s from %s ran.",
          FormatTestCount(unit_test.test_to_run_count()).c_str(),
          FormatTestCaseCount(unit_test.test_case_to_run_count()).c_str());
-  if (GTEST_FLAG(print_time)) {
+  if (PrintTimeForEvent()) {
     printf(" (%s ms total)",
            internal::StreamableToString(unit_test.elapsed_time()).c_str());
   }
@@ -3184,12 +3839,174 @@ void PrettyUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
 
 // End PrettyUnitTestResultPrinter
 
+// class BriefUnitTestResultPrinter
+
+// This class implements the --gtest_brief output: it prints the failures
+// and the summary the way PrettyUnitTestResultPrinter does, but nothing
+// for the tests that pass.  If stdout is a terminal, it also keeps a
+// progress line below the failures, rewritten at most every
+// kProgressMillis.
+class BriefUnitTestResultPrinter : public PrettyUnitTestResultPrinter {
+ public:
+  explicit BriefUnitTestResultPrinter(bool shows_progress)
+      : shows_progress_(shows_progress), progress_length_(0),
+        iteration_start_(0), last_progress_time_(0), test_count_(0),
+        finished_test_count_(0), failed_test_count_(0) {}
+
+  virtual int SubscribedEvents() const {
+    return kTestIterationStart | kTestPartResult | kTestEnd |
+        kTestIterationEnd;
+  }
+  virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
+  virtual void OnTestPartResult(const TestPartResult& result);
+  virtual void OnTestEnd(const TestInfo& test_info);
+  virtual void OnTestIterationEnd(const UnitTest& unit_test, int iteration);
+
+ private:
+  static const int kProgressMillis = 100;
+
+  // Rewrites the progress line with the counts as of the given time.
+  void PrintProgress(TimeInMillis now);
+
+  // Erases the progress line, if there is one, so that other output can
+  // take its place.
+  void ClearProgress();
+
+  const bool shows_progress_;
+  // The number of characters of the progress line on the screen, or 0
+  // if there is none.
+  size_t progress_length_;
+  TimeInMillis iteration_start_;
+  TimeInMillis last_progress_time_;
+  int test_count_;
+  int finished_test_count_;
+  int failed_test_count_;
+};
+
+void BriefUnitTestResultPrinter::OnTestIterationStart(
+    const UnitTest& unit_test, int iteration) {
+  PrettyUnitTestResultPrinter::OnTestIterationStart(unit_test, iteration);
+  iteration_start_ = GetTimeInMillis();
+  last_progress_time_ = 0;
+  test_count_ = unit_test.test_to_run_count();
+  finished_test_count_ = 0;
+  failed_test_count_ = 0;
+}
+
+void BriefUnitTestResultPrinter::OnTestPartResult(
+    const TestPartResult& result) {
+  if (result.type() == TestPartResult::kSuccess)
+    return;
+
+  ClearProgress();
+  PrettyUnitTestResultPrinter::OnTestPartResult(result);
+}
+
+void BriefUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  finished_test_count_++;
+  if (test_info.result()->Failed()) {
+    failed_test_count_++;
+    ClearProgress();
+    PrettyUnitTestResultPrinter::OnTestEnd(test_info);
+  }
+
+  if (shows_progress_) {
+    const TimeInMillis now = GetTimeInMillis();
+    if (now - last_progress_time_ >= kProgressMillis ||
+        finished_test_count_ == test_count_) {
+      PrintProgress(now);
+    }
+  }
+}
+
+void BriefUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
+                                                    int iteration) {
+  ClearProgress();
+  PrettyUnitTestResultPrinter::OnTestIterationEnd(unit_test, iteration);
+}
+
+void BriefUnitTestResultPrinter::PrintProgress(TimeInMillis now) {
+  last_progress_time_ = now;
+
+  Message counts;
+  counts << "[ " << finished_test_count_ << "/" << test_count_ << " ]";
+  Message details;
+  details << " " << failed_test_count_ << " failed";
+  const TimeInMillis elapsed = now - iteration_start_;
+  if (elapsed > 0) {
+    // Estimates the time left from the pace of the tests so far.
+    const TimeInMillis remaining =
+        elapsed * (test_count_ - finished_test_count_) / finished_test_count_;
+    details << ", " << finished_test_count_ * 1000 / elapsed << " tests/s"
+            << ", ETA " << (remaining + 999) / 1000 << "s";
+  }
+  const std::string counts_string = counts.GetString();
+  const std::string details_string = details.GetString();
+
+  printf("\r");
+  ColoredPrintf(failed_test_count_ == 0 ? COLOR_GREEN : COLOR_RED,
+                "%s", counts_string.c_str());
+  printf("%s", details_string.c_str());
+  // Overwrites the rest of a longer previous line.
+  const size_t length = counts_string.length() + details_string.length();
+  if (length < progress_length_)
+    printf("%*s", static_cast<int>(progress_length_ - length), "");
+  progress_length_ = std::max(length, progress_length_);
+  fflush(stdout);
+}
+
+void BriefUnitTestResultPrinter::ClearProgress() {
+  if (progress_length_ == 0)
+    return;
+
+  printf("\r%*s\r", static_cast<int>(progress_length_), "");
+  progress_length_ = 0;
+}
+
+// End BriefUnitTestResultPrinter
+
 // class TestEventRepeater
 //
-// This class forwards events to other event listeners.
+// This class forwards events to other event listeners.  After
+// StartReportingThread() it queues the events instead, and a reporting
+// thread forwards them, so that slow listeners don't hold up the tests.
+// An event nobody subscribes to is neither queued nor forwarded.
+
+// An event of the event listener API, as queued for the reporting thread.
+struct TestEvent {
+  // The types are in the order of the TestEventListener::Event bits:
+  // the bit of type t is 1 << t.
+  enum Type {
+    kOnTestProgramStart,
+    kOnTestIterationStart,
+    kOnEnvironmentsSetUpStart,
+    kOnEnvironmentsSetUpEnd,
+    kOnTestCaseStart,
+    kOnTestStart,
+    kOnTestPartResult,
+    kOnTestEnd,
+    kOnTestCaseEnd,
+    kOnEnvironmentsTearDownStart,
+    kOnEnvironmentsTearDownEnd,
+    kOnTestIterationEnd,
+    kOnTestProgramEnd
+  };
+  static const int kTypeCount = kOnTestProgramEnd + 1;
+
+  Type type;
+  // The UnitTest, TestCase, TestInfo, or TestPartResult the event is about.
+  const void* subject;
+  // The iteration of an iteration start or end event.
+  int iteration;
+  // The state as of the event, if it is queued.
+  TestEventState state;
+};
+
+class TestEventQueue;
+
 class TestEventRepeater : public TestEventListener {
  public:
-  TestEventRepeater() : forwarding_enabled_(true) {}
+  TestEventRepeater() : forwarding_enabled_(true), queue_(NULL) {}
   virtual ~TestEventRepeater();
   void Append(TestEventListener *listener);
   TestEventListener* Release(TestEventListener* listener);
@@ -3197,7 +4014,19 @@ class TestEventRepeater : public TestEventListener {
   // Controls whether events will be forwarded to listeners_. Set to false
   // in death test child processes.
   bool forwarding_enabled() const { return forwarding_enabled_; }
-  void set_forwarding_enabled(bool enable) { forwarding_enabled_ = enable; }
+  void set_forwarding_enabled(bool enable);
+
+  // Starts forwarding the events on a reporting thread, which stops after
+  // forwarding OnTestProgramEnd().  Does nothing on platforms without
+  // threads.
+  void StartReportingThread();
+
+  // Blocks until the reporting thread has forwarded all queued events.
+  // Returns true iff there is a reporting thread, which is then idle.
+  bool Flush();
+
+  // Forwards the given event to listeners_ on the calling thread.
+  void Forward(const TestEvent& event);
 
   virtual void OnTestProgramStart(const UnitTest& unit_test);
   virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
@@ -3214,28 +4043,239 @@ class TestEventRepeater : public TestEventListener {
   virtual void OnTestProgramEnd(const UnitTest& unit_test);
 
  private:
+  // Forwards an event now, or queues it for the reporting thread if
+  // there is one.
+  void Post(TestEvent::Type type, const void* subject, int iteration);
+
   // Controls whether events will be forwarded to listeners_. Set to false
   // in death test child processes.
   bool forwarding_enabled_;
   // The list of listeners that receive events.
   std::vector<TestEventListener*> listeners_;
+  // For each event type, the listeners in listeners_ that subscribe to
+  // it, in the same order.
+  std::vector<TestEventListener*> subscribers_[TestEvent::kTypeCount];
+  // The events waiting for the reporting thread, or NULL if events are
+  // forwarded as they happen.
+  TestEventQueue* queue_;
 
   GTEST_DISALLOW_COPY_AND_ASSIGN_(TestEventRepeater);
 };
 
-TestEventRepeater::~TestEventRepeater() {
-  ForEach(listeners_, Delete<TestEventListener>);
-}
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
 
-void TestEventRepeater::Append(TestEventListener *listener) {
-  listeners_.push_back(listener);
-}
+// A bounded queue of test events, and the reporting thread that forwards
+// them to a repeater's listeners in the order they were pushed.
+class TestEventQueue {
+ public:
+  // Starts the reporting thread.
+  explicit TestEventQueue(TestEventRepeater* repeater);
+
+  // Forwards the events still in the queue, then stops the reporting
+  // thread.
+  ~TestEventQueue();
+
+  // Adds an event to the queue, waiting for room if the queue is full.
+  // The event may refer to a TestPartResult, which the queue copies; the
+  // other objects must outlive the event.
+  void Push(TestEvent event);
+
+  // Blocks until every event in the queue has been forwarded.
+  void Flush();
+
+  // Returns true iff the calling thread is the reporting thread.
+  bool IsReportingThread() const {
+    return pthread_equal(pthread_self(), thread_) != 0;
+  }
+
+  // The body of the reporting thread.
+  void ForwardEvents();
+
+ private:
+  // How many events can wait for the reporting thread before Push()
+  // blocks the thread that runs the tests.
+  static const size_t kCapacity = 1024;
+  // How many events the reporting thread waits for, for at most
+  // kGatherMillis, before it forwards what it has.
+  static const size_t kBatchSize = 256;
+  static const int kGatherMillis = 1;
+
+  TestEventRepeater* const repeater_;
+  // Protects the members below.
+  pthread_mutex_t mutex_;
+  // Signaled when events are pushed, or when the thread should stop.
+  pthread_cond_t events_pushed_;
+  // Broadcast when events have been forwarded and left the queue.
+  pthread_cond_t events_forwarded_;
+  // A ring buffer holding size_ events, starting at index first_.  The
+  // reporting thread reads the events without holding mutex_, since
+  // Push() only ever writes to the free part of the buffer.
+  TestEvent events_[kCapacity];
+  size_t first_;
+  size_t size_;
+  // The number of threads waiting in Flush().
+  int flushers_;
+  bool stopping_;
+  pthread_t thread_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(TestEventQueue);
+};
+
+// pthread_create() accepts a pointer to a function type with the C linkage.
+extern "C" inline void* ForwardTestEventsThreadFunc(void* queue) {
+  static_cast<TestEventQueue*>(queue)->ForwardEvents();
+  return NULL;
+}
+
+TestEventQueue::TestEventQueue(TestEventRepeater* repeater)
+    : repeater_(repeater), first_(0), size_(0), flushers_(0),
+      stopping_(false) {
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_init(&mutex_, NULL));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_init(&events_pushed_, NULL));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_init(&events_forwarded_, NULL));
+  GTEST_CHECK_POSIX_SUCCESS_(
+      pthread_create(&thread_, NULL, &ForwardTestEventsThreadFunc, this));
+}
+
+TestEventQueue::~TestEventQueue() {
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_lock(&mutex_));
+  stopping_ = true;
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_signal(&events_pushed_));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_unlock(&mutex_));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_join(thread_, NULL));
+
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_destroy(&events_forwarded_));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_destroy(&events_pushed_));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_destroy(&mutex_));
+}
+
+void TestEventQueue::Push(TestEvent event) {
+  // A test part result is usually a temporary of the thread that
+  // reported it.
+  if (event.type == TestEvent::kOnTestPartResult) {
+    event.subject = new TestPartResult(
+        *static_cast<const TestPartResult*>(event.subject));
+  }
+
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_lock(&mutex_));
+  while (size_ == kCapacity) {
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_wait(&events_forwarded_, &mutex_));
+  }
+  events_[(first_ + size_) % kCapacity] = event;
+  // The reporting thread waits for the first event, then for a batch.
+  size_++;
+  if (size_ == 1 || size_ == kBatchSize)
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_signal(&events_pushed_));
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_unlock(&mutex_));
+}
+
+void TestEventQueue::Flush() {
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_lock(&mutex_));
+  // Stops the reporting thread from waiting for a fuller batch.
+  flushers_++;
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_signal(&events_pushed_));
+  while (size_ != 0) {
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_wait(&events_forwarded_, &mutex_));
+  }
+  flushers_--;
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_unlock(&mutex_));
+}
+
+void TestEventQueue::ForwardEvents() {
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_lock(&mutex_));
+  for (;;) {
+    while (size_ == 0 && !stopping_) {
+      GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_wait(&events_pushed_, &mutex_));
+    }
+
+    // Gives the tests a moment to queue more events, so that this thread
+    // wakes up once per batch rather than once per event.
+    if (size_ < kBatchSize && flushers_ == 0 && !stopping_) {
+      timeval now;
+      gettimeofday(&now, NULL);
+      timespec deadline;
+      deadline.tv_sec = now.tv_sec;
+      deadline.tv_nsec = (now.tv_usec + kGatherMillis * 1000L) * 1000L;
+      if (deadline.tv_nsec >= 1000L * 1000L * 1000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000L * 1000L * 1000L;
+      }
+      const int error = pthread_cond_timedwait(&events_pushed_, &mutex_,
+                                               &deadline);
+      GTEST_CHECK_(error == 0 || error == ETIMEDOUT)
+          << "pthread_cond_timedwait failed with error " << error;
+    }
+    if (size_ == 0)
+      break;
+
+    // Forwards everything queued so far as one batch, so that the lock
+    // is taken twice per batch instead of twice per event.
+    const size_t first = first_;
+    const size_t count = size_;
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_unlock(&mutex_));
+    for (size_t i = 0; i != count; i++) {
+      const TestEvent& event = events_[(first + i) % kCapacity];
+      g_queued_event_state.set(&event.state);
+      repeater_->Forward(event);
+      g_queued_event_state.set(NULL);
+      if (event.type == TestEvent::kOnTestPartResult)
+        delete static_cast<const TestPartResult*>(event.subject);
+    }
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_lock(&mutex_));
+
+    first_ = (first_ + count) % kCapacity;
+    size_ -= count;
+    GTEST_CHECK_POSIX_SUCCESS_(pthread_cond_broadcast(&events_forwarded_));
+  }
+  GTEST_CHECK_POSIX_SUCCESS_(pthread_mutex_unlock(&mutex_));
+}
+
+// The repeater whose queued events are forwarded when the program exits.
+static TestEventRepeater* g_repeater_to_flush_at_exit = NULL;
+
+// Forwards the queued events when a test calls exit(), so that the
+// listeners see everything that happened before.
+static void FlushTestEventsAtExit() {
+  g_repeater_to_flush_at_exit->Flush();
+}
+
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+
+TestEventRepeater::~TestEventRepeater() {
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  delete queue_;
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  ForEach(listeners_, Delete<TestEventListener>);
+}
+
+void TestEventRepeater::Append(TestEventListener *listener) {
+  GTEST_COMPILE_ASSERT_(TestEventListener::kTestProgramEnd ==
+                        1 << TestEvent::kOnTestProgramEnd,
+                        event_bits_must_follow_event_types);
+
+  // The reporting thread reads subscribers_ while it forwards events.
+  Flush();
+  listeners_.push_back(listener);
+  const int events = listener->SubscribedEvents();
+  for (int type = 0; type < TestEvent::kTypeCount; type++) {
+    if (events & (1 << type))
+      subscribers_[type].push_back(listener);
+  }
+}
 
 // TODO(vladl@google.com): Factor the search functionality into Vector::Find.
 TestEventListener* TestEventRepeater::Release(TestEventListener *listener) {
+  Flush();
   for (size_t i = 0; i < listeners_.size(); ++i) {
     if (listeners_[i] == listener) {
       listeners_.erase(listeners_.begin() + i);
+      for (int type = 0; type < TestEvent::kTypeCount; type++) {
+        std::vector<TestEventListener*>& subscribers = subscribers_[type];
+        const std::vector<TestEventListener*>::iterator it =
+            std::find(subscribers.begin(), subscribers.end(), listener);
+        if (it != subscribers.end())
+          subscribers.erase(it);
+      }
       return listener;
     }
   }
@@ -3243,24 +4283,118 @@ TestEventListener* TestEventRepeater::Release(TestEventListener *listener) {
   return NULL;
 }
 
-// Since most methods are very similar, use macros to reduce boilerplate.
-// This defines a member that forwards the call to all listeners.
-#define GTEST_REPEATER_METHOD_(Name, Type) \
-void TestEventRepeater::Name(const Type& parameter) { \
-  if (forwarding_enabled_) { \
-    for (size_t i = 0; i < listeners_.size(); i++) { \
-      listeners_[i]->Name(parameter); \
+void TestEventRepeater::set_forwarding_enabled(bool enable) {
+  forwarding_enabled_ = enable;
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  // A death test child process forked by the thread running the tests
+  // doesn't have the reporting thread, so it must neither wait for the
+  // thread nor stop it.  It leaks the queue instead.
+  if (!enable)
+    queue_ = NULL;
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+}
+
+void TestEventRepeater::StartReportingThread() {
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  if (queue_ == NULL) {
+    queue_ = new TestEventQueue(this);
+    if (g_repeater_to_flush_at_exit == NULL) {
+      g_repeater_to_flush_at_exit = this;
+      atexit(&FlushTestEventsAtExit);
+    }
+  }
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+}
+
+bool TestEventRepeater::Flush() {
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  // A listener running on the reporting thread can't wait for itself.
+  if (queue_ != NULL && !queue_->IsReportingThread()) {
+    queue_->Flush();
+    return true;
+  }
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  return false;
+}
+
+void TestEventRepeater::Post(TestEvent::Type type, const void* subject,
+                             int iteration) {
+  // Saves queueing the event, and copying a test part result for the
+  // queue, when no listener wants it.
+  if (subscribers_[type].empty())
+    return;
+
+  TestEvent event = { type, subject, iteration, { NULL, NULL, false } };
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  // Events that listeners generate while handling an event, such as
+  // failed assertions, are forwarded right away.
+  if (queue_ != NULL && !queue_->IsReportingThread()) {
+    const UnitTestImpl* const impl = GetUnitTestImpl();
+    event.state.current_test_case = impl->current_test_case();
+    event.state.current_test_info = impl->current_test_info();
+    event.state.print_time = GTEST_FLAG(print_time);
+    queue_->Push(event);
+    return;
+  }
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  Forward(event);
+}
+
+// Since most events are very similar, use macros to reduce boilerplate.
+// This forwards the event to all its subscribers.
+#define GTEST_FORWARD_EVENT_(Name, Type) \
+  case TestEvent::k##Name: \
+    for (size_t i = 0; i < subscribers.size(); i++) { \
+      subscribers[i]->Name(*static_cast<const Type*>(event.subject)); \
     } \
-  } \
+    break
+// This forwards the event to all its subscribers in reverse order.
+#define GTEST_REVERSE_FORWARD_EVENT_(Name, Type) \
+  case TestEvent::k##Name: \
+    for (int i = static_cast<int>(subscribers.size()) - 1; i >= 0; i--) { \
+      subscribers[i]->Name(*static_cast<const Type*>(event.subject)); \
+    } \
+    break
+
+void TestEventRepeater::Forward(const TestEvent& event) {
+  const std::vector<TestEventListener*>& subscribers =
+      subscribers_[event.type];
+  switch (event.type) {
+    GTEST_FORWARD_EVENT_(OnTestProgramStart, UnitTest);
+    GTEST_FORWARD_EVENT_(OnEnvironmentsSetUpStart, UnitTest);
+    GTEST_FORWARD_EVENT_(OnTestCaseStart, TestCase);
+    GTEST_FORWARD_EVENT_(OnTestStart, TestInfo);
+    GTEST_FORWARD_EVENT_(OnTestPartResult, TestPartResult);
+    GTEST_FORWARD_EVENT_(OnEnvironmentsTearDownStart, UnitTest);
+    GTEST_REVERSE_FORWARD_EVENT_(OnEnvironmentsSetUpEnd, UnitTest);
+    GTEST_REVERSE_FORWARD_EVENT_(OnEnvironmentsTearDownEnd, UnitTest);
+    GTEST_REVERSE_FORWARD_EVENT_(OnTestEnd, TestInfo);
+    GTEST_REVERSE_FORWARD_EVENT_(OnTestCaseEnd, TestCase);
+    GTEST_REVERSE_FORWARD_EVENT_(OnTestProgramEnd, UnitTest);
+
+    case TestEvent::kOnTestIterationStart:
+      for (size_t i = 0; i < subscribers.size(); i++) {
+        subscribers[i]->OnTestIterationStart(
+            *static_cast<const UnitTest*>(event.subject), event.iteration);
+      }
+      break;
+    case TestEvent::kOnTestIterationEnd:
+      for (int i = static_cast<int>(subscribers.size()) - 1; i >= 0; i--) {
+        subscribers[i]->OnTestIterationEnd(
+            *static_cast<const UnitTest*>(event.subject), event.iteration);
+      }
+      break;
+  }
 }
-// This defines a member that forwards the call to all listeners in reverse
-// order.
-#define GTEST_REVERSE_REPEATER_METHOD_(Name, Type) \
+
+#undef GTEST_FORWARD_EVENT_
+#undef GTEST_REVERSE_FORWARD_EVENT_
+
+// This defines a member that forwards the event to all listeners.
+#define GTEST_REPEATER_METHOD_(Name, Type) \
 void TestEventRepeater::Name(const Type& parameter) { \
   if (forwarding_enabled_) { \
-    for (int i = static_cast<int>(listeners_.size()) - 1; i >= 0; i--) { \
-      listeners_[i]->Name(parameter); \
-    } \
+    Post(TestEvent::k##Name, &parameter, 0); \
   } \
 }
 
@@ -3270,43 +4404,155 @@ GTEST_REPEATER_METHOD_(OnTestCaseStart, TestCase)
 GTEST_REPEATER_METHOD_(OnTestStart, TestInfo)
 GTEST_REPEATER_METHOD_(OnTestPartResult, TestPartResult)
 GTEST_REPEATER_METHOD_(OnEnvironmentsTearDownStart, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsSetUpEnd, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnEnvironmentsTearDownEnd, UnitTest)
-GTEST_REVERSE_REPEATER_METHOD_(OnTestEnd, TestInfo)
-GTEST_REVERSE_REPEATER_METHOD_(OnTestCaseEnd, TestCase)
-GTEST_REVERSE_REPEATER_METHOD_(OnTestProgramEnd, UnitTest)
+GTEST_REPEATER_METHOD_(OnEnvironmentsSetUpEnd, UnitTest)
+GTEST_REPEATER_METHOD_(OnEnvironmentsTearDownEnd, UnitTest)
+GTEST_REPEATER_METHOD_(OnTestEnd, TestInfo)
+GTEST_REPEATER_METHOD_(OnTestCaseEnd, TestCase)
 
 #undef GTEST_REPEATER_METHOD_
-#undef GTEST_REVERSE_REPEATER_METHOD_
 
+// The listeners read the flags that apply to the whole iteration, such
+// as --gtest_filter and --gtest_shuffle, when it starts, so this event
+// waits for the reporting thread before the tests can change them.
 void TestEventRepeater::OnTestIterationStart(const UnitTest& unit_test,
                                              int iteration) {
   if (forwarding_enabled_) {
-    for (size_t i = 0; i < listeners_.size(); i++) {
-      listeners_[i]->OnTestIterationStart(unit_test, iteration);
-    }
+    Post(TestEvent::kOnTestIterationStart, &unit_test, iteration);
+    Flush();
   }
 }
 
+// The listeners must be done with an iteration before the tests are
+// unshuffled and their results cleared for the next one, so this event
+// waits for the reporting thread.
 void TestEventRepeater::OnTestIterationEnd(const UnitTest& unit_test,
                                            int iteration) {
   if (forwarding_enabled_) {
-    for (int i = static_cast<int>(listeners_.size()) - 1; i >= 0; i--) {
-      listeners_[i]->OnTestIterationEnd(unit_test, iteration);
-    }
+    Post(TestEvent::kOnTestIterationEnd, &unit_test, iteration);
+    Flush();
+  }
+}
+
+// The program may exit as soon as this event returns, so it stops the
+// reporting thread after the thread has forwarded everything.
+void TestEventRepeater::OnTestProgramEnd(const UnitTest& unit_test) {
+  if (forwarding_enabled_) {
+    Post(TestEvent::kOnTestProgramEnd, &unit_test, 0);
   }
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  delete queue_;
+  queue_ = NULL;
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
 }
 
 // End TestEventRepeater
 
-// This class generates an XML output file.
+// A stream buffer that writes to a FILE in large chunks, so that a
+// report can be streamed to its file as it's generated.
+class FileStreamBuf : public ::std::streambuf {
+ public:
+  explicit FileStreamBuf(FILE* file) : file_(file), buffer_(64 * 1024) {
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+  }
+
+  virtual ~FileStreamBuf() { sync(); }
+
+ protected:
+  virtual int_type overflow(int_type ch) {
+    if (sync() != 0)
+      return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  virtual ::std::streamsize xsputn(const char* s, ::std::streamsize n) {
+    if (n > epptr() - pptr()) {
+      if (sync() != 0)
+        return 0;
+      // Text that can't fit in the buffer goes straight to the file.
+      if (n > epptr() - pptr()) {
+        return static_cast< ::std::streamsize>(
+            fwrite(s, 1, static_cast<size_t>(n), file_));
+      }
+    }
+    memcpy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+  }
+
+  // Writes the buffered text to the file.
+  virtual int sync() {
+    const size_t size = static_cast<size_t>(pptr() - pbase());
+    setp(&buffer_[0], &buffer_[0] + buffer_.size());
+    return fwrite(&buffer_[0], 1, size, file_) == size ? 0 : -1;
+  }
+
+ private:
+  FILE* const file_;
+  std::vector<char> buffer_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(FileStreamBuf);
+};
+
+// Opens file_path for writing, creating its directory if needed.
+// Exits the program if the file can't be opened.
+static FILE* OpenFileForWriting(const std::string& file_path) {
+  FILE* file = NULL;
+  FilePath output_file(file_path);
+  FilePath output_dir(output_file.RemoveFileName());
+
+  if (output_dir.CreateDirectoriesRecursively()) {
+    file = posix::FOpen(file_path.c_str(), "w");
+  }
+  if (file == NULL) {
+    // TODO(wan): report the reason of the failure.
+    //
+    // We don't do it for now as:
+    //
+    //   1. There is no urgent need for it.
+    //   2. It's a bit involved to make the errno variable thread-safe on
+    //      all three operating systems (Linux, Windows, and Mac OS).
+    //   3. To interpret the meaning of errno in a thread-safe way,
+    //      we need the strerror_r() function, which is not available on
+    //      Windows.
+    fprintf(stderr,
+            "Unable to open file \"%s\"\n",
+            file_path.c_str());
+    fflush(stderr);
+    exit(EXIT_FAILURE);
+  }
+  return file;
+}
+
+// This class generates an XML output file.  In incremental mode, it
+// also streams each test to the file as soon as the test finishes, so
+// that a crash leaves a partial report behind; the complete report
+// replaces it at the end of the iteration.
 class XmlUnitTestResultPrinter : public EmptyTestEventListener {
  public:
-  explicit XmlUnitTestResultPrinter(const char* output_file);
+  XmlUnitTestResultPrinter(const char* output_file, bool is_incremental);
+  virtual ~XmlUnitTestResultPrinter();
 
+  // Only incremental reports need the events before the iteration ends.
+  virtual int SubscribedEvents() const {
+    return is_incremental_ ?
+        kTestIterationStart | kTestCaseStart | kTestEnd | kTestCaseEnd |
+        kTestIterationEnd :
+        kTestIterationEnd;
+  }
+  virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
+  virtual void OnTestCaseStart(const TestCase& test_case);
+  virtual void OnTestEnd(const TestInfo& test_info);
+  virtual void OnTestCaseEnd(const TestCase& test_case);
   virtual void OnTestIterationEnd(const UnitTest& unit_test, int iteration);
 
  private:
+  // Flushes and closes the partial report, if one is open.
+  void ClosePartialReport();
+
   // Is c a whitespace character that is normalized to a space character
   // when it appears in an XML attribute value?
   static bool IsNormalizableWhitespace(char c) {
@@ -3318,15 +4564,19 @@ class XmlUnitTestResultPrinter : public EmptyTestEventListener {
     return IsNormalizableWhitespace(c) || c >= 0x20;
   }
 
+  // Streams the XML-escaped form of the length characters starting at
+  // str.  If is_attribute is true, the text is meant to appear as an
+  // attribute value, and normalizable whitespace is preserved by
+  // replacing it with character references.
+  static void OutputEscapedXml(::std::ostream* stream, const char* str,
+                               size_t length, bool is_attribute);
+
   // Returns an XML-escaped copy of the input string str.  If
   // is_attribute is true, the text is meant to appear as an attribute
   // value, and normalizable whitespace is preserved by replacing it
   // with character references.
   static std::string EscapeXml(const std::string& str, bool is_attribute);
 
-  // Returns the given string with all characters invalid in XML removed.
-  static std::string RemoveInvalidXmlCharacters(const std::string& str);
-
   // Convenience wrapper around EscapeXml when str is an attribute value.
   static std::string EscapeXmlAttribute(const std::string& str) {
     return EscapeXml(str, true);
@@ -3344,8 +4594,11 @@ class XmlUnitTestResultPrinter : public EmptyTestEventListener {
                                  const std::string& name,
                                  const std::string& value);
 
-  // Streams an XML CDATA section, escaping invalid CDATA sequences as needed.
-  static void OutputXmlCDataSection(::std::ostream* stream, const char* data);
+  // Streams an XML CDATA section holding the length characters starting
+  // at data, without the characters that are invalid in XML, and
+  // escaping invalid CDATA sequences as needed.
+  static void OutputXmlCDataSection(::std::ostream* stream, const char* data,
+                                    size_t length);
 
   // Streams an XML representation of a TestInfo object.
   static void OutputXmlTestInfo(::std::ostream* stream,
@@ -3369,12 +4622,24 @@ class XmlUnitTestResultPrinter : public EmptyTestEventListener {
   // The output file.
   const std::string output_file_;
 
+  // True iff the report is written as tests finish.
+  const bool is_incremental_;
+
+  // The partial report being written in incremental mode, or NULL.  The
+  // stream writes through the buffer, which writes to the file.
+  FILE* partial_file_;
+  scoped_ptr<FileStreamBuf> partial_buffer_;
+  scoped_ptr< ::std::ostream> partial_stream_;
+
   GTEST_DISALLOW_COPY_AND_ASSIGN_(XmlUnitTestResultPrinter);
 };
 
 // Creates a new XmlUnitTestResultPrinter.
-XmlUnitTestResultPrinter::XmlUnitTestResultPrinter(const char* output_file)
-    : output_file_(output_file) {
+XmlUnitTestResultPrinter::XmlUnitTestResultPrinter(const char* output_file,
+                                                   bool is_incremental)
+    : output_file_(output_file),
+      is_incremental_(is_incremental),
+      partial_file_(NULL) {
   if (output_file_.c_str() == NULL || output_file_.empty()) {
     fprintf(stderr, "XML output file may not be null\n");
     fflush(stderr);
@@ -3382,43 +4647,137 @@ XmlUnitTestResultPrinter::XmlUnitTestResultPrinter(const char* output_file)
   }
 }
 
-// Called after the unit test ends.
+XmlUnitTestResultPrinter::~XmlUnitTestResultPrinter() {
+  ClosePartialReport();
+}
+
+// Flushes and closes the partial report, if one is open.
+void XmlUnitTestResultPrinter::ClosePartialReport() {
+  if (partial_file_ == NULL)
+    return;
+
+  // The stream goes before the buffer it writes to, and the buffer
+  // writes out what it holds before the file is closed.
+  partial_stream_.reset();
+  partial_buffer_.reset();
+  fclose(partial_file_);
+  partial_file_ = NULL;
+}
+
+// Called before each iteration starts.  In incremental mode, starts a
+// partial report holding the attributes that are already known.
+void XmlUnitTestResultPrinter::OnTestIterationStart(const UnitTest& unit_test,
+                                                    int /*iteration*/) {
+  if (!is_incremental_)
+    return;
+
+  ClosePartialReport();
+  partial_file_ = OpenFileForWriting(output_file_);
+  partial_buffer_.reset(new FileStreamBuf(partial_file_));
+  partial_stream_.reset(new ::std::ostream(partial_buffer_.get()));
+
+  const std::string kTestsuites = "testsuites";
+  ::std::ostream* const stream = partial_stream_.get();
+  *stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  *stream << "<" << kTestsuites;
+  OutputXmlAttribute(
+      stream, kTestsuites, "timestamp",
+      FormatEpochTimeInMillisAsIso8601(unit_test.start_timestamp()));
+  if (GTEST_FLAG(shuffle)) {
+    OutputXmlAttribute(stream, kTestsuites, "random_seed",
+                       StreamableToString(unit_test.random_seed()));
+  }
+  OutputXmlAttribute(stream, kTestsuites, "name", "AllTests");
+  *stream << ">\n";
+  stream->flush();
+  fflush(partial_file_);
+}
+
+// Called before each test case starts.
+void XmlUnitTestResultPrinter::OnTestCaseStart(const TestCase& test_case) {
+  if (partial_stream_.get() == NULL || test_case.reportable_test_count() == 0)
+    return;
+
+  const std::string kTestsuite = "testsuite";
+  *partial_stream_ << "  <" << kTestsuite;
+  OutputXmlAttribute(partial_stream_.get(), kTestsuite, "name",
+                     test_case.name());
+  *partial_stream_ << ">\n";
+}
+
+// Called after each test ends.  In incremental mode, writes the test to
+// the partial report and pushes it to the file, so that it survives a
+// crash in a later test.
+void XmlUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  if (partial_stream_.get() == NULL || !test_info.is_reportable())
+    return;
+
+  OutputXmlTestInfo(partial_stream_.get(), test_info.test_case_name(),
+                    test_info);
+  partial_stream_->flush();
+  fflush(partial_file_);
+}
+
+// Called after each test case ends.
+void XmlUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
+  if (partial_stream_.get() == NULL || test_case.reportable_test_count() == 0)
+    return;
+
+  *partial_stream_ << "  </testsuite>\n";
+  partial_stream_->flush();
+  fflush(partial_file_);
+}
+
+// Called after the unit test ends.  Writes the complete report, which
+// replaces the partial one in incremental mode.
 void XmlUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
                                                   int /*iteration*/) {
-  FILE* xmlout = NULL;
-  FilePath output_file(output_file_);
-  FilePath output_dir(output_file.RemoveFileName());
+  ClosePartialReport();
 
-  if (output_dir.CreateDirectoriesRecursively()) {
-    xmlout = posix::FOpen(output_file_.c_str(), "w");
-  }
-  if (xmlout == NULL) {
-    // TODO(wan): report the reason of the failure.
-    //
-    // We don't do it for now as:
-    //
-    //   1. There is no urgent need for it.
-    //   2. It's a bit involved to make the errno variable thread-safe on
-    //      all three operating systems (Linux, Windows, and Mac OS).
-    //   3. To interpret the meaning of errno in a thread-safe way,
-    //      we need the strerror_r() function, which is not available on
-    //      Windows.
-    fprintf(stderr,
-            "Unable to open file \"%s\"\n",
-            output_file_.c_str());
-    fflush(stderr);
-    exit(EXIT_FAILURE);
+  FILE* const xmlout = OpenFileForWriting(output_file_);
+  {
+    FileStreamBuf buffer(xmlout);
+    std::ostream stream(&buffer);
+    PrintXmlUnitTest(&stream, unit_test);
   }
-  std::stringstream stream;
-  PrintXmlUnitTest(&stream, unit_test);
-  fprintf(xmlout, "%s", StringStreamToString(&stream).c_str());
   fclose(xmlout);
 }
 
-// Returns an XML-escaped copy of the input string str.  If is_attribute
-// is true, the text is meant to appear as an attribute value, and
-// normalizable whitespace is preserved by replacing it with character
-// references.
+// Returns the length of the run of characters at the start of [begin,
+// end) that are printable ASCII characters (and thus valid in both XML
+// and JSON text as they are) and aren't in specials.
+static size_t PlainTextRunLength(const char* begin, const char* end,
+                                 const char* specials) {
+  const char* p = begin;
+#if GTEST_HAS_SSE2
+  // Checks 16 characters at a time.  Bytes are signed here, so the ones
+  // above 0x7F end the run too, and the loop below decides whether
+  // they belong in it.
+  const __m128i kBeforeSpace = _mm_set1_epi8(0x1F);
+  const size_t num_specials = strlen(specials);
+  while (end - p >= 16) {
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i plain = _mm_cmpgt_epi8(chars, kBeforeSpace);
+    for (size_t i = 0; i != num_specials; i++) {
+      plain = _mm_andnot_si128(
+          _mm_cmpeq_epi8(chars, _mm_set1_epi8(specials[i])), plain);
+    }
+    if (_mm_movemask_epi8(plain) != 0xFFFF)
+      break;  // The loop below finds where the run ends.
+    p += 16;
+  }
+#endif  // GTEST_HAS_SSE2
+  // Where char is signed, the characters above 0x7F are negative and
+  // invalid in XML, as IsValidXmlCharacter() says.
+  while (p != end && *p >= 0x20 && strchr(specials, *p) == NULL)
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+// Streams the XML-escaped form of the length characters starting at
+// str.  If is_attribute is true, the text is meant to appear as an
+// attribute value, and normalizable whitespace is preserved by
+// replacing it with character references.
 //
 // Invalid XML characters in str, if any, are stripped from the output.
 // It is expected that most, if not all, of the text processed by this
@@ -3427,61 +4786,63 @@ void XmlUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
 // most invalid characters can be retained using character references.
 // TODO(wan): It might be nice to have a minimally invasive, human-readable
 // escaping scheme for invalid characters, rather than dropping them.
-std::string XmlUnitTestResultPrinter::EscapeXml(
-    const std::string& str, bool is_attribute) {
-  Message m;
+void XmlUnitTestResultPrinter::OutputEscapedXml(
+    ::std::ostream* stream, const char* str, size_t length,
+    bool is_attribute) {
+  const char* const end = str + length;
+  const char* const specials = is_attribute ? "<>&'\"" : "<>&";
+  while (str != end) {
+    // Runs of characters that need no escaping are written as they are.
+    const size_t run_length = PlainTextRunLength(str, end, specials);
+    stream->write(str, static_cast<std::streamsize>(run_length));
+    str += run_length;
+    if (str == end)
+      break;
 
-  for (size_t i = 0; i < str.size(); ++i) {
-    const char ch = str[i];
+    const char ch = *str++;
     switch (ch) {
       case '<':
-        m << "&lt;";
+        *stream << "&lt;";
         break;
       case '>':
-        m << "&gt;";
+        *stream << "&gt;";
         break;
       case '&':
-        m << "&amp;";
+        *stream << "&amp;";
         break;
       case '\'':
-        if (is_attribute)
-          m << "&apos;";
-        else
-          m << '\'';
+        *stream << "&apos;";
         break;
       case '"':
-        if (is_attribute)
-          m << "&quot;";
-        else
-          m << '"';
+        *stream << "&quot;";
         break;
-      default:
-        if (IsValidXmlCharacter(ch)) {
-          if (is_attribute && IsNormalizableWhitespace(ch))
-            m << "&#x" << String::FormatByte(static_cast<unsigned char>(ch))
-              << ";";
-          else
-            m << ch;
+      case '\t':
+      case '\n':
+      case '\r':
+        if (is_attribute) {
+          *stream << (ch == '\t' ? "&#x09;" :
+                      ch == '\n' ? "&#x0A;" : "&#x0D;");
+        } else {
+          stream->put(ch);
         }
         break;
+      default:
+        if (IsValidXmlCharacter(ch))
+          stream->put(ch);
+        break;
     }
   }
-
-  return m.GetString();
 }
 
-// Returns the given string with all characters invalid in XML removed.
-// Currently invalid characters are dropped from the string. An
-// alternative is to replace them with certain characters such as . or ?.
-std::string XmlUnitTestResultPrinter::RemoveInvalidXmlCharacters(
-    const std::string& str) {
-  std::string output;
-  output.reserve(str.size());
-  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
-    if (IsValidXmlCharacter(*it))
-      output.push_back(*it);
-
-  return output;
+// Returns an XML-escaped copy of the input string str.  If is_attribute
+// is true, the text is meant to appear as an attribute value, and
+// normalizable whitespace is preserved by replacing it with character
+// references.
+std::string XmlUnitTestResultPrinter::EscapeXml(
+    const std::string& str, bool is_attribute) {
+  ::std::stringstream stream;
+  OutputEscapedXml(&stream, str.data(), str.size(), is_attribute);
+  return stream.str();
 }
 
 // The following routines generate an XML representation of a UnitTest
@@ -3538,21 +4899,40 @@ std::string FormatEpochTimeInMillisAsIso8601(TimeInMillis ms) {
       String::FormatIntWidth2(time_struct.tm_sec);
 }
 
-// Streams an XML CDATA section, escaping invalid CDATA sequences as needed.
+// Streams an XML CDATA section holding the length characters starting
+// at data, without the characters that are invalid in XML, and escaping
+// invalid CDATA sequences as needed.
 void XmlUnitTestResultPrinter::OutputXmlCDataSection(::std::ostream* stream,
-                                                     const char* data) {
-  const char* segment = data;
+                                                     const char* data,
+                                                     size_t length) {
+  const char* const end = data + length;
+  // The number of ']' characters the section ends with so far, up to 2.
+  int num_brackets = 0;
   *stream << "<![CDATA[";
-  for (;;) {
-    const char* const next_segment = strstr(segment, "]]>");
-    if (next_segment != NULL) {
-      stream->write(
-          segment, static_cast<std::streamsize>(next_segment - segment));
-      *stream << "]]>]]&gt;<![CDATA[";
-      segment = next_segment + strlen("]]>");
-    } else {
-      *stream << segment;
-      break;
+  while (data != end) {
+    if (num_brackets == 2 && *data == '>') {
+      // Ends the section with this "]]>", and escapes the '>' in a new one.
+      *stream << ">]]&gt;<![CDATA[";
+      num_brackets = 0;
+      data++;
+      continue;
+    }
+
+    const size_t run_length = PlainTextRunLength(data, end, "]");
+    if (run_length != 0) {
+      stream->write(data, static_cast<std::streamsize>(run_length));
+      data += run_length;
+      num_brackets = 0;
+      continue;
+    }
+
+    const char ch = *data++;
+    if (ch == ']') {
+      stream->put(ch);
+      num_brackets = (std::min)(num_brackets + 1, 2);
+    } else if (IsValidXmlCharacter(ch)) {
+      stream->put(ch);
+      num_brackets = 0;
     }
   }
   *stream << "]]>";
@@ -3571,7 +4951,9 @@ void XmlUnitTestResultPrinter::OutputXmlAttribute(
       << "Attribute " << name << " is not allowed for element <" << element_name
       << ">.";
 
-  *stream << " " << name << "=\"" << EscapeXmlAttribute(value) << "\"";
+  *stream << " " << name << "=\"";
+  OutputEscapedXml(stream, value.data(), value.size(), true);
+  *stream << "\"";
 }
 
 // Prints an XML representation of a TestInfo object.
@@ -3610,11 +4992,11 @@ void XmlUnitTestResultPrinter::OutputXmlTestInfo(::std::ostream* stream,
       const string location = internal::FormatCompilerIndependentFileLocation(
           part.file_name(), part.line_number());
       const string summary = location + "\n" + part.summary();
-      *stream << "      <failure message=\""
-              << EscapeXmlAttribute(summary.c_str())
-              << "\" type=\"\">";
+      *stream << "      <failure message=\"";
+      OutputEscapedXml(stream, summary.data(), summary.size(), true);
+      *stream << "\" type=\"\">";
       const string detail = location + "\n" + part.message();
-      OutputXmlCDataSection(stream, RemoveInvalidXmlCharacters(detail).c_str());
+      OutputXmlCDataSection(stream, detail.data(), detail.size());
       *stream << "</failure>\n";
     }
   }
@@ -3705,71 +5087,947 @@ std::string XmlUnitTestResultPrinter::TestPropertiesAsXmlAttributes(
 
 // End XmlUnitTestResultPrinter
 
+// This class generates a JSON output file.  The document has the same
+// structure and keys as the XML report: a "testsuites" array holding
+// one object per test case, each with a "testsuite" array holding one
+// object per test.  As with XML, in incremental mode each test is also
+// streamed to the file as soon as it finishes; a crash leaves the
+// unterminated document behind.
+class JsonUnitTestResultPrinter : public EmptyTestEventListener {
+ public:
+  JsonUnitTestResultPrinter(const char* output_file, bool is_incremental);
+  virtual ~JsonUnitTestResultPrinter();
+
+  // Only incremental reports need the events before the iteration ends.
+  virtual int SubscribedEvents() const {
+    return is_incremental_ ?
+        kTestIterationStart | kTestCaseStart | kTestEnd | kTestCaseEnd |
+        kTestIterationEnd :
+        kTestIterationEnd;
+  }
+  virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
+  virtual void OnTestCaseStart(const TestCase& test_case);
+  virtual void OnTestEnd(const TestInfo& test_info);
+  virtual void OnTestCaseEnd(const TestCase& test_case);
+  virtual void OnTestIterationEnd(const UnitTest& unit_test, int iteration);
+
+ private:
+  // Flushes and closes the partial report, if one is open.
+  void ClosePartialReport();
+
+  // Streams str, quoted and JSON-escaped.
+  static void OutputJsonString(::std::ostream* stream, const std::string& str);
+
+  // Streams a "name": "value" member at the given indentation, preceded
+  // by a comma unless it is the first member of its object.
+  static void OutputJsonKey(::std::ostream* stream, const char* indent,
+                            const char* name, const std::string& value,
+                            bool is_first = false);
+
+  // Streams a "name": value member whose value is a number.
+  static void OutputJsonKey(::std::ostream* stream, const char* indent,
+                            const char* name, int value,
+                            bool is_first = false);
+
+  // Streams the recorded properties of result as members.
+  static void OutputJsonProperties(::std::ostream* stream, const char* indent,
+                                   const TestResult& result);
+
+  // Streams a JSON representation of a TestInfo object.
+  static void OutputJsonTestInfo(::std::ostream* stream,
+                                 const char* test_case_name,
+                                 const TestInfo& test_info);
+
+  // Prints a JSON representation of a TestCase object.
+  static void PrintJsonTestCase(::std::ostream* stream,
+                                const TestCase& test_case);
+
+  // Prints a JSON summary of unit_test to output stream out.
+  static void PrintJsonUnitTest(::std::ostream* stream,
+                                const UnitTest& unit_test);
+
+  // The output file.
+  const std::string output_file_;
+
+  // True iff the report is written as tests finish.
+  const bool is_incremental_;
+
+  // The partial report being written in incremental mode, or NULL.  The
+  // stream writes through the buffer, which writes to the file.
+  FILE* partial_file_;
+  scoped_ptr<FileStreamBuf> partial_buffer_;
+  scoped_ptr< ::std::ostream> partial_stream_;
+
+  // The number of test cases and of tests in the current test case that
+  // the partial report has, which tells whether a separator is needed.
+  int partial_test_case_count_;
+  int partial_test_count_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(JsonUnitTestResultPrinter);
+};
+
+// Creates a new JsonUnitTestResultPrinter.
+JsonUnitTestResultPrinter::JsonUnitTestResultPrinter(const char* output_file,
+                                                     bool is_incremental)
+    : output_file_(output_file),
+      is_incremental_(is_incremental),
+      partial_file_(NULL),
+      partial_test_case_count_(0),
+      partial_test_count_(0) {
+  if (output_file_.c_str() == NULL || output_file_.empty()) {
+    fprintf(stderr, "JSON output file may not be null\n");
+    fflush(stderr);
+    exit(EXIT_FAILURE);
+  }
+}
+
+JsonUnitTestResultPrinter::~JsonUnitTestResultPrinter() {
+  ClosePartialReport();
+}
+
+// Flushes and closes the partial report, if one is open.
+void JsonUnitTestResultPrinter::ClosePartialReport() {
+  if (partial_file_ == NULL)
+    return;
+
+  partial_stream_.reset();
+  partial_buffer_.reset();
+  fclose(partial_file_);
+  partial_file_ = NULL;
+}
+
+// Called before each iteration starts.  In incremental mode, starts a
+// partial report holding the members that are already known.
+void JsonUnitTestResultPrinter::OnTestIterationStart(const UnitTest& unit_test,
+                                                     int /*iteration*/) {
+  if (!is_incremental_)
+    return;
+
+  ClosePartialReport();
+  partial_file_ = OpenFileForWriting(output_file_);
+  partial_buffer_.reset(new FileStreamBuf(partial_file_));
+  partial_stream_.reset(new ::std::ostream(partial_buffer_.get()));
+  partial_test_case_count_ = 0;
+
+  const char kIndent[] = "  ";
+  ::std::ostream* const stream = partial_stream_.get();
+  *stream << "{\n";
+  OutputJsonKey(
+      stream, kIndent, "timestamp",
+      FormatEpochTimeInMillisAsIso8601(unit_test.start_timestamp()), true);
+  if (GTEST_FLAG(shuffle))
+    OutputJsonKey(stream, kIndent, "random_seed", unit_test.random_seed());
+  OutputJsonKey(stream, kIndent, "name", "AllTests");
+  *stream << ",\n" << kIndent << "\"testsuites\": [";
+  stream->flush();
+  fflush(partial_file_);
+}
+
+// Called before each test case starts.
+void JsonUnitTestResultPrinter::OnTestCaseStart(const TestCase& test_case) {
+  if (partial_stream_.get() == NULL || test_case.reportable_test_count() == 0)
+    return;
+
+  *partial_stream_ << (partial_test_case_count_++ == 0 ? "\n" : ",\n")
+                   << "    {\n";
+  OutputJsonKey(partial_stream_.get(), "      ", "name", test_case.name(),
+                true);
+  *partial_stream_ << ",\n      \"testsuite\": [";
+  partial_stream_->flush();
+  fflush(partial_file_);
+  partial_test_count_ = 0;
+}
+
+// Called after each test ends.  In incremental mode, writes the test to
+// the partial report and pushes it to the file, so that it survives a
+// crash in a later test.
+void JsonUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  if (partial_stream_.get() == NULL || !test_info.is_reportable())
+    return;
+
+  *partial_stream_ << (partial_test_count_++ == 0 ? "\n" : ",\n");
+  OutputJsonTestInfo(partial_stream_.get(), test_info.test_case_name(),
+                     test_info);
+  partial_stream_->flush();
+  fflush(partial_file_);
+}
+
+// Called after each test case ends.
+void JsonUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
+  if (partial_stream_.get() == NULL || test_case.reportable_test_count() == 0)
+    return;
+
+  *partial_stream_ << "\n      ]\n    }";
+  partial_stream_->flush();
+  fflush(partial_file_);
+}
+
+// Called after the unit test ends.  Writes the complete report, which
+// replaces the partial one in incremental mode.
+void JsonUnitTestResultPrinter::OnTestIterationEnd(const UnitTest& unit_test,
+                                                   int /*iteration*/) {
+  ClosePartialReport();
+
+  FILE* const jsonout = OpenFileForWriting(output_file_);
+  {
+    FileStreamBuf buffer(jsonout);
+    std::ostream stream(&buffer);
+    PrintJsonUnitTest(&stream, unit_test);
+  }
+  fclose(jsonout);
+}
+
+// Streams str, quoted and JSON-escaped.  Control characters are written
+// as escape sequences, and all other characters, including those of
+// UTF-8 multibyte sequences, are written as they are.
+void JsonUnitTestResultPrinter::OutputJsonString(::std::ostream* stream,
+                                                 const std::string& str) {
+  const char* p = str.data();
+  const char* const end = p + str.size();
+  stream->put('"');
+  for (;;) {
+    const size_t run_length = PlainTextRunLength(p, end, "\"\\");
+    stream->write(p, static_cast< ::std::streamsize>(run_length));
+    p += run_length;
+    if (p == end)
+      break;
+
+    const char ch = *p++;
+    switch (ch) {
+      case '"':  *stream << "\\\""; break;
+      case '\\': *stream << "\\\\"; break;
+      case '\b': *stream << "\\b"; break;
+      case '\f': *stream << "\\f"; break;
+      case '\n': *stream << "\\n"; break;
+      case '\r': *stream << "\\r"; break;
+      case '\t': *stream << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(ch) >= 0x80) {
+          stream->put(ch);
+        } else {
+          *stream << "\\u00" << String::FormatByte(
+              static_cast<unsigned char>(ch));
+        }
+        break;
+    }
+  }
+  stream->put('"');
+}
+
+// Streams a "name": "value" member at the given indentation.
+void JsonUnitTestResultPrinter::OutputJsonKey(::std::ostream* stream,
+                                              const char* indent,
+                                              const char* name,
+                                              const std::string& value,
+                                              bool is_first) {
+  *stream << (is_first ? "" : ",\n") << indent << "\"" << name << "\": ";
+  OutputJsonString(stream, value);
+}
+
+// Streams a "name": value member whose value is a number.
+void JsonUnitTestResultPrinter::OutputJsonKey(::std::ostream* stream,
+                                              const char* indent,
+                                              const char* name,
+                                              int value,
+                                              bool is_first) {
+  *stream << (is_first ? "" : ",\n") << indent << "\"" << name << "\": "
+          << value;
+}
+
+// Streams the recorded properties of result as members.  Their keys
+// can't clash with the other members, as RecordProperty() rejects the
+// names of those too (see kReservedTestSuitesAttributes).
+void JsonUnitTestResultPrinter::OutputJsonProperties(
+    ::std::ostream* stream, const char* indent, const TestResult& result) {
+  for (int i = 0; i < result.test_property_count(); ++i) {
+    const TestProperty& property = result.GetTestProperty(i);
+    *stream << ",\n" << indent;
+    OutputJsonString(stream, property.key());
+    *stream << ": ";
+    OutputJsonString(stream, property.value());
+  }
+}
+
+// Streams a JSON representation of a TestInfo object.
+void JsonUnitTestResultPrinter::OutputJsonTestInfo(::std::ostream* stream,
+                                                   const char* test_case_name,
+                                                   const TestInfo& test_info) {
+  const TestResult& result = *test_info.result();
+  const char kIndent[] = "          ";
+
+  *stream << "        {\n";
+  OutputJsonKey(stream, kIndent, "name", test_info.name(), true);
+
+  if (test_info.value_param() != NULL)
+    OutputJsonKey(stream, kIndent, "value_param", test_info.value_param());
+  if (test_info.type_param() != NULL)
+    OutputJsonKey(stream, kIndent, "type_param", test_info.type_param());
+
+  OutputJsonKey(stream, kIndent, "status",
+                test_info.should_run() ? "RUN" : "NOTRUN");
+  OutputJsonKey(stream, kIndent, "time",
+                FormatTimeInMillisAsSeconds(result.elapsed_time()) + "s");
+  OutputJsonKey(stream, kIndent, "classname", test_case_name);
+  OutputJsonProperties(stream, kIndent, result);
+
+  int failures = 0;
+  for (int i = 0; i < result.total_part_count(); ++i) {
+    const TestPartResult& part = result.GetTestPartResult(i);
+    if (part.failed()) {
+      *stream << (++failures == 1 ? ",\n          \"failures\": [\n" : ",\n")
+              << "            {\n";
+      const string location = internal::FormatCompilerIndependentFileLocation(
+          part.file_name(), part.line_number());
+      OutputJsonKey(stream, "              ", "failure",
+                    location + "\n" + part.message(), true);
+      OutputJsonKey(stream, "              ", "type", "");
+      *stream << "\n            }";
+    }
+  }
+  if (failures > 0)
+    *stream << "\n          ]";
+
+  *stream << "\n        }";
+}
+
+// Prints a JSON representation of a TestCase object.
+void JsonUnitTestResultPrinter::PrintJsonTestCase(::std::ostream* stream,
+                                                  const TestCase& test_case) {
+  const char kIndent[] = "      ";
+
+  *stream << "    {\n";
+  OutputJsonKey(stream, kIndent, "name", test_case.name(), true);
+  OutputJsonKey(stream, kIndent, "tests", test_case.reportable_test_count());
+  OutputJsonKey(stream, kIndent, "failures", test_case.failed_test_count());
+  OutputJsonKey(stream, kIndent, "disabled",
+                test_case.reportable_disabled_test_count());
+  OutputJsonKey(stream, kIndent, "errors", 0);
+  OutputJsonKey(stream, kIndent, "time",
+                FormatTimeInMillisAsSeconds(test_case.elapsed_time()) + "s");
+  OutputJsonProperties(stream, kIndent, test_case.ad_hoc_test_result());
+  *stream << ",\n" << kIndent << "\"testsuite\": [";
+
+  bool is_first = true;
+  for (int i = 0; i < test_case.total_test_count(); ++i) {
+    if (test_case.GetTestInfo(i)->is_reportable()) {
+      *stream << (is_first ? "\n" : ",\n");
+      is_first = false;
+      OutputJsonTestInfo(stream, test_case.name(), *test_case.GetTestInfo(i));
+    }
+  }
+  *stream << "\n" << kIndent << "]\n    }";
+}
+
+// Prints a JSON summary of unit_test to output stream out.
+void JsonUnitTestResultPrinter::PrintJsonUnitTest(::std::ostream* stream,
+                                                  const UnitTest& unit_test) {
+  const char kIndent[] = "  ";
+
+  *stream << "{\n";
+  OutputJsonKey(stream, kIndent, "tests", unit_test.reportable_test_count(),
+                true);
+  OutputJsonKey(stream, kIndent, "failures", unit_test.failed_test_count());
+  OutputJsonKey(stream, kIndent, "disabled",
+                unit_test.reportable_disabled_test_count());
+  OutputJsonKey(stream, kIndent, "errors", 0);
+  OutputJsonKey(
+      stream, kIndent, "timestamp",
+      FormatEpochTimeInMillisAsIso8601(unit_test.start_timestamp()));
+  OutputJsonKey(stream, kIndent, "time",
+                FormatTimeInMillisAsSeconds(unit_test.elapsed_time()) + "s");
+
+  if (GTEST_FLAG(shuffle))
+    OutputJsonKey(stream, kIndent, "random_seed", unit_test.random_seed());
+
+  OutputJsonProperties(stream, kIndent, unit_test.ad_hoc_test_result());
+  OutputJsonKey(stream, kIndent, "name", "AllTests");
+  *stream << ",\n" << kIndent << "\"testsuites\": [";
+
+  bool is_first = true;
+  for (int i = 0; i < unit_test.total_test_case_count(); ++i) {
+    if (unit_test.GetTestCase(i)->reportable_test_count() > 0) {
+      *stream << (is_first ? "\n" : ",\n");
+      is_first = false;
+      PrintJsonTestCase(stream, *unit_test.GetTestCase(i));
+    }
+  }
+  *stream << "\n" << kIndent << "]\n}\n";
+}
+
+// End JsonUnitTestResultPrinter
+
+// This class records the test events in a compact binary log, which
+// scripts/convert_binlog.py turns into an XML report or console output,
+// merging the logs of several test shards if needed.
+//
+// The log starts with the 8 bytes "GTBINLOG" and the format version as
+// a varint.  A varint is an unsigned integer stored 7 bits per byte,
+// least significant bits first, with the high bit set in all bytes but
+// the last.  Then come the records.  A record is its length in bytes as
+// a varint followed by as many bytes: the record type, then the fields
+// of the record, each of which is either
+//
+//   - a number, stored as a varint,
+//   - a string, stored as the varint ID of a string record that comes
+//     earlier in the log, or 0 for no string, or
+//   - text, stored as its length as a varint followed by its bytes.
+//
+// Each distinct string is thus written only once.  The records are:
+//
+//   kStringRecord            the remaining bytes are the text of the
+//                            string, whose ID is 1 for the first string
+//                            record, 2 for the second, and so on.
+//   kIterationStartRecord    iteration, timestamp in milliseconds since
+//                            the epoch, random seed or 0 if the tests
+//                            aren't shuffled.
+//   kTestRecord              test case name, test name text, value
+//                            parameter, type parameter, flags
+//                            (kShouldRunFlag, kDisabledFlag).  Written
+//                            at the start of each iteration for each
+//                            test in the report.
+//   kTestCaseStartRecord     test case name.
+//   kTestStartRecord         the position of the test among the test
+//                            records of the iteration, starting at 0.
+//   kTestPartResultRecord    TestPartResult::Type, file name, line
+//                            number plus one, message text.
+//   kPropertyRecord          scope (kTestScope, kTestCaseScope or
+//                            kProgramScope), key, value text.
+//   kTestEndRecord           elapsed time in milliseconds.
+//   kTestCaseEndRecord       elapsed time in milliseconds.
+//   kIterationEndRecord      elapsed time in milliseconds.
+//
+// The properties of a test, test case, or iteration are written just
+// before its end record.
+class BinlogUnitTestResultPrinter : public EmptyTestEventListener {
+ public:
+  explicit BinlogUnitTestResultPrinter(const char* output_file);
+  virtual ~BinlogUnitTestResultPrinter();
+
+  virtual int SubscribedEvents() const {
+    return kAllEvents & ~(kEnvironmentsSetUpStart |
+                          kEnvironmentsSetUpEnd |
+                          kEnvironmentsTearDownStart |
+                          kEnvironmentsTearDownEnd);
+  }
+  virtual void OnTestProgramStart(const UnitTest& unit_test);
+  virtual void OnTestIterationStart(const UnitTest& unit_test, int iteration);
+  virtual void OnTestCaseStart(const TestCase& test_case);
+  virtual void OnTestStart(const TestInfo& test_info);
+  virtual void OnTestPartResult(const TestPartResult& result);
+  virtual void OnTestEnd(const TestInfo& test_info);
+  virtual void OnTestCaseEnd(const TestCase& test_case);
+  virtual void OnTestIterationEnd(const UnitTest& unit_test, int iteration);
+  virtual void OnTestProgramEnd(const UnitTest& unit_test);
+
+  // Writes the records buffered so far to the log.
+  void Flush();
+
+ private:
+  enum {
+    kFormatVersion = 1
+  };
+
+  enum RecordType {
+    kStringRecord = 1,
+    kIterationStartRecord,
+    kTestRecord,
+    kTestCaseStartRecord,
+    kTestStartRecord,
+    kTestPartResultRecord,
+    kPropertyRecord,
+    kTestEndRecord,
+    kTestCaseEndRecord,
+    kIterationEndRecord
+  };
+
+  enum TestFlags {
+    kShouldRunFlag = 1,
+    kDisabledFlag = 2
+  };
+
+  enum PropertyScope {
+    kTestScope,
+    kTestCaseScope,
+    kProgramScope
+  };
+
+  // Appends value to buffer as a varint.
+  static void AppendVarint(std::string* buffer, UInt64 value);
+
+  // Starts a record of the given type in record_.
+  void BeginRecord(RecordType type);
+
+  // Writes the record in record_ to the log.
+  void EndRecord();
+
+  // Returns the ID of str, writing a string record first if str hasn't
+  // appeared in the log yet.
+  UInt64 InternString(const char* str);
+
+  // Appends str, which may be NULL, to record_ as a string field.
+  void AppendString(const char* str);
+
+  // Appends the length characters starting at text to record_ as a
+  // text field.
+  void AppendText(const char* text, size_t length);
+
+  // Writes a property record for each property of result.
+  void WriteProperties(PropertyScope scope, const TestResult& result);
+
+  // Flushes and closes the log, if it is open.
+  void Close();
+
+  // The output file.
+  const std::string output_file_;
+
+  // The log, or NULL when it isn't open.  The stream writes through
+  // the buffer, which writes to the file.
+  FILE* file_;
+  scoped_ptr<FileStreamBuf> buffer_;
+  scoped_ptr< ::std::ostream> stream_;
+
+  // The IDs of the strings written so far.
+  std::map<std::string, UInt64> string_ids_;
+
+  // The tests of the current iteration in the order of their test
+  // records, which is the order they run in, and the position of the
+  // last test that started.
+  std::vector<const TestInfo*> tests_;
+  size_t current_test_;
+
+  // The record being built.  Reused so that records don't allocate.
+  std::string record_;
+
+  // The encoded length of the record being written.
+  std::string record_length_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(BinlogUnitTestResultPrinter);
+};
+
+// Creates a new BinlogUnitTestResultPrinter.
+BinlogUnitTestResultPrinter::BinlogUnitTestResultPrinter(
+    const char* output_file)
+    : output_file_(output_file), file_(NULL), current_test_(0) {
+  if (output_file_.c_str() == NULL || output_file_.empty()) {
+    fprintf(stderr, "Binary log output file may not be null\n");
+    fflush(stderr);
+    exit(EXIT_FAILURE);
+  }
+}
+
+BinlogUnitTestResultPrinter::~BinlogUnitTestResultPrinter() {
+  Close();
+}
+
+// Appends value to buffer as a varint.
+void BinlogUnitTestResultPrinter::AppendVarint(std::string* buffer,
+                                               UInt64 value) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+// Starts a record of the given type in record_.
+void BinlogUnitTestResultPrinter::BeginRecord(RecordType type) {
+  record_.clear();
+  record_.push_back(static_cast<char>(type));
+}
+
+// Writes the record in record_ to the log.
+void BinlogUnitTestResultPrinter::EndRecord() {
+  record_length_.clear();
+  AppendVarint(&record_length_, record_.size());
+  stream_->write(record_length_.data(),
+                 static_cast< ::std::streamsize>(record_length_.size()));
+  stream_->write(record_.data(),
+                 static_cast< ::std::streamsize>(record_.size()));
+}
+
+// Returns the ID of str, writing a string record first if needed.
+UInt64 BinlogUnitTestResultPrinter::InternString(const char* str) {
+  const UInt64 new_id = string_ids_.size() + 1;
+  const std::pair<std::map<std::string, UInt64>::iterator, bool> inserted =
+      string_ids_.insert(std::make_pair(std::string(str), new_id));
+  if (inserted.second) {
+    // The string record goes ahead of the record being built.
+    const size_t length = strlen(str);
+    record_length_.clear();
+    AppendVarint(&record_length_, length + 1);
+    record_length_.push_back(static_cast<char>(kStringRecord));
+    stream_->write(record_length_.data(),
+                   static_cast< ::std::streamsize>(record_length_.size()));
+    stream_->write(str, static_cast< ::std::streamsize>(length));
+  }
+  return inserted.first->second;
+}
+
+// Appends str to record_ as a string field.
+void BinlogUnitTestResultPrinter::AppendString(const char* str) {
+  AppendVarint(&record_, str == NULL ? 0 : InternString(str));
+}
+
+// Appends the length characters starting at text to record_ as a text
+// field.
+void BinlogUnitTestResultPrinter::AppendText(const char* text,
+                                             size_t length) {
+  AppendVarint(&record_, length);
+  record_.append(text, length);
+}
+
+// Writes a property record for each property of result.
+void BinlogUnitTestResultPrinter::WriteProperties(PropertyScope scope,
+                                                  const TestResult& result) {
+  for (int i = 0; i < result.test_property_count(); ++i) {
+    const TestProperty& property = result.GetTestProperty(i);
+    BeginRecord(kPropertyRecord);
+    AppendVarint(&record_, scope);
+    AppendString(property.key());
+    AppendText(property.value(), strlen(property.value()));
+    EndRecord();
+  }
+}
+
+// Opens the log.
+void BinlogUnitTestResultPrinter::OnTestProgramStart(
+    const UnitTest& /*unit_test*/) {
+  file_ = OpenFileForWriting(output_file_);
+  buffer_.reset(new FileStreamBuf(file_));
+  stream_.reset(new ::std::ostream(buffer_.get()));
+
+  std::string header("GTBINLOG");
+  AppendVarint(&header, kFormatVersion);
+  stream_->write(header.data(),
+                 static_cast< ::std::streamsize>(header.size()));
+}
+
+// Writes the start of the iteration and the tests in the report.
+void BinlogUnitTestResultPrinter::OnTestIterationStart(
+    const UnitTest& unit_test, int iteration) {
+  BeginRecord(kIterationStartRecord);
+  AppendVarint(&record_, static_cast<UInt64>(iteration));
+  AppendVarint(&record_, static_cast<UInt64>(unit_test.start_timestamp()));
+  AppendVarint(&record_, GTEST_FLAG(shuffle) ?
+               static_cast<UInt64>(unit_test.random_seed()) : 0);
+  EndRecord();
+
+  // The tests are shuffled by now, so they are listed in the order they
+  // run in.
+  tests_.clear();
+  current_test_ = 0;
+  for (int i = 0; i < unit_test.total_test_case_count(); ++i) {
+    const TestCase& test_case = *unit_test.GetTestCase(i);
+    const UInt64 test_case_name_id = InternString(test_case.name());
+    // Mirrors how UnitTestImpl::FilterTests() finds disabled tests.
+    const bool is_test_case_disabled =
+        UnitTestOptions::MatchesFilter(test_case.name(), kDisableTestFilter);
+    for (int j = 0; j < test_case.total_test_count(); ++j) {
+      const TestInfo& test_info = *test_case.GetTestInfo(j);
+      if (!test_info.is_reportable())
+        continue;
+
+      const bool is_disabled = is_test_case_disabled ||
+          UnitTestOptions::MatchesFilter(test_info.name(),
+                                         kDisableTestFilter);
+      // Test names are rarely shared, so they aren't worth interning.
+      BeginRecord(kTestRecord);
+      AppendVarint(&record_, test_case_name_id);
+      AppendText(test_info.name(), strlen(test_info.name()));
+      AppendString(test_info.value_param());
+      AppendString(test_info.type_param());
+      AppendVarint(&record_, (test_info.should_run() ? kShouldRunFlag : 0) |
+                   (is_disabled ? kDisabledFlag : 0));
+      EndRecord();
+      tests_.push_back(&test_info);
+    }
+  }
+}
+
+void BinlogUnitTestResultPrinter::OnTestCaseStart(const TestCase& test_case) {
+  BeginRecord(kTestCaseStartRecord);
+  AppendString(test_case.name());
+  EndRecord();
+}
+
+// Writes the position of the test among the test records.  As the
+// tests start in the order of their records, finding it takes constant
+// time on average.
+void BinlogUnitTestResultPrinter::OnTestStart(const TestInfo& test_info) {
+  for (size_t searched = 0; searched < tests_.size(); searched++) {
+    if (tests_[current_test_] == &test_info) {
+      BeginRecord(kTestStartRecord);
+      AppendVarint(&record_, current_test_);
+      EndRecord();
+      return;
+    }
+    current_test_ = (current_test_ + 1) % tests_.size();
+  }
+}
+
+void BinlogUnitTestResultPrinter::OnTestPartResult(
+    const TestPartResult& result) {
+  BeginRecord(kTestPartResultRecord);
+  AppendVarint(&record_, static_cast<UInt64>(result.type()));
+  AppendString(result.file_name());
+  AppendVarint(&record_, static_cast<UInt64>(result.line_number() + 1));
+  AppendText(result.message(), strlen(result.message()));
+  EndRecord();
+}
+
+void BinlogUnitTestResultPrinter::OnTestEnd(const TestInfo& test_info) {
+  WriteProperties(kTestScope, *test_info.result());
+  BeginRecord(kTestEndRecord);
+  AppendVarint(&record_,
+               static_cast<UInt64>(test_info.result()->elapsed_time()));
+  EndRecord();
+}
+
+void BinlogUnitTestResultPrinter::OnTestCaseEnd(const TestCase& test_case) {
+  WriteProperties(kTestCaseScope, test_case.ad_hoc_test_result());
+  BeginRecord(kTestCaseEndRecord);
+  AppendVarint(&record_, static_cast<UInt64>(test_case.elapsed_time()));
+  EndRecord();
+}
+
+void BinlogUnitTestResultPrinter::OnTestIterationEnd(
+    const UnitTest& unit_test, int /*iteration*/) {
+  WriteProperties(kProgramScope, unit_test.ad_hoc_test_result());
+  BeginRecord(kIterationEndRecord);
+  AppendVarint(&record_, static_cast<UInt64>(unit_test.elapsed_time()));
+  EndRecord();
+}
+
+void BinlogUnitTestResultPrinter::OnTestProgramEnd(
+    const UnitTest& /*unit_test*/) {
+  Close();
+}
+
+// Writes the records buffered so far to the log.
+void BinlogUnitTestResultPrinter::Flush() {
+  if (file_ == NULL)
+    return;
+
+  stream_->flush();
+  fflush(file_);
+}
+
+// Flushes and closes the log, if it is open.
+void BinlogUnitTestResultPrinter::Close() {
+  if (file_ == NULL)
+    return;
+
+  // The stream goes before the buffer it writes to, and the buffer
+  // writes out what it holds before the file is closed.
+  stream_.reset();
+  buffer_.reset();
+  fclose(file_);
+  file_ = NULL;
+}
+
+// End BinlogUnitTestResultPrinter
+
 #if GTEST_CAN_STREAM_RESULTS_
 
-// Checks if str contains '=', '&', '%' or '\n' characters. If yes,
-// replaces them by "%xx" where xx is their hexadecimal value. For
-// example, replaces "=" with "%3D".  This algorithm is O(strlen(str))
-// in both time and space -- important as the input str may contain an
-// arbitrarily long test failure message and stack trace.
-string StreamingListener::UrlEncode(const char* str) {
-  string result;
-  result.reserve(strlen(str) + 1);
+// Appends str to *output, replacing '=', '&', '%' and '\n' characters by
+// "%xx" where xx is their hexadecimal value.  For example, replaces "="
+// with "%3D".  This algorithm is O(strlen(str)) in both time and space
+// -- important as the input str may contain an arbitrarily long test
+// failure message and stack trace.
+static void AppendUrlEncoded(const char* str, string* output) {
+  static const char kHexDigits[] = "0123456789ABCDEF";
   for (char ch = *str; ch != '\0'; ch = *++str) {
     switch (ch) {
       case '%':
       case '=':
       case '&':
       case '\n':
-        result.append("%" + String::FormatByte(static_cast<unsigned char>(ch)));
+        output->push_back('%');
+        output->push_back(kHexDigits[static_cast<unsigned char>(ch) >> 4]);
+        output->push_back(kHexDigits[ch & 0xF]);
         break;
       default:
-        result.push_back(ch);
+        output->push_back(ch);
         break;
     }
   }
+}
+
+// Checks if str contains '=', '&', '%' or '\n' characters. If yes,
+// replaces them by "%xx" where xx is their hexadecimal value.
+string StreamingListener::UrlEncode(const char* str) {
+  string result;
+  result.reserve(strlen(str) + 1);
+  AppendUrlEncoded(str, &result);
   return result;
 }
 
+void StreamingListener::StartMessage() {
+  message_.clear();
+  if (framing_ == kBinaryFraming) {
+    // Leaves room for the length, which SendMessage() fills in.
+    message_.append(4, '\0');
+  }
+}
+
+void StreamingListener::AddField(const char* key, const char* value) {
+  if (framing_ == kBinaryFraming) {
+    message_.append(key);
+    message_.push_back('\0');
+    message_.append(value);
+    message_.push_back('\0');
+  } else {
+    if (!message_.empty())
+      message_.push_back('&');
+    message_.append(key);
+    message_.push_back('=');
+    AppendUrlEncoded(value, &message_);
+  }
+}
+
+void StreamingListener::AddIntField(const char* key, TimeInMillis value,
+                                    const char* unit) {
+  // Formats the number backwards from the end of the buffer, which has
+  // room for the digits of any 64-bit number, a sign, and the unit.
+  char buffer[32];
+  const size_t unit_length = strlen(unit);
+  GTEST_CHECK_(unit_length < 8);
+  char* const end = buffer + sizeof(buffer) - 1 - unit_length;
+  memcpy(end, unit, unit_length + 1);
+
+  const bool is_negative = value < 0;
+  UInt64 magnitude = is_negative ? 0 - static_cast<UInt64>(value) :
+      static_cast<UInt64>(value);
+  char* begin = end;
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (is_negative)
+    *--begin = '-';
+  AddField(key, begin);
+}
+
+void StreamingListener::SendMessage() {
+  if (framing_ == kBinaryFraming) {
+    const UInt32 length = static_cast<UInt32>(message_.size() - 4);
+    message_[0] = static_cast<char>(length >> 24);
+    message_[1] = static_cast<char>(length >> 16);
+    message_[2] = static_cast<char>(length >> 8);
+    message_[3] = static_cast<char>(length);
+  } else {
+    message_.push_back('\n');
+  }
+  socket_writer_->Send(message_);
+}
+
+void StreamingListener::SocketWriter::Send(const string& message) {
+  GTEST_CHECK_(sockfd_ != -1)
+      << "Send() can be called only when there is a connection.";
+
+  buffer_.append(message);
+  if (buffer_.size() >= kFlushBytes ||
+      GetTimeInMillis() - last_flush_time_ >= kFlushMillis) {
+    FlushPending();
+  }
+}
+
+void StreamingListener::SocketWriter::FlushPending() {
+  last_flush_time_ = GetTimeInMillis();
+  WriteBuffer(kMaxPendingBytes);
+}
+
+void StreamingListener::SocketWriter::WriteBuffer(size_t max_pending_bytes) {
+  size_t written = 0;
+  while (written != buffer_.size()) {
+    const size_t pending = buffer_.size() - written;
+    // MSG_NOSIGNAL turns a reader that went away into an error rather
+    // than a SIGPIPE.
+    const ssize_t count = send(sockfd_, buffer_.data() + written, pending,
+                               MSG_NOSIGNAL);
+    if (count > 0) {
+      written += static_cast<size_t>(count);
+    } else if (count == -1 && errno == EINTR) {
+      continue;
+    } else if (count == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // The socket is full.  Keeps the rest for later, unless too much
+      // is waiting for the reader already.
+      if (pending <= max_pending_bytes)
+        break;
+      pollfd writable;
+      writable.fd = sockfd_;
+      writable.events = POLLOUT;
+      writable.revents = 0;
+      poll(&writable, 1, -1);
+    } else {
+      GTEST_LOG_(WARNING)
+          << "stream_result_to: failed to stream to " << Endpoint();
+      written = buffer_.size();
+    }
+  }
+  buffer_.erase(0, written);
+}
+
 void StreamingListener::SocketWriter::MakeConnection() {
   GTEST_CHECK_(sockfd_ == -1)
       << "MakeConnection() can't be called when there is already a connection.";
 
-  addrinfo hints;
-  memset(&hints, 0, sizeof(hints));
-  hints.ai_family = AF_UNSPEC;    // To allow both IPv4 and IPv6 addresses.
-  hints.ai_socktype = SOCK_STREAM;
-  addrinfo* servinfo = NULL;
-
-  // Use the getaddrinfo() to get a linked list of IP addresses for
-  // the given host name.
-  const int error_num = getaddrinfo(
-      host_name_.c_str(), port_num_.c_str(), &hints, &servinfo);
-  if (error_num != 0) {
-    GTEST_LOG_(WARNING) << "stream_result_to: getaddrinfo() failed: "
-                        << gai_strerror(error_num);
-  }
-
-  // Loop through all the results and connect to the first we can.
-  for (addrinfo* cur_addr = servinfo; sockfd_ == -1 && cur_addr != NULL;
-       cur_addr = cur_addr->ai_next) {
-    sockfd_ = socket(
-        cur_addr->ai_family, cur_addr->ai_socktype, cur_addr->ai_protocol);
-    if (sockfd_ != -1) {
-      // Connect the client socket to the server socket.
-      if (connect(sockfd_, cur_addr->ai_addr, cur_addr->ai_addrlen) == -1) {
+  if (!unix_socket_path_.empty()) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (unix_socket_path_.length() < sizeof(address.sun_path)) {
+      memcpy(address.sun_path, unix_socket_path_.c_str(),
+             unix_socket_path_.length());
+      sockfd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (sockfd_ != -1 &&
+          connect(sockfd_, reinterpret_cast<sockaddr*>(&address),
+                  sizeof(address)) == -1) {
         close(sockfd_);
         sockfd_ = -1;
       }
     }
-  }
+  } else {
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;    // To allow both IPv4 and IPv6 addresses.
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* servinfo = NULL;
+
+    // Use the getaddrinfo() to get a linked list of IP addresses for
+    // the given host name.
+    const int error_num = getaddrinfo(
+        host_name_.c_str(), port_num_.c_str(), &hints, &servinfo);
+    if (error_num != 0) {
+      GTEST_LOG_(WARNING) << "stream_result_to: getaddrinfo() failed: "
+                          << gai_strerror(error_num);
+    }
+
+    // Loop through all the results and connect to the first we can.
+    for (addrinfo* cur_addr = servinfo; sockfd_ == -1 && cur_addr != NULL;
+         cur_addr = cur_addr->ai_next) {
+      sockfd_ = socket(
+          cur_addr->ai_family, cur_addr->ai_socktype, cur_addr->ai_protocol);
+      if (sockfd_ != -1) {
+        // Connect the client socket to the server socket.
+        if (connect(sockfd_, cur_addr->ai_addr, cur_addr->ai_addrlen) == -1) {
+          close(sockfd_);
+          sockfd_ = -1;
+        }
+      }
+    }
 
-  freeaddrinfo(servinfo);  // all done with this structure
+    freeaddrinfo(servinfo);  // all done with this structure
+  }
 
   if (sockfd_ == -1) {
     GTEST_LOG_(WARNING) << "stream_result_to: failed to connect to "
-                        << host_name_ << ":" << port_num_;
+                        << Endpoint();
+    return;
   }
+
+  // Writes that would block are buffered instead; see WriteBuffer().
+  fcntl(sockfd_, F_SETFL, fcntl(sockfd_, F_GETFL) | O_NONBLOCK);
 }
 
 // End of class Streaming Listener
@@ -3925,6 +6183,18 @@ void TestEventListeners::SuppressEventForwarding() {
   repeater_->set_forwarding_enabled(false);
 }
 
+// Makes the repeater forward the events on a background reporting
+// thread (--gtest_async_listeners) until the test program ends.
+void TestEventListeners::StartReportingThread() {
+  repeater_->StartReportingThread();
+}
+
+// Blocks until the reporting thread has forwarded all events so far.
+// Returns true iff there is a reporting thread, which is then idle.
+bool TestEventListeners::FlushEvents() {
+  return repeater_->Flush();
+}
+
 // class UnitTest
 
 // Gets the singleton UnitTest object.  The first time this method is
@@ -4232,17 +6502,27 @@ const char* UnitTest::original_working_dir() const {
 }
 
 // Returns the TestCase object for the test that's currently running,
-// or NULL if no test is running.
+// or NULL if no test is running.  On the reporting thread, "currently"
+// means when the event being forwarded happened.
 const TestCase* UnitTest::current_test_case() const
     GTEST_LOCK_EXCLUDED_(mutex_) {
+  const internal::TestEventState* const state =
+      internal::QueuedEventState();
+  if (state != NULL)
+    return state->current_test_case;
   internal::MutexLock lock(&mutex_);
   return impl_->current_test_case();
 }
 
 // Returns the TestInfo object for the test that's currently running,
-// or NULL if no test is running.
+// or NULL if no test is running.  On the reporting thread, "currently"
+// means when the event being forwarded happened.
 const TestInfo* UnitTest::current_test_info() const
     GTEST_LOCK_EXCLUDED_(mutex_) {
+  const internal::TestEventState* const state =
+      internal::QueuedEventState();
+  if (state != NULL)
+    return state->current_test_info;
   internal::MutexLock lock(&mutex_);
   return impl_->current_test_info();
 }
@@ -4305,6 +6585,10 @@ UnitTestImpl::UnitTestImpl(UnitTest* parent)
       current_test_case_(NULL),
       current_test_info_(NULL),
       ad_hoc_test_result_(),
+      binlog_printer_(NULL),
+#if GTEST_CAN_STREAM_RESULTS_
+      streaming_listener_(NULL),
+#endif  // GTEST_CAN_STREAM_RESULTS_
       os_stack_trace_getter_(NULL),
       post_flag_parse_init_performed_(false),
       random_seed_(0),  // Will be overridden by the flag before first use.
@@ -4366,7 +6650,16 @@ void UnitTestImpl::ConfigureXmlOutput() {
   const std::string& output_format = UnitTestOptions::GetOutputFormat();
   if (output_format == "xml") {
     listeners()->SetDefaultXmlGenerator(new XmlUnitTestResultPrinter(
-        UnitTestOptions::GetAbsolutePathToOutputFile().c_str()));
+        UnitTestOptions::GetAbsolutePathToOutputFile().c_str(),
+        GTEST_FLAG(incremental_output)));
+  } else if (output_format == "json") {
+    listeners()->SetDefaultXmlGenerator(new JsonUnitTestResultPrinter(
+        UnitTestOptions::GetAbsolutePathToOutputFile().c_str(),
+        GTEST_FLAG(incremental_output)));
+  } else if (output_format == "binlog") {
+    binlog_printer_ = new BinlogUnitTestResultPrinter(
+        UnitTestOptions::GetAbsolutePathToOutputFile().c_str());
+    listeners()->SetDefaultXmlGenerator(binlog_printer_);
   } else if (output_format != "") {
     printf("WARNING: unrecognized output format \"%s\" ignored.\n",
            output_format.c_str());
@@ -4380,10 +6673,27 @@ void UnitTestImpl::ConfigureXmlOutput() {
 void UnitTestImpl::ConfigureStreamingOutput() {
   const std::string& target = GTEST_FLAG(stream_result_to);
   if (!target.empty()) {
+    const std::string& format = GTEST_FLAG(stream_result_format);
+    StreamingListener::Framing framing = StreamingListener::kTextFraming;
+    if (format == "binary") {
+      framing = StreamingListener::kBinaryFraming;
+    } else if (format != "text") {
+      printf("WARNING: unrecognized streaming format \"%s\" ignored.\n",
+             format.c_str());
+      fflush(stdout);
+    }
+
     const size_t pos = target.find(':');
-    if (pos != std::string::npos) {
-      listeners()->Append(new StreamingListener(target.substr(0, pos),
-                                                target.substr(pos+1)));
+    if (target.compare(0, 5, "unix:") == 0) {
+      streaming_listener_ = new StreamingListener(
+          new StreamingListener::SocketWriter(target.substr(5)), framing);
+      listeners()->Append(streaming_listener_);
+    } else if (pos != std::string::npos) {
+      streaming_listener_ = new StreamingListener(
+          new StreamingListener::SocketWriter(target.substr(0, pos),
+                                              target.substr(pos+1)),
+          framing);
+      listeners()->Append(streaming_listener_);
     } else {
       printf("WARNING: unrecognized streaming target \"%s\" ignored.\n",
              target.c_str());
@@ -4393,6 +6703,26 @@ void UnitTestImpl::ConfigureStreamingOutput() {
 }
 #endif  // GTEST_CAN_STREAM_RESULTS_
 
+// Waits until the reporting thread of --gtest_async_listeners, if any,
+// is idle, and writes out the results buffered for the binary log and
+// the --gtest_stream_result_to socket, so that a process forked next
+// inherits none of them.  Returns true iff there is a reporting thread.
+bool UnitTestImpl::FlushEventsBeforeFork() {
+  const bool has_reporting_thread = listeners()->FlushEvents();
+  // A child that calls exit() would otherwise write the buffered records
+  // to the log a second time.
+  if (binlog_printer_ != NULL &&
+      listeners()->default_xml_generator() == binlog_printer_)
+    binlog_printer_->Flush();
+#if GTEST_CAN_STREAM_RESULTS_
+  // Once FlushEvents() returns, the reporting thread no longer touches
+  // the listeners, so this thread can write for it.
+  if (streaming_listener_ != NULL)
+    streaming_listener_->Flush();
+#endif  // GTEST_CAN_STREAM_RESULTS_
+  return has_reporting_thread;
+}
+
 // Performs initialization dependent upon flag values obtained in
 // ParseGoogleTestFlagsOnly.  Is called from InitGoogleTest after the call to
 // ParseGoogleTestFlagsOnly.  In case a user neglects to call InitGoogleTest
@@ -4413,6 +6743,13 @@ void UnitTestImpl::PostFlagParsingInit() {
     // RUN_ALL_TESTS.
     RegisterParameterizedTests();
 
+    // Replaces the console output with the brief one, unless the user
+    // has removed it.
+    if (GTEST_FLAG(brief) && listeners()->default_result_printer() != NULL) {
+      listeners()->SetDefaultResultPrinter(new BriefUnitTestResultPrinter(
+          posix::IsATTY(posix::FileNo(stdout)) != 0));
+    }
+
     // Configures listeners for XML output. This makes it possible for users
     // to shut down the default XML output before invoking RUN_ALL_TESTS.
     ConfigureXmlOutput();
@@ -4560,6 +6897,11 @@ bool UnitTestImpl::RunAllTests() {
   // True iff at least one test has failed.
   bool failed = false;
 
+  // Death test subprocesses don't forward events, so they don't need a
+  // reporting thread.
+  if (GTEST_FLAG(async_listeners) && !in_subprocess_for_death_test)
+    listeners()->StartReportingThread();
+
   TestEventListener* repeater = listeners()->repeater();
 
   start_timestamp_ = GetTimeInMillis();
@@ -5137,19 +7479,40 @@ static const char kColorEncodedHelpMessage[] =
 "      Enable/disable colored output. The default is @Gauto@D.\n"
 "  -@G-" GTEST_FLAG_PREFIX_ "print_time=0@D\n"
 "      Don't print the elapsed time of each test.\n"
-"  @G--" GTEST_FLAG_PREFIX_ "output=xml@Y[@G:@YDIRECTORY_PATH@G"
-    GTEST_PATH_SEP_ "@Y|@G:@YFILE_PATH]@D\n"
-"      Generate an XML report in the given directory or with the given file\n"
-"      name. @YFILE_PATH@D defaults to @Gtest_details.xml@D.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "brief@D\n"
+"      Print only the failures and a summary, plus a progress line when the\n"
+"      output is a terminal.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "print_budget=@Y[CHARACTERS]@D\n"
+"      Print at most this many characters of a value in a failure message,\n"
+"      or everything if @YCHARACTERS@D is @G0@D. The default is @G65536@D.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "output=@Y(@Gjson@Y|@Gxml@Y|@Gbinlog@Y)"
+    "[@G:@YDIRECTORY_PATH@G" GTEST_PATH_SEP_ "@Y|@G:@YFILE_PATH]@D\n"
+"      Generate a JSON or XML report, or a binary log of the test events,\n"
+"      in the given directory or with the given file name. @YFILE_PATH@D\n"
+"      defaults to @Gtest_detail.@D followed by the format.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "incremental_output@D\n"
+"      Write the XML or JSON report as tests finish, so that a crash leaves a\n"
+"      partial report behind, and complete it when the tests are done.\n"
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+"  @G--" GTEST_FLAG_PREFIX_ "async_listeners@D\n"
+"      Print the output and deliver the other test events on a background\n"
+"      thread, so that a slow terminal or listener doesn't hold up the tests.\n"
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
 #if GTEST_CAN_STREAM_RESULTS_
-"  @G--" GTEST_FLAG_PREFIX_ "stream_result_to=@YHOST@G:@YPORT@D\n"
+"  @G--" GTEST_FLAG_PREFIX_ "stream_result_to=@Y(@YHOST@G:@YPORT@Y|@Gunix:"
+    "@YPATH@Y)@D\n"
 "      Stream test results to the given server.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "stream_result_format=@Y(@Gtext@Y|@Gbinary@Y)@D\n"
+"      Stream a line per event, or a length-prefixed message per event.\n"
 #endif  // GTEST_CAN_STREAM_RESULTS_
 "\n"
 "Assertion Behavior:\n"
 #if GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
 "  @G--" GTEST_FLAG_PREFIX_ "death_test_style=@Y(@Gfast@Y|@Gthreadsafe@Y)@D\n"
 "      Set the default death test style.\n"
+"  @G--" GTEST_FLAG_PREFIX_ "death_test_use_zygote@D\n"
+"      Fork threadsafe death tests from a helper process started by\n"
+"      InitGoogleTest(), instead of re-executing the test program.\n"
 #endif  // GTEST_HAS_DEATH_TEST && !GTEST_OS_WINDOWS
 "  @G--" GTEST_FLAG_PREFIX_ "break_on_failure@D\n"
 "      Turn assertion failures into debugger break-points.\n"
@@ -5187,8 +7550,11 @@ void ParseGoogleTestFlagsOnlyImpl(int* argc, CharType** argv) {
     // Do we see a Google Test flag?
     if (ParseBoolFlag(arg, kAlsoRunDisabledTestsFlag,
                       &GTEST_FLAG(also_run_disabled_tests)) ||
+        ParseBoolFlag(arg, kAsyncListenersFlag,
+                      &GTEST_FLAG(async_listeners)) ||
         ParseBoolFlag(arg, kBreakOnFailureFlag,
                       &GTEST_FLAG(break_on_failure)) ||
+        ParseBoolFlag(arg, kBriefFlag, &GTEST_FLAG(brief)) ||
         ParseBoolFlag(arg, kCatchExceptionsFlag,
                       &GTEST_FLAG(catch_exceptions)) ||
         ParseStringFlag(arg, kColorFlag, &GTEST_FLAG(color)) ||
@@ -5196,17 +7562,24 @@ void ParseGoogleTestFlagsOnlyImpl(int* argc, CharType** argv) {
                         &GTEST_FLAG(death_test_style)) ||
         ParseBoolFlag(arg, kDeathTestUseFork,
                       &GTEST_FLAG(death_test_use_fork)) ||
+        ParseBoolFlag(arg, kDeathTestUseZygote,
+                      &GTEST_FLAG(death_test_use_zygote)) ||
         ParseStringFlag(arg, kFilterFlag, &GTEST_FLAG(filter)) ||
         ParseStringFlag(arg, kInternalRunDeathTestFlag,
                         &GTEST_FLAG(internal_run_death_test)) ||
+        ParseBoolFlag(arg, kIncrementalOutputFlag,
+                      &GTEST_FLAG(incremental_output)) ||
         ParseBoolFlag(arg, kListTestsFlag, &GTEST_FLAG(list_tests)) ||
         ParseStringFlag(arg, kOutputFlag, &GTEST_FLAG(output)) ||
+        ParseInt32Flag(arg, kPrintBudgetFlag, &GTEST_FLAG(print_budget)) ||
         ParseBoolFlag(arg, kPrintTimeFlag, &GTEST_FLAG(print_time)) ||
         ParseInt32Flag(arg, kRandomSeedFlag, &GTEST_FLAG(random_seed)) ||
         ParseInt32Flag(arg, kRepeatFlag, &GTEST_FLAG(repeat)) ||
         ParseBoolFlag(arg, kShuffleFlag, &GTEST_FLAG(shuffle)) ||
         ParseInt32Flag(arg, kStackTraceDepthFlag,
                        &GTEST_FLAG(stack_trace_depth)) ||
+        ParseStringFlag(arg, kStreamResultFormatFlag,
+                        &GTEST_FLAG(stream_result_format)) ||
         ParseStringFlag(arg, kStreamResultToFlag,
                         &GTEST_FLAG(stream_result_to)) ||
         ParseBoolFlag(arg, kThrowOnFailureFlag,
@@ -5277,6 +7650,14 @@ void InitGoogleTestImpl(int* argc, CharType** argv) {
 #endif  // GTEST_HAS_DEATH_TEST
 
   ParseGoogleTestFlagsOnly(argc, argv);
+
+#if GTEST_CAN_FORK_TESTS_
+  // Forks the zygote before the program starts threads of its own, and
+  // before the listeners are set up, so that its children set them up
+  // like a re-executed test program would.
+  StartDeathTestZygote();
+#endif  // GTEST_CAN_FORK_TESTS_
+
   GetUnitTestImpl()->PostFlagParsingInit();
 }
 
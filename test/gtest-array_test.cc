@@ -0,0 +1,611 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Tests for the assertions on arrays and containers.
+
+#include "gtest/gtest-array.h"
+
+#include <stddef.h>
+
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gtest/gtest-spi.h"
+
+namespace {
+
+using ::testing::AssertionResult;
+using ::testing::internal::ArraysNearPredFormat;
+using ::testing::internal::ArraysNearUlpPredFormat;
+using ::testing::internal::CmpHelperArrayEQ;
+using ::testing::internal::CmpHelperContainerEQ;
+using ::testing::internal::FindArrayMismatch;
+using ::testing::internal::FloatingPoint;
+using ::testing::internal::FloatingPointArrayErrors;
+using ::testing::internal::IsTriviallyComparable;
+using ::testing::internal::MeasureAbsErrors;
+using ::testing::internal::MeasureUlpErrors;
+
+// Returns the failure message of an AssertionResult, or "" if it's a
+// success.
+std::string FailureMessageOf(const AssertionResult& result) {
+  return result ? "" : result.message();
+}
+
+std::vector<int> Iota(int size) {
+  std::vector<int> v;
+  for (int i = 0; i < size; ++i)
+    v.push_back(i);
+  return v;
+}
+
+TEST(IsTriviallyComparableTest, IsTrueForIntegersAndPointers) {
+  EXPECT_TRUE(IsTriviallyComparable<bool>::value);
+  EXPECT_TRUE(IsTriviallyComparable<char>::value);
+  EXPECT_TRUE(IsTriviallyComparable<unsigned short>::value);  // NOLINT
+  EXPECT_TRUE(IsTriviallyComparable<int>::value);
+  EXPECT_TRUE(IsTriviallyComparable<long>::value);  // NOLINT
+  EXPECT_TRUE(IsTriviallyComparable<const char*>::value);
+}
+
+TEST(IsTriviallyComparableTest, IsFalseForFloatingPointAndClasses) {
+  EXPECT_FALSE(IsTriviallyComparable<float>::value);
+  EXPECT_FALSE(IsTriviallyComparable<double>::value);
+  EXPECT_FALSE(IsTriviallyComparable<std::string>::value);
+}
+
+// Tests that the memcmp() based search finds differences at and around
+// the boundaries of the blocks it compares.
+TEST(FindArrayMismatchTest, FindsMismatchesAroundBlockBoundaries) {
+  const std::vector<int> expected = Iota(10000);
+  const int kIndices[] = { 0, 1, 1023, 1024, 1025, 5000, 9999 };
+  for (size_t i = 0; i < GTEST_ARRAY_SIZE_(kIndices); ++i) {
+    std::vector<int> actual = expected;
+    actual[kIndices[i]] = -1;
+    EXPECT_EQ(static_cast<size_t>(kIndices[i]),
+              FindArrayMismatch(&expected[0], &actual[0], 0, 10000));
+    EXPECT_EQ(10000u,
+              FindArrayMismatch(&expected[0], &actual[0], kIndices[i] + 1,
+                                10000));
+  }
+  EXPECT_EQ(10000u, FindArrayMismatch(&expected[0], &expected[0], 0, 10000));
+}
+
+TEST(ArrayEqTest, SucceedsOnEqualArrays) {
+  const int a[] = { 1, 2, 3 };
+  const int b[] = { 1, 2, 3 };
+  EXPECT_ARRAY_EQ(a, b, 3);
+  ASSERT_ARRAY_EQ(a, b, 3);
+
+  const std::vector<int> v = Iota(100000);
+  const std::vector<int> w = v;
+  EXPECT_ARRAY_EQ(&v[0], &w[0], v.size());
+}
+
+TEST(ArrayEqTest, ComparesOnlyTheGivenNumberOfElements) {
+  const int a[] = { 1, 2, 3 };
+  const int b[] = { 1, 2, 4 };
+  EXPECT_ARRAY_EQ(a, b, 2);
+  EXPECT_ARRAY_EQ(a, b, 0);
+}
+
+TEST(ArrayEqTest, ComparesElementsOfDifferentTypes) {
+  const int a[] = { 1, 2, 3 };
+  const long b[] = { 1, 2, 3 };  // NOLINT
+  const double c[] = { 1.0, 2.0, 3.5 };
+  EXPECT_ARRAY_EQ(a, b, 3);
+  EXPECT_FALSE(CmpHelperArrayEQ("a", "c", "3", a, c, 3));
+}
+
+TEST(ArrayEqTest, ComparesFloatingPointValuesWithOperatorEq) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double a[] = { 0.0, nan };
+  const double b[] = { -0.0, nan };
+  EXPECT_ARRAY_EQ(a, b, 1);
+  EXPECT_FALSE(CmpHelperArrayEQ("a", "b", "2", a, b, 2));
+}
+
+TEST(ArrayEqTest, ReportsDifferingRangesWithContext) {
+  std::vector<int> expected = Iota(1000);
+  std::vector<int> actual = expected;
+  actual[10] = -10;
+  actual[11] = -11;
+  actual[500] = 0;
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "3 of n (which is 1000) elements differ, in 2 ranges.\n"
+            "Elements [10, 12) differ; showing [8, 14):\n"
+            "  Expected: { 8, 9, 10, 11, 12, 13 }\n"
+            "    Actual: { 8, 9, -10, -11, 12, 13 }\n"
+            "Element 500 differs; showing [498, 503):\n"
+            "  Expected: { 498, 499, 500, 501, 502 }\n"
+            "    Actual: { 498, 499, 0, 501, 502 }",
+            FailureMessageOf(CmpHelperArrayEQ("expected", "actual", "n",
+                                              &expected[0], &actual[0],
+                                              expected.size())));
+}
+
+TEST(ArrayEqTest, ClipsContextToTheArray) {
+  const int expected[] = { 1, 2, 3 };
+  const int actual[] = { 0, 2, 0 };
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "2 of 3 elements differ, in 2 ranges.\n"
+            "Element 0 differs; showing [0, 3):\n"
+            "  Expected: { 1, 2, 3 }\n"
+            "    Actual: { 0, 2, 0 }\n"
+            "Element 2 differs; showing [0, 3):\n"
+            "  Expected: { 1, 2, 3 }\n"
+            "    Actual: { 0, 2, 0 }",
+            FailureMessageOf(CmpHelperArrayEQ("expected", "actual", "3",
+                                              expected, actual, 3)));
+}
+
+TEST(ArrayEqTest, PrintsOnlyTheStartOfALongRange) {
+  const std::vector<int> expected = Iota(100);
+  const std::vector<int> actual(100, -1);
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "100 of 100 elements differ, in 1 range.\n"
+            "Elements [0, 100) differ; showing [0, 10):\n"
+            "  Expected: { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 }\n"
+            "    Actual: { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }",
+            FailureMessageOf(CmpHelperArrayEQ("expected", "actual", "100",
+                                              &expected[0], &actual[0],
+                                              100)));
+}
+
+TEST(ArrayEqTest, CountsRangesThatAreNotShown) {
+  const std::vector<int> expected = Iota(100);
+  std::vector<int> actual = expected;
+  for (int i = 0; i < 100; i += 10)
+    actual[i] = -1;
+  const std::string message = FailureMessageOf(
+      CmpHelperArrayEQ("expected", "actual", "100",
+                       &expected[0], &actual[0], 100));
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring,
+                      "10 of 100 elements differ, in 10 ranges.", message);
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring, "Element 30 differs", message);
+  EXPECT_PRED_FORMAT2(::testing::IsNotSubstring, "Element 40", message);
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring,
+                      "(6 more ranges of differing elements not shown)",
+                      message);
+}
+
+TEST(ArrayEqTest, PrintsElementsWithUniversalPrinter) {
+  const std::string expected[] = { "a", "b" };
+  const std::string actual[] = { "a", "c" };
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring,
+                      "  Expected: { \"a\", \"b\" }\n"
+                      "    Actual: { \"a\", \"c\" }",
+                      FailureMessageOf(CmpHelperArrayEQ(
+                          "expected", "actual", "2", expected, actual, 2)));
+}
+
+static int global_expected[] = { 1, 2, 3 };
+static int global_actual[] = { 1, 2, 4 };
+
+TEST(ArrayEqTest, ExpectArrayEqFailsNonFatally) {
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_ARRAY_EQ(global_expected, global_actual, 3),
+      "1 of 3 elements differs, in 1 range.");
+}
+
+TEST(ArrayEqTest, AssertArrayEqFailsFatally) {
+  EXPECT_FATAL_FAILURE(ASSERT_ARRAY_EQ(global_expected, global_actual, 3),
+                       "Element 2 differs; showing [0, 3):");
+}
+
+TEST(ContainerEqTest, SucceedsOnEqualContainers) {
+  const std::vector<int> v = Iota(5);
+  const std::list<int> l(v.begin(), v.end());
+  const std::deque<long> d(v.begin(), v.end());  // NOLINT
+  const std::set<int> s(v.begin(), v.end());
+  EXPECT_CONTAINER_EQ(v, l);
+  EXPECT_CONTAINER_EQ(l, d);
+  ASSERT_CONTAINER_EQ(d, s);
+  EXPECT_CONTAINER_EQ(std::string("abc"), std::string("abc"));
+  EXPECT_CONTAINER_EQ(std::vector<int>(), std::list<int>());
+}
+
+TEST(ContainerEqTest, ComparesVectorsOfBool) {
+  std::vector<bool> expected(3, true);
+  std::vector<bool> actual(3, true);
+  EXPECT_CONTAINER_EQ(expected, actual);
+  actual[1] = false;
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "1 of 3 elements differs, in 1 range.\n"
+            "Element 1 differs; showing [0, 3):\n"
+            "  Expected: { true, true, true }\n"
+            "    Actual: { true, false, true }",
+            FailureMessageOf(CmpHelperContainerEQ("expected", "actual",
+                                                  expected, actual)));
+}
+
+TEST(ContainerEqTest, ReportsDifferingElementsOfListsWithContext) {
+  const std::vector<int> v = Iota(10);
+  const std::list<int> expected(v.begin(), v.end());
+  std::list<int> actual(expected);
+  actual.back() = 0;
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "1 of 10 elements differs, in 1 range.\n"
+            "Element 9 differs; showing [7, 10):\n"
+            "  Expected: { 7, 8, 9 }\n"
+            "    Actual: { 7, 8, 0 }",
+            FailureMessageOf(CmpHelperContainerEQ("expected", "actual",
+                                                  expected, actual)));
+}
+
+TEST(ContainerEqTest, ReportsDifferentSizes) {
+  const std::vector<int> expected = Iota(5);
+  const std::vector<int> actual = Iota(4);
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "They have different sizes: 5 elements are expected, "
+            "but there are 4.",
+            FailureMessageOf(CmpHelperContainerEQ("expected", "actual",
+                                                  expected, actual)));
+}
+
+// A container with forward iterators and no size(), like
+// std::forward_list.
+class ForwardOnlyContainer {
+ public:
+  typedef int value_type;
+
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef int value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const int* pointer;
+    typedef const int& reference;
+
+    explicit const_iterator(const int* p) : p_(p) {}
+    const int& operator*() const { return *p_; }
+    const_iterator& operator++() {
+      ++p_;
+      return *this;
+    }
+    bool operator==(const const_iterator& other) const {
+      return p_ == other.p_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return p_ != other.p_;
+    }
+
+   private:
+    const int* p_;
+  };
+
+  ForwardOnlyContainer(const int* begin, const int* end)
+      : begin_(begin), end_(end) {}
+
+  const_iterator begin() const { return const_iterator(begin_); }
+  const_iterator end() const { return const_iterator(end_); }
+
+ private:
+  const int* begin_;
+  const int* end_;
+};
+
+TEST(ContainerEqTest, ComparesContainersWithoutSize) {
+  const int kValues[] = { 0, 1, 2, 3 };
+  const ForwardOnlyContainer container(kValues, kValues + 4);
+  EXPECT_CONTAINER_EQ(Iota(4), container);
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected\n"
+            "They have different sizes: 3 elements are expected, "
+            "but there are 4.",
+            FailureMessageOf(CmpHelperContainerEQ("expected", "actual",
+                                                  Iota(3), container)));
+}
+
+static std::vector<int> global_vector(3, 1);
+static std::list<int> global_list(2, 1);
+
+TEST(ContainerEqTest, ExpectContainerEqFailsNonFatally) {
+  EXPECT_NONFATAL_FAILURE(EXPECT_CONTAINER_EQ(global_vector, global_list),
+                          "They have different sizes");
+}
+
+TEST(ContainerEqTest, AssertContainerEqFailsFatally) {
+  EXPECT_FATAL_FAILURE(ASSERT_CONTAINER_EQ(global_vector, global_list),
+                       "They have different sizes");
+}
+
+// Returns the number that is ulps ULPs above the positive number value.
+template <typename RawType>
+RawType UlpsAbove(RawType value, int ulps) {
+  typename FloatingPoint<RawType>::Bits bits =
+      FloatingPoint<RawType>(value).bits() + ulps;
+  return FloatingPoint<RawType>::ReinterpretBits(bits);
+}
+
+// Returns the histogram bucket of a difference of ulps ULPs, for a
+// tolerance of 4 ULPs.
+int BucketOfUlps(int ulps) {
+  const int kLimits[] = { 0, 1, 2, 4, 16, 256 };
+  int bucket = 0;
+  while (bucket < 6 && ulps > kLimits[bucket])
+    ++bucket;
+  return bucket;
+}
+
+// Builds arrays that differ by i % 11 ULPs at index i, except where i is
+// a multiple of 1000 and the actual element is a NaN, and checks what
+// MeasureUlpErrors() says about them.  The sizes are chosen to exercise
+// the vectorized loops, their scalar tails, and the flushing of their
+// counters.
+template <typename RawType>
+void CheckUlpErrors(size_t size) {
+  std::vector<RawType> expected(size);
+  std::vector<RawType> actual(size);
+  size_t histogram[FloatingPointArrayErrors::kNumBuckets] = { 0 };
+  size_t num_failures = 0;
+  for (size_t i = 0; i < size; ++i) {
+    expected[i] = static_cast<RawType>(1.0 + i / 7.0);
+    const int ulps = static_cast<int>(i % 11);
+    if (i % 1000 == 999) {
+      actual[i] = std::numeric_limits<RawType>::quiet_NaN();
+      histogram[FloatingPointArrayErrors::kNumBuckets - 1]++;
+      num_failures++;
+    } else {
+      actual[i] = UlpsAbove(expected[i], ulps);
+      histogram[BucketOfUlps(ulps)]++;
+      num_failures += ulps > 4;
+    }
+  }
+
+  FloatingPointArrayErrors errors;
+  MeasureUlpErrors(&expected[0], &actual[0], size, 4, &errors);
+  EXPECT_EQ(num_failures, errors.num_failures) << "size " << size;
+  for (int k = 0; k < FloatingPointArrayErrors::kNumBuckets; ++k)
+    EXPECT_EQ(histogram[k], errors.histogram[k]) << "bucket " << k;
+  if (size >= 1000) {
+    EXPECT_EQ(999u, errors.worst_index);
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), errors.max_error);
+  } else {
+    EXPECT_EQ(10u, errors.worst_index);
+    EXPECT_EQ(10.0, errors.max_error);
+  }
+}
+
+TEST(MeasureUlpErrorsTest, MeasuresFloats) {
+  CheckUlpErrors<float>(11);
+  CheckUlpErrors<float>(103);
+  CheckUlpErrors<float>(300001);
+}
+
+TEST(MeasureUlpErrorsTest, MeasuresDoubles) {
+  CheckUlpErrors<double>(11);
+  CheckUlpErrors<double>(103);
+  CheckUlpErrors<double>(300001);
+}
+
+TEST(MeasureUlpErrorsTest, CountsUlpsAcrossZero) {
+  const float denorm_min = std::numeric_limits<float>::denorm_min();
+  const float expected[] = { -0.0f, -denorm_min, 1.0f, -1.0f, 0.0f };
+  const float actual[] = { 0.0f, denorm_min, 1.0f, -1.0f, 0.0f };
+  FloatingPointArrayErrors errors;
+  MeasureUlpErrors(expected, actual, 5, 0, &errors);
+  EXPECT_EQ(1u, errors.num_failures);
+  EXPECT_EQ(1u, errors.worst_index);
+  EXPECT_EQ(2.0, errors.max_error);
+}
+
+TEST(MeasureUlpErrorsTest, NeverTreatsNanAsNear) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double expected[] = { nan, 1.0 };
+  const double actual[] = { nan, 1.0 };
+  FloatingPointArrayErrors errors;
+  MeasureUlpErrors(expected, actual, 2,
+                   ~static_cast<testing::internal::UInt64>(0), &errors);
+  EXPECT_EQ(1u, errors.num_failures);
+  EXPECT_EQ(0u, errors.worst_index);
+}
+
+template <typename RawType>
+void CheckAbsErrors(size_t size) {
+  std::vector<RawType> expected(size);
+  std::vector<RawType> actual(size);
+  size_t num_failures = 0;
+  size_t num_nans = 0;
+  for (size_t i = 0; i < size; ++i) {
+    expected[i] = static_cast<RawType>(i % 5);
+    if (i % 1000 == 999) {
+      actual[i] = std::numeric_limits<RawType>::quiet_NaN();
+      num_failures++;
+      num_nans++;
+    } else {
+      // Differs by 0, 0.25, 0.5, 0.75, or 1.
+      actual[i] = static_cast<RawType>(expected[i] + (i % 5) * 0.25);
+      num_failures += i % 5 > 2;
+    }
+  }
+
+  FloatingPointArrayErrors errors;
+  MeasureAbsErrors(&expected[0], &actual[0], size, 0.5, &errors);
+  EXPECT_EQ(num_failures, errors.num_failures) << "size " << size;
+  EXPECT_EQ(num_nans,
+            errors.histogram[FloatingPointArrayErrors::kNumBuckets - 1]);
+  EXPECT_EQ(0.5, errors.bucket_limits[3]);
+  if (size >= 1000) {
+    EXPECT_EQ(999u, errors.worst_index);
+  } else {
+    EXPECT_EQ(4u, errors.worst_index);
+    EXPECT_EQ(1.0, errors.max_error);
+  }
+}
+
+TEST(MeasureAbsErrorsTest, MeasuresFloatsAndDoubles) {
+  CheckAbsErrors<float>(5);
+  CheckAbsErrors<float>(1001);
+  CheckAbsErrors<double>(5);
+  CheckAbsErrors<double>(1001);
+}
+
+// An infinite difference is as large as one involving a NaN, but the
+// NaN is still the worst.
+template <typename RawType>
+void CheckNanOutranksInfinity(size_t size) {
+  std::vector<RawType> expected(size, RawType(1));
+  std::vector<RawType> actual(size, RawType(1));
+  actual[1] = std::numeric_limits<RawType>::infinity();
+  actual[size - 2] = std::numeric_limits<RawType>::quiet_NaN();
+  actual[size - 1] = -std::numeric_limits<RawType>::infinity();
+
+  FloatingPointArrayErrors errors;
+  MeasureAbsErrors(&expected[0], &actual[0], size, 0.5, &errors);
+  EXPECT_EQ(3u, errors.num_failures) << "size " << size;
+  EXPECT_EQ(size - 2, errors.worst_index) << "size " << size;
+  EXPECT_EQ(std::numeric_limits<double>::infinity(), errors.max_error);
+
+  MeasureUlpErrors(&expected[0], &actual[0], size, 4, &errors);
+  EXPECT_EQ(3u, errors.num_failures) << "size " << size;
+  EXPECT_EQ(size - 2, errors.worst_index) << "size " << size;
+}
+
+TEST(MeasureAbsErrorsTest, NanOutranksInfiniteDifference) {
+  CheckNanOutranksInfinity<float>(5);
+  CheckNanOutranksInfinity<float>(1001);
+  CheckNanOutranksInfinity<double>(5);
+  CheckNanOutranksInfinity<double>(1001);
+}
+
+TEST(MeasureAbsErrorsTest, TreatsEqualInfinitiesAsNear) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double expected[] = { inf, -inf, inf };
+  const double actual[] = { inf, -inf, 1.0 };
+  FloatingPointArrayErrors errors;
+  MeasureAbsErrors(expected, actual, 3, 1.0, &errors);
+  EXPECT_EQ(1u, errors.num_failures);
+  EXPECT_EQ(2u, errors.worst_index);
+  EXPECT_EQ(inf, errors.max_error);
+}
+
+TEST(ArraysNearTest, SucceedsWithinTolerance) {
+  const float expected[] = { 1.0f, 2.0f, 3.0f };
+  const float actual[] = { 1.0f, UlpsAbove(2.0f, 4), 3.0f };
+  EXPECT_ARRAYS_NEAR_ULP(expected, actual, 3, 4);
+  ASSERT_ARRAYS_NEAR_ULP(expected, actual, 3, 4);
+  EXPECT_ARRAYS_NEAR(expected, actual, 3, 1e-6);
+  ASSERT_ARRAYS_NEAR(expected, actual, 3, 1e-6);
+
+  const std::vector<double> v(100000, 0.1);
+  EXPECT_ARRAYS_NEAR_ULP(&v[0], &v[0], v.size(), 0);
+  EXPECT_ARRAYS_NEAR(&v[0], &v[0], v.size(), 0.0);
+}
+
+TEST(ArraysNearTest, ReportsTheLargestDifferenceAndAHistogram) {
+  const double expected[] = { 1.0, 2.0, 3.0, 4.0 };
+  const double actual[] = { 1.0, UlpsAbove(2.0, 3), UlpsAbove(3.0, 1000),
+                            UlpsAbove(4.0, 5) };
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected, within max_ulps (which is 4) ULPs\n"
+            "2 of 4 elements differ by more than that.\n"
+            "The largest difference is 1000 ULPs, at index 2:\n"
+            "  expected[2] = 3\n"
+            "    actual[2] = 3.0000000000004441\n"
+            "Histogram of the differences:\n"
+            "  0: 1\n"
+            "  (2, 4]: 1\n"
+            "  (4, 16]: 1\n"
+            "  > 256: 1",
+            FailureMessageOf(ArraysNearUlpPredFormat(
+                "expected", "actual", "4", "max_ulps",
+                expected, actual, 4, 4)));
+}
+
+TEST(ArraysNearTest, ReportsNan) {
+  const float expected[] = { 1.0f, 2.0f };
+  const float actual[] = { 1.5f, std::numeric_limits<float>::quiet_NaN() };
+  const std::string message = FailureMessageOf(ArraysNearPredFormat(
+      "expected", "actual", "n", "1", expected, actual, 2, 1));
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring,
+                      "Value of: actual\n"
+                      "Expected: expected, within 1\n"
+                      "1 of n (which is 2) elements differs by more than "
+                      "that.\n"
+                      "The largest difference is NaN, at index 1:\n"
+                      "  expected[1] = 2\n", message);
+  EXPECT_PRED_FORMAT2(::testing::IsSubstring,
+                      "Histogram of the differences:\n"
+                      "  (0.25, 0.5]: 1\n"
+                      "  NaN: 1", message);
+}
+
+TEST(ArraysNearTest, FailsWithNanTolerance) {
+  const float expected[] = { 1.0f, 2.0f, 3.0f };
+  const float actual[] = { 100.0f, 200.0f, 300.0f };
+  EXPECT_EQ("Value of: actual\n"
+            "Expected: expected, within abs_error (which is nan)\n"
+            "The tolerance is NaN, so no element can be near.",
+            FailureMessageOf(ArraysNearPredFormat(
+                "expected", "actual", "3", "abs_error", expected, actual, 3,
+                std::numeric_limits<double>::quiet_NaN())));
+  EXPECT_FALSE(ArraysNearPredFormat(
+      "expected", "expected", "3", "abs_error", expected, expected, 3,
+      std::numeric_limits<double>::quiet_NaN()));
+}
+
+static double global_expected_doubles[] = { 1.0, 2.0 };
+static double global_actual_doubles[] = { 1.0, 2.5 };
+
+TEST(ArraysNearTest, ExpectArraysNearFailsNonFatally) {
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_ARRAYS_NEAR(global_expected_doubles, global_actual_doubles, 2,
+                         0.1),
+      "The largest difference is 0.5, at index 1");
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_ARRAYS_NEAR_ULP(global_expected_doubles, global_actual_doubles,
+                             2, 4),
+      "1 of 2 elements differs by more than that.");
+}
+
+TEST(ArraysNearTest, AssertArraysNearFailsFatally) {
+  EXPECT_FATAL_FAILURE(
+      ASSERT_ARRAYS_NEAR(global_expected_doubles, global_actual_doubles, 2,
+                         0.1),
+      "The largest difference is 0.5, at index 1");
+  EXPECT_FATAL_FAILURE(
+      ASSERT_ARRAYS_NEAR_ULP(global_expected_doubles, global_actual_doubles,
+                             2, 4),
+      "1 of 2 elements differs by more than that.");
+}
+
+}  // namespace
@@ -459,6 +459,46 @@ TEST_F(TestForDeathTest, MixedStyles) {
   EXPECT_DEATH(_exit(1), "");
 }
 
+# if !GTEST_OS_WINDOWS
+
+// A signal handler that does nothing.
+void IgnoreSignal(int /* signum */) {}
+
+// Tests that the child process of a threadsafe death test starts with
+// the signal mask of the test program, but with the default action for
+// the signals it handles, and that the test program gets its mask back
+// after spawning the child with all signals blocked.
+TEST_F(TestForDeathTest, ThreadsafeDeathTestKeepsSignalMask) {
+  testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  sigset_t sigusr1, saved_mask;
+  sigemptyset(&sigusr1);
+  sigaddset(&sigusr1, SIGUSR1);
+  ASSERT_EQ(0, pthread_sigmask(SIG_BLOCK, &sigusr1, &saved_mask));
+  // The re-executed child runs this code as well, and must not install
+  // the handler itself.
+  struct sigaction handler, saved_handler;
+  memset(&handler, 0, sizeof(handler));
+  handler.sa_handler = &IgnoreSignal;
+  if (!InDeathTestChild()) {
+    ASSERT_EQ(0, sigaction(SIGUSR2, &handler, &saved_handler));
+  }
+
+  EXPECT_EXIT(raise(SIGUSR2), testing::KilledBySignal(SIGUSR2), "");
+  EXPECT_EXIT({
+    raise(SIGUSR1);
+    _exit(1);
+  }, testing::ExitedWithCode(1), "");
+
+  ASSERT_EQ(0, sigaction(SIGUSR2, &saved_handler, &handler));
+  EXPECT_EQ(&IgnoreSignal, handler.sa_handler);
+  sigset_t mask;
+  ASSERT_EQ(0, pthread_sigmask(SIG_SETMASK, &saved_mask, &mask));
+  EXPECT_TRUE(sigismember(&mask, SIGUSR1));
+  EXPECT_FALSE(sigismember(&mask, SIGUSR2));
+}
+
+# endif  // !GTEST_OS_WINDOWS
+
 # if GTEST_HAS_CLONE && GTEST_HAS_PTHREAD
 
 namespace {
@@ -33,6 +33,9 @@
 
 #include "gtest/gtest-message.h"
 
+#include <iomanip>
+#include <limits>
+
 #include "gtest/gtest.h"
 
 namespace {
@@ -127,6 +130,71 @@ TEST(MessageTest, StreamsInt) {
   EXPECT_EQ("123", (Message() << 123).GetString());
 }
 
+// Returns what streaming value to a stringstream set up the way a
+// Message's is prints.
+template <typename T>
+std::string StreamToString(const T& value) {
+  ::std::stringstream ss;
+  ss << std::setprecision(std::numeric_limits<double>::digits10 + 2)
+     << value;
+  return ss.str();
+}
+
+// Tests that numbers are streamed exactly as an ostream prints them.
+TEST(MessageTest, StreamsNumbersLikeOStream) {
+  const short min_short = std::numeric_limits<short>::min();  // NOLINT
+  EXPECT_EQ(StreamToString(min_short), (Message() << min_short).GetString());
+  const unsigned short max_ushort = 65535;  // NOLINT
+  EXPECT_EQ("65535", (Message() << max_ushort).GetString());
+  EXPECT_EQ("-2147483648",
+            (Message() << std::numeric_limits<int>::min()).GetString());
+  EXPECT_EQ("4294967295", (Message() << 4294967295U).GetString());
+  const long min_long = std::numeric_limits<long>::min();  // NOLINT
+  EXPECT_EQ(StreamToString(min_long), (Message() << min_long).GetString());
+  const unsigned long max_ulong =  // NOLINT
+      std::numeric_limits<unsigned long>::max();  // NOLINT
+  EXPECT_EQ(StreamToString(max_ulong), (Message() << max_ulong).GetString());
+  EXPECT_EQ("-9223372036854775808",
+            (Message() << std::numeric_limits<testing::internal::BiggestInt>
+                          ::min()).GetString());
+  EXPECT_EQ("18446744073709551615",
+            (Message() << std::numeric_limits<testing::internal::UInt64>
+                          ::max()).GetString());
+
+  const double doubles[] = {
+    0.0, -0.0, 1.0, 0.1, 1.0 / 3, -2.5e-300, 1e300, 123456789012345678.0,
+    std::numeric_limits<double>::infinity(),
+    std::numeric_limits<double>::denorm_min()
+  };
+  for (size_t i = 0; i != sizeof(doubles) / sizeof(doubles[0]); i++) {
+    EXPECT_EQ(StreamToString(doubles[i]),
+              (Message() << doubles[i]).GetString());
+    EXPECT_EQ(StreamToString(static_cast<float>(doubles[i])),
+              (Message() << static_cast<float>(doubles[i])).GetString());
+  }
+}
+
+// Tests that IO manipulators apply to the values streamed after them.
+TEST(MessageTest, StreamsNumbersWithManipulators) {
+  EXPECT_EQ("1 ff 0x3 1.5e+00",
+            (Message() << 1 << " " << std::hex << 255 << " "
+                       << std::showbase << 3 << " " << std::scientific
+                       << std::setprecision(1) << 1.5).GetString());
+}
+
+// Tests streaming text that doesn't fit in a Message's buffer.
+TEST(MessageTest, StreamsLongText) {
+  const std::string line(50, 'x');
+  Message msg;
+  std::string expected;
+  for (int i = 0; i < 10; i++) {
+    msg << line << i << '\0';
+    expected += line + static_cast<char>('0' + i) + "\\0";
+  }
+  EXPECT_EQ(expected, msg.GetString());
+  EXPECT_EQ(expected, Message(msg).GetString());
+}
+
 // Tests that basic IO manipulators (endl, ends, and flush) can be
 // streamed to Message.
 TEST(MessageTest, StreamsBasicIoManip) {
@@ -103,6 +103,32 @@ TEST(XmlOutputTest, GetOutputFileFromDirectoryPath) {
 #endif
 }
 
+TEST(JsonOutputTest, GetOutputFormat) {
+  GTEST_FLAG(output) = "json:filename";
+  EXPECT_STREQ("json", UnitTestOptions::GetOutputFormat().c_str());
+}
+
+TEST(JsonOutputTest, GetOutputFileDefault) {
+  GTEST_FLAG(output) = "json";
+  EXPECT_EQ(GetAbsolutePathOf(FilePath("test_detail.json")).string(),
+            UnitTestOptions::GetAbsolutePathToOutputFile());
+}
+
+TEST(JsonOutputTest, GetOutputFileFromDirectoryPath) {
+  GTEST_FLAG(output) = "json:path" GTEST_PATH_SEP_;
+  const std::string expected_output_file =
+      GetAbsolutePathOf(
+          FilePath(std::string("path") + GTEST_PATH_SEP_ +
+                   GetCurrentExecutableName().string() + ".json")).string();
+  const std::string& output_file =
+      UnitTestOptions::GetAbsolutePathToOutputFile();
+#if GTEST_OS_WINDOWS
+  EXPECT_STRCASEEQ(expected_output_file.c_str(), output_file.c_str());
+#else
+  EXPECT_EQ(expected_output_file, output_file.c_str());
+#endif
+}
+
 TEST(OutputFileHelpersTest, GetCurrentExecutableName) {
   const std::string exe_str = GetCurrentExecutableName().string();
 #if GTEST_OS_WINDOWS
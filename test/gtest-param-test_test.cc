@@ -121,6 +121,17 @@ template <typename T1, typename T2, typename T3, typename T4, typename T5,
   return stream.str();
 }
 
+#  if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Longer tuples are only generated by the variadic Combine(), which
+// also implies that Google Test knows how to print them.
+template <typename... Ts>
+::std::string PrintValue(const tuple<Ts...>& value) {
+  return ::testing::PrintToString(value);
+}
+
+#  endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 # endif  // GTEST_HAS_COMBINE
 
 // Verifies that a sequence generated by the generator and accessed
@@ -440,6 +451,26 @@ TEST(ValuesTest, ValuesWorksForMaxLengthList) {
   VerifyGenerator(gen, expected_values);
 }
 
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Tests that the variadic Values() isn't limited to 50 parameters.
+TEST(ValuesTest, ValuesWorksForMoreThanFiftyValues) {
+  const ParamGenerator<int> gen = Values(
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+      21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37,
+      38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54,
+      55, 56, 57, 58, 59, 60);
+
+  const int expected_values[] = {
+      1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+      21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37,
+      38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54,
+      55, 56, 57, 58, 59, 60};
+  VerifyGenerator(gen, expected_values);
+}
+
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 // Edge case test. Tests that single-parameter Values() generates the sequence
 // with the single value.
 TEST(ValuesTest, ValuesWithSingleParameter) {
@@ -542,6 +573,27 @@ TEST(CombineTest, CombineWithMaxNumberOfParameters) {
   VerifyGenerator(gen, expected_values);
 }
 
+#  if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Tests that the variadic Combine() isn't limited to 10 parameters.
+TEST(CombineTest, CombineWithMoreThanTenParameters) {
+  const ParamGenerator<tuple<int, int, int, int, int, int, int, int, int,
+                             int, int, int> > gen =
+      Combine(Values(0, 1), Values(2), Values(3), Values(4), Values(5),
+              Values(6), Values(7), Values(8), Values(9), Values(10),
+              Values(11), Values(12, 13));
+
+  tuple<int, int, int, int, int, int, int, int, int, int, int, int>
+      expected_values[] = {
+        make_tuple(0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12),
+        make_tuple(0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 13),
+        make_tuple(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12),
+        make_tuple(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 13)};
+  VerifyGenerator(gen, expected_values);
+}
+
+#  endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 # endif  // GTEST_HAS_COMBINE
 
 // Tests that an generator produces correct sequence after being
@@ -40,6 +40,7 @@
 #include <string.h>
 #include <algorithm>
 #include <deque>
+#include <limits>
 #include <list>
 #include <map>
 #include <set>
@@ -652,6 +653,107 @@ TEST(PrintArrayTest, BigArray) {
             PrintArrayHelper(a));
 }
 
+// Returns what a stream with the given format prints for each element
+// of a, in the format of the universal printer.
+template <typename T, size_t N>
+string StreamEachElement(const T (&a)[N], ::std::ios_base::fmtflags flags,
+                         ::std::streamsize precision) {
+  ::std::stringstream ss;
+  ss.flags(flags);
+  ss.precision(precision);
+  ss << "{ ";
+  for (size_t i = 0; i != N; i++) {
+    if (i != 0)
+      ss << ", ";
+    ss << a[i];
+  }
+  ss << " }";
+  return ss.str();
+}
+
+// Returns what the universal printer prints for a to a stream with
+// the given format.
+template <typename T, size_t N>
+string PrintWithFormat(const T (&a)[N], ::std::ios_base::fmtflags flags,
+                       ::std::streamsize precision) {
+  ::std::stringstream ss;
+  ss.flags(flags);
+  ss.precision(precision);
+  UniversalPrint(a, &ss);
+  return ss.str();
+}
+
+// Verifies that an array of integers of type T prints the same as
+// printing each element with <<, with the default format and with hex.
+template <typename T>
+void TestIntegerArray() {
+  const T kMin = ::std::numeric_limits<T>::min();
+  const T kMax = ::std::numeric_limits<T>::max();
+  const T a[] = {
+    kMin, static_cast<T>(kMin + 1), 0, 1, static_cast<T>(-1), 9, 10, 99, 100,
+    static_cast<T>(12345), static_cast<T>(kMax - 1), kMax
+  };
+  const ::std::ios_base::fmtflags kDefaultFlags = ::std::stringstream().flags();
+  EXPECT_EQ(StreamEachElement(a, kDefaultFlags, 6),
+            PrintWithFormat(a, kDefaultFlags, 6));
+  EXPECT_EQ(StreamEachElement(a, ::std::ios_base::hex, 6),
+            PrintWithFormat(a, ::std::ios_base::hex, 6));
+  EXPECT_EQ(StreamEachElement(a, ::std::ios_base::showpos, 6),
+            PrintWithFormat(a, ::std::ios_base::showpos, 6));
+}
+
+TEST(PrintArrayTest, IntegerArraysPrintLikeTheirElements) {
+  TestIntegerArray<short>();  // NOLINT
+  TestIntegerArray<unsigned short>();  // NOLINT
+  TestIntegerArray<int>();
+  TestIntegerArray<unsigned int>();
+  TestIntegerArray<long>();  // NOLINT
+  TestIntegerArray<unsigned long>();  // NOLINT
+  TestIntegerArray<testing::internal::BiggestInt>();
+  TestIntegerArray<testing::internal::UInt64>();
+}
+
+// Verifies that an array of floating-point numbers of type T prints
+// the same as printing each element with <<, for various formats.
+template <typename T>
+void TestFloatingPointArray() {
+  const T kInfinity = ::std::numeric_limits<T>::infinity();
+  const T a[] = {
+    0, static_cast<T>(-0.0), static_cast<T>(1.5), static_cast<T>(-2.25),
+    static_cast<T>(1.0 / 3), static_cast<T>(3.14159265358979),
+    static_cast<T>(1e-30), static_cast<T>(1e30), static_cast<T>(123456789),
+    ::std::numeric_limits<T>::min(), ::std::numeric_limits<T>::max(),
+    ::std::numeric_limits<T>::denorm_min(), kInfinity, -kInfinity
+  };
+  const ::std::ios_base::fmtflags kDefaultFlags = ::std::stringstream().flags();
+  const ::std::streamsize kPrecisions[] = { 0, 1, 6, 9, 17, 20, 30 };
+  for (size_t i = 0; i != GTEST_ARRAY_SIZE_(kPrecisions); i++) {
+    EXPECT_EQ(StreamEachElement(a, kDefaultFlags, kPrecisions[i]),
+              PrintWithFormat(a, kDefaultFlags, kPrecisions[i]))
+        << "with precision " << kPrecisions[i];
+  }
+  EXPECT_EQ(StreamEachElement(a, ::std::ios_base::fixed, 3),
+            PrintWithFormat(a, ::std::ios_base::fixed, 3));
+  EXPECT_EQ(StreamEachElement(a, ::std::ios_base::uppercase, 6),
+            PrintWithFormat(a, ::std::ios_base::uppercase, 6));
+}
+
+TEST(PrintArrayTest, FloatingPointArraysPrintLikeTheirElements) {
+  TestFloatingPointArray<float>();
+  TestFloatingPointArray<double>();
+}
+
+// Tests that a long vector of numbers is cut short the same way as
+// other containers.
+TEST(PrintArrayTest, LongVectorOfNumbers) {
+  const vector<double> v(40, 0.5);
+  EXPECT_EQ("{ 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, "
+            "0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, "
+            "0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, ... }", Print(v));
+  EXPECT_EQ("{}", Print(vector<double>()));
+}
+
+// Tests printing ::string and ::std::string.
 // Tests printing ::string and ::std::string.
 
 #if GTEST_HAS_GLOBAL_STRING
@@ -686,6 +788,67 @@ TEST(PrintStringTest, StringAmbiguousHex) {
   EXPECT_EQ("\"!\\x5-!\"", Print(::std::string("!\x5-!")));
 }
 
+// Makes a pseudo-random string of characters from kStringChars, with
+// runs of plain characters of various lengths between the others.
+const char kStringChars[] = { 'a', '7', '"', '\\', '\n', '\x01', '\xFF' };
+
+template <typename StringType>
+StringType MakeStringToEscape(size_t len) {
+  StringType str;
+  unsigned int state = 12345;
+  while (str.size() < len) {
+    state = state * 1103515245 + 12345;
+    const size_t run = (state >> 16) % 40;
+    for (size_t i = 0; i != run; i++)
+      str += static_cast<typename StringType::value_type>('a' + i % 26);
+    state = state * 1103515245 + 12345;
+    str += static_cast<typename StringType::value_type>(
+        static_cast<unsigned char>(kStringChars[(state >> 16) % 7]));
+  }
+  return str;
+}
+
+// Escapes a string made by MakeStringToEscape() one character at a
+// time, the way the universal printer is expected to.
+template <typename StringType>
+string EscapeOneByOne(const StringType& str, const char* quote_begin) {
+  string escaped = quote_begin;
+  bool is_previous_hex = false;
+  for (size_t i = 0; i != str.size(); i++) {
+    const int c = static_cast<int>(str[i]) & 0xFF;
+    if (is_previous_hex && isxdigit(c))
+      escaped += string("\" ") + quote_begin;
+    is_previous_hex = false;
+    if (c == '"') {
+      escaped += "\\\"";
+    } else if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else if (c == 0x01) {
+      escaped += "\\x1";
+      is_previous_hex = true;
+    } else if (c == 0xFF) {
+      escaped += "\\xFF";
+      is_previous_hex = true;
+    } else {
+      escaped += static_cast<char>(c);
+    }
+  }
+  return escaped + "\"";
+}
+
+// Tests that long strings, which are escaped a run of characters at a
+// time, print the same as when escaped one character at a time.
+TEST(PrintStringTest, LongStringWithCharactersToEscape) {
+  for (size_t len = 0; len != 100; len++) {
+    const ::std::string str = MakeStringToEscape< ::std::string>(len);
+    EXPECT_EQ(EscapeOneByOne(str, "\""), Print(str)) << "of length " << len;
+  }
+  const ::std::string str = MakeStringToEscape< ::std::string>(10000);
+  EXPECT_EQ(EscapeOneByOne(str, "\""), Print(str));
+}
+
 // Tests printing ::wstring and ::std::wstring.
 
 #if GTEST_HAS_GLOBAL_WSTRING
@@ -718,6 +881,11 @@ TEST(PrintWideStringTest, StringAmbiguousHex) {
             Print(::std::wstring(L"NOM\x6" L"BANANA")));
   EXPECT_EQ("L\"!\\x5-!\"", Print(::std::wstring(L"!\x5-!")));
 }
+
+TEST(PrintWideStringTest, LongStringWithCharactersToEscape) {
+  const ::std::wstring str = MakeStringToEscape< ::std::wstring>(10000);
+  EXPECT_EQ(EscapeOneByOne(str, "L\""), Print(str));
+}
 #endif  // GTEST_HAS_STD_WSTRING
 
 // Tests printing types that support generic streaming (i.e. streaming
@@ -978,6 +1146,100 @@ TEST(PrintStlContainerTest, ConstIterator) {
   EXPECT_EQ("1-byte object <00>", Print(it));
 }
 
+// Tests that the print budget bounds what's printed for a value.
+
+// A stream buffer that can't tell its position, which is the case for
+// e.g. pipes.
+class UnseekableStringBuf : public ::std::streambuf {
+ public:
+  const string& str() const { return str_; }
+
+ protected:
+  virtual int_type overflow(int_type c) {
+    if (c != traits_type::eof())
+      str_ += static_cast<char>(c);
+    return c;
+  }
+
+ private:
+  string str_;
+};
+
+class PrintBudgetTest : public Test {
+ protected:
+  virtual void SetUp() { saved_budget_ = GTEST_FLAG(print_budget); }
+  virtual void TearDown() { GTEST_FLAG(print_budget) = saved_budget_; }
+
+ private:
+  internal::Int32 saved_budget_;
+};
+
+TEST_F(PrintBudgetTest, IsSharedByNestedContainers) {
+  GTEST_FLAG(print_budget) = 12;
+  vector<vector<int> > v(3);
+  for (int i = 0; i != 9; i++)
+    v[i / 3].push_back(i + 1);
+  EXPECT_EQ("{ { 1, 2, 3 }, ... (2 more) }", Print(v));
+
+  GTEST_FLAG(print_budget) = 18;
+  EXPECT_EQ("{ { 1, 2, 3 }, { 4, ... (2 more) }, ... (1 more) }", Print(v));
+}
+
+TEST_F(PrintBudgetTest, CountsAllOmittedArrayElements) {
+  GTEST_FLAG(print_budget) = 20;
+  int a[30];
+  for (int i = 0; i != 30; i++)
+    a[i] = i;
+  EXPECT_EQ("{ 0, 1, 2, 3, 4, 5, ... (24 more) }", Print(a));
+
+  GTEST_FLAG(print_budget) = 45;
+  EXPECT_EQ("{ 0, 1, 2, 3, 4, 5, 6, 7, ..., 22, 23, 24, 25, ... (4 more) }",
+            Print(a));
+}
+
+TEST_F(PrintBudgetTest, CutsLongStrings) {
+  GTEST_FLAG(print_budget) = 10;
+  EXPECT_EQ("\"aaaaaaaaa\" ... (91 more)", Print(::std::string(100, 'a')));
+  EXPECT_EQ("L\"aaaaaaaa\" ... (92 more)", Print(::std::wstring(100, L'a')));
+
+  vector< ::std::string> v(2, ::std::string(100, 'a'));
+  EXPECT_EQ("{ \"aaaaaaa\" ... (93 more), ... (1 more) }", Print(v));
+}
+
+TEST_F(PrintBudgetTest, LimitsElementsOnStreamsThatCannotTellPosition) {
+  GTEST_FLAG(print_budget) = 8;
+  vector<int> v;
+  for (int i = 1; i <= 10; i++)
+    v.push_back(i);
+  UnseekableStringBuf buf;
+  ::std::ostream os(&buf);
+  UniversalPrint(v, &os);
+  EXPECT_EQ("{ 1, 2, 3, 4, ... (6 more) }", buf.str());
+}
+
+TEST_F(PrintBudgetTest, StartsAfterWhatIsAlreadyInTheStream) {
+  GTEST_FLAG(print_budget) = 12;
+  const vector<int> v(10, 7);
+  ::std::stringstream ss;
+  ss << "Which is: ";
+  UniversalPrint(v, &ss);
+  EXPECT_EQ("Which is: { 7, 7, 7, 7, ... (6 more) }", ss.str());
+}
+
+TEST_F(PrintBudgetTest, ZeroMeansNoLimit) {
+  GTEST_FLAG(print_budget) = 0;
+  EXPECT_EQ(100002u, Print(::std::string(100000, 'a')).size());
+}
+
+TEST_F(PrintBudgetTest, DefaultBudgetBoundsHugeNestedContainers) {
+  GTEST_FLAG(print_budget) = kDefaultPrintBudget;
+  const vector<vector<vector<int> > > v(
+      32, vector<vector<int> >(32, vector<int>(32, 123456789)));
+  const string printed = Print(v);
+  EXPECT_LT(printed.size(), static_cast<size_t>(kDefaultPrintBudget) + 100);
+  EXPECT_PRED_FORMAT2(IsSubstring, "more) }, ... (", printed);
+}
+
 #if GTEST_HAS_TR1_TUPLE
 // Tests printing ::std::tr1::tuples.
 
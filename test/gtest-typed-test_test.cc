@@ -166,6 +166,42 @@ TYPED_TEST(NumericTest, DefaultIsZero) {
 
 }  // namespace library1
 
+# if GTEST_HAS_VARIADIC_TEMPLATES
+
+// Tests that a typed test case can have more types than the 50
+// supported by the pump-generated type lists, and that the tests are
+// registered in the order of the types.
+
+template <int N>
+struct Int {
+  static int value() { return N; }
+};
+
+template <typename T>
+class LongTypeListTest : public Test {
+};
+
+typedef Types<
+    Int<0>, Int<1>, Int<2>, Int<3>, Int<4>, Int<5>, Int<6>, Int<7>,
+    Int<8>, Int<9>, Int<10>, Int<11>, Int<12>, Int<13>, Int<14>,
+    Int<15>, Int<16>, Int<17>, Int<18>, Int<19>, Int<20>, Int<21>,
+    Int<22>, Int<23>, Int<24>, Int<25>, Int<26>, Int<27>, Int<28>,
+    Int<29>, Int<30>, Int<31>, Int<32>, Int<33>, Int<34>, Int<35>,
+    Int<36>, Int<37>, Int<38>, Int<39>, Int<40>, Int<41>, Int<42>,
+    Int<43>, Int<44>, Int<45>, Int<46>, Int<47>, Int<48>, Int<49>,
+    Int<50>, Int<51>, Int<52>, Int<53>, Int<54>, Int<55>, Int<56>,
+    Int<57>, Int<58>, Int<59> > SixtyTypes;
+TYPED_TEST_CASE(LongTypeListTest, SixtyTypes);
+
+TYPED_TEST(LongTypeListTest, IndexMatchesType) {
+  EXPECT_EQ("LongTypeListTest/" +
+                testing::internal::StreamableToString(TypeParam::value()),
+            std::string(testing::UnitTest::GetInstance()
+                            ->current_test_info()->test_case_name()));
+}
+
+# endif  // GTEST_HAS_VARIADIC_TEMPLATES
+
 #endif  // GTEST_HAS_TYPED_TEST
 
 // This #ifdef block tests type-parameterized tests.
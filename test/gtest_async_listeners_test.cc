@@ -0,0 +1,231 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This file verifies that with --gtest_async_listeners, the event
+// listeners receive all events, in order, on a reporting thread, and
+// that UnitTest::current_test_info() and current_test_case() return
+// the test and test case as of each event.
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using ::testing::InitGoogleTest;
+using ::testing::Message;
+using ::testing::TestCase;
+using ::testing::TestEventListener;
+using ::testing::TestInfo;
+using ::testing::TestPartResult;
+using ::testing::UnitTest;
+
+// The number of results ManyResultsAreForwardedInOrder reports; more
+// than the reporting thread's queue holds.
+const int kManyResults = 3000;
+
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+
+namespace {
+
+// Records the events it receives, and whether any of them were received on
+// the thread that runs the tests.
+class EventRecordingListener : public TestEventListener {
+ public:
+  EventRecordingListener(std::vector<std::string>* events,
+                         bool* on_main_thread)
+      : events_(events), on_main_thread_(on_main_thread),
+        main_thread_(pthread_self()), has_slept_(false) {}
+
+ protected:
+  virtual void OnTestProgramStart(const UnitTest& /*unit_test*/) {
+    Record("OnTestProgramStart");
+  }
+
+  virtual void OnTestIterationStart(const UnitTest& /*unit_test*/,
+                                    int iteration) {
+    Record((Message() << "OnTestIterationStart(" << iteration << ")")
+           .GetString());
+  }
+
+  virtual void OnEnvironmentsSetUpStart(const UnitTest& /*unit_test*/) {
+    Record("OnEnvironmentsSetUpStart");
+  }
+
+  virtual void OnEnvironmentsSetUpEnd(const UnitTest& /*unit_test*/) {
+    Record("OnEnvironmentsSetUpEnd");
+  }
+
+  virtual void OnTestCaseStart(const TestCase& test_case) {
+    Record(std::string("OnTestCaseStart ") + test_case.name() +
+           CurrentTest());
+  }
+
+  virtual void OnTestStart(const TestInfo& test_info) {
+    Record(std::string("OnTestStart ") + test_info.name() + CurrentTest());
+  }
+
+  // Sleeps on the first result, so that the tests fill up the queue and
+  // have to wait for the reporting thread.
+  virtual void OnTestPartResult(const TestPartResult& result) {
+    if (!has_slept_) {
+      ::testing::internal::SleepMilliseconds(100);
+      has_slept_ = true;
+    }
+    Record(std::string("OnTestPartResult ") + result.message() +
+           CurrentTest());
+  }
+
+  virtual void OnTestEnd(const TestInfo& test_info) {
+    Record(std::string("OnTestEnd ") + test_info.name() + CurrentTest());
+  }
+
+  virtual void OnTestCaseEnd(const TestCase& test_case) {
+    Record(std::string("OnTestCaseEnd ") + test_case.name() + CurrentTest());
+  }
+
+  virtual void OnEnvironmentsTearDownStart(const UnitTest& /*unit_test*/) {
+    Record("OnEnvironmentsTearDownStart");
+  }
+
+  virtual void OnEnvironmentsTearDownEnd(const UnitTest& /*unit_test*/) {
+    Record("OnEnvironmentsTearDownEnd");
+  }
+
+  virtual void OnTestIterationEnd(const UnitTest& /*unit_test*/,
+                                  int iteration) {
+    Record((Message() << "OnTestIterationEnd(" << iteration << ")")
+           .GetString());
+  }
+
+  virtual void OnTestProgramEnd(const UnitTest& /*unit_test*/) {
+    Record("OnTestProgramEnd");
+  }
+
+ private:
+  // Returns " in " followed by the names of the current test case and
+  // test, as far as there are any.
+  static std::string CurrentTest() {
+    const TestCase* const test_case =
+        UnitTest::GetInstance()->current_test_case();
+    const TestInfo* const test_info =
+        UnitTest::GetInstance()->current_test_info();
+    std::string name = " in ";
+    name += test_case == NULL ? "no test case" : test_case->name();
+    if (test_info != NULL)
+      name += std::string(".") + test_info->name();
+    return name;
+  }
+
+  void Record(const std::string& event) {
+    events_->push_back(event);
+    if (pthread_equal(pthread_self(), main_thread_))
+      *on_main_thread_ = true;
+  }
+
+  std::vector<std::string>* const events_;
+  bool* const on_main_thread_;
+  const pthread_t main_thread_;
+  bool has_slept_;
+};
+
+}  // namespace
+
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+
+TEST(AsyncListenersTest, Passes) {
+}
+
+TEST(AsyncListenersTest, ManyResultsAreForwardedInOrder) {
+  for (int i = 0; i < kManyResults; i++)
+    SUCCEED() << i;
+}
+
+int main(int argc, char **argv) {
+  InitGoogleTest(&argc, argv);
+
+#if GTEST_CAN_DELIVER_EVENTS_ASYNC_
+  std::vector<std::string> events;
+  bool on_main_thread = false;
+  UnitTest::GetInstance()->listeners().Append(
+      new EventRecordingListener(&events, &on_main_thread));
+
+  ::testing::GTEST_FLAG(async_listeners) = true;
+  ::testing::GTEST_FLAG(repeat) = 2;
+  if (RUN_ALL_TESTS() != 0)
+    return 1;
+
+  std::vector<std::string> expected;
+  expected.push_back("OnTestProgramStart");
+  for (int iteration = 0; iteration < 2; iteration++) {
+    expected.push_back((Message() << "OnTestIterationStart(" << iteration
+                        << ")").GetString());
+    expected.push_back("OnEnvironmentsSetUpStart");
+    expected.push_back("OnEnvironmentsSetUpEnd");
+    expected.push_back("OnTestCaseStart AsyncListenersTest"
+                       " in AsyncListenersTest");
+    expected.push_back("OnTestStart Passes in AsyncListenersTest.Passes");
+    expected.push_back("OnTestEnd Passes in AsyncListenersTest.Passes");
+    expected.push_back("OnTestStart ManyResultsAreForwardedInOrder"
+                       " in AsyncListenersTest.ManyResultsAreForwardedInOrder");
+    for (int i = 0; i < kManyResults; i++) {
+      expected.push_back((Message() << "OnTestPartResult Succeeded\n" << i
+                          << " in AsyncListenersTest."
+                          "ManyResultsAreForwardedInOrder").GetString());
+    }
+    expected.push_back("OnTestEnd ManyResultsAreForwardedInOrder"
+                       " in AsyncListenersTest.ManyResultsAreForwardedInOrder");
+    expected.push_back("OnTestCaseEnd AsyncListenersTest"
+                       " in AsyncListenersTest");
+    expected.push_back("OnEnvironmentsTearDownStart");
+    expected.push_back("OnEnvironmentsTearDownEnd");
+    expected.push_back((Message() << "OnTestIterationEnd(" << iteration
+                        << ")").GetString());
+  }
+  expected.push_back("OnTestProgramEnd");
+
+  if (events != expected) {
+    printf("The listener received these events:\n");
+    for (size_t i = 0; i < events.size(); i++)
+      printf("  %s\n", events[i].c_str());
+    return 1;
+  }
+  if (on_main_thread) {
+    printf("The listener received events on the thread running the tests.\n");
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+#else
+  return RUN_ALL_TESTS();
+#endif  // GTEST_CAN_DELIVER_EVENTS_ASYNC_
+}
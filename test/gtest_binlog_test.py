@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Unit test for the binary log of Google Test and its converter.
+
+Verifies that scripts/convert_binlog.py turns the binary log of a test
+program into the very XML report and console output the program writes
+itself, also when the log comes from several test shards or a death test
+child process exits through exit(), and that it rejects a corrupted log.
+"""
+
+import os
+import re
+import sys
+
+import gtest_test_utils
+
+
+GTEST_OUTPUT_FLAG = '--gtest_output'
+GTEST_PROGRAM_NAME = 'gtest_xml_output_unittest_'
+GTEST_PROGRAM_PATH = gtest_test_utils.GetTestExecutablePath(GTEST_PROGRAM_NAME)
+CONVERTER_PATH = os.path.join(gtest_test_utils.GetSourceDir(), os.pardir,
+                              'scripts', 'convert_binlog.py')
+NUM_SHARDS = 3
+
+# A program whose death tests call exit(), which runs the destructors of
+# the listeners in the child process.
+DEATH_TEST_PROGRAM_PATH = gtest_test_utils.GetTestExecutablePath(
+    'gtest_filter_unittest_')
+DEATH_TEST_FILTER_FLAG = '--gtest_filter=HasDeathTest.*'
+
+
+def Normalize(text):
+  """Removes the times and timestamps, which vary between runs."""
+
+  text = re.sub(r' time(stamp)?="[^"]*"', '', text)
+  return re.sub(r'\(\d+ ms', '(* ms', text)
+
+
+def ReadFile(path, mode='r'):
+  f = open(path, mode)
+  try:
+    return f.read()
+  finally:
+    f.close()
+
+
+class GTestBinlogTest(gtest_test_utils.TestCase):
+  """Tests the binary log and its converter."""
+
+  def testConvertsToXml(self):
+    self.assertEquals(Normalize(self._RunProgram('xml')),
+                      Normalize(self._Convert('xml', self._WriteLogs(1))))
+
+  def testConvertsToConsoleOutput(self):
+    output = self._RunProgram('console')
+    self.assertEquals(Normalize(output),
+                      Normalize(self._Convert('console', self._WriteLogs(1))))
+
+  def testMergesShards(self):
+    logs = self._WriteLogs(NUM_SHARDS)
+    self.assertEquals(Normalize(self._RunProgram('xml')),
+                      Normalize(self._Convert('xml', logs)))
+    self.assertEquals(Normalize(self._RunProgram('console')),
+                      Normalize(self._Convert('console', logs)))
+
+  def testWritesTheLogOnceWithDeathTests(self):
+    xml_path = os.path.join(gtest_test_utils.GetTempDir(),
+                            'gtest_filter_unittest_out.xml')
+    log_path = os.path.join(gtest_test_utils.GetTempDir(),
+                            'gtest_filter_unittest_.binlog')
+    for path in (xml_path, log_path):
+      output_format = os.path.splitext(path)[1][1:]
+      p = gtest_test_utils.Subprocess(
+          [DEATH_TEST_PROGRAM_PATH, DEATH_TEST_FILTER_FLAG,
+           '%s=%s:%s' % (GTEST_OUTPUT_FLAG, output_format, path)])
+      self.assert_(p.exited)
+      self.assertEquals(0, p.exit_code)
+    self.assertEquals(1, ReadFile(log_path, 'rb').count(b'GTBINLOG'))
+    self.assertEquals(Normalize(ReadFile(xml_path)),
+                      Normalize(self._Convert('xml', [log_path])))
+
+  def testRejectsASecondHeader(self):
+    log_path = self._WriteLogs(1)[0]
+    log = ReadFile(log_path, 'rb')
+    f = open(log_path, 'wb')
+    try:
+      f.write(log + log)
+    finally:
+      f.close()
+
+    p = gtest_test_utils.Subprocess(
+        [sys.executable, CONVERTER_PATH, log_path], capture_stderr=False)
+    self.assert_(p.exited)
+    self.assertEquals(1, p.exit_code)
+    self.assertEquals('', p.output)
+
+  def _RunProgram(self, output_format):
+    """Runs the test program; returns its XML report or console output."""
+
+    xml_path = os.path.join(gtest_test_utils.GetTempDir(),
+                            GTEST_PROGRAM_NAME + 'out.xml')
+    p = gtest_test_utils.Subprocess(
+        [GTEST_PROGRAM_PATH, '%s=xml:%s' % (GTEST_OUTPUT_FLAG, xml_path)],
+        capture_stderr=False)
+    self.assert_(p.exited)
+    self.assertEquals(1, p.exit_code)
+    if output_format == 'xml':
+      return ReadFile(xml_path)
+    return p.output
+
+  def _WriteLogs(self, num_shards):
+    """Runs the test program in shards; returns the paths of their logs."""
+
+    paths = []
+    for shard_index in range(num_shards):
+      path = os.path.join(gtest_test_utils.GetTempDir(),
+                          '%s%d.binlog' % (GTEST_PROGRAM_NAME, shard_index))
+      env = None
+      if num_shards > 1:
+        env = os.environ.copy()
+        env['GTEST_TOTAL_SHARDS'] = str(num_shards)
+        env['GTEST_SHARD_INDEX'] = str(shard_index)
+      p = gtest_test_utils.Subprocess(
+          [GTEST_PROGRAM_PATH, '%s=binlog:%s' % (GTEST_OUTPUT_FLAG, path)],
+          env=env)
+      self.assert_(p.exited)
+      paths.append(path)
+    return paths
+
+  def _Convert(self, output_format, paths):
+    """Converts the logs at paths; returns the result."""
+
+    p = gtest_test_utils.Subprocess(
+        [sys.executable, CONVERTER_PATH, '--format=%s' % output_format] +
+        paths, capture_stderr=False)
+    self.assert_(p.exited)
+    self.assertEquals(0, p.exit_code)
+    return p.output
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Verifies the console output of Google Test with --gtest_brief."""
+
+import os
+import subprocess
+
+import gtest_test_utils
+
+
+COMMAND = gtest_test_utils.GetTestExecutablePath('gtest_brief_test_')
+BRIEF_FLAG = '--gtest_brief'
+
+IS_POSIX = os.name == 'posix'
+if IS_POSIX:
+  import pty
+
+
+def RunOnTerminal(command):
+  """Runs the given command with a pseudo-terminal as its output.
+
+  Returns:
+    the text output, in which the terminal has turned '\n' into '\r\n'.
+  """
+
+  master, slave = pty.openpty()
+  child = subprocess.Popen(command, stdout=slave, stderr=slave)
+  os.close(slave)
+  output = ''
+  while True:
+    try:
+      data = os.read(master, 1024)
+    except OSError:  # Linux reports the end of the output as EIO.
+      break
+    if not data:
+      break
+    output += data
+  child.wait()
+  os.close(master)
+  return output
+
+
+class GTestBriefTest(gtest_test_utils.TestCase):
+  def testPrintsOnlyFailuresAndSummary(self):
+    p = gtest_test_utils.Subprocess([COMMAND, BRIEF_FLAG])
+    self.assertEquals(1, p.exit_code)
+    self.assert_('[ RUN      ]' not in p.output, p.output)
+    self.assert_('[       OK ]' not in p.output, p.output)
+    self.assert_('BriefTest.Passes' not in p.output, p.output)
+    self.assert_('Expected failure.' in p.output, p.output)
+    self.assert_('[  FAILED  ] BriefTest.Fails' in p.output, p.output)
+    self.assert_('[==========] 3 tests from 1 test case ran.' in p.output,
+                 p.output)
+    self.assert_('[  PASSED  ] 2 tests.' in p.output, p.output)
+
+    # There is no progress line when the output isn't a terminal.
+    self.assert_('\r' not in p.output, p.output)
+
+  def testPrintsEveryTestWithoutFlag(self):
+    p = gtest_test_utils.Subprocess([COMMAND])
+    self.assert_('[ RUN      ] BriefTest.Passes' in p.output, p.output)
+    self.assert_('[       OK ] BriefTest.Passes' in p.output, p.output)
+
+  if IS_POSIX:
+    def testRewritesProgressLineOnTerminal(self):
+      output = RunOnTerminal([COMMAND, BRIEF_FLAG, '--gtest_color=no'])
+      self.assert_('\r[ 1/3 ] 0 failed' in output, output)
+      self.assert_('\r[ 3/3 ] 1 failed' in output, output)
+      self.assert_('BriefTest.Passes' not in output, output)
+
+      # The progress line is erased before the summary is printed.
+      summary = output.index('[==========] 3 tests from 1 test case ran.')
+      self.assert_(output[:summary].endswith('\r'), output)
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
@@ -0,0 +1,107 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// This test verifies that it's possible to write tests by including
+// the gtest-core.h header file alone, and that doing so doesn't pull
+// in the headers for value-parameterized, typed, and death tests.
+
+#include "gtest/gtest-core.h"
+
+#include <string>
+#include <vector>
+
+#ifdef GTEST_INCLUDE_GTEST_GTEST_PARAM_TEST_H_
+# error "gtest-core.h must not include gtest-param-test.h."
+#endif
+#ifdef GTEST_INCLUDE_GTEST_GTEST_TYPED_TEST_H_
+# error "gtest-core.h must not include gtest-typed-test.h."
+#endif
+#ifdef GTEST_INCLUDE_GTEST_GTEST_DEATH_TEST_H_
+# error "gtest-core.h must not include gtest-death-test.h."
+#endif
+#ifdef GTEST_INCLUDE_GTEST_INTERNAL_GTEST_TYPE_UTIL_H_
+# error "gtest-core.h must not include gtest-type-util.h."
+#endif
+
+namespace {
+
+using testing::AssertionFailure;
+using testing::AssertionResult;
+using testing::AssertionSuccess;
+
+AssertionResult IsEven(int n) {
+  if (n % 2 == 0)
+    return AssertionSuccess();
+  return AssertionFailure() << n << " is odd";
+}
+
+TEST(CoreHeaderTest, BooleanAssertionsWork) {
+  EXPECT_TRUE(true);
+  EXPECT_FALSE(false);
+  ASSERT_TRUE(IsEven(2));
+  EXPECT_FALSE(IsEven(3));
+  EXPECT_PRED1(IsEven, 4);
+}
+
+TEST(CoreHeaderTest, ComparisonAssertionsWork) {
+  EXPECT_EQ(1, 1);
+  EXPECT_NE(1, 2);
+  EXPECT_LT(1, 2);
+  ASSERT_EQ(std::string("a"), "a");
+  EXPECT_STREQ("abc", "abc");
+  EXPECT_DOUBLE_EQ(1.0, 1.0);
+  EXPECT_NEAR(1.0, 1.05, 0.1);
+}
+
+// Tests that failure messages still print the operands, which requires
+// the universal printer.
+TEST(CoreHeaderTest, FailureMessagesPrintOperands) {
+  std::vector<int> v;
+  v.push_back(1);
+  v.push_back(2);
+  const AssertionResult result =
+      testing::internal::CmpHelperEQ("v", "w", v, std::vector<int>());
+  EXPECT_FALSE(result);
+  EXPECT_NE(std::string::npos,
+            std::string(result.message()).find("{ 1, 2 }"));
+}
+
+class CoreHeaderFixtureTest : public testing::Test {
+ protected:
+  CoreHeaderFixtureTest() : value_(0) {}
+  virtual void SetUp() { value_ = 42; }
+
+  int value_;
+};
+
+TEST_F(CoreHeaderFixtureTest, FixturesWork) {
+  EXPECT_EQ(42, value_);
+}
+
+}  // namespace
@@ -0,0 +1,105 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This file verifies that with --gtest_death_test_use_zygote, the child
+// processes of threadsafe-style death tests are forked from the zygote
+// rather than re-executed from the test program.
+
+#include "gtest/gtest.h"
+
+#if GTEST_CAN_FORK_TESTS_
+
+# include <signal.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <unistd.h>
+
+# include "gtest/gtest-spi.h"
+
+// Indicates that this translation unit is part of Google Test's
+// implementation.  It must come before gtest-internal-inl.h is
+// included, or there will be a compiler error.  This trick is to
+// prevent a user from accidentally including gtest-internal-inl.h in
+// his code.
+# define GTEST_IMPLEMENTATION_ 1
+# include "src/gtest-internal-inl.h"
+# undef GTEST_IMPLEMENTATION_
+
+using ::testing::ExitedWithCode;
+using ::testing::KilledBySignal;
+
+namespace {
+
+// The process ID of the test program, which the child processes of
+// death tests inherit from it through the zygote.
+pid_t g_test_program_pid = 0;
+
+TEST(DeathTestZygoteTest, ForksChildFromZygote) {
+  // A child forked from the zygote is the zygote's, not the test
+  // program's, and it didn't start main() over.
+  EXPECT_EXIT(_exit(getppid() != g_test_program_pid &&
+                    getpid() != g_test_program_pid ? 0 : 1),
+              ExitedWithCode(0), "");
+}
+
+TEST(DeathTestZygoteTest, CapturesStderr) {
+  EXPECT_DEATH({
+    fprintf(stderr, "Output of the death test.\n");
+    abort();
+  }, "Output of the death test\\.");
+}
+
+TEST(DeathTestZygoteTest, RunsSeveralDeathTestsInOneTest) {
+  EXPECT_EXIT(_exit(1), ExitedWithCode(1), "");
+  EXPECT_EXIT(_exit(2), ExitedWithCode(2), "");
+  EXPECT_EXIT(raise(SIGKILL), KilledBySignal(SIGKILL), "");
+}
+
+TEST(DeathTestZygoteTest, ReportsDeathTestThatLives) {
+  EXPECT_NONFATAL_FAILURE(EXPECT_DEATH(fprintf(stderr, "Alive.\n"), "Alive"),
+                          "failed to die");
+}
+
+}  // namespace
+
+#endif  // GTEST_CAN_FORK_TESTS_
+
+int main(int argc, char **argv) {
+#if GTEST_CAN_FORK_TESTS_
+  g_test_program_pid = getpid();
+  testing::GTEST_FLAG(death_test_style) = "threadsafe";
+  testing::GTEST_FLAG(death_test_use_zygote) = true;
+#endif  // GTEST_CAN_FORK_TESTS_
+
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -84,18 +84,24 @@ class GTestEnvVarTest(gtest_test_utils.TestCase):
   def testEnvVarAffectsFlag(self):
     """Tests that environment variable should affect the corresponding flag."""
 
+    TestFlag('async_listeners', '1', '0')
     TestFlag('break_on_failure', '1', '0')
+    TestFlag('brief', '1', '0')
     TestFlag('color', 'yes', 'auto')
     TestFlag('filter', 'FooTest.Bar', '*')
     TestFlag('output', 'xml:tmp/foo.xml', '')
+    TestFlag('incremental_output', '1', '0')
+    TestFlag('print_budget', '100', '65536')
     TestFlag('print_time', '0', '1')
     TestFlag('repeat', '999', '1')
+    TestFlag('stream_result_format', 'binary', 'text')
     TestFlag('throw_on_failure', '1', '0')
     TestFlag('death_test_style', 'threadsafe', 'fast')
     TestFlag('catch_exceptions', '0', '1')
 
     if IS_LINUX:
       TestFlag('death_test_use_fork', '1', '0')
+      TestFlag('death_test_use_zygote', '1', '0')
       TestFlag('stack_trace_depth', '0', '100')
 
 
@@ -51,11 +51,21 @@ TEST(GTestEnvVarTest, Dummy) {
 }
 
 void PrintFlag(const char* flag) {
+  if (strcmp(flag, "async_listeners") == 0) {
+    cout << GTEST_FLAG(async_listeners);
+    return;
+  }
+
   if (strcmp(flag, "break_on_failure") == 0) {
     cout << GTEST_FLAG(break_on_failure);
     return;
   }
 
+  if (strcmp(flag, "brief") == 0) {
+    cout << GTEST_FLAG(brief);
+    return;
+  }
+
   if (strcmp(flag, "catch_exceptions") == 0) {
     cout << GTEST_FLAG(catch_exceptions);
     return;
@@ -76,16 +86,31 @@ void PrintFlag(const char* flag) {
     return;
   }
 
+  if (strcmp(flag, "death_test_use_zygote") == 0) {
+    cout << GTEST_FLAG(death_test_use_zygote);
+    return;
+  }
+
   if (strcmp(flag, "filter") == 0) {
     cout << GTEST_FLAG(filter);
     return;
   }
 
+  if (strcmp(flag, "incremental_output") == 0) {
+    cout << GTEST_FLAG(incremental_output);
+    return;
+  }
+
   if (strcmp(flag, "output") == 0) {
     cout << GTEST_FLAG(output);
     return;
   }
 
+  if (strcmp(flag, "print_budget") == 0) {
+    cout << GTEST_FLAG(print_budget);
+    return;
+  }
+
   if (strcmp(flag, "print_time") == 0) {
     cout << GTEST_FLAG(print_time);
     return;
@@ -101,6 +126,11 @@ void PrintFlag(const char* flag) {
     return;
   }
 
+  if (strcmp(flag, "stream_result_format") == 0) {
+    cout << GTEST_FLAG(stream_result_format);
+    return;
+  }
+
   if (strcmp(flag, "throw_on_failure") == 0) {
     cout << GTEST_FLAG(throw_on_failure);
     return;
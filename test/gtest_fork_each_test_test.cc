@@ -0,0 +1,200 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// The Google C++ Testing Framework (Google Test)
+//
+// This file verifies that after Test::ForkEachTest(), each test of the
+// test case runs in a child process forked after SetUpTestCase(), and
+// that the results the child processes report become the tests' results.
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if GTEST_CAN_FORK_TESTS_
+# include <unistd.h>
+#endif  // GTEST_CAN_FORK_TESTS_
+
+using ::testing::InitGoogleTest;
+using ::testing::Test;
+using ::testing::TestCase;
+using ::testing::TestInfo;
+using ::testing::TestPartResult;
+using ::testing::TestResult;
+using ::testing::UnitTest;
+
+#if GTEST_CAN_FORK_TESTS_
+
+namespace {
+
+class ForkEachTestTest : public Test {
+ protected:
+  static void SetUpTestCase() {
+    set_up_count_++;
+    parent_pid_ = getpid();
+    data_ = 42;
+    ForkEachTest();
+  }
+
+  static void TearDownTestCase() {
+    data_after_tests_ = data_;
+  }
+
+  static int set_up_count_;
+  static pid_t parent_pid_;
+  static int data_;
+
+ public:
+  static int data_after_tests_;
+};
+
+int ForkEachTestTest::set_up_count_ = 0;
+pid_t ForkEachTestTest::parent_pid_ = 0;
+int ForkEachTestTest::data_ = 0;
+int ForkEachTestTest::data_after_tests_ = 0;
+
+TEST_F(ForkEachTestTest, RunsInChildProcess) {
+  EXPECT_NE(parent_pid_, getpid());
+  EXPECT_EQ(1, set_up_count_);
+}
+
+// Each of these tests changes the data after checking that it's as
+// SetUpTestCase() left it, so whichever runs second checks that it
+// doesn't see what the other one did.
+TEST_F(ForkEachTestTest, ChangesData) {
+  EXPECT_EQ(42, data_);
+  data_ = 0;
+}
+
+TEST_F(ForkEachTestTest, ChangesDataAgain) {
+  EXPECT_EQ(42, data_);
+  data_ = 1;
+}
+
+TEST_F(ForkEachTestTest, RecordsProperty) {
+  RecordProperty("key", "value");
+  SUCCEED() << "Expected success.";
+}
+
+TEST_F(ForkEachTestTest, Fails) {
+  ADD_FAILURE() << "Expected failure.";
+}
+
+TEST_F(ForkEachTestTest, ExitsEarly) {
+  _exit(3);
+}
+
+# if GTEST_HAS_DEATH_TEST
+TEST_F(ForkEachTestTest, RunsDeathTests) {
+  EXPECT_EXIT(_exit(1), ::testing::ExitedWithCode(1), "");
+}
+# endif  // GTEST_HAS_DEATH_TEST
+
+// Returns the result of the given test of ForkEachTestTest.
+const TestResult& ResultOf(const char* name) {
+  const TestCase* const test_case = UnitTest::GetInstance()->GetTestCase(0);
+  for (int i = 0; i < test_case->total_test_count(); i++) {
+    if (strcmp(test_case->GetTestInfo(i)->name(), name) == 0)
+      return *test_case->GetTestInfo(i)->result();
+  }
+  printf("Test ForkEachTestTest.%s not found.\n", name);
+  exit(1);
+}
+
+// Returns true iff the result has one test part result, of the given
+// type, whose message contains the given text.
+bool HasOnePartResult(const TestResult& result, TestPartResult::Type type,
+                      const char* text) {
+  return result.total_part_count() == 1 &&
+      result.GetTestPartResult(0).type() == type &&
+      strstr(result.GetTestPartResult(0).message(), text) != NULL;
+}
+
+}  // namespace
+
+#endif  // GTEST_CAN_FORK_TESTS_
+
+int main(int argc, char **argv) {
+  InitGoogleTest(&argc, argv);
+
+#if GTEST_CAN_FORK_TESTS_
+  if (RUN_ALL_TESTS() == 0) {
+    printf("The expected failures are missing.\n");
+    return 1;
+  }
+
+  const UnitTest& unit_test = *UnitTest::GetInstance();
+  if (unit_test.failed_test_count() != 2 ||
+      !ResultOf("Fails").Failed() || !ResultOf("ExitsEarly").Failed()) {
+    printf("Tests other than Fails and ExitsEarly failed.\n");
+    return 1;
+  }
+
+  // The parent process never sees the tests' changes.
+  if (ForkEachTestTest::data_after_tests_ != 42) {
+    printf("The tests changed the data in the test program's process.\n");
+    return 1;
+  }
+
+  const TestResult& fails = ResultOf("Fails");
+  if (!HasOnePartResult(fails, TestPartResult::kNonFatalFailure,
+                        "Expected failure.") ||
+      fails.GetTestPartResult(0).file_name() == NULL ||
+      strstr(fails.GetTestPartResult(0).file_name(),
+             "gtest_fork_each_test_test.cc") == NULL ||
+      fails.GetTestPartResult(0).line_number() <= 0) {
+    printf("The failure of Fails wasn't reported as it happened.\n");
+    return 1;
+  }
+
+  const TestResult& records_property = ResultOf("RecordsProperty");
+  if (!HasOnePartResult(records_property, TestPartResult::kSuccess,
+                        "Expected success.") ||
+      records_property.test_property_count() != 1 ||
+      strcmp(records_property.GetTestProperty(0).key(), "key") != 0 ||
+      strcmp(records_property.GetTestProperty(0).value(), "value") != 0) {
+    printf("The success and property of RecordsProperty are missing.\n");
+    return 1;
+  }
+
+  if (!HasOnePartResult(ResultOf("ExitsEarly"),
+                        TestPartResult::kFatalFailure,
+                        "Exited with exit status 3")) {
+    printf("The early exit of ExitsEarly wasn't reported.\n");
+    return 1;
+  }
+
+  printf("PASS\n");
+  return 0;
+#else
+  return RUN_ALL_TESTS();
+#endif  // GTEST_CAN_FORK_TESTS_
+}
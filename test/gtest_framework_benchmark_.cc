@@ -0,0 +1,462 @@
+// Copyright 2015, Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Measures the overhead of Google Test itself: registering, filtering
+// and running tests, evaluating assertions, and writing the XML report.
+// scripts/framework_benchmark.py runs this program once per measurement
+// and collects the results; it can also be run by hand:
+//
+//   gtest_framework_benchmark_ --benchmark=NAME [--n=N] [--threads=T]
+//
+// It prints a single line "NAME N VALUE ns/UNIT", where VALUE is the
+// average cost of one UNIT.  The benchmarks are:
+//
+//   register      registers N tests at run time.
+//   filter        registers N tests and applies a --gtest_filter to them.
+//   run           runs N empty tests (fixture construction, listener
+//                 dispatch, and timing).
+//   xml           writes the XML report for N passed tests.
+//   json          writes the JSON report for N passed tests.
+//   binlog        runs N empty tests while writing the binary log of
+//                 their events; compare with run.
+//   async         runs N empty tests with --gtest_async_listeners, until
+//                 the reporting thread has caught up; compare with run.
+//   expect_pass   evaluates N passing EXPECT_EQs.
+//   expect_fail   evaluates N failing EXPECT_EQs.
+//   scoped_trace  evaluates N passing EXPECT_EQs, each in a SCOPED_TRACE.
+//   contention    evaluates N failing EXPECT_EQs spread over T threads.
+//   death_fast    runs fast-style death tests in a process that has N MB
+//                 of memory in use.
+//   death_exec    runs threadsafe-style death tests, which re-execute
+//                 the program, in a process that has N MB in use.
+//   death_zygote  the same, with --gtest_death_test_use_zygote.
+//   wide_ascii    converts an N-character wide string of ASCII text to
+//                 UTF-8, as failure messages about wide strings do.
+//   wide_cjk      the same for CJK text with a space every 5 characters.
+//
+// The death test benchmarks show how the cost of creating the child
+// process grows with the size of the test program.
+//
+// The default result printer is removed, so the numbers don't include
+// the cost of writing to the terminal.
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if GTEST_OS_WINDOWS
+# include <windows.h>  // NOLINT
+#else
+# include <sys/time.h>  // NOLINT
+# include <unistd.h>  // NOLINT
+#endif  // GTEST_OS_WINDOWS
+
+// We must define this macro in order to #include
+// gtest-internal-inl.h.  This is how Google Test prevents a user from
+// accidentally depending on its internal implementation.
+#define GTEST_IMPLEMENTATION_ 1
+#include "src/gtest-internal-inl.h"
+#undef GTEST_IMPLEMENTATION_
+
+namespace testing {
+namespace {
+
+using internal::GetUnitTestImpl;
+using internal::StreamableToString;
+using internal::UnitTestImpl;
+
+// The command line of the benchmark.
+std::string g_benchmark;
+int g_n = 10000;
+int g_threads = 4;
+
+// The number of tests registered per test case.
+const int kTestsPerTestCase = 100;
+
+// A wall-clock stopwatch with sub-millisecond resolution.
+class Stopwatch {
+ public:
+  Stopwatch() : start_(Now()) {}
+
+  // Restarts the stopwatch.
+  void Reset() { start_ = Now(); }
+
+  // Returns the nanoseconds elapsed since the last reset.
+  double ElapsedNanos() const { return Now() - start_; }
+
+ private:
+  static double Now() {
+#if GTEST_OS_WINDOWS
+    LARGE_INTEGER frequency, counter;
+    ::QueryPerformanceFrequency(&frequency);
+    ::QueryPerformanceCounter(&counter);
+    return 1e9 * static_cast<double>(counter.QuadPart) /
+        static_cast<double>(frequency.QuadPart);
+#else
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return 1e9 * now.tv_sec + 1e3 * now.tv_usec;
+#endif  // GTEST_OS_WINDOWS
+  }
+
+  double start_;
+};
+
+// Prints the result of the benchmark.
+void Report(double elapsed_nanos, int count, const char* unit) {
+  printf("%s %d %.1f ns/%s\n", g_benchmark.c_str(), g_n,
+         elapsed_nanos / count, unit);
+  fflush(stdout);
+}
+
+class EmptyTest : public Test {
+ private:
+  virtual void TestBody() {}
+};
+
+// Registers n empty tests.  The names are formatted up front so that
+// only the registration is timed.
+void RegisterEmptyTests(int n, Stopwatch* stopwatch) {
+  std::vector<std::string> test_case_names;
+  std::vector<std::string> test_names;
+  for (int i = 0; i < n; i++) {
+    test_case_names.push_back(
+        "BenchmarkCase" + StreamableToString(i / kTestsPerTestCase));
+    test_names.push_back("Test" + StreamableToString(i));
+  }
+
+  stopwatch->Reset();
+  for (int i = 0; i < n; i++) {
+    internal::MakeAndRegisterTestInfo(
+        test_case_names[i].c_str(), test_names[i].c_str(), NULL, NULL,
+        internal::GetTestTypeId(), Test::SetUpTestCase,
+        Test::TearDownTestCase, new internal::TestFactoryImpl<EmptyTest>);
+  }
+}
+
+// Times the iterations of RUN_ALL_TESTS().  Because the end events are
+// delivered in the reverse order of listener registration, this
+// listener sees the end of an iteration after any listener registered
+// after it, e.g. the XML printer, has handled it.
+class TimingListener : public EmptyTestEventListener {
+ public:
+  TimingListener() : run_nanos_(0), report_nanos_(0) {}
+
+  double run_nanos() const { return run_nanos_; }
+  double report_nanos() const { return report_nanos_; }
+
+ private:
+  virtual void OnTestIterationStart(const UnitTest& /* unit_test */,
+                                    int /* iteration */) {
+    stopwatch_.Reset();
+  }
+
+  virtual void OnEnvironmentsTearDownEnd(const UnitTest& /* unit_test */) {
+    run_nanos_ = stopwatch_.ElapsedNanos();
+    stopwatch_.Reset();
+  }
+
+  virtual void OnTestIterationEnd(const UnitTest& /* unit_test */,
+                                  int /* iteration */) {
+    report_nanos_ = stopwatch_.ElapsedNanos();
+  }
+
+  Stopwatch stopwatch_;
+  double run_nanos_;
+  double report_nanos_;
+};
+
+// Runs the registered tests and reports how long they take.  Returns
+// the value of RUN_ALL_TESTS().
+int RunRegisteredTests() {
+  TimingListener* const listener = new TimingListener;
+  UnitTest::GetInstance()->listeners().Append(listener);
+
+  // Sets up the report printer after the timing listener.
+  const bool writes_report = g_benchmark == "xml" || g_benchmark == "json" ||
+      g_benchmark == "binlog";
+  const std::string report_file = "gtest_framework_benchmark." + g_benchmark;
+  if (writes_report) {
+    GTEST_FLAG(output) = g_benchmark + ":" + report_file;
+    GetUnitTestImpl()->ConfigureXmlOutput();
+  }
+
+  GTEST_FLAG(async_listeners) = g_benchmark == "async";
+
+  const int result = RUN_ALL_TESTS();
+  if (g_benchmark == "async") {
+    // The listener measures on the reporting thread, which may finish
+    // forwarding the tests' events after they have run.
+    Report(listener->run_nanos() + listener->report_nanos(), g_n, "test");
+  } else if (g_benchmark == "binlog") {
+    // The log is written as the tests run.
+    remove(report_file.c_str());
+    Report(listener->run_nanos() + listener->report_nanos(), g_n, "test");
+  } else if (writes_report) {
+    remove(report_file.c_str());
+    Report(listener->report_nanos(), g_n, "test");
+  } else {
+    Report(listener->run_nanos(), g_n, "test");
+  }
+  return result;
+}
+
+// Runs body(i) for every i in [0, n) and reports the time per call.
+void TimeLoop(void (*body)(int), int n, const char* unit) {
+  Stopwatch stopwatch;
+  for (int i = 0; i < n; i++)
+    body(i);
+  Report(stopwatch.ElapsedNanos(), n, unit);
+}
+
+// A value the compiler cannot constant-fold.
+volatile int g_zero = 0;
+
+void PassingExpectEq(int i) {
+  EXPECT_EQ(i, i + g_zero);
+}
+
+void FailingExpectEq(int i) {
+  EXPECT_EQ(i, i + 1 + g_zero);
+}
+
+void ScopedTraceAndExpectEq(int i) {
+  SCOPED_TRACE("trace");
+  EXPECT_EQ(i, i + g_zero);
+}
+
+// The benchmarks that run inside a test.  They are skipped unless they
+// are selected with --benchmark.
+
+TEST(FrameworkBenchmark, ExpectPass) {
+  TimeLoop(&PassingExpectEq, g_n, "assertion");
+}
+
+TEST(FrameworkBenchmark, ExpectFail) {
+  TimeLoop(&FailingExpectEq, g_n, "assertion");
+}
+
+TEST(FrameworkBenchmark, ScopedTrace) {
+  TimeLoop(&ScopedTraceAndExpectEq, g_n, "assertion");
+}
+
+#if GTEST_IS_THREADSAFE
+
+using internal::Notification;
+using internal::ThreadWithParam;
+using internal::scoped_ptr;
+
+void ManyFailingExpectEqs(int count) {
+  for (int i = 0; i < count; i++)
+    FailingExpectEq(i);
+}
+
+TEST(FrameworkBenchmark, Contention) {
+  const int per_thread = g_n / g_threads;
+  std::vector<ThreadWithParam<int>*> threads;
+  Notification threads_can_start;
+  for (int i = 0; i < g_threads; i++) {
+    threads.push_back(new ThreadWithParam<int>(
+        &ManyFailingExpectEqs, per_thread, &threads_can_start));
+  }
+
+  Stopwatch stopwatch;
+  threads_can_start.Notify();
+  for (int i = 0; i < g_threads; i++) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+  Report(stopwatch.ElapsedNanos(), per_thread * g_threads, "assertion");
+}
+
+#endif  // GTEST_IS_THREADSAFE
+
+#if GTEST_HAS_DEATH_TEST
+
+// The number of death tests a death test benchmark runs.
+const int kDeathTestsPerRun = 20;
+
+TEST(FrameworkBenchmark, DeathTest) {
+  // Only the test program holds the memory; a child process that
+  // re-executes it doesn't allocate it again.
+  std::vector<char> memory;
+  if (!internal::InDeathTestChild())
+    memory.resize(static_cast<size_t>(g_n) << 20, 1);
+
+  Stopwatch stopwatch;
+  for (int i = 0; i < kDeathTestsPerRun; i++)
+    EXPECT_EXIT(_exit(0), ExitedWithCode(0), "");
+  Report(stopwatch.ElapsedNanos(), kDeathTestsPerRun, "death_test");
+}
+
+#endif  // GTEST_HAS_DEATH_TEST
+
+// The number of conversions a wide string benchmark times.
+const int kWideStringConversions = 100;
+
+// Where the conversions store their results, so that they aren't
+// optimized away.
+volatile size_t g_utf8_length = 0;
+
+// Converts a g_n-character wide string to UTF-8, repeatedly, and reports
+// the time per character.  Every period-th character is a space, and
+// the others are text[i % text_size].
+void TimeWideStringConversion(const wchar_t* text, int text_size,
+                              int period) {
+  std::vector<wchar_t> wide(static_cast<size_t>(g_n) + 1, L'\0');
+  for (int i = 0; i < g_n; i++)
+    wide[i] = (i + 1) % period == 0 ? L' ' : text[i % text_size];
+
+  Stopwatch stopwatch;
+  for (int i = 0; i < kWideStringConversions; i++)
+    g_utf8_length = internal::String::ShowWideCString(&wide[0]).length();
+  Report(stopwatch.ElapsedNanos(), kWideStringConversions * g_n, "char");
+}
+
+// Parses a --NAME=VALUE argument.  Returns true and sets *value if arg
+// has that form.
+bool ParseArgument(const char* arg, const char* name, std::string* value) {
+  const std::string prefix = std::string("--") + name + "=";
+  if (strncmp(arg, prefix.c_str(), prefix.length()) != 0)
+    return false;
+  *value = arg + prefix.length();
+  return true;
+}
+
+int RunBenchmark() {
+  delete UnitTest::GetInstance()->listeners().Release(
+      UnitTest::GetInstance()->listeners().default_result_printer());
+
+  if (g_benchmark == "register") {
+    Stopwatch stopwatch;
+    RegisterEmptyTests(g_n, &stopwatch);
+    Report(stopwatch.ElapsedNanos(), g_n, "test");
+    return 0;
+  }
+
+  if (g_benchmark == "filter") {
+    Stopwatch stopwatch;
+    RegisterEmptyTests(g_n, &stopwatch);
+    GTEST_FLAG(filter) = "BenchmarkCase1*.*:BenchmarkCase*.Test*7-*.Test1*";
+    stopwatch.Reset();
+    GetUnitTestImpl()->FilterTests(UnitTestImpl::IGNORE_SHARDING_PROTOCOL);
+    Report(stopwatch.ElapsedNanos(), g_n, "test");
+    return 0;
+  }
+
+  if (g_benchmark == "run" || g_benchmark == "xml" || g_benchmark == "json" ||
+      g_benchmark == "binlog" || g_benchmark == "async") {
+    Stopwatch stopwatch;
+    RegisterEmptyTests(g_n, &stopwatch);
+    GTEST_FLAG(filter) = "BenchmarkCase*.*";
+    return RunRegisteredTests();
+  }
+
+  if (g_benchmark == "wide_ascii") {
+    TimeWideStringConversion(L"abcdefghijklmnopqrstuvwxyz", 26, 80);
+    return 0;
+  }
+
+  if (g_benchmark == "wide_cjk") {
+    // Some common Chinese characters.
+    TimeWideStringConversion(L"\x4E2D\x6587\x5B57\x7B26\x4E32", 5, 6);
+    return 0;
+  }
+
+#if GTEST_HAS_DEATH_TEST
+  GTEST_FLAG(death_test_style) =
+      g_benchmark == "death_fast" ? "fast" : "threadsafe";
+#endif  // GTEST_HAS_DEATH_TEST
+
+  // Maps the benchmarks that run inside a test to the test.
+  static const struct {
+    const char* benchmark;
+    const char* test;
+    bool fails;
+  } kTestBenchmarks[] = {
+    { "expect_pass", "ExpectPass", false },
+    { "expect_fail", "ExpectFail", true },
+    { "scoped_trace", "ScopedTrace", false },
+    { "contention", "Contention", true },
+#if GTEST_HAS_DEATH_TEST
+    { "death_fast", "DeathTest", false },
+    { "death_exec", "DeathTest", false },
+    { "death_zygote", "DeathTest", false },
+#endif  // GTEST_HAS_DEATH_TEST
+  };
+  for (size_t i = 0; i < GTEST_ARRAY_SIZE_(kTestBenchmarks); i++) {
+    if (g_benchmark == kTestBenchmarks[i].benchmark) {
+      GTEST_FLAG(filter) =
+          std::string("FrameworkBenchmark.") + kTestBenchmarks[i].test;
+      const int result = RUN_ALL_TESTS();
+      return kTestBenchmarks[i].fails ? 0 : result;
+    }
+  }
+
+  fprintf(stderr, "Unknown benchmark: %s\n", g_benchmark.c_str());
+  return 1;
+}
+
+}  // namespace
+}  // namespace testing
+
+int main(int argc, char** argv) {
+  // The zygote must be started by InitGoogleTest().
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--benchmark=death_zygote") == 0)
+      testing::GTEST_FLAG(death_test_use_zygote) = true;
+  }
+
+  testing::InitGoogleTest(&argc, argv);
+
+  for (int i = 1; i < argc; i++) {
+    std::string value;
+    if (testing::ParseArgument(argv[i], "benchmark", &value)) {
+      testing::g_benchmark = value;
+    } else if (testing::ParseArgument(argv[i], "n", &value)) {
+      testing::g_n = atoi(value.c_str());
+    } else if (testing::ParseArgument(argv[i], "threads", &value)) {
+      testing::g_threads = atoi(value.c_str());
+    } else {
+      fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (testing::g_benchmark.empty() || testing::g_n <= 0 ||
+      testing::g_threads <= 0) {
+    fprintf(stderr, "Usage: %s --benchmark=NAME [--n=N] [--threads=T]\n",
+            argv[0]);
+    return 1;
+  }
+
+  return testing::RunBenchmark();
+}
@@ -50,7 +50,10 @@ IS_WINDOWS = os.name == 'nt'
 PROGRAM_PATH = gtest_test_utils.GetTestExecutablePath('gtest_help_test_')
 FLAG_PREFIX = '--gtest_'
 DEATH_TEST_STYLE_FLAG = FLAG_PREFIX + 'death_test_style'
+DEATH_TEST_USE_ZYGOTE_FLAG = FLAG_PREFIX + 'death_test_use_zygote'
 STREAM_RESULT_TO_FLAG = FLAG_PREFIX + 'stream_result_to'
+STREAM_RESULT_FORMAT_FLAG = FLAG_PREFIX + 'stream_result_format'
+ASYNC_LISTENERS_FLAG = FLAG_PREFIX + 'async_listeners'
 UNKNOWN_FLAG = FLAG_PREFIX + 'unknown_flag_for_testing'
 LIST_TESTS_FLAG = FLAG_PREFIX + 'list_tests'
 INCORRECT_FLAG_VARIANTS = [re.sub('^--', '-', LIST_TESTS_FLAG),
@@ -71,7 +74,10 @@ HELP_REGEX = re.compile(
     FLAG_PREFIX + r'random_seed=.*' +
     FLAG_PREFIX + r'color=.*' +
     FLAG_PREFIX + r'print_time.*' +
+    FLAG_PREFIX + r'brief.*' +
+    FLAG_PREFIX + r'print_budget=.*' +
     FLAG_PREFIX + r'output=.*' +
+    FLAG_PREFIX + r'incremental_output.*' +
     FLAG_PREFIX + r'break_on_failure.*' +
     FLAG_PREFIX + r'throw_on_failure.*' +
     FLAG_PREFIX + r'catch_exceptions=0.*',
@@ -114,13 +120,22 @@ class GTestHelpTest(gtest_test_utils.TestCase):
 
     if IS_LINUX:
       self.assert_(STREAM_RESULT_TO_FLAG in output, output)
+      self.assert_(STREAM_RESULT_FORMAT_FLAG in output, output)
     else:
       self.assert_(STREAM_RESULT_TO_FLAG not in output, output)
+      self.assert_(STREAM_RESULT_FORMAT_FLAG not in output, output)
+
+    if IS_WINDOWS:
+      self.assert_(ASYNC_LISTENERS_FLAG not in output, output)
+    else:
+      self.assert_(ASYNC_LISTENERS_FLAG in output, output)
 
     if SUPPORTS_DEATH_TESTS and not IS_WINDOWS:
       self.assert_(DEATH_TEST_STYLE_FLAG in output, output)
+      self.assert_(DEATH_TEST_USE_ZYGOTE_FLAG in output, output)
     else:
       self.assert_(DEATH_TEST_STYLE_FLAG not in output, output)
+      self.assert_(DEATH_TEST_USE_ZYGOTE_FLAG not in output, output)
 
   def TestNonHelpFlag(self, flag):
     """Verifies correct behavior when no help flag is specified.
@@ -0,0 +1,279 @@
+#!/usr/bin/env python
+#
+# Copyright 2015, Google Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above
+# copyright notice, this list of conditions and the following disclaimer
+# in the documentation and/or other materials provided with the
+# distribution.
+#     * Neither the name of Google Inc. nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Unit test for the JSON output of Google Test."""
+
+import json
+import os
+import re
+
+import gtest_test_utils
+
+
+GTEST_FILTER_FLAG = '--gtest_filter'
+GTEST_INCREMENTAL_OUTPUT_FLAG = '--gtest_incremental_output'
+GTEST_OUTPUT_FLAG = '--gtest_output'
+GTEST_DEFAULT_OUTPUT_FILE = 'test_detail.json'
+GTEST_PROGRAM_NAME = 'gtest_xml_output_unittest_'
+
+SUPPORTS_TYPED_TESTS = 'TypedTest' in gtest_test_utils.Subprocess(
+    [gtest_test_utils.GetTestExecutablePath(GTEST_PROGRAM_NAME),
+     '--gtest_list_tests'], capture_stderr=False).output
+
+
+def Test(name, classname, status='RUN', failures=None, **extra):
+  """Returns the expected JSON object for a test."""
+
+  test = {'name': name, 'status': status, 'time': '*',
+          'classname': classname}
+  if failures:
+    test['failures'] = [{'failure': 'gtest_xml_output_unittest_.cc:*\n' + f,
+                         'type': ''} for f in failures]
+  test.update(extra)
+  return test
+
+
+def TestCase(name, tests, failures=0, disabled=0, **extra):
+  """Returns the expected JSON object for a test case."""
+
+  test_case = {'name': name, 'tests': len(tests), 'failures': failures,
+               'disabled': disabled, 'errors': 0, 'time': '*',
+               'testsuite': tests}
+  test_case.update(extra)
+  return test_case
+
+
+EXPECTED_TEST_CASES = [
+    TestCase('SuccessfulTest', [Test('Succeeds', 'SuccessfulTest')]),
+    TestCase('FailedTest', [
+        Test('Fails', 'FailedTest',
+             failures=['Value of: 2\nExpected: 1'])], failures=1),
+    TestCase('DisabledTest', [
+        Test('DISABLED_test_not_run', 'DisabledTest', status='NOTRUN')],
+             disabled=1),
+    TestCase('MixedResultTest', [
+        Test('Succeeds', 'MixedResultTest'),
+        Test('Fails', 'MixedResultTest',
+             failures=['Value of: 2\nExpected: 1',
+                       'Value of: 3\nExpected: 2']),
+        Test('DISABLED_test', 'MixedResultTest', status='NOTRUN')],
+             failures=1, disabled=1),
+    TestCase('XmlQuotingTest', [
+        Test('OutputsCData', 'XmlQuotingTest',
+             failures=['Failed\nXML output: <?xml encoding="utf-8">'
+                       '<top><![CDATA[cdata text]]></top>'])], failures=1),
+    TestCase('InvalidCharactersTest', [
+        Test('InvalidCharactersInMessage', 'InvalidCharactersTest',
+             failures=['Failed\nInvalid characters in brackets '
+                       '[\x01\x02]'])], failures=1),
+    TestCase('PropertyRecordingTest', [
+        Test('OneProperty', 'PropertyRecordingTest', key_1='1'),
+        Test('IntValuedProperty', 'PropertyRecordingTest', key_int='1'),
+        Test('ThreeProperties', 'PropertyRecordingTest',
+             key_1='1', key_2='2', key_3='3'),
+        Test('TwoValuesForOneKeyUsesLastValue', 'PropertyRecordingTest',
+             key_1='2')],
+             SetUpTestCase='yes', TearDownTestCase='aye'),
+    TestCase('NoFixtureTest', [
+        Test('RecordProperty', 'NoFixtureTest', key='1'),
+        Test('ExternalUtilityThatCallsRecordIntValuedProperty',
+             'NoFixtureTest', key_for_utility_int='1'),
+        Test('ExternalUtilityThatCallsRecordStringValuedProperty',
+             'NoFixtureTest', key_for_utility_string='1')]),
+    TestCase('TypedTest/0', [
+        Test('HasTypeParamAttribute', 'TypedTest/0', type_param='*')]),
+    TestCase('TypedTest/1', [
+        Test('HasTypeParamAttribute', 'TypedTest/1', type_param='*')]),
+    TestCase('Single/TypeParameterizedTestCase/0', [
+        Test('HasTypeParamAttribute', 'Single/TypeParameterizedTestCase/0',
+             type_param='*')]),
+    TestCase('Single/TypeParameterizedTestCase/1', [
+        Test('HasTypeParamAttribute', 'Single/TypeParameterizedTestCase/1',
+             type_param='*')]),
+    TestCase('Single/ValueParamTest', [
+        Test('HasValueParamAttribute/0', 'Single/ValueParamTest',
+             value_param='33'),
+        Test('HasValueParamAttribute/1', 'Single/ValueParamTest',
+             value_param='42'),
+        Test('AnotherTestThatHasValueParamAttribute/0',
+             'Single/ValueParamTest', value_param='33'),
+        Test('AnotherTestThatHasValueParamAttribute/1',
+             'Single/ValueParamTest', value_param='42')]),
+    ]
+
+EXPECTED_NON_EMPTY_JSON = {
+    'tests': 23, 'failures': 4, 'disabled': 2, 'errors': 0,
+    'timestamp': '*', 'time': '*', 'ad_hoc_property': '42',
+    'name': 'AllTests', 'testsuites': EXPECTED_TEST_CASES}
+
+EXPECTED_FILTERED_TEST_JSON = {
+    'tests': 1, 'failures': 0, 'disabled': 0, 'errors': 0,
+    'timestamp': '*', 'time': '*', 'ad_hoc_property': '42',
+    'name': 'AllTests', 'testsuites': EXPECTED_TEST_CASES[:1]}
+
+EXPECTED_EMPTY_JSON = {
+    'tests': 0, 'failures': 0, 'disabled': 0, 'errors': 0,
+    'timestamp': '*', 'time': '*', 'name': 'AllTests', 'testsuites': []}
+
+
+def Normalize(node):
+  """Replaces the parts of a JSON report that vary between runs with '*'.
+
+  These are the times, the timestamp, the type parameters, whose names
+  depend on the compiler, and the file paths and line numbers of the
+  failures.
+  """
+
+  if isinstance(node, list):
+    return [Normalize(element) for element in node]
+  if not isinstance(node, dict):
+    return node
+
+  normalized = {}
+  for key, value in node.items():
+    if key in ('time', 'timestamp', 'type_param'):
+      value = '*'
+    elif key == 'failure':
+      value = re.sub(r'^(?:.*[/\\])?([^/\\\n]*:)\d+\n', r'\1*\n', value)
+    normalized[key] = Normalize(value)
+  return normalized
+
+
+class GTestJsonOutputUnitTest(gtest_test_utils.TestCase):
+  """Unit test for Google Test's JSON output functionality."""
+
+  # This test currently breaks on platforms that do not support typed and
+  # type-parameterized tests, so we don't run it under them.
+  if SUPPORTS_TYPED_TESTS:
+    def testNonEmptyJsonOutput(self):
+      """Verifies the JSON output of a program with all kinds of tests."""
+
+      self._TestJsonOutput(GTEST_PROGRAM_NAME, EXPECTED_NON_EMPTY_JSON, 1)
+
+    def testIncrementalJsonOutput(self):
+      """Verifies that the incremental report is complete once the tests are
+      done, and that it matches the one written at the end.
+      """
+
+      self._TestJsonOutput(GTEST_PROGRAM_NAME, EXPECTED_NON_EMPTY_JSON, 1,
+                           extra_args=[GTEST_INCREMENTAL_OUTPUT_FLAG])
+
+  def testEmptyJsonOutput(self):
+    """Verifies the JSON output of a Google Test binary without tests."""
+
+    self._TestJsonOutput('gtest_no_test_unittest', EXPECTED_EMPTY_JSON, 0)
+
+  def testFilteredTestJsonOutput(self):
+    """Verifies that tests filtered out don't show up in the JSON output."""
+
+    self._TestJsonOutput(GTEST_PROGRAM_NAME, EXPECTED_FILTERED_TEST_JSON, 0,
+                         extra_args=['%s=SuccessfulTest.*' % GTEST_FILTER_FLAG])
+
+  def testIncrementalJsonOutputSurvivesCrash(self):
+    """Verifies that the tests that finished before the program crashed are
+    in the incremental JSON report.
+    """
+
+    json_path = os.path.join(gtest_test_utils.GetTempDir(),
+                             GTEST_PROGRAM_NAME + 'out.json')
+    if os.path.isfile(json_path):
+      os.remove(json_path)
+
+    command = [gtest_test_utils.GetTestExecutablePath(GTEST_PROGRAM_NAME),
+               '%s=json:%s' % (GTEST_OUTPUT_FLAG, json_path),
+               GTEST_INCREMENTAL_OUTPUT_FLAG,
+               '%s=SuccessfulTest.*:FailedTest.*' % GTEST_FILTER_FLAG,
+               '--crash_in_failed_test']
+    p = gtest_test_utils.Subprocess(command)
+    self.assert_(not p.exited or p.exit_code != 0)
+
+    # The partial report ends in the "testsuite" array of FailedTest,
+    # which is still empty; closing the open arrays and objects makes it
+    # a complete document.
+    json_file = open(json_path)
+    try:
+      partial = json_file.read()
+    finally:
+      json_file.close()
+    actual = json.loads(partial + '\n      ]\n    }\n  ]\n}')
+    self.assertEquals(
+        {'timestamp': '*', 'name': 'AllTests',
+         'testsuites': [
+             {'name': 'SuccessfulTest',
+              'testsuite': EXPECTED_TEST_CASES[0]['testsuite']},
+             {'name': 'FailedTest', 'testsuite': []}]},
+        Normalize(actual))
+
+  def testDefaultOutputFile(self):
+    """Verifies the JSON output file name when none is given."""
+
+    output_file = os.path.join(gtest_test_utils.GetTempDir(),
+                               GTEST_DEFAULT_OUTPUT_FILE)
+    if os.path.isfile(output_file):
+      os.remove(output_file)
+
+    p = gtest_test_utils.Subprocess(
+        [gtest_test_utils.GetTestExecutablePath('gtest_no_test_unittest'),
+         '%s=json' % GTEST_OUTPUT_FLAG],
+        working_dir=gtest_test_utils.GetTempDir())
+    self.assert_(p.exited)
+    self.assertEquals(0, p.exit_code)
+    self.assert_(os.path.isfile(output_file))
+
+  def _TestJsonOutput(self, gtest_prog_name, expected_json,
+                      expected_exit_code, extra_args=None):
+    """Asserts that running gtest_prog_name produces expected_json.
+
+    Furthermore, the program's exit code must be expected_exit_code.
+    """
+
+    json_path = os.path.join(gtest_test_utils.GetTempDir(),
+                             gtest_prog_name + 'out.json')
+    command = ([gtest_test_utils.GetTestExecutablePath(gtest_prog_name),
+                '%s=json:%s' % (GTEST_OUTPUT_FLAG, json_path)] +
+               (extra_args or []))
+    p = gtest_test_utils.Subprocess(command)
+    self.assert_(p.exited, '%s was killed by a signal' % gtest_prog_name)
+    self.assertEquals(expected_exit_code, p.exit_code,
+                      "'%s' exited with code %s, which doesn't match "
+                      'the expected exit code %s.'
+                      % (command, p.exit_code, expected_exit_code))
+
+    json_file = open(json_path)
+    try:
+      actual = json.load(json_file)
+    finally:
+      json_file.close()
+    self.assertEquals(expected_json, Normalize(actual))
+
+
+if __name__ == '__main__':
+  gtest_test_utils.Main()
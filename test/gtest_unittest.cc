@@ -39,18 +39,23 @@
 // Do not move it after other #includes.
 TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
   bool dummy = testing::GTEST_FLAG(also_run_disabled_tests)
+      || testing::GTEST_FLAG(async_listeners)
       || testing::GTEST_FLAG(break_on_failure)
+      || testing::GTEST_FLAG(brief)
       || testing::GTEST_FLAG(catch_exceptions)
       || testing::GTEST_FLAG(color) != "unknown"
       || testing::GTEST_FLAG(filter) != "unknown"
+      || testing::GTEST_FLAG(incremental_output)
       || testing::GTEST_FLAG(list_tests)
       || testing::GTEST_FLAG(output) != "unknown"
+      || testing::GTEST_FLAG(print_budget) > 0
       || testing::GTEST_FLAG(print_time)
       || testing::GTEST_FLAG(random_seed)
       || testing::GTEST_FLAG(repeat) > 0
       || testing::GTEST_FLAG(show_internal_stack_frames)
       || testing::GTEST_FLAG(shuffle)
       || testing::GTEST_FLAG(stack_trace_depth) > 0
+      || testing::GTEST_FLAG(stream_result_format) != "unknown"
       || testing::GTEST_FLAG(stream_result_to) != "unknown"
       || testing::GTEST_FLAG(throw_on_failure);
   EXPECT_TRUE(dummy || !dummy);  // Suppresses warning that dummy is unused.
@@ -76,6 +81,12 @@ TEST(CommandLineFlagsTest, CanBeAccessedInCodeOnceGTestHIsIncluded) {
 #include "src/gtest-internal-inl.h"
 #undef GTEST_IMPLEMENTATION_
 
+#if GTEST_CAN_STREAM_RESULTS_
+# include <sys/socket.h>  // NOLINT
+# include <sys/un.h>  // NOLINT
+# include <unistd.h>  // NOLINT
+#endif  // GTEST_CAN_STREAM_RESULTS_
+
 namespace testing {
 namespace internal {
 
@@ -85,10 +96,16 @@ class StreamingListenerTest : public Test {
  public:
   class FakeSocketWriter : public StreamingListener::AbstractSocketWriter {
    public:
+    FakeSocketWriter() : pending_flushes_(0) {}
+
     // Sends a string to the socket.
     virtual void Send(const string& message) { output_ += message; }
 
+    // Counts the calls, as there is nothing to write.
+    virtual void FlushPending() { pending_flushes_++; }
+
     string output_;
+    int pending_flushes_;
   };
 
   StreamingListenerTest()
@@ -133,6 +150,7 @@ TEST_F(StreamingListenerTest, OnTestStart) {
   *output() = "";
   streamer_.OnTestStart(test_info_obj_);
   EXPECT_EQ("event=TestStart&name=Bar\n", *output());
+  EXPECT_EQ(1, fake_sock_writer_->pending_flushes_);
 }
 
 TEST_F(StreamingListenerTest, OnTestEnd) {
@@ -150,6 +168,101 @@ TEST_F(StreamingListenerTest, OnTestPartResult) {
   EXPECT_EQ(
       "event=TestPartResult&file=foo.cc&line=42&message=failed%3D%0A%26%25\n",
       *output());
+  EXPECT_EQ(1, fake_sock_writer_->pending_flushes_);
+}
+
+TEST_F(StreamingListenerTest, OnTestPartResultWithoutFile) {
+  *output() = "";
+  streamer_.OnTestPartResult(TestPartResult(
+      TestPartResult::kFatalFailure, NULL, -1, "failed"));
+  EXPECT_EQ("event=TestPartResult&file=&line=-1&message=failed\n", *output());
+}
+
+TEST_F(StreamingListenerTest, BinaryFraming) {
+  FakeSocketWriter* const writer = new FakeSocketWriter;
+  StreamingListener streamer(writer, StreamingListener::kBinaryFraming);
+  EXPECT_EQ(string("\0\0\0\x25"
+                   "gtest_streaming_protocol_version\0" "1.0\0", 41),
+            writer->output_);
+
+  writer->output_ = "";
+  streamer.OnTestStart(test_info_obj_);
+  EXPECT_EQ(string("\0\0\0\x19" "event\0TestStart\0name\0Bar\0", 29),
+            writer->output_);
+
+  // Nothing in a message is escaped.
+  writer->output_ = "";
+  streamer.OnTestPartResult(TestPartResult(
+      TestPartResult::kFatalFailure, "foo.cc", 42, "failed=\n&%"));
+  EXPECT_EQ(string("\0\0\0\x3C" "event\0TestPartResult\0file\0foo.cc\0"
+                   "line\0" "42\0message\0failed=\n&%\0", 64),
+            writer->output_);
+}
+
+// The end of a connection to a Unix domain socket, and everything
+// received on it.
+struct SocketReader {
+  int fd;
+  string received;
+};
+
+void ReadUntilClosed(SocketReader* reader) {
+  char buffer[4096];
+  for (;;) {
+    const ssize_t count = read(reader->fd, buffer, sizeof(buffer));
+    if (count <= 0)
+      break;
+    reader->received.append(buffer, static_cast<size_t>(count));
+  }
+}
+
+// Tests that the socket writer delivers everything to a slow reader of a
+// Unix domain socket, even when it has to wait for the reader.
+TEST(StreamingSocketWriterTest, StreamsEverythingToUnixSocket) {
+  const string path = "/tmp/gtest_unittest_" + StreamableToString(getpid()) +
+      ".sock";
+  const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_NE(-1, server);
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path.c_str());  // NOLINT
+  unlink(path.c_str());
+  ASSERT_EQ(0, bind(server, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)));
+  ASSERT_EQ(0, listen(server, 1));
+
+  StreamingListener::SocketWriter* const writer =
+      new StreamingListener::SocketWriter(path);
+  SocketReader reader;
+  reader.fd = accept(server, NULL, NULL);
+  ASSERT_NE(-1, reader.fd);
+
+  Notification reader_can_start;
+  ThreadWithParam<SocketReader*> reader_thread(
+      &ReadUntilClosed, &reader, &reader_can_start);
+
+  // Fills the socket before the reader starts (but stays below the
+  // writer's pending limit, past which it waits for the reader), so that
+  // the writer has to buffer the lines.
+  string expected;
+  for (int i = 0; i < 100000; i++) {
+    const string line = "event=TestStart&name=Test" + StreamableToString(i) +
+        "\n";
+    writer->Send(line);
+    expected += line;
+    if (i == 20000)
+      reader_can_start.Notify();
+  }
+  delete writer;  // Flushes the lines and closes the connection.
+  reader_thread.Join();
+
+  close(reader.fd);
+  close(server);
+  unlink(path.c_str());
+  EXPECT_TRUE(expected == reader.received)
+      << "Received " << reader.received.size() << " of " << expected.size()
+      << " bytes.";
 }
 
 #endif  // GTEST_CAN_STREAM_RESULTS_
@@ -198,24 +311,32 @@ class UnitTestRecordPropertyTestHelper : public Test {
 using testing::AssertionFailure;
 using testing::AssertionResult;
 using testing::AssertionSuccess;
+using testing::DeferredAssertionFailure;
+using testing::DeferredAssertionSuccess;
 using testing::DoubleLE;
 using testing::EmptyTestEventListener;
 using testing::Environment;
 using testing::FloatLE;
 using testing::GTEST_FLAG(also_run_disabled_tests);
+using testing::GTEST_FLAG(async_listeners);
 using testing::GTEST_FLAG(break_on_failure);
+using testing::GTEST_FLAG(brief);
 using testing::GTEST_FLAG(catch_exceptions);
 using testing::GTEST_FLAG(color);
 using testing::GTEST_FLAG(death_test_use_fork);
+using testing::GTEST_FLAG(death_test_use_zygote);
 using testing::GTEST_FLAG(filter);
+using testing::GTEST_FLAG(incremental_output);
 using testing::GTEST_FLAG(list_tests);
 using testing::GTEST_FLAG(output);
+using testing::GTEST_FLAG(print_budget);
 using testing::GTEST_FLAG(print_time);
 using testing::GTEST_FLAG(random_seed);
 using testing::GTEST_FLAG(repeat);
 using testing::GTEST_FLAG(show_internal_stack_frames);
 using testing::GTEST_FLAG(shuffle);
 using testing::GTEST_FLAG(stack_trace_depth);
+using testing::GTEST_FLAG(stream_result_format);
 using testing::GTEST_FLAG(stream_result_to);
 using testing::GTEST_FLAG(throw_on_failure);
 using testing::IsNotSubstring;
@@ -225,6 +346,7 @@ using testing::ScopedFakeTestPartResultReporter;
 using testing::StaticAssertTypeEq;
 using testing::Test;
 using testing::TestCase;
+using testing::TestEventListener;
 using testing::TestEventListeners;
 using testing::TestInfo;
 using testing::TestPartResult;
@@ -282,12 +404,14 @@ using testing::internal::TestEventListenersAccessor;
 using testing::internal::TestResultAccessor;
 using testing::internal::UInt32;
 using testing::internal::WideStringToUtf8;
+using testing::internal::edit_distance::CalculateMinimalEdits;
 using testing::internal::edit_distance::CalculateOptimalEdits;
 using testing::internal::edit_distance::CreateUnifiedDiff;
 using testing::internal::edit_distance::EditType;
 using testing::internal::kMaxRandomSeed;
 using testing::internal::kTestTypeIdInGoogleTest;
 using testing::internal::scoped_ptr;
+using testing::kDefaultPrintBudget;
 using testing::kMaxStackTraceDepth;
 
 #if GTEST_HAS_STREAM_REDIRECTION
@@ -707,6 +831,44 @@ TEST(WideStringToUtf8Test, ConcatenatesCodepointsCorrectly) {
 }
 #endif  // !GTEST_WIDE_STRING_USES_UTF16_
 
+// Tests encoding a string long enough to need more than one pass
+// through the buffer WideStringToUtf8() encodes it in.
+TEST(WideStringToUtf8Test, EncodesLongStrings) {
+  const wchar_t chars[] = { 'a', 'Z', 0x576, '\n', 0x8D3, 0xC74D, '~' };
+  std::wstring wide;
+  std::string expected;
+  for (int i = 0; i < 5000; i++) {
+    // Alternates long runs of ASCII characters with mixed text.
+    const wchar_t ch = chars[(i / 300 % 2 == 0 ? 0 : i) % 7];
+    wide += ch;
+    expected += CodePointToUtf8(static_cast<UInt32>(ch));
+  }
+  EXPECT_EQ(expected, WideStringToUtf8(wide.c_str(), -1));
+
+#if !GTEST_WIDE_STRING_USES_UTF16_
+  const std::wstring invalid(300, static_cast<wchar_t>(0x7FFFFFFF));
+  expected.clear();
+  for (int i = 0; i < 300; i++)
+    expected += "(Invalid Unicode 0x7FFFFFFF)";
+  EXPECT_EQ(expected, WideStringToUtf8(invalid.c_str(), -1));
+#endif  // !GTEST_WIDE_STRING_USES_UTF16_
+}
+
+// Tests a run of ASCII characters that nearly or completely fills the
+// buffer WideStringToUtf8() encodes into, followed by a code point that
+// takes several characters.
+TEST(WideStringToUtf8Test, EncodesCodePointAfterFullBuffer) {
+  for (size_t length = 1023; length <= 1024; length++) {
+    const std::wstring ascii(length, L'a');
+    EXPECT_EQ(std::string(length, 'a') + "\xE4\xB8\xAD",
+              WideStringToUtf8((ascii + L"\x4E2D").c_str(), -1));
+#if !GTEST_WIDE_STRING_USES_UTF16_
+    EXPECT_EQ(std::string(length, 'a') + "(Invalid Unicode 0x7FFFFFFF)",
+              WideStringToUtf8((ascii + L"\x7FFFFFFF").c_str(), -1));
+#endif  // !GTEST_WIDE_STRING_USES_UTF16_
+  }
+}
+
 // Tests the Random class.
 
 TEST(RandomDeathTest, GeneratesCrashesOnInvalidRange) {
@@ -1529,18 +1691,24 @@ class GTestFlagSaverTest : public Test {
     saver_ = new GTestFlagSaver;
 
     GTEST_FLAG(also_run_disabled_tests) = false;
+    GTEST_FLAG(async_listeners) = false;
     GTEST_FLAG(break_on_failure) = false;
+    GTEST_FLAG(brief) = false;
     GTEST_FLAG(catch_exceptions) = false;
     GTEST_FLAG(death_test_use_fork) = false;
+    GTEST_FLAG(death_test_use_zygote) = false;
     GTEST_FLAG(color) = "auto";
     GTEST_FLAG(filter) = "";
+    GTEST_FLAG(incremental_output) = false;
     GTEST_FLAG(list_tests) = false;
     GTEST_FLAG(output) = "";
+    GTEST_FLAG(print_budget) = kDefaultPrintBudget;
     GTEST_FLAG(print_time) = true;
     GTEST_FLAG(random_seed) = 0;
     GTEST_FLAG(repeat) = 1;
     GTEST_FLAG(shuffle) = false;
     GTEST_FLAG(stack_trace_depth) = kMaxStackTraceDepth;
+    GTEST_FLAG(stream_result_format) = "text";
     GTEST_FLAG(stream_result_to) = "";
     GTEST_FLAG(throw_on_failure) = false;
   }
@@ -1556,34 +1724,46 @@ class GTestFlagSaverTest : public Test {
   // modifies each of them.
   void VerifyAndModifyFlags() {
     EXPECT_FALSE(GTEST_FLAG(also_run_disabled_tests));
+    EXPECT_FALSE(GTEST_FLAG(async_listeners));
     EXPECT_FALSE(GTEST_FLAG(break_on_failure));
+    EXPECT_FALSE(GTEST_FLAG(brief));
     EXPECT_FALSE(GTEST_FLAG(catch_exceptions));
     EXPECT_STREQ("auto", GTEST_FLAG(color).c_str());
     EXPECT_FALSE(GTEST_FLAG(death_test_use_fork));
+    EXPECT_FALSE(GTEST_FLAG(death_test_use_zygote));
     EXPECT_STREQ("", GTEST_FLAG(filter).c_str());
+    EXPECT_FALSE(GTEST_FLAG(incremental_output));
     EXPECT_FALSE(GTEST_FLAG(list_tests));
     EXPECT_STREQ("", GTEST_FLAG(output).c_str());
+    EXPECT_EQ(kDefaultPrintBudget, GTEST_FLAG(print_budget));
     EXPECT_TRUE(GTEST_FLAG(print_time));
     EXPECT_EQ(0, GTEST_FLAG(random_seed));
     EXPECT_EQ(1, GTEST_FLAG(repeat));
     EXPECT_FALSE(GTEST_FLAG(shuffle));
     EXPECT_EQ(kMaxStackTraceDepth, GTEST_FLAG(stack_trace_depth));
+    EXPECT_STREQ("text", GTEST_FLAG(stream_result_format).c_str());
     EXPECT_STREQ("", GTEST_FLAG(stream_result_to).c_str());
     EXPECT_FALSE(GTEST_FLAG(throw_on_failure));
 
     GTEST_FLAG(also_run_disabled_tests) = true;
+    GTEST_FLAG(async_listeners) = true;
     GTEST_FLAG(break_on_failure) = true;
+    GTEST_FLAG(brief) = true;
     GTEST_FLAG(catch_exceptions) = true;
     GTEST_FLAG(color) = "no";
     GTEST_FLAG(death_test_use_fork) = true;
+    GTEST_FLAG(death_test_use_zygote) = true;
     GTEST_FLAG(filter) = "abc";
+    GTEST_FLAG(incremental_output) = true;
     GTEST_FLAG(list_tests) = true;
     GTEST_FLAG(output) = "xml:foo.xml";
+    GTEST_FLAG(print_budget) = 1;
     GTEST_FLAG(print_time) = false;
     GTEST_FLAG(random_seed) = 1;
     GTEST_FLAG(repeat) = 100;
     GTEST_FLAG(shuffle) = true;
     GTEST_FLAG(stack_trace_depth) = 1;
+    GTEST_FLAG(stream_result_format) = "binary";
     GTEST_FLAG(stream_result_to) = "localhost:1234";
     GTEST_FLAG(throw_on_failure) = true;
   }
@@ -1972,6 +2152,8 @@ class UnitTestRecordPropertyTest :
         "name");
     ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTestCase(
         "tests");
+    ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTestCase(
+        "testsuite");
     ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTestCase(
         "time");
 
@@ -2049,14 +2231,16 @@ TEST_F(UnitTestRecordPropertyTest,
       "time");
   ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTest(
       "classname");
+  ExpectNonFatalFailureRecordingPropertyWithReservedKeyForCurrentTest(
+      "failures");
 }
 
 TEST_F(UnitTestRecordPropertyTest,
        AddRecordWithReservedKeysGeneratesCorrectPropertyList) {
   EXPECT_NONFATAL_FAILURE(
       Test::RecordProperty("name", "1"),
-      "'classname', 'name', 'status', 'time', 'type_param', and 'value_param'"
-      " are reserved");
+      "'classname', 'failures', 'name', 'status', 'time', 'type_param', and "
+      "'value_param' are reserved");
 }
 
 class UnitTestRecordPropertyTestEnvironment : public Environment {
@@ -2078,6 +2262,8 @@ class UnitTestRecordPropertyTestEnvironment : public Environment {
         "time");
     ExpectNonFatalFailureRecordingPropertyWithReservedKeyOutsideOfTestCase(
         "random_seed");
+    ExpectNonFatalFailureRecordingPropertyWithReservedKeyOutsideOfTestCase(
+        "testsuites");
   }
 };
 
@@ -3485,7 +3671,7 @@ TEST(EditDistance, TestCases) {
       {__LINE__, "ABCDEFGH", "ABXEGH1", "  -/ -  +",
        "@@ -1,8 +1,7 @@\n A\n B\n-C\n-D\n+X\n E\n-F\n G\n H\n+1\n"},
       {__LINE__, "AAAABCCCC", "ABABCDCDC", "- /   + / ",
-       "@@ -1,9 +1,9 @@\n-A\n A\n-A\n+B\n A\n B\n C\n+D\n C\n-C\n+D\n C\n"},
+       "@@ -1,9 +1,9 @@\n A\n-A\n-A\n+B\n A\n B\n C\n+D\n C\n-C\n+D\n C\n"},
       {__LINE__, "ABCDE", "BCDCD", "-   +/",
        "@@ -1,5 +1,5 @@\n-A\n B\n C\n D\n-E\n+C\n+D\n"},
       {__LINE__, "ABCDEFGHIJKL", "BCDCDEFGJKLJK", "- ++     --   ++",
@@ -3507,6 +3693,115 @@ TEST(EditDistance, TestCases) {
   }
 }
 
+// Tests that CalculateMinimalEdits() finds a shortest edit script.
+TEST(EditDistance, MinimalEdits) {
+  struct Case {
+    int line;
+    const char* left;
+    const char* right;
+    const char* expected_edits;
+  };
+  static const Case kCases[] = {
+      {__LINE__, "", "", ""},
+      {__LINE__, "ABC", "ABC", "   "},
+      {__LINE__, "", "AB", "++"},
+      {__LINE__, "AB", "", "--"},
+      {__LINE__, "A", "a", "-+"},
+      // The example from Myers' paper.
+      {__LINE__, "ABCABBA", "CBABAC", "-+ -  - +"},
+      {__LINE__, "ABCDEFGH", "ABXEGH1", "  -+- -  +"},
+      {}};
+  for (const Case* c = kCases; c->left; ++c) {
+    std::vector<EditType> edits;
+    ASSERT_TRUE(CalculateMinimalEdits(CharsToIndices(c->left),
+                                      CharsToIndices(c->right), 100, &edits));
+    EXPECT_EQ(c->expected_edits, EditsToString(edits))
+        << "Left <" << c->left << "> Right <" << c->right << ">";
+  }
+}
+
+// Tests that CalculateMinimalEdits() gives up when more than max_edits
+// adds and removes are needed.
+TEST(EditDistance, MinimalEditsRespectsLimit) {
+  std::vector<EditType> edits;
+  EXPECT_TRUE(CalculateMinimalEdits(CharsToIndices("ABCD"),
+                                    CharsToIndices("abcd"), 8, &edits));
+  EXPECT_FALSE(CalculateMinimalEdits(CharsToIndices("ABCDEFGH"),
+                                     CharsToIndices("abcdefgh"), 8, &edits));
+  EXPECT_FALSE(CalculateMinimalEdits(CharsToIndices(""),
+                                     CharsToIndices("abcdefghij"), 8,
+                                     &edits));
+}
+
+// Tests that CalculateMinimalEdits() succeeds with max_edits equal to
+// the number of adds and removes needed, and fails with one less, for
+// edit distances found by both the forward and the backward search.
+TEST(EditDistance, MinimalEditsLimitIsExact) {
+  struct Case {
+    int line;
+    const char* left;
+    const char* right;
+    size_t edit_count;
+  };
+  static const Case kCases[] = {
+      {__LINE__, "A", "ab", 3},
+      {__LINE__, "AB", "abc", 5},
+      {__LINE__, "ABCD", "abcd", 8},
+      {__LINE__, "ABCDE", "abcde", 10},
+      {__LINE__, "ABCABBA", "CBABAC", 5},
+      {__LINE__, "ABCDEFGH", "ABXEGH1", 5},
+      {}};
+  for (const Case* c = kCases; c->left; ++c) {
+    std::vector<EditType> edits;
+    EXPECT_TRUE(CalculateMinimalEdits(CharsToIndices(c->left),
+                                      CharsToIndices(c->right),
+                                      c->edit_count, &edits))
+        << "Left <" << c->left << "> Right <" << c->right << ">";
+    EXPECT_FALSE(CalculateMinimalEdits(CharsToIndices(c->left),
+                                       CharsToIndices(c->right),
+                                       c->edit_count - 1, &edits))
+        << "Left <" << c->left << "> Right <" << c->right << ">";
+  }
+}
+
+std::vector<std::string> NumberedLines(const char* prefix, int count) {
+  std::vector<std::string> lines;
+  for (int i = 0; i < count; ++i) {
+    lines.push_back(prefix + StreamableToString(i));
+  }
+  return lines;
+}
+
+// Tests that a few changes in long inputs are found without a quadratic
+// amount of memory.
+TEST(EditDistance, CreateUnifiedDiffHandlesLongInputs) {
+  const std::vector<std::string> left = NumberedLines("line ", 100000);
+  std::vector<std::string> right = left;
+  right[10] = "changed";
+  right.erase(right.begin() + 70000);
+  EXPECT_EQ("@@ -9,5 +9,5 @@\n line 8\n line 9\n-line 10\n+changed\n"
+            " line 11\n line 12\n"
+            "@@ -69999,5 @@\n line 69998\n line 69999\n-line 70000\n"
+            " line 70001\n line 70002\n",
+            CreateUnifiedDiff(left, right));
+}
+
+// Tests that CreateUnifiedDiff() shows just the first difference when the
+// inputs differ in too many lines.
+TEST(EditDistance, CreateUnifiedDiffShowsFirstDifferenceOnly) {
+  std::vector<std::string> left = NumberedLines("left ", 2000);
+  std::vector<std::string> right = NumberedLines("right ", 2000);
+  left[0] = right[0] = "same";
+  EXPECT_EQ("@@ -1,11 +1,11 @@\n same\n"
+            "-left 1\n-left 2\n-left 3\n-left 4\n-left 5\n"
+            "-left 6\n-left 7\n-left 8\n-left 9\n-left 10\n"
+            "+right 1\n+right 2\n+right 3\n+right 4\n+right 5\n"
+            "+right 6\n+right 7\n+right 8\n+right 9\n+right 10\n"
+            "(More than 1000 lines differ; only the first difference is "
+            "shown.)\n",
+            CreateUnifiedDiff(left, right));
+}
+
 // Tests EqFailure(), used for implementing *EQ* assertions.
 TEST(AssertionTest, EqFailure) {
   const std::string foo_val("5"), bar_val("6");
@@ -4394,6 +4689,56 @@ TEST(ExpectTest, EXPECT_EQ_Double) {
                           "5.1");
 }
 
+// Tests that EXPECT_EQ on strings that don't fit in the print budget
+// shows the strings around their first difference.
+TEST(ExpectTest, EXPECT_EQ_HugeStrings) {
+  GTestFlagSaver saver;
+  GTEST_FLAG(print_budget) = 1000;
+
+  const std::string expected(2000, 'a');
+  std::string actual = expected;
+  actual[1500] = 'b';
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_EQ(expected, actual),
+      "  Actual: \"" + std::string(64, 'a') + "b" + std::string(191, 'a') +
+      "\"\nExpected: expected\nWhich is: \"" + std::string(256, 'a') + "\"\n"
+      "The strings are too long to print in full, so only their characters "
+      "[1436, 1692) are shown.  They first differ at index 1500, and have "
+      "2000 and 2000 characters respectively.");
+
+  // The strings differ after the end of the shorter one.
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_EQ(expected, expected + "\n"),
+      "Which is: \"" + std::string(64, 'a') + "\"\n"
+      "The strings are too long to print in full, so only their characters "
+      "[1936, 2001) are shown.  They first differ at index 2000, and have "
+      "2000 and 2001 characters respectively.");
+
+  // Strings that fit are printed in full.
+  GTEST_FLAG(print_budget) = 0;
+  EXPECT_NONFATAL_FAILURE(EXPECT_EQ(expected, actual),
+                          "Which is: \"" + expected + "\"");
+}
+
+#if GTEST_HAS_STD_WSTRING
+TEST(ExpectTest, EXPECT_EQ_HugeWideStrings) {
+  GTestFlagSaver saver;
+  GTEST_FLAG(print_budget) = 280;
+
+  const ::std::wstring expected(300, L'a');
+  ::std::wstring actual = expected;
+  actual[10] = L'\x263A';
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_EQ(expected, actual),
+      "  Actual: L\"" + std::string(10, 'a') + "\\x263A\" L\"" +
+      std::string(245, 'a') + "\"\n");
+  EXPECT_NONFATAL_FAILURE(EXPECT_EQ(expected, actual),
+                          "only their characters [0, 256) are shown.  They "
+                          "first differ at index 10, and have 300 and 300 "
+                          "characters respectively.");
+}
+#endif  // GTEST_HAS_STD_WSTRING
+
 #if GTEST_CAN_COMPARE_NULL
 // Tests EXPECT_EQ(NULL, pointer).
 TEST(ExpectTest, EXPECT_EQ_NULL) {
@@ -5110,6 +5455,75 @@ TEST(AssertionResultTest, CanStreamOstreamManipulators) {
   EXPECT_STREQ("Data\n\\0Will be visible", r.message());
 }
 
+// A formatter for deferred AssertionResult messages that counts how
+// many times it has been called.
+class CountingFormatter {
+ public:
+  CountingFormatter(const char* text, int* calls)
+      : text_(text), calls_(calls) {}
+
+  void operator()(Message* msg) const {
+    ++*calls_;
+    *msg << text_ << " " << *calls_;
+  }
+
+ private:
+  const char* text_;
+  int* calls_;
+};
+
+void FormatXyz(Message* msg) { *msg << "xyz"; }
+
+// Tests that a deferred message is formatted once, when it's needed.
+TEST(AssertionResultTest, FormatsDeferredMessageWhenNeeded) {
+  int calls = 0;
+  AssertionResult r1 = DeferredAssertionFailure(
+      CountingFormatter("abc", &calls));
+  EXPECT_FALSE(r1);
+  EXPECT_EQ(0, calls);
+  EXPECT_STREQ("abc 1", r1.message());
+  EXPECT_STREQ("abc 1", r1.message());
+  EXPECT_EQ(1, calls);
+
+  AssertionResult r2 = DeferredAssertionSuccess(&FormatXyz);
+  EXPECT_TRUE(r2);
+  EXPECT_STREQ("xyz", r2.message());
+}
+
+// Tests that copies and negations of a deferred result format their
+// messages independently of the original.
+TEST(AssertionResultTest, CopiesDeferredMessage) {
+  int calls = 0;
+  const AssertionResult r1 = DeferredAssertionFailure(
+      CountingFormatter("abc", &calls));
+  AssertionResult r2 = r1;
+  const AssertionResult r3 = !r2;
+  EXPECT_EQ(0, calls);
+  EXPECT_TRUE(r3);
+  EXPECT_STREQ("abc 1", r3.message());
+  EXPECT_STREQ("abc 2", r2.message());
+  EXPECT_STREQ("abc 3", r1.message());
+}
+
+// Tests streaming to an AssertionResult with a deferred message.
+TEST(AssertionResultTest, StreamsAfterDeferredMessage) {
+  AssertionResult r = DeferredAssertionFailure(&FormatXyz);
+  r << " and " << 1;
+  EXPECT_STREQ("xyz and 1", r.message());
+
+  AssertionResult negation = !(AssertionSuccess() << "abc ");
+  EXPECT_STREQ("abc ", negation.message());
+}
+
+// Tests that a failed assertion prints the deferred message.
+TEST(AssertionResultTest, AssertionPrintsDeferredMessage) {
+  int calls = 0;
+  EXPECT_NONFATAL_FAILURE(
+      EXPECT_TRUE(DeferredAssertionFailure(CountingFormatter("abc", &calls))),
+      "Actual: false (abc 1)");
+  EXPECT_EQ(1, calls);
+}
+
 // The next test uses explicit conversion operators -- a C++11 feature.
 #if GTEST_LANG_CXX11
 
@@ -5388,17 +5802,23 @@ TEST_F(SetUpTestCaseTest, Test2) {
 struct Flags {
   // Constructs a Flags struct where each flag has its default value.
   Flags() : also_run_disabled_tests(false),
+            async_listeners(false),
             break_on_failure(false),
+            brief(false),
             catch_exceptions(false),
             death_test_use_fork(false),
+            death_test_use_zygote(false),
             filter(""),
+            incremental_output(false),
             list_tests(false),
             output(""),
+            print_budget(kDefaultPrintBudget),
             print_time(true),
             random_seed(0),
             repeat(1),
             shuffle(false),
             stack_trace_depth(kMaxStackTraceDepth),
+            stream_result_format("text"),
             stream_result_to(""),
             throw_on_failure(false) {}
 
@@ -5412,6 +5832,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_async_listeners flag has
+  // the given value.
+  static Flags AsyncListeners(bool async_listeners) {
+    Flags flags;
+    flags.async_listeners = async_listeners;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_break_on_failure flag has
   // the given value.
   static Flags BreakOnFailure(bool break_on_failure) {
@@ -5420,6 +5848,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_brief flag has the given
+  // value.
+  static Flags Brief(bool brief) {
+    Flags flags;
+    flags.brief = brief;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_catch_exceptions flag has
   // the given value.
   static Flags CatchExceptions(bool catch_exceptions) {
@@ -5436,6 +5872,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_death_test_use_zygote flag has
+  // the given value.
+  static Flags DeathTestUseZygote(bool death_test_use_zygote) {
+    Flags flags;
+    flags.death_test_use_zygote = death_test_use_zygote;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_filter flag has the given
   // value.
   static Flags Filter(const char* filter) {
@@ -5444,6 +5888,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_incremental_output flag has
+  // the given value.
+  static Flags IncrementalOutput(bool incremental_output) {
+    Flags flags;
+    flags.incremental_output = incremental_output;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_list_tests flag has the
   // given value.
   static Flags ListTests(bool list_tests) {
@@ -5460,6 +5912,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the gtest_print_budget flag has the
+  // given value.
+  static Flags PrintBudget(Int32 print_budget) {
+    Flags flags;
+    flags.print_budget = print_budget;
+    return flags;
+  }
+
   // Creates a Flags struct where the gtest_print_time flag has the given
   // value.
   static Flags PrintTime(bool print_time) {
@@ -5500,6 +5960,14 @@ struct Flags {
     return flags;
   }
 
+  // Creates a Flags struct where the GTEST_FLAG(stream_result_format) flag
+  // has the given value.
+  static Flags StreamResultFormat(const char* stream_result_format) {
+    Flags flags;
+    flags.stream_result_format = stream_result_format;
+    return flags;
+  }
+
   // Creates a Flags struct where the GTEST_FLAG(stream_result_to) flag has
   // the given value.
   static Flags StreamResultTo(const char* stream_result_to) {
@@ -5518,17 +5986,23 @@ struct Flags {
 
   // These fields store the flag values.
   bool also_run_disabled_tests;
+  bool async_listeners;
   bool break_on_failure;
+  bool brief;
   bool catch_exceptions;
   bool death_test_use_fork;
+  bool death_test_use_zygote;
   const char* filter;
+  bool incremental_output;
   bool list_tests;
   const char* output;
+  Int32 print_budget;
   bool print_time;
   Int32 random_seed;
   Int32 repeat;
   bool shuffle;
   Int32 stack_trace_depth;
+  const char* stream_result_format;
   const char* stream_result_to;
   bool throw_on_failure;
 };
@@ -5539,17 +6013,23 @@ class InitGoogleTestTest : public Test {
   // Clears the flags before each test.
   virtual void SetUp() {
     GTEST_FLAG(also_run_disabled_tests) = false;
+    GTEST_FLAG(async_listeners) = false;
     GTEST_FLAG(break_on_failure) = false;
+    GTEST_FLAG(brief) = false;
     GTEST_FLAG(catch_exceptions) = false;
     GTEST_FLAG(death_test_use_fork) = false;
+    GTEST_FLAG(death_test_use_zygote) = false;
     GTEST_FLAG(filter) = "";
+    GTEST_FLAG(incremental_output) = false;
     GTEST_FLAG(list_tests) = false;
     GTEST_FLAG(output) = "";
+    GTEST_FLAG(print_budget) = kDefaultPrintBudget;
     GTEST_FLAG(print_time) = true;
     GTEST_FLAG(random_seed) = 0;
     GTEST_FLAG(repeat) = 1;
     GTEST_FLAG(shuffle) = false;
     GTEST_FLAG(stack_trace_depth) = kMaxStackTraceDepth;
+    GTEST_FLAG(stream_result_format) = "text";
     GTEST_FLAG(stream_result_to) = "";
     GTEST_FLAG(throw_on_failure) = false;
   }
@@ -5569,17 +6049,25 @@ class InitGoogleTestTest : public Test {
   static void CheckFlags(const Flags& expected) {
     EXPECT_EQ(expected.also_run_disabled_tests,
               GTEST_FLAG(also_run_disabled_tests));
+    EXPECT_EQ(expected.async_listeners, GTEST_FLAG(async_listeners));
     EXPECT_EQ(expected.break_on_failure, GTEST_FLAG(break_on_failure));
+    EXPECT_EQ(expected.brief, GTEST_FLAG(brief));
     EXPECT_EQ(expected.catch_exceptions, GTEST_FLAG(catch_exceptions));
     EXPECT_EQ(expected.death_test_use_fork, GTEST_FLAG(death_test_use_fork));
+    EXPECT_EQ(expected.death_test_use_zygote,
+              GTEST_FLAG(death_test_use_zygote));
     EXPECT_STREQ(expected.filter, GTEST_FLAG(filter).c_str());
+    EXPECT_EQ(expected.incremental_output, GTEST_FLAG(incremental_output));
     EXPECT_EQ(expected.list_tests, GTEST_FLAG(list_tests));
     EXPECT_STREQ(expected.output, GTEST_FLAG(output).c_str());
+    EXPECT_EQ(expected.print_budget, GTEST_FLAG(print_budget));
     EXPECT_EQ(expected.print_time, GTEST_FLAG(print_time));
     EXPECT_EQ(expected.random_seed, GTEST_FLAG(random_seed));
     EXPECT_EQ(expected.repeat, GTEST_FLAG(repeat));
     EXPECT_EQ(expected.shuffle, GTEST_FLAG(shuffle));
     EXPECT_EQ(expected.stack_trace_depth, GTEST_FLAG(stack_trace_depth));
+    EXPECT_STREQ(expected.stream_result_format,
+                 GTEST_FLAG(stream_result_format).c_str());
     EXPECT_STREQ(expected.stream_result_to,
                  GTEST_FLAG(stream_result_to).c_str());
     EXPECT_EQ(expected.throw_on_failure, GTEST_FLAG(throw_on_failure));
@@ -5830,6 +6318,23 @@ TEST_F(InitGoogleTestTest, DeathTestUseFork) {
   GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestUseFork(true), false);
 }
 
+// Tests parsing --gtest_death_test_use_zygote.
+TEST_F(InitGoogleTestTest, DeathTestUseZygote) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_death_test_use_zygote",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::DeathTestUseZygote(true),
+                            false);
+}
+
 // Tests having the same flag twice with different values.  The
 // expected behavior is that the one coming last takes precedence.
 TEST_F(InitGoogleTestTest, DuplicatedFlags) {
@@ -6016,6 +6521,38 @@ TEST_F(InitGoogleTestTest, OutputXmlDirectory) {
                             Flags::Output("xml:directory/path/"), false);
 }
 
+// Tests having a --gtest_incremental_output flag
+TEST_F(InitGoogleTestTest, IncrementalOutput) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_incremental_output",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::IncrementalOutput(true), false);
+}
+
+// Tests parsing --gtest_print_budget=number.
+TEST_F(InitGoogleTestTest, PrintBudget) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_print_budget=100",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::PrintBudget(100), false);
+}
+
 // Tests having a --gtest_print_time flag
 TEST_F(InitGoogleTestTest, PrintTimeFlag) {
     const char* argv[] = {
@@ -6179,6 +6716,38 @@ TEST_F(InitGoogleTestTest, AlsoRunDisabledTestsFalse) {
                               Flags::AlsoRunDisabledTests(false), false);
 }
 
+// Tests having a --gtest_async_listeners flag
+TEST_F(InitGoogleTestTest, AsyncListeners) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_async_listeners",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::AsyncListeners(true), false);
+}
+
+// Tests having a --gtest_brief flag
+TEST_F(InitGoogleTestTest, Brief) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_brief",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(argv, argv2, Flags::Brief(true), false);
+}
+
 // Tests parsing --gtest_shuffle.
 TEST_F(InitGoogleTestTest, ShuffleWithoutValue) {
   const char* argv[] = {
@@ -6260,6 +6829,38 @@ TEST_F(InitGoogleTestTest, StreamResultTo) {
       argv, argv2, Flags::StreamResultTo("localhost:1234"), false);
 }
 
+TEST_F(InitGoogleTestTest, StreamResultToUnixSocket) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_stream_result_to=unix:/tmp/gtest.sock",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(
+      argv, argv2, Flags::StreamResultTo("unix:/tmp/gtest.sock"), false);
+}
+
+TEST_F(InitGoogleTestTest, StreamResultFormat) {
+  const char* argv[] = {
+    "foo.exe",
+    "--gtest_stream_result_format=binary",
+    NULL
+  };
+
+  const char* argv2[] = {
+    "foo.exe",
+    NULL
+  };
+
+  GTEST_TEST_PARSING_FLAGS_(
+      argv, argv2, Flags::StreamResultFormat("binary"), false);
+}
+
 // Tests parsing --gtest_throw_on_failure.
 TEST_F(InitGoogleTestTest, ThrowOnFailureWithoutValue) {
   const char* argv[] = {
@@ -6958,6 +7559,74 @@ TEST(EventListenerTest, AppendKeepsOrder) {
   EXPECT_STREQ("1st.OnTestIterationEnd", vec[2].c_str());
 }
 
+// A listener that records the program start and end events it receives,
+// and subscribes to the given events only.
+class SubscribingListener : public EmptyTestEventListener {
+ public:
+  SubscribingListener(std::vector<std::string>* vector, const char* id,
+                      int events)
+      : vector_(vector), id_(id), events_(events) {}
+
+ protected:
+  virtual int SubscribedEvents() const { return events_; }
+
+  virtual void OnTestProgramStart(const UnitTest& /*unit_test*/) {
+    vector_->push_back(std::string(id_) + ".OnTestProgramStart");
+  }
+
+  virtual void OnTestProgramEnd(const UnitTest& /*unit_test*/) {
+    vector_->push_back(std::string(id_) + ".OnTestProgramEnd");
+  }
+
+ private:
+  std::vector<std::string>* vector_;
+  const char* const id_;
+  const int events_;
+
+  GTEST_DISALLOW_COPY_AND_ASSIGN_(SubscribingListener);
+};
+
+// Tests that listeners receive only the events they subscribe to, still
+// in the order they were appended.
+TEST(EventListenerTest, ForwardsOnlySubscribedEvents) {
+  std::vector<std::string> vec;
+  TestEventListeners listeners;
+  listeners.Append(new SubscribingListener(
+      &vec, "1st",
+      TestEventListener::kTestProgramStart |
+      TestEventListener::kTestProgramEnd));
+  TestEventListener* const second = new SubscribingListener(
+      &vec, "2nd", TestEventListener::kTestProgramEnd);
+  listeners.Append(second);
+  listeners.Append(new SubscribingListener(
+      &vec, "3rd", TestEventListener::kAllEvents));
+  listeners.Append(new SubscribingListener(&vec, "4th", 0));
+
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramStart(
+      *UnitTest::GetInstance());
+  ASSERT_EQ(2U, vec.size());
+  EXPECT_STREQ("1st.OnTestProgramStart", vec[0].c_str());
+  EXPECT_STREQ("3rd.OnTestProgramStart", vec[1].c_str());
+
+  vec.clear();
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramEnd(
+      *UnitTest::GetInstance());
+  ASSERT_EQ(3U, vec.size());
+  EXPECT_STREQ("3rd.OnTestProgramEnd", vec[0].c_str());
+  EXPECT_STREQ("2nd.OnTestProgramEnd", vec[1].c_str());
+  EXPECT_STREQ("1st.OnTestProgramEnd", vec[2].c_str());
+
+  // A released listener stops receiving the events it subscribed to.
+  vec.clear();
+  EXPECT_EQ(second, listeners.Release(second));
+  delete second;
+  TestEventListenersAccessor::GetRepeater(&listeners)->OnTestProgramEnd(
+      *UnitTest::GetInstance());
+  ASSERT_EQ(2U, vec.size());
+  EXPECT_STREQ("3rd.OnTestProgramEnd", vec[0].c_str());
+  EXPECT_STREQ("1st.OnTestProgramEnd", vec[1].c_str());
+}
+
 // Tests that a listener removed from a TestEventListeners list stops receiving
 // events and is not deleted when the list is destroyed.
 TEST(TestEventListenersTest, Release) {
@@ -0,0 +1,99 @@
+// Copyright 2008 Google Inc.
+// All Rights Reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// A translation unit that exercises the type lists, Values(), and
+// Combine().  It isn't a test: scripts/compile_benchmark.py compiles it
+// with GTEST_HAS_VARIADIC_TEMPLATES set to 0 and 1 to compare the cost
+// of the pump-generated and the variadic implementations.  The lists
+// stay within the limits of the pump-generated versions so that both
+// variants compile.
+
+#include "gtest/gtest.h"
+
+namespace {
+
+template <int N>
+struct Int {};
+
+template <typename T>
+class TypedBenchmarkTest : public ::testing::Test {};
+
+typedef ::testing::Types<
+    Int<0>, Int<1>, Int<2>, Int<3>, Int<4>, Int<5>, Int<6>, Int<7>, Int<8>,
+    Int<9>, Int<10>, Int<11>, Int<12>, Int<13>, Int<14>, Int<15>, Int<16>,
+    Int<17>, Int<18>, Int<19>, Int<20>, Int<21>, Int<22>, Int<23>, Int<24>,
+    Int<25>, Int<26>, Int<27>, Int<28>, Int<29>, Int<30>, Int<31>, Int<32>,
+    Int<33>, Int<34>, Int<35>, Int<36>, Int<37>, Int<38>, Int<39> > FortyTypes;
+TYPED_TEST_CASE(TypedBenchmarkTest, FortyTypes);
+
+TYPED_TEST(TypedBenchmarkTest, A) {}
+TYPED_TEST(TypedBenchmarkTest, B) {}
+
+template <typename T>
+class TypeParameterizedBenchmarkTest : public ::testing::Test {};
+
+TYPED_TEST_CASE_P(TypeParameterizedBenchmarkTest);
+
+TYPED_TEST_P(TypeParameterizedBenchmarkTest, A) {}
+TYPED_TEST_P(TypeParameterizedBenchmarkTest, B) {}
+TYPED_TEST_P(TypeParameterizedBenchmarkTest, C) {}
+TYPED_TEST_P(TypeParameterizedBenchmarkTest, D) {}
+
+REGISTER_TYPED_TEST_CASE_P(TypeParameterizedBenchmarkTest, A, B, C, D);
+INSTANTIATE_TYPED_TEST_CASE_P(Forty, TypeParameterizedBenchmarkTest,
+                              FortyTypes);
+
+class ValuesBenchmarkTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(ValuesBenchmarkTest, A) {}
+
+INSTANTIATE_TEST_CASE_P(Forty, ValuesBenchmarkTest,
+                        ::testing::Values(0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                          10, 11, 12, 13, 14, 15, 16, 17, 18,
+                                          19, 20, 21, 22, 23, 24, 25, 26, 27,
+                                          28, 29, 30, 31, 32, 33, 34, 35, 36,
+                                          37, 38, 39));
+
+#if GTEST_HAS_COMBINE
+
+class CombineBenchmarkTest
+    : public ::testing::TestWithParam<
+          ::testing::tuple<int, bool, char, int, bool, char> > {};
+
+TEST_P(CombineBenchmarkTest, A) {}
+
+INSTANTIATE_TEST_CASE_P(
+    Six, CombineBenchmarkTest,
+    ::testing::Combine(::testing::Values(1, 2), ::testing::Bool(),
+                       ::testing::Values('a', 'b'), ::testing::Range(0, 3),
+                       ::testing::Bool(), ::testing::Values('c')));
+
+#endif  // GTEST_HAS_COMBINE
+
+}  // namespace
@@ -45,6 +45,7 @@ import gtest_xml_test_utils
 
 
 GTEST_FILTER_FLAG = '--gtest_filter'
+GTEST_INCREMENTAL_OUTPUT_FLAG = '--gtest_incremental_output'
 GTEST_LIST_TESTS_FLAG = '--gtest_list_tests'
 GTEST_OUTPUT_FLAG         = "--gtest_output"
 GTEST_DEFAULT_OUTPUT_FILE = "test_detail.xml"
@@ -164,6 +165,14 @@ class GTestXMLOutputUnitTest(gtest_xml_test_utils.GTestXMLTestCase):
       """
       self._TestXmlOutput(GTEST_PROGRAM_NAME, EXPECTED_NON_EMPTY_XML, 1)
 
+    def testIncrementalXmlOutput(self):
+      """
+      Verifies that the incremental report is complete once the tests are
+      done, and that it matches the one written at the end.
+      """
+      self._TestXmlOutput(GTEST_PROGRAM_NAME, EXPECTED_NON_EMPTY_XML, 1,
+                          extra_args=[GTEST_INCREMENTAL_OUTPUT_FLAG])
+
   def testEmptyXmlOutput(self):
     """Verifies XML output for a Google Test binary without actual tests.
 
@@ -249,6 +258,31 @@ class GTestXMLOutputUnitTest(gtest_xml_test_utils.GTestXMLTestCase):
 
     self.assert_(not os.path.isfile(xml_path))
 
+  def testIncrementalXmlOutputSurvivesCrash(self):
+    """
+    Verifies that the tests that finished before the program crashed are
+    in the incremental XML report.
+    """
+
+    xml_path = os.path.join(gtest_test_utils.GetTempDir(),
+                            GTEST_PROGRAM_NAME + 'out.xml')
+    if os.path.isfile(xml_path):
+      os.remove(xml_path)
+
+    command = [GTEST_PROGRAM_PATH,
+               '%s=xml:%s' % (GTEST_OUTPUT_FLAG, xml_path),
+               GTEST_INCREMENTAL_OUTPUT_FLAG,
+               '%s=SuccessfulTest.*:FailedTest.*' % GTEST_FILTER_FLAG,
+               '--crash_in_failed_test']
+    p = gtest_test_utils.Subprocess(command)
+    self.assert_(not p.exited or p.exit_code != 0)
+
+    xml = open(xml_path).read()
+    self.assert_('<testsuite name="SuccessfulTest"' in xml, xml)
+    self.assert_('<testcase name="Succeeds" status="run"' in xml, xml)
+    self.assert_('name="Fails"' not in xml, xml)
+    self.assert_('</testsuites>' not in xml, xml)
+
   def testFilteredTestXmlOutput(self):
     """Verifies XML output when a filter is applied.
 
@@ -38,10 +38,15 @@
 // This program will be invoked from a Python unit test.  Don't run it
 // directly.
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "gtest/gtest.h"
 
+using ::testing::EmptyTestEventListener;
 using ::testing::InitGoogleTest;
 using ::testing::TestEventListeners;
+using ::testing::TestInfo;
 using ::testing::TestWithParam;
 using ::testing::UnitTest;
 using ::testing::Test;
@@ -169,6 +174,16 @@ INSTANTIATE_TYPED_TEST_CASE_P(Single,
                               TypeParameterizedTestCaseTypes);
 #endif
 
+// Crashes the program when FailedTest starts, for testing that the
+// tests that finished before it are in the incremental XML report.
+class CrashingListener : public EmptyTestEventListener {
+ public:
+  virtual void OnTestStart(const TestInfo& test_info) {
+    if (strcmp(test_info.test_case_name(), "FailedTest") == 0)
+      abort();
+  }
+};
+
 int main(int argc, char** argv) {
   InitGoogleTest(&argc, argv);
 
@@ -176,6 +191,9 @@ int main(int argc, char** argv) {
     TestEventListeners& listeners = UnitTest::GetInstance()->listeners();
     delete listeners.Release(listeners.default_xml_generator());
   }
+  if (argc > 1 && strcmp(argv[1], "--crash_in_failed_test") == 0) {
+    UnitTest::GetInstance()->listeners().Append(new CrashingListener);
+  }
   testing::Test::RecordProperty("ad_hoc_property", "42");
   return RUN_ALL_TESTS();
 }